@@ -75,6 +75,43 @@ extern "C" {
     apr_atomic_cas32((mem), (with), (cmp))
 /** @} */
 
+/**
+ * @name Macro definitions for 64 bit atomic counters
+ *
+ * These are meant for statistics and similar counters that may be updated
+ * concurrently without further synchronization.  APR 1.7 and newer provide
+ * them natively.  With older APR versions, we use the GCC builtins where
+ * available and fall back to plain, i.e. racy, operations otherwise.
+ * @{
+ */
+#if APR_VERSION_AT_LEAST(1,7,0)
+
+/** Atomically read a 64 bit counter from memory. */
+#define svn_atomic__read64(mem) apr_atomic_read64((mem))
+
+/** Atomically set a 64 bit counter in memory. */
+#define svn_atomic__set64(mem, val) apr_atomic_set64((mem), (val))
+
+/** Atomically add @a val to a 64 bit counter. */
+#define svn_atomic__add64(mem, val) ((void)apr_atomic_add64((mem), (val)))
+
+#elif defined(__GNUC__)
+
+#define svn_atomic__read64(mem) __atomic_load_n((mem), __ATOMIC_RELAXED)
+#define svn_atomic__set64(mem, val) \
+    __atomic_store_n((mem), (val), __ATOMIC_RELAXED)
+#define svn_atomic__add64(mem, val) \
+    ((void)__atomic_fetch_add((mem), (val), __ATOMIC_RELAXED))
+
+#else
+
+#define svn_atomic__read64(mem) (*(mem))
+#define svn_atomic__set64(mem, val) ((void)(*(mem) = (val)))
+#define svn_atomic__add64(mem, val) ((void)(*(mem) += (val)))
+
+#endif
+/** @} */
+
 /**
  * @name Single-threaded atomic initialization
  * @{
@@ -65,6 +65,10 @@ typedef svn_error_t *(*svn_cache__deserialize_func_t)(void **out,
  * @a baton passed into can be used to deserialize only a specific part or
  * sub-structure or to perform any other non-modifying operation that may
  * not require the whole structure to be processed.
+ *
+ * @a data is not a copy but the cached item itself.  It must be treated
+ * as read-only and may be accessed in place through a
+ * #svn_temp_deserializer__view_t.
  */
 typedef svn_error_t *(*svn_cache__partial_getter_func_t)(void **out,
                                                          const void *data,
@@ -148,6 +152,17 @@ typedef struct svn_cache__info_t
    */
   apr_uint64_t failures;
 
+  /** Number of items that the cache's admission policy refused to keep
+   * in favor of more frequently used data.  0 if the cache does not
+   * implement an admission policy.
+   */
+  apr_uint64_t rejects;
+
+  /** Number of items that got removed from the cache to make room for
+   * new data.  0 if that information is not available.
+   */
+  apr_uint64_t evictions;
+
   /** Size of the data currently stored in the cache.
    * May be 0 if that information is not available.
    */
@@ -270,6 +285,25 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
                                      apr_pool_t *result_pool,
                                      apr_pool_t *scratch_pool);
 
+/**
+ * Admission policies supported by the membuffer cache.  They decide
+ * whether an item leaving the small first cache level may replace data
+ * in the larger second level.
+ */
+typedef enum svn_cache__admission_policy_t
+{
+  /** Decide based on item priorities and hit counts alone. */
+  svn_cache__admission_default = 0,
+
+  /** TinyLFU.  Keep an approximate access frequency history of recently
+   * requested keys and admit an item to the second level only if it has
+   * been requested more often than the item it would replace.  This
+   * prevents one-time scans (e.g. verification or a full export) from
+   * pushing out the data that is actually being used.
+   */
+  svn_cache__admission_tinylfu
+} svn_cache__admission_policy_t;
+
 /**
  * Creates a new membuffer cache object in @a *cache. It will contain
  * up to @a total_size bytes of data, using @a directory_size bytes
@@ -299,6 +333,10 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
  * (no data being written to the cache) if some reader or another writer
  * currently holds the segment lock.
  *
+ * @a admission_policy selects the strategy used to decide which data to
+ * keep when the cache is full.  #svn_cache__admission_tinylfu requires
+ * about 8 extra bytes per index entry on top of @a total_size.
+ *
  * Allocations will be made in @a result_pool, in particular the data buffers.
  */
 svn_error_t *
@@ -308,8 +346,37 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t segment_count,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
+                                  svn_cache__admission_policy_t admission_policy,
                                   apr_pool_t *result_pool);
 
+/**
+ * Like svn_cache__membuffer_cache_create() but place the cache in an
+ * anonymous shared memory region.  The resulting cache is always
+ * thread-safe.  Processes forked after this call will access the same
+ * cache, i.e. data cached by one process will be available to all others
+ * and the memory consumption remains the same for any number of processes.
+ *
+ * The region is mapped to the same address in all of these processes, but
+ * it cannot be attached to by unrelated processes.  Therefore, this has to
+ * be called in the parent process before forking any workers.
+ *
+ * Shared caches don't use the key prefix pool that normally allows for
+ * more compact index entries.  Hit rates may be slightly lower for very
+ * small items.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the platform does not support
+ * shared memory caches.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(
+  svn_membuffer_t **cache,
+  apr_size_t total_size,
+  apr_size_t directory_size,
+  apr_size_t segment_count,
+  svn_boolean_t allow_blocking_writes,
+  svn_cache__admission_policy_t admission_policy,
+  apr_pool_t *result_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -544,6 +611,139 @@ svn_cache__format_info(const svn_cache__info_t *info,
                        svn_boolean_t access_only,
                        apr_pool_t *result_pool);
 
+/**
+ * Number of buckets in the @a latency histogram of
+ * #svn_cache__metrics_info_t.
+ */
+#define SVN_CACHE__LATENCY_BUCKETS 16
+
+/**
+ * A snapshot of the process-wide access statistics of all cache instances
+ * that have been registered under the same name.
+ *
+ * @see svn_cache__enable_metrics()
+ */
+typedef struct svn_cache__metrics_info_t
+{
+  /** The name that the caches have been registered under. */
+  const char *name;
+
+  /** Number of getter calls. */
+  apr_uint64_t gets;
+
+  /** Number of getter calls that returned data. */
+  apr_uint64_t hits;
+
+  /** Number of setter calls. */
+  apr_uint64_t sets;
+
+  /** Number of function calls that returned an error. */
+  apr_uint64_t failures;
+
+  /** Number of getter calls by duration.  Element @c i counts the calls
+   * that took less than 2^i microseconds.  Slower calls saturate into
+   * the last element.  All 0 unless latency tracking has been enabled
+   * with svn_cache__config_set_latency_tracking().
+   */
+  apr_uint64_t latency[SVN_CACHE__LATENCY_BUCKETS];
+
+  /** Total duration of all getter calls counted in @a latency, in
+   * microseconds. */
+  apr_uint64_t latency_sum;
+} svn_cache__metrics_info_t;
+
+/**
+ * Make @a cache count all accesses in the process-wide statistics record
+ * for @a name as well.  All caches registered under the same @a name share
+ * the same record, which remains valid for the lifetime of the process.
+ * Hence, @a name should identify the kind of data cached, e.g. the key
+ * prefix without any repository or transaction specific parts, and not
+ * the individual instance.  Counters are updated atomically, i.e. without
+ * any locking.
+ *
+ * Because these shared counters are contended between threads, this is
+ * a no-op unless enabled with svn_cache__config_set_metrics() before
+ * @a cache gets registered.
+ *
+ * @a scratch_pool is used for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__enable_metrics(svn_cache__t *cache,
+                          const char *name,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * If @a enabled is set, let svn_cache__enable_metrics() attach caches to
+ * the process-wide statistics records.  This is disabled by default.
+ * Caches created while disabled will not be counted.
+ *
+ * @since New in 1.15.
+ */
+void
+svn_cache__config_set_metrics(svn_boolean_t enabled);
+
+/**
+ * Return whether caches shall be registered for process-wide statistics.
+ *
+ * @since New in 1.15.
+ */
+svn_boolean_t
+svn_cache__config_get_metrics(void);
+
+/**
+ * If @a enabled is set, measure the duration of all getter calls to caches
+ * registered with svn_cache__enable_metrics().  This adds two clock reads
+ * to each call and is disabled by default.
+ *
+ * @since New in 1.15.
+ */
+void
+svn_cache__config_set_latency_tracking(svn_boolean_t enabled);
+
+/**
+ * Return whether the duration of getter calls shall be measured.
+ *
+ * @since New in 1.15.
+ */
+svn_boolean_t
+svn_cache__config_get_latency_tracking(void);
+
+/**
+ * Set @a *metrics to a snapshot of all process-wide statistics records as
+ * an array of #svn_cache__metrics_info_t *, sorted by name and allocated
+ * in @a result_pool.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__get_metrics(apr_array_header_t **metrics,
+                       apr_pool_t *result_pool);
+
+/**
+ * Set @a *text to all process-wide cache statistics, i.e. those returned
+ * by svn_cache__get_metrics() and svn_cache__membuffer_get_global_info(),
+ * in the Prometheus text exposition format.  Allocate the result in
+ * @a result_pool and temporaries in @a scratch_pool.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__format_metrics(svn_string_t **text,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Atomically replace the file at @a path with the output of
+ * svn_cache__format_metrics().  Use @a scratch_pool for temporaries.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__write_metrics(const char *path,
+                         apr_pool_t *scratch_pool);
+
 /**
  * Access the process-global (singleton) membuffer cache. The first call
  * will automatically allocate the cache using the current cache config.
@@ -554,6 +754,45 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Select the @a policy to be used by the process-global membuffer cache.
+ * Like svn_cache_config_set(), this has no effect once the global cache
+ * has been created, i.e. call it during process initialization.
+ *
+ * This function is not thread-safe.
+ */
+void
+svn_cache__config_set_admission_policy(svn_cache__admission_policy_t policy);
+
+/**
+ * Return the admission policy for the process-global membuffer cache.
+ */
+svn_cache__admission_policy_t
+svn_cache__config_get_admission_policy(void);
+
+/**
+ * If @a shared is set, try to create the process-global membuffer
+ * cache in shared memory such that it can be used by all processes forked
+ * afterwards, see svn_cache__membuffer_cache_create_shared().  Fall back
+ * to a process-local cache if that is not supported.
+ *
+ * Like svn_cache_config_set(), this has no effect once the global cache
+ * has been created.  Pre-fork servers should call this during process
+ * initialization and then force the creation of the global cache by
+ * calling svn_cache__get_global_membuffer_cache() before forking.
+ *
+ * This function is not thread-safe.
+ */
+void
+svn_cache__config_set_process_shared(svn_boolean_t shared);
+
+/**
+ * Return whether the process-global membuffer cache shall be shared with
+ * child processes.
+ */
+svn_boolean_t
+svn_cache__config_get_process_shared(void);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
@@ -570,6 +809,46 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache);
 
+/**
+ * Write the contents of the membuffer @a cache to @a stream such that they
+ * can later be restored with svn_cache__membuffer_load(), e.g. to start
+ * a server process with a warm cache.  The snapshot includes the keys,
+ * serialized values, priorities and hit counts of all cached items.
+ *
+ * @a validation_tag will be stored in the snapshot.  It should identify
+ * the state of all data sources the cached items have been derived from,
+ * e.g. the UUIDs and youngest revisions of all repositories.
+ *
+ * The cache remains usable while being saved but writes to it may be
+ * dropped.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          const char *validation_tag,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Add the items from the snapshot in @a stream, written by
+ * svn_cache__membuffer_save(), to the membuffer @a cache.  The cache does
+ * not need to have the same size or configuration as the one that the
+ * snapshot has been taken from.
+ *
+ * If the snapshot has been written for a different @a validation_tag,
+ * by an incompatible version or on an incompatible platform, ignore it
+ * and set @a *loaded to @c FALSE.  Otherwise, set @a *loaded to @c TRUE.
+ * Return #SVN_ERR_MALFORMED_FILE if the snapshot is corrupt.  In that
+ * case, some of its items may have been added to the cache already.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_load(svn_boolean_t *loaded,
+                          svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          const char *validation_tag,
+                          apr_pool_t *scratch_pool);
+
 /** @} */
 
 
@@ -34,6 +34,8 @@
 #include "svn_delta.h"
 #include "svn_editor.h"
 
+#include "private/svn_subr_private.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -108,6 +110,100 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
                                  apr_pool_t *pool);
 
+/** Like svn_txdelta_to_svndiff3() but, for @a svndiff_version 3,
+    compress all windows using the Zstandard dictionary @a zstd_dict
+    unless that is @c NULL.  For version 3, @a compression_level is
+    the Zstandard compression level and will be clipped to the range
+    1 .. #SVN__ZSTD_MAX_LEVEL. */
+void
+svn_txdelta__to_svndiff_with_dict(svn_txdelta_window_handler_t *handler,
+                                  void **handler_baton,
+                                  svn_stream_t *output,
+                                  int svndiff_version,
+                                  int compression_level,
+                                  const svn__zstd_dict_t *zstd_dict,
+                                  apr_pool_t *pool);
+
+/** Like svn_txdelta__to_svndiff_with_dict() but compress up to
+    @a max_threads windows concurrently in a process-wide pool of worker
+    threads.  The windows will still be written to @a output in order
+    but may be written only during later calls to @a *handler.  All of
+    them will have been written when @a *handler returns for the final
+    @c NULL window.
+
+    Uncompressed data, i.e. @a svndiff_version 0, as well as
+    @a max_threads values smaller than 2 or builds without thread
+    support will not use worker threads.  @a max_threads will be
+    clipped to an implementation-defined limit.
+
+    @note Decoding is always serial.  Dump streams carry uncompressed
+    svndiff0 data and FSFS reads stored windows one by one, so there is
+    no read path that would benefit from parallel decompression.
+
+    @since New in 1.15. */
+void
+svn_txdelta__to_svndiff_parallel(svn_txdelta_window_handler_t *handler,
+                                 void **handler_baton,
+                                 svn_stream_t *output,
+                                 int svndiff_version,
+                                 int compression_level,
+                                 const svn__zstd_dict_t *zstd_dict,
+                                 int max_threads,
+                                 apr_pool_t *pool);
+
+/** Like svn_txdelta_read_svndiff_window() but decompress svndiff
+    version 3 data using the Zstandard dictionary @a zstd_dict.  If the
+    data has been compressed with a dictionary, @a zstd_dict must be
+    that very dictionary.  Otherwise, it may be @c NULL. */
+svn_error_t *
+svn_txdelta__read_svndiff_window_with_dict(svn_txdelta_window_t **window,
+                                           svn_stream_t *stream,
+                                           int svndiff_version,
+                                           const svn__zstd_dict_t *zstd_dict,
+                                           apr_pool_t *pool);
+
+/** The algorithms that svn_txdelta__create() and svn_txdelta__target_push()
+    may use to compute delta windows.
+
+    @since New in 1.15. */
+typedef enum svn_txdelta__engine_t
+{
+  /** Compute each window against the equally sized chunk of the source
+      at the same offset.  This is what svn_txdelta2() does. */
+  svn_txdelta__engine_xdelta = 0,
+
+  /** Index the whole source and compute each window against the part of
+      the source that matches its target data best.  This finds data that
+      has been moved by more than one window.  The source views never
+      slide backwards and only leave the source data following that of
+      the previous window if another part matches clearly better.  The
+      whole source will be held in memory, up to an implementation-defined
+      limit of a few GB.  Any data beyond that will not be used as delta
+      source. */
+  svn_txdelta__engine_indexed
+} svn_txdelta__engine_t;
+
+/** Like svn_txdelta2() but use the delta algorithm @a engine.
+
+    @since New in 1.15. */
+void
+svn_txdelta__create(svn_txdelta_stream_t **stream,
+                    svn_stream_t *source,
+                    svn_stream_t *target,
+                    svn_boolean_t calculate_checksum,
+                    svn_txdelta__engine_t engine,
+                    apr_pool_t *pool);
+
+/** Like svn_txdelta_target_push() but use the delta algorithm @a engine.
+
+    @since New in 1.15. */
+svn_stream_t *
+svn_txdelta__target_push(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         svn_txdelta__engine_t engine,
+                         apr_pool_t *pool);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
@@ -135,6 +135,57 @@ svn_stream__from_aprfile(apr_file_t *file,
                          svn_boolean_t truncate_on_seek,
                          apr_pool_t *pool);
 
+/** Borrow callback function for a stream.  Like #svn_read_fn_t with
+ * full read semantics but instead of copying up to @a *len bytes into
+ * a caller-provided buffer, set @a *data to the stream's own memory.
+ * The returned data must remain valid until the stream gets closed.
+ */
+typedef svn_error_t *(*svn_stream__borrow_fn_t)(void *baton,
+                                                const char **data,
+                                                apr_size_t *len);
+
+/** Set @a stream's borrow function to @a borrow_fn.
+ */
+void
+svn_stream__set_borrow(svn_stream_t *stream,
+                       svn_stream__borrow_fn_t borrow_fn);
+
+/** Return TRUE, if @a stream supports svn_stream__borrow().
+ */
+svn_boolean_t
+svn_stream__supports_borrow(svn_stream_t *stream);
+
+/** Read up to @a *len bytes from @a stream without copying them.  Set
+ * @a *data to the data read and @a *len to the number of bytes read.
+ * Fewer bytes than requested will only be returned at the end of the
+ * stream.  @a *data remains valid until @a stream gets closed.
+ *
+ * Return #SVN_ERR_STREAM_NOT_SUPPORTED if @a stream does not support
+ * borrowing its data.
+ */
+svn_error_t *
+svn_stream__borrow(svn_stream_t *stream,
+                   const char **data,
+                   apr_size_t *len);
+
+/** Set @a *stream to a read-only stream over the whole contents of
+ * @a file, allocated in @a result_pool.  The stream takes ownership of
+ * @a file.
+ *
+ * If the platform supports it and the file is large enough, the file
+ * gets memory mapped and closed immediately, so that the stream supports
+ * svn_stream__borrow().  Otherwise, this is equivalent to
+ * svn_stream_from_aprfile2() with @a disown set to FALSE.  The file must
+ * not be modified while the stream is open.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_stream__from_mapped_aprfile(svn_stream_t **stream,
+                                apr_file_t *file,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
 #if defined(WIN32)
 
 /* ### Move to something like io.h or subr.h, to avoid making it
@@ -27,6 +27,8 @@
 #ifndef SVN_MUTEX_H
 #define SVN_MUTEX_H
 
+#include <apr_thread_proc.h>
+
 #include "svn_error.h"
 
 #ifdef __cplusplus
@@ -115,6 +117,72 @@ svn_mutex__get(svn_mutex__t *mutex);
 
 #endif
 
+/**
+ * This is a simple wrapper around @c apr_thread_cond_t and will be a
+ * valid identifier even if APR does not support threading.
+ */
+typedef struct svn_thread_cond__t svn_thread_cond__t;
+
+/** Create the condition variable @a *cond with a lifetime defined by
+ * @a result_pool.
+ *
+ * If threading is not supported by APR, this function only allocates
+ * a dummy object.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_thread_cond__create(svn_thread_cond__t **cond,
+                        apr_pool_t *result_pool);
+
+/** Wake up all threads waiting for @a cond.
+ *
+ * If threading is not supported by APR, this function is a no-op.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_thread_cond__broadcast(svn_thread_cond__t *cond);
+
+/** Release @a mutex, which must have been created with @a mutex_required
+ * set and be held by the current thread, wait for @a cond to be signaled
+ * and re-acquire @a mutex.  Spurious wake-ups are possible.
+ *
+ * If threading is not supported by APR, this function is a no-op.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_thread_cond__wait(svn_thread_cond__t *cond,
+                      svn_mutex__t *mutex);
+
+/** Maximum number of worker threads that svn_thread_pool__push() will
+ * run concurrently throughout the process.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_THREAD_POOL__MAX_THREADS 16
+
+#if APR_HAS_THREADS
+
+/** Execute @a func with @a data in some thread of the process-wide worker
+ * pool, which gets created upon first use and lives until APR terminates.
+ * @a owner is passed through to @c apr_thread_pool_push.  Use
+ * @a scratch_pool for temporary allocations.
+ *
+ * Tasks will be queued once all #SVN_THREAD_POOL__MAX_THREADS workers
+ * are busy.  Therefore, @a func must not wait for other tasks.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_thread_pool__push(apr_thread_start_t func,
+                      void *data,
+                      void *owner,
+                      apr_pool_t *scratch_pool);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
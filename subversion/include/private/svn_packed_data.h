@@ -235,6 +235,17 @@ svn_packed__get_uint(svn_packed__int_stream_t *stream);
 apr_int64_t
 svn_packed__get_int(svn_packed__int_stream_t *stream);
 
+/* Read up to COUNT numbers from STREAM as unsigned integers into VALUES,
+ * in the order they have been written.  Return the number of integers
+ * actually read, which will only be less than COUNT when reaching the end
+ * of the stream.  This is much faster than calling svn_packed__get_uint()
+ * repeatedly for streams without sub-streams.
+ */
+apr_size_t
+svn_packed__get_uints(svn_packed__int_stream_t *stream,
+                      apr_uint64_t *values,
+                      apr_size_t count);
+
 /* Return the next byte sequence from STREAM and set *LEN to the length
  * of that sequence.  Sets *LEN to 0 when reading beyond the end of the
  * stream.
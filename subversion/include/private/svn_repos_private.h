@@ -131,6 +131,31 @@ svn_repos__fs_type(const char **fs_type,
                    apr_pool_t *pool);
 
 
+/**
+ * Set @a *tag to a string that identifies the state of the repositories
+ * at @a repos_paths and of all repositories directly below the directories
+ * listed in @a parent_paths.  Both arrays contain <tt>const char *</tt>
+ * local paths.  The tag consists of path, UUID, instance ID and youngest
+ * revision of each repository.  Pass it to svn_cache__membuffer_save() and
+ * svn_cache__membuffer_load() to make sure that cached data will not be
+ * restored after a repository has been replaced or rolled back.
+ *
+ * The repositories will not be opened.  Instead, the respective FS
+ * metadata files will be read directly, so this is only meaningful for
+ * the FSFS and FSX back-ends.  Other directories are listed as
+ * unavailable.
+ *
+ * Allocate the result in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_repos__cache_snapshot_tag(const char **tag,
+                              const apr_array_header_t *repos_paths,
+                              const apr_array_header_t *parent_paths,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+
 /* Create a commit editor for REPOS, based on REVISION.  */
 svn_error_t *
 svn_repos__get_commit_ev2(svn_editor_t **editor,
@@ -74,12 +74,30 @@ svn_sort__hash(apr_hash_t *ht,
 
 /* Sort APR array @a array using ordering defined by @a comparison_func.
  * @a comparison_func is defined as for the C stdlib function qsort().
+ *
+ * Large arrays of paths sorted with svn_sort_compare_paths() will use
+ * a radix sort; see svn_sort__items().
  */
 void
 svn_sort__array(apr_array_header_t *array,
                 int (*comparison_func)(const void *,
                                        const void *));
 
+/* Sort the array @a items of #svn_sort__item_t using the ordering defined
+ * by @a comparison_func.
+ *
+ * For svn_sort_compare_items_as_paths() and
+ * svn_sort_compare_items_lexically(), larger arrays will be sorted by a
+ * radix sort on the keys, which is much faster than qsort() on long
+ * lists of paths sharing common prefixes.  Use @a scratch_pool for
+ * temporary allocations.
+ */
+void
+svn_sort__items(apr_array_header_t *items,
+                int (*comparison_func)(const svn_sort__item_t *,
+                                       const svn_sort__item_t *),
+                apr_pool_t *scratch_pool);
+
 /** Return the lowest index at which the element @a *key should be inserted into
  * the array @a array, according to the ordering defined by @a compare_func.
  * The array must already be sorted in the ordering defined by @a compare_func.
@@ -59,6 +59,31 @@ typedef enum svn_sqlite__mode_e {
     svn_sqlite__mode_rwcreate    /* open/create the database read-write */
 } svn_sqlite__mode_t;
 
+/* How often SQLite flushes data to disk, see PRAGMA synchronous. */
+typedef enum svn_sqlite__synchronous_e {
+    svn_sqlite__sync_off,        /* never; atomic only on process crashes */
+    svn_sqlite__sync_normal,     /* at critical moments only */
+    svn_sqlite__sync_full        /* before every commit */
+} svn_sqlite__synchronous_t;
+
+/* Journaling and durability settings to be used by svn_sqlite__open2(). */
+typedef struct svn_sqlite__open_options_t
+{
+  /* Use a write-ahead log instead of the default rollback journal.
+     This allows readers to run concurrently with a writer and makes
+     commits considerably cheaper.  It requires shared memory and thus
+     does not work on network file systems.  Ignored for read-only
+     connections. */
+  svn_boolean_t wal;
+
+  /* Disk synchronization level. */
+  svn_sqlite__synchronous_t synchronous;
+
+  /* Access up to this many bytes of the database file through a memory
+     map instead of read() calls.  0 disables memory mapping. */
+  apr_int64_t mmap_size;
+} svn_sqlite__open_options_t;
+
 /* The type used for callback functions. */
 typedef svn_error_t *(*svn_sqlite__func_t)(svn_sqlite__context_t *sctx,
                                            int argc,
@@ -89,6 +114,30 @@ svn_sqlite__step(svn_boolean_t *got_row, svn_sqlite__stmt_t *stmt);
 svn_error_t *
 svn_sqlite__insert(apr_int64_t *row_id, svn_sqlite__stmt_t *stmt);
 
+/* Callback for svn_sqlite__insert_rows() that binds the values for row
+   number ROW to STMT.  Only the parameters that differ from the previous
+   row need to be bound.  Use SCRATCH_POOL for temporary allocations. */
+typedef svn_error_t *(*svn_sqlite__bind_row_func_t)(svn_sqlite__stmt_t *stmt,
+                                                    int row,
+                                                    void *baton,
+                                                    apr_pool_t *scratch_pool);
+
+/* Insert ROW_COUNT rows using the single prepared STMT.  For each row,
+   BIND_ROW will be called with BATON to bind the row specific values.
+   Bindings are kept from one row to the next, so values that are the same
+   for all rows may be bound to STMT once before calling this function.
+   STMT will be reset prior to returning.
+
+   Callers should run this within a transaction, e.g. within
+   svn_sqlite__with_transaction(), such that all rows get committed at
+   once.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_sqlite__insert_rows(svn_sqlite__stmt_t *stmt,
+                        int row_count,
+                        svn_sqlite__bind_row_func_t bind_row,
+                        void *baton,
+                        apr_pool_t *scratch_pool);
+
 /* Perform an update/delete and then return the number of affected rows.
    If AFFECTED_ROWS is not NULL, then set *AFFECTED_ROWS to the
    number of rows changed.
@@ -117,12 +166,25 @@ svn_sqlite__read_schema_version(int *version,
    STATEMENTS itself may be NULL, in which case it has no impact.
    See svn_sqlite__get_statement() for how these strings are used.
 
+   OPTIONS control journaling and durability of the connection.  If NULL,
+   the rollback journal is used without any disk synchronization and
+   without memory mapping.
+
    TIMEOUT defines the SQLite busy timeout, values <= 0 cause a Subversion
    default to be used.
 
    The statements will be finalized and the SQLite database will be closed
    when RESULT_POOL is cleaned up. */
 svn_error_t *
+svn_sqlite__open2(svn_sqlite__db_t **db, const char *path,
+                  svn_sqlite__mode_t mode, const char * const statements[],
+                  const svn_sqlite__open_options_t *options,
+                  apr_int32_t timeout,
+                  apr_pool_t *result_pool, apr_pool_t *scratch_pool);
+
+/* Like svn_sqlite__open2() but always uses the default OPTIONS.
+   LATEST_SCHEMA and UPGRADE_SQL are ignored. */
+svn_error_t *
 svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  svn_sqlite__mode_t mode, const char * const statements[],
                  int latest_schema, const char * const *upgrade_sql,
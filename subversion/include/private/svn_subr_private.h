@@ -268,6 +268,19 @@ svn_checksum_t *
 svn_checksum__from_digest_fnv1a_32x4(const unsigned char *digest,
                                      apr_pool_t *result_pool);
 
+/**
+ * Feed @a len bytes from @a data into both checksum contexts @a ctx1 and
+ * @a ctx2, e.g. to calculate the MD5 and the SHA1 checksum of the same
+ * content.  The data is processed in chunks small enough to be read from
+ * memory only once.  Either context may be @c NULL.
+ *
+ * @since New in 1.15
+ */
+svn_error_t *
+svn_checksum__update_pair(svn_checksum_ctx_t *ctx1,
+                          svn_checksum_ctx_t *ctx2,
+                          const void *data,
+                          apr_size_t len);
 
 /**
  * Return a stream that calculates a checksum of type @a kind over all
@@ -428,6 +441,56 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
                      svn_boolean_t incremental,
                      apr_pool_t *pool);
 
+/** Like svn_hash__read_entry() but parse the next key-value pair from the
+ * serialized hash in memory that starts at @a *data and ends at @a end,
+ * then advance @a *data past it.  Nothing gets copied or allocated:
+ * the members of @a *entry point into the buffer and their terminating
+ * NULs replace the newlines that follow them in the serialized data.
+ *
+ * The buffer must therefore be writable and @a *end must be a NUL, as is
+ * the case for the contents of any #svn_stringbuf_t.  If @a terminator is
+ * @c NULL, the hash ends at @a end.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_hash__parse_entry(svn_hash__entry_t *entry,
+                      char **data,
+                      const char *end,
+                      const char *terminator,
+                      svn_boolean_t incremental);
+
+/** Callback type to be used with svn_hash__parse().  @a entry is never
+ * the end-of-hash marker.  The callback may modify the data that the
+ * members of @a entry point to.
+ *
+ * @since New in 1.15.
+ */
+typedef svn_error_t *
+(*svn_hash__entry_func_t)(void *baton,
+                          svn_hash__entry_t *entry,
+                          apr_pool_t *scratch_pool);
+
+/** Parse all key-value pairs in the serialized hash at @a *data, up to
+ * and including @a terminator, using svn_hash__parse_entry() and pass
+ * each of them to @a entry_func along with @a baton.  Upon return,
+ * @a *data points to the first byte following the hash.
+ *
+ * This allows callers to construct their own data structures without
+ * going through an intermediate hash.  @a scratch_pool is passed on to
+ * @a entry_func but never cleared.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_hash__parse(char **data,
+                const char *end,
+                const char *terminator,
+                svn_boolean_t incremental,
+                svn_hash__entry_func_t entry_func,
+                void *baton,
+                apr_pool_t *scratch_pool);
+
 /** @} */
 
 /** @} */
@@ -591,6 +654,75 @@ svn__decompress_lz4(const void *data, apr_size_t len,
                     svn_stringbuf_t *out,
                     apr_size_t limit);
 
+/* Zstandard compression is optional.  Return TRUE if it is available
+ * in this build, i.e. if the *_zstd functions below may be used.
+ * Otherwise, they return SVN_ERR_UNSUPPORTED_FEATURE.
+ */
+svn_boolean_t
+svn__zstd_available(void);
+
+/* The highest Zstandard compression level that we support. */
+#define SVN__ZSTD_MAX_LEVEL 19
+
+/* Default Zstandard compression level, suitable for storage. */
+#define SVN__ZSTD_DEFAULT_LEVEL 3
+
+/* Opaque, immutable Zstandard dictionary, prepared for compression and
+ * decompression.  Once created, it may be used concurrently by multiple
+ * threads.
+ */
+typedef struct svn__zstd_dict_t svn__zstd_dict_t;
+
+/* Set *DICT to the Zstandard dictionary with the contents DATA of length
+ * LEN, e.g. as produced by svn__zstd_train_dict(), for compression at
+ * COMPRESSION_LEVEL.  Allocate *DICT in RESULT_POOL.
+ */
+svn_error_t *
+svn__zstd_dict_create(svn__zstd_dict_t **dict,
+                      const void *data,
+                      apr_size_t len,
+                      int compression_level,
+                      apr_pool_t *result_pool);
+
+/* Return the ID of DICT that gets recorded in all data compressed with it.
+ */
+apr_uint32_t
+svn__zstd_dict_id(const svn__zstd_dict_t *dict);
+
+/* Train a Zstandard dictionary of at most MAX_SIZE bytes on SAMPLES,
+ * an array of const svn_string_t *, and return its contents in *DICT.
+ * Samples should be typical for the data to compress and their total
+ * size should be about 100 times MAX_SIZE.  Allocate *DICT in
+ * RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn__zstd_train_dict(svn_stringbuf_t **dict,
+                     const apr_array_header_t *samples,
+                     apr_size_t max_size,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool);
+
+/* Same as svn__compress_zlib(), but use Zstandard compression at
+ * COMPRESSION_LEVEL, which must be between 1 and SVN__ZSTD_MAX_LEVEL.
+ * If DICT is not NULL, compress using that dictionary at the level given
+ * to svn__zstd_dict_create() instead.
+ */
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int compression_level,
+                   const svn__zstd_dict_t *dict);
+
+/* Same as svn__decompress_zlib(), but use Zstandard compression.  If the
+ * data has been compressed with a dictionary, DICT must be that very
+ * dictionary.  Otherwise, DICT may be NULL.
+ */
+svn_error_t *
+svn__decompress_zstd(const void *data, apr_size_t len,
+                     svn_stringbuf_t *out,
+                     apr_size_t limit,
+                     const svn__zstd_dict_t *dict);
+
 /** @} */
 
 /**
@@ -626,6 +758,45 @@ svn_root_pools__release_pool(apr_pool_t *pool,
 
 /** @} */
 
+/**
+ * @defgroup svn_scratch_pools Recycle-able scratch pools API
+ * @{
+ */
+
+/* APR pools are cheap bump allocators but creating and destroying them is
+ * not.  Every creation initializes a new pool structure and every
+ * destruction hands the memory back to the allocator, which may need to
+ * take a lock that is shared with other threads.
+ *
+ * Scratch pools avoid that cost for short-lived sub-pools created in hot
+ * code paths, e.g. per directory or per representation.  Each thread keeps
+ * a few cleared pools that share a private allocator and hands them out
+ * again and again.
+ *
+ * Code that creates a sub-pool with svn_pool_create() and later destroys
+ * it with svn_pool_destroy() may use these functions instead.  Clearing a
+ * scratch pool with svn_pool_clear() works as usual.
+ */
+
+/* Return an empty pool for temporary allocations that behaves like a
+ * sub-pool of PARENT: it will be released automatically when PARENT gets
+ * cleared or destroyed.
+ *
+ * The pool must only be used by the calling thread.  Release it with
+ * svn_pool__release_scratch() instead of destroying it.
+ */
+apr_pool_t *
+svn_pool__acquire_scratch(apr_pool_t *parent);
+
+/* Clear the scratch POOL and return it to the calling thread's cache.
+ * POOL must have been returned by svn_pool__acquire_scratch() in the same
+ * thread and must not be used afterwards.
+ */
+void
+svn_pool__release_scratch(apr_pool_t *pool);
+
+/** @} */
+
 /**
  * @defgroup svn_config_private Private configuration handling API
  * @{
@@ -746,6 +917,18 @@ const char *svn_lz4__compiled_version(void);
  */
 int svn_lz4__runtime_version(void);
 
+/* Return the Zstandard version we compiled against or NULL, if
+ * Zstandard is not available. */
+const char *svn_zstd__compiled_version(void);
+
+/* Return the Zstandard version we run against or NULL, if Zstandard
+ * is not available. */
+const char *svn_zstd__runtime_version(void);
+
+/* Return the name of the vectorized base64 codec used by svn_base64_*()
+ * on this machine, or "generic" if there is none. */
+const char *svn_base64__implementation(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -216,6 +216,53 @@ svn_temp_deserializer__resolve(const void *buffer, void **ptr);
 const void *
 svn_temp_deserializer__ptr(const void *buffer, const void *const *ptr);
 
+/**
+ * Read-only view of serialized data that is accessed in place, e.g. from
+ * within a cache's memory, rather than being copied and resolved first.
+ * Pointers get resolved lazily upon access and all results are checked
+ * to lie within the view.  Hence, a single item can be extracted from a
+ * large serialized structure without touching or duplicating the rest.
+ *
+ * The view does not own the data and must not outlive it.
+ */
+typedef struct svn_temp_deserializer__view_t
+{
+  /** Start of the serialized data. */
+  const char *data;
+
+  /** Number of valid bytes at @a data. */
+  apr_size_t len;
+} svn_temp_deserializer__view_t;
+
+/**
+ * Initialize @a view to cover the @a len bytes of serialized @a data.
+ */
+void
+svn_temp_deserializer__view_init(svn_temp_deserializer__view_t *view,
+                                 const void *data,
+                                 apr_size_t len);
+
+/**
+ * Similar to svn_temp_deserializer__ptr() but for the serialized pointer
+ * @a *ptr within the sub-structure @a parent of @a view.  Return NULL if
+ * @a ptr itself does not lie within @a view, if that pointer is NULL or
+ * if the @a size bytes it refers to do not lie within @a view entirely.
+ */
+const void *
+svn_temp_deserializer__view_ptr(const svn_temp_deserializer__view_t *view,
+                                const void *parent,
+                                const void *const *ptr,
+                                apr_size_t size);
+
+/**
+ * Like svn_temp_deserializer__view_ptr() but for a serialized C string.
+ * Return NULL if the string is not NUL-terminated within @a view.
+ */
+const char *
+svn_temp_deserializer__view_string(const svn_temp_deserializer__view_t *view,
+                                   const void *parent,
+                                   const char *const *ptr);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
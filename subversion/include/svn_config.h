@@ -171,6 +171,12 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SQLITE_JOURNAL_MODE       "journal-mode"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SQLITE_SYNCHRONOUS        "synchronous"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE          "mmap-size"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -89,6 +89,44 @@ void svn_txdelta__xdelta(svn_txdelta__ops_baton_t *build_baton,
                          apr_pool_t *pool);
 
 
+/* The largest source that svn_txdelta__index_source() accepts.  Block
+   positions within the index are 32 bit values. */
+#define SVN_TXDELTA__MAX_INDEXED_SOURCE \
+  (sizeof(apr_size_t) > 4 ? (apr_size_t)APR_UINT32_MAX - 1 : APR_SIZE_MAX / 2)
+
+/* Index over a whole delta source, used by svn_txdelta__xdelta_indexed(). */
+typedef struct svn_txdelta__source_index_t svn_txdelta__source_index_t;
+
+/* Index the LEN bytes of source DATA for use with
+   svn_txdelta__xdelta_indexed().  DATA must remain valid as long as the
+   index is being used.  LEN must not exceed SVN_TXDELTA__MAX_INDEXED_SOURCE.
+   Allocate the index in POOL. */
+svn_txdelta__source_index_t *
+svn_txdelta__index_source(const char *data,
+                          apr_size_t len,
+                          apr_pool_t *pool);
+
+/* Create xdelta window data for the TARGET_LEN bytes at TARGET against
+   the part of the source in INDEX that matches TARGET best.  The source
+   view will not start before *VIEW_OFFSET, nor be longer than
+   SVN_DELTA_WINDOW_SIZE.  Return its position in *VIEW_OFFSET and
+   *VIEW_LEN.
+
+   *SEQUENTIAL_OFFSET is the source position where the data used by the
+   previous window ended, 0 for the first window.  Unless other parts of
+   the source match TARGET clearly better, the view will start there.  It
+   will be updated for the next window.  Allocate temporary data from
+   POOL. */
+void svn_txdelta__xdelta_indexed(svn_txdelta__ops_baton_t *build_baton,
+                                 apr_size_t *view_offset,
+                                 apr_size_t *view_len,
+                                 apr_size_t *sequential_offset,
+                                 const svn_txdelta__source_index_t *index,
+                                 const char *target,
+                                 apr_size_t target_len,
+                                 apr_pool_t *pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
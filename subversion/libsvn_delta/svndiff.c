@@ -24,8 +24,10 @@
 
 #include <assert.h>
 #include <string.h>
+
 #include "svn_delta.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
 #include "delta.h"
 #include "svn_pools.h"
 #include "svn_private_config.h"
@@ -35,17 +37,21 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
 
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
 static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
+static const char SVNDIFF_V3[] = { 'S', 'V', 'N', 3 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
 static const char *
 get_svndiff_header(int version)
 {
-  if (version == 2)
+  if (version == 3)
+    return SVNDIFF_V3;
+  else if (version == 2)
     return SVNDIFF_V2;
   else if (version == 1)
     return SVNDIFF_V1;
@@ -53,6 +59,253 @@ get_svndiff_header(int version)
     return SVNDIFF_V0;
 }
 
+/* ----- Concurrent window processing ----- */
+
+/* Maximum number of threads that a single encoder may use.
+ * All of them share the process-wide worker pool. */
+#define MAX_THREADS SVN_THREAD_POOL__MAX_THREADS
+
+/* A single window to be processed by some worker thread. */
+typedef struct window_job_t
+{
+  /* Thread-safe root pool containing this structure as well as all
+   * inputs and outputs of the job. */
+  apr_pool_t *pool;
+
+  /* Queue that this job belongs to. */
+  struct window_queue_t *queue;
+
+  /* The delta window to encode. */
+  svn_txdelta_window_t *window;
+
+  /* Encoder outputs. */
+  svn_stringbuf_t *header;
+  svn_stringbuf_t *instructions;
+  const svn_string_t *newdata;
+
+  /* Result of the processing function.  Only valid once DONE is set. */
+  svn_error_t *result;
+
+  /* Set by the worker when the job has been processed.  Guarded by the
+   * queue's mutex. */
+  svn_boolean_t done;
+} window_job_t;
+
+/* Callback processing JOB in some worker thread.  BATON is the
+ * encoder baton that the job queue belongs to. */
+typedef svn_error_t *(*window_job_func_t)(window_job_t *job, void *baton);
+
+/* Windows being processed concurrently, in stream order.  Only the
+ * thread that owns the encoder may add or remove jobs. */
+typedef struct window_queue_t
+{
+  /* Ring buffer of CAPACITY jobs.  The COUNT jobs in it start at FIRST. */
+  window_job_t **jobs;
+  int capacity;
+  int first;
+  int count;
+
+  /* Function to execute for each job and the baton to pass to it. */
+  window_job_func_t process;
+  void *baton;
+
+  /* Protects the jobs' DONE and RESULT members.  COND gets signaled
+   * whenever a job has been completed. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+} window_queue_t;
+
+/* Wait for all jobs in QUEUE to finish and release them. */
+static svn_error_t *
+queue_clear(window_queue_t *queue)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  for (; queue->count; --queue->count)
+    {
+      window_job_t *job = queue->jobs[queue->first];
+      svn_boolean_t done = FALSE;
+
+      /* This loop implicitly handles spurious wake-ups. */
+      while (!done && !err)
+        {
+          err = svn_mutex__lock(queue->mutex);
+          if (err)
+            break;
+
+          done = job->done;
+          if (!done)
+            err = svn_thread_cond__wait(queue->cond, queue->mutex);
+
+          err = svn_mutex__unlock(queue->mutex, err);
+        }
+
+      /* If we could not wait for the job, it may still be using its
+         pool.  Leak it rather than pulling the rug from under it. */
+      if (err)
+        break;
+
+      svn_error_clear(job->result);
+      svn_pool_destroy(job->pool);
+      queue->first = (queue->first + 1) % queue->capacity;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Pool pre-cleanup function making sure that no worker thread still
+ * uses the window_queue_t in DATA when its pool gets destroyed. */
+static apr_status_t
+queue_pre_cleanup(void *data)
+{
+  svn_error_clear(queue_clear(data));
+  return APR_SUCCESS;
+}
+
+/* Set *QUEUE to a new job queue allocated in RESULT_POOL that may hold
+ * up to 2 * THREADS windows.  Each job will be processed by calling
+ * PROCESS with BATON. */
+static svn_error_t *
+queue_create(window_queue_t **queue,
+             int threads,
+             window_job_func_t process,
+             void *baton,
+             apr_pool_t *result_pool)
+{
+  window_queue_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  /* Allow for some more windows than there are threads such that the
+     workers don't run dry while we are writing or consuming the output
+     of a finished job. */
+  result->capacity = 2 * threads;
+  result->jobs = apr_pcalloc(result_pool,
+                             result->capacity * sizeof(*result->jobs));
+  result->process = process;
+  result->baton = baton;
+
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+  SVN_ERR(svn_thread_cond__create(&result->cond, result_pool));
+
+  /* The mutex and condition variable must outlive all jobs. */
+  apr_pool_pre_cleanup_register(result_pool, result, queue_pre_cleanup);
+
+  *queue = result;
+  return SVN_NO_ERROR;
+}
+
+/* Store RESULT in JOB, mark it as done and wake up the thread waiting
+ * for it. */
+static svn_error_t *
+job_finished(window_job_t *job,
+             svn_error_t *result)
+{
+  window_queue_t *queue = job->queue;
+
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  job->result = result;
+  job->done = TRUE;
+
+  SVN_ERR(svn_thread_cond__broadcast(queue->cond));
+  SVN_ERR(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-pool task processing the window_job_t given by DATA. */
+static void * APR_THREAD_FUNC
+window_task(apr_thread_t *tid,
+            void *data)
+{
+  window_job_t *job = data;
+  window_queue_t *queue = job->queue;
+
+  /* As soon as job_finished() releases the mutex, JOB may be invalid
+     (the owning thread may have woken up and released it).
+
+     Therefore, we cannot chain this error into JOB->RESULT.
+     OTOH, the owning thread will probably deadlock anyway if we got
+     an error here, thus there is no point in trying to tell it what
+     the problem was. */
+  svn_error_clear(job_finished(job, queue->process(job, queue->baton)));
+
+  return NULL;
+}
+
+/* Append JOB, allocated in its own root pool, to QUEUE and start
+ * processing it.  QUEUE must not be full. */
+static void
+queue_push(window_queue_t *queue,
+           window_job_t *job)
+{
+#if APR_HAS_THREADS
+  svn_error_t *err;
+#endif
+
+  SVN_ERR_ASSERT_NO_RETURN(queue->count < queue->capacity);
+
+  job->queue = queue;
+  job->result = SVN_NO_ERROR;
+  job->done = FALSE;
+  queue->jobs[(queue->first + queue->count) % queue->capacity] = job;
+  ++queue->count;
+
+#if APR_HAS_THREADS
+  err = svn_thread_pool__push(window_task, job, queue, job->pool);
+  if (!err)
+    return;
+
+  svn_error_clear(err);
+#endif
+
+  /* Process the window right here.  Since we are the only thread that
+     knows about this job, no locking is necessary. */
+  job->result = queue->process(job, queue->baton);
+  job->done = TRUE;
+}
+
+/* Remove the oldest job from QUEUE and return it in *JOB.  If that job
+ * has not been completed, yet, wait for it if WAIT is set or return
+ * NULL otherwise.  Also return NULL if QUEUE is empty.  The caller must
+ * destroy the job's pool after using its results.  Errors in the job
+ * itself will be returned in the job's RESULT. */
+static svn_error_t *
+queue_pop(window_job_t **job,
+          window_queue_t *queue,
+          svn_boolean_t wait)
+{
+  window_job_t *oldest;
+  svn_boolean_t done = FALSE;
+
+  *job = NULL;
+  if (queue->count == 0)
+    return SVN_NO_ERROR;
+
+  oldest = queue->jobs[queue->first];
+  do
+    {
+      SVN_ERR(svn_mutex__lock(queue->mutex));
+
+      done = oldest->done;
+      if (!done && wait)
+        SVN_ERR(svn_mutex__unlock(queue->mutex,
+                                  svn_thread_cond__wait(queue->cond,
+                                                        queue->mutex)));
+      else
+        SVN_ERR(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+    }
+  while (!done && wait);
+
+  if (done)
+    {
+      queue->jobs[queue->first] = NULL;
+      queue->first = (queue->first + 1) % queue->capacity;
+      --queue->count;
+      *job = oldest;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* ----- Text delta to svndiff ----- */
 
 /* We make one of these and get it passed back to us in calls to the
@@ -63,8 +316,18 @@ struct encoder_baton {
   svn_boolean_t header_done;
   int version;
   int compression_level;
+  /* Zstandard dictionary to use with svndiff version 3.  May be NULL. */
+  const svn__zstd_dict_t *zstd_dict;
   /* Pool for temporary allocations, will be cleared periodically. */
   apr_pool_t *scratch_pool;
+  /* Maximum number of windows to compress concurrently.  1 means that
+     all windows get compressed in the caller's thread. */
+  int threads;
+  /* Windows being compressed in the background, in stream order.
+     Created upon the first window if THREADS is larger than 1. */
+  window_queue_t *queue;
+  /* Pool that QUEUE gets allocated in. */
+  apr_pool_t *pool;
 };
 
 /* This is at least as big as the largest size for a single instruction. */
@@ -150,9 +413,18 @@ send_simple_insertion_window(svn_txdelta_window_t *window,
   return SVN_NO_ERROR;
 }
 
+/* Map the svndiff COMPRESSION_LEVEL to a valid Zstandard compression
+   level. */
+static int
+zstd_compression_level(int compression_level)
+{
+  return MIN(MAX(1, compression_level), SVN__ZSTD_MAX_LEVEL);
+}
+
 /* Encodes delta window WINDOW to svndiff-format.
    The svndiff version is VERSION. COMPRESSION_LEVEL is the
-   compression level to use.
+   compression level to use.  For version 3, ZSTD_DICT is the
+   optional Zstandard dictionary to compress with.
    Returned values will be allocated in POOL or refer to *WINDOW
    fields. */
 static svn_error_t *
@@ -162,6 +434,7 @@ encode_window(svn_stringbuf_t **instructions_p,
               svn_txdelta_window_t *window,
               int version,
               int compression_level,
+              const svn__zstd_dict_t *zstd_dict,
               apr_pool_t *pool)
 {
   svn_stringbuf_t *instructions;
@@ -198,7 +471,17 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, window->sview_offset);
   append_encoded_int(header, window->sview_len);
   append_encoded_int(header, window->tview_len);
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed_instructions;
+      compressed_instructions = svn_stringbuf_create_empty(pool);
+      SVN_ERR(svn__compress_zstd(instructions->data, instructions->len,
+                                 compressed_instructions,
+                                 zstd_compression_level(compression_level),
+                                 zstd_dict));
+      instructions = compressed_instructions;
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed_instructions;
       compressed_instructions = svn_stringbuf_create_empty(pool);
@@ -217,7 +500,17 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, instructions->len);
 
   /* Encode the data. */
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__compress_zstd(window->new_data->data,
+                                 window->new_data->len, compressed,
+                                 zstd_compression_level(compression_level),
+                                 zstd_dict));
+      newdata = svn_stringbuf__morph_into_string(compressed);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
 
@@ -245,6 +538,103 @@ encode_window(svn_stringbuf_t **instructions_p,
   return SVN_NO_ERROR;
 }
 
+/* Write the encoded window given by HEADER, INSTRUCTIONS and NEWDATA
+   to EB's output stream. */
+static svn_error_t *
+write_window(struct encoder_baton *eb,
+             const svn_stringbuf_t *header,
+             const svn_stringbuf_t *instructions,
+             const svn_string_t *newdata)
+{
+  apr_size_t len;
+
+  len = header->len;
+  SVN_ERR(svn_stream_write(eb->output, header->data, &len));
+  if (instructions->len > 0)
+    {
+      len = instructions->len;
+      SVN_ERR(svn_stream_write(eb->output, instructions->data, &len));
+    }
+  if (newdata->len > 0)
+    {
+      len = newdata->len;
+      SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements window_job_func_t for encoder batons. */
+static svn_error_t *
+encode_job(window_job_t *job, void *baton)
+{
+  struct encoder_baton *eb = baton;
+
+  return svn_error_trace(encode_window(&job->instructions, &job->header,
+                                       &job->newdata, job->window,
+                                       eb->version, eb->compression_level,
+                                       eb->zstd_dict, job->pool));
+}
+
+/* Write the compressed windows at the head of EB's queue to its output
+   stream until no more than MAX_PENDING windows remain in the queue.
+   Beyond that, write those that have already been completed. */
+static svn_error_t *
+write_finished_windows(struct encoder_baton *eb,
+                       int max_pending)
+{
+  while (TRUE)
+    {
+      window_job_t *job;
+      svn_error_t *err;
+
+      SVN_ERR(queue_pop(&job, eb->queue, eb->queue->count > max_pending));
+      if (!job)
+        break;
+
+      err = job->result;
+      if (!err)
+        err = write_window(eb, job->header, job->instructions, job->newdata);
+
+      svn_pool_destroy(job->pool);
+      SVN_ERR(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue WINDOW in EB for compression in a worker thread.  Write all
+   windows that have been compressed so far.  A NULL WINDOW flushes the
+   whole queue. */
+static svn_error_t *
+queue_window(struct encoder_baton *eb,
+             svn_txdelta_window_t *window)
+{
+  apr_pool_t *job_pool;
+  window_job_t *job;
+
+  if (window == NULL)
+    return eb->queue ? svn_error_trace(write_finished_windows(eb, 0))
+                     : SVN_NO_ERROR;
+
+  if (!eb->queue)
+    SVN_ERR(queue_create(&eb->queue, eb->threads, encode_job, eb,
+                         eb->pool));
+
+  SVN_ERR(write_finished_windows(eb, eb->queue->capacity - 1));
+
+  /* The caller may modify or release WINDOW as soon as we return.
+     Give the worker its own copy in a thread-safe pool. */
+  job_pool = svn_pool_create(NULL);
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->pool = job_pool;
+  job->window = svn_txdelta_window_dup(window, job_pool);
+
+  queue_push(eb->queue, job);
+
+  return SVN_NO_ERROR;
+}
+
 /* Note: When changing things here, check the related comment in
    the svn_txdelta_to_svndiff_stream() function.  */
 static svn_error_t *
@@ -269,6 +659,10 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       eb->header_done = TRUE;
     }
 
+  /* Uncompressed windows are cheap to encode and get written directly. */
+  if (eb->threads > 1 && eb->version > 0)
+    SVN_ERR(queue_window(eb, window));
+
   if (window == NULL)
     {
       /* We're done; clean up. */
@@ -279,36 +673,29 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       return SVN_NO_ERROR;
     }
 
+  /* Queued windows will be written once they have been compressed. */
+  if (eb->queue)
+    return SVN_NO_ERROR;
+
   svn_pool_clear(eb->scratch_pool);
 
   SVN_ERR(encode_window(&instructions, &header, &newdata, window,
                         eb->version, eb->compression_level,
-                        eb->scratch_pool));
+                        eb->zstd_dict, eb->scratch_pool));
 
   /* Write out the window.  */
-  len = header->len;
-  SVN_ERR(svn_stream_write(eb->output, header->data, &len));
-  if (instructions->len > 0)
-    {
-      len = instructions->len;
-      SVN_ERR(svn_stream_write(eb->output, instructions->data, &len));
-    }
-  if (newdata->len > 0)
-    {
-      len = newdata->len;
-      SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(write_window(eb, header, instructions, newdata));
 }
 
 void
-svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
-                        void **handler_baton,
-                        svn_stream_t *output,
-                        int svndiff_version,
-                        int compression_level,
-                        apr_pool_t *pool)
+svn_txdelta__to_svndiff_parallel(svn_txdelta_window_handler_t *handler,
+                                 void **handler_baton,
+                                 svn_stream_t *output,
+                                 int svndiff_version,
+                                 int compression_level,
+                                 const svn__zstd_dict_t *zstd_dict,
+                                 int max_threads,
+                                 apr_pool_t *pool)
 {
   struct encoder_baton *eb;
 
@@ -318,11 +705,46 @@ svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
   eb->scratch_pool = svn_pool_create(pool);
   eb->version = svndiff_version;
   eb->compression_level = compression_level;
+  eb->zstd_dict = zstd_dict;
+#if APR_HAS_THREADS
+  eb->threads = MIN(MAX(1, max_threads), MAX_THREADS);
+#else
+  eb->threads = 1;
+#endif
+  eb->queue = NULL;
+  eb->pool = pool;
 
   *handler = window_handler;
   *handler_baton = eb;
 }
 
+void
+svn_txdelta__to_svndiff_with_dict(svn_txdelta_window_handler_t *handler,
+                                  void **handler_baton,
+                                  svn_stream_t *output,
+                                  int svndiff_version,
+                                  int compression_level,
+                                  const svn__zstd_dict_t *zstd_dict,
+                                  apr_pool_t *pool)
+{
+  svn_txdelta__to_svndiff_parallel(handler, handler_baton, output,
+                                   svndiff_version, compression_level,
+                                   zstd_dict, 1, pool);
+}
+
+void
+svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
+                        void **handler_baton,
+                        svn_stream_t *output,
+                        int svndiff_version,
+                        int compression_level,
+                        apr_pool_t *pool)
+{
+  svn_txdelta__to_svndiff_with_dict(handler, handler_baton, output,
+                                    svndiff_version, compression_level,
+                                    NULL, pool);
+}
+
 void
 svn_txdelta_to_svndiff2(svn_txdelta_window_handler_t *handler,
                         void **handler_baton,
@@ -546,12 +968,13 @@ count_and_verify_instructions(int *ninst,
    the remainder of the window contents, fill in a delta window
    structure *WINDOW.  New allocations will be performed in POOL;
    the new_data field of *WINDOW will refer directly to memory pointed
-   to by DATA. */
+   to by DATA.  ZSTD_DICT is the Zstandard dictionary that svndiff
+   version 3 data may have been compressed with; it may be NULL. */
 static svn_error_t *
 decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
               apr_size_t sview_len, apr_size_t tview_len, apr_size_t inslen,
               apr_size_t newlen, const unsigned char *data, apr_pool_t *pool,
-              unsigned int version)
+              unsigned int version, const svn__zstd_dict_t *zstd_dict)
 {
   const unsigned char *insend;
   int ninst;
@@ -565,7 +988,23 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
   insend = data + inslen;
 
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_zstd(insend, newlen, ndout,
+                                   SVN_DELTA_WINDOW_SIZE, zstd_dict));
+      SVN_ERR(svn__decompress_zstd(data, insend - data, instout,
+                                   MAX_INSTRUCTION_SECTION_LEN, zstd_dict));
+
+      newlen = ndout->len;
+      data = (unsigned char *)instout->data;
+      insend = (unsigned char *)instout->data + instout->len;
+
+      new_data = svn_stringbuf__morph_into_string(ndout);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
@@ -653,6 +1092,8 @@ write_handler(void *baton,
         db->version = 1;
       else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
         db->version = 2;
+      else if (memcmp(buffer, SVNDIFF_V3 + db->header_bytes, nheader) == 0)
+        db->version = 3;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
@@ -758,7 +1199,7 @@ write_handler(void *baton,
       /* Decode the window and send it off. */
       SVN_ERR(decode_window(&window, db->sview_offset, db->sview_len,
                             db->tview_len, db->inslen, db->newlen, p,
-                            db->subpool, db->version));
+                            db->subpool, db->version, NULL));
       SVN_ERR(db->consumer_func(&window, db->consumer_baton));
 
       p += db->inslen + db->newlen;
@@ -940,10 +1381,11 @@ read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
 }
 
 svn_error_t *
-svn_txdelta_read_svndiff_window(svn_txdelta_window_t **window,
-                                svn_stream_t *stream,
-                                int svndiff_version,
-                                apr_pool_t *pool)
+svn_txdelta__read_svndiff_window_with_dict(svn_txdelta_window_t **window,
+                                           svn_stream_t *stream,
+                                           int svndiff_version,
+                                           const svn__zstd_dict_t *zstd_dict,
+                                           apr_pool_t *pool)
 {
   svn_filesize_t sview_offset;
   apr_size_t sview_len, tview_len, inslen, newlen, len, header_len;
@@ -959,7 +1401,19 @@ svn_txdelta_read_svndiff_window(svn_txdelta_window_t **window,
                             _("Unexpected end of svndiff input"));
   *window = apr_palloc(pool, sizeof(**window));
   return decode_window(*window, sview_offset, sview_len, tview_len, inslen,
-                       newlen, buf, pool, svndiff_version);
+                       newlen, buf, pool, svndiff_version, zstd_dict);
+}
+
+svn_error_t *
+svn_txdelta_read_svndiff_window(svn_txdelta_window_t **window,
+                                svn_stream_t *stream,
+                                int svndiff_version,
+                                apr_pool_t *pool)
+{
+  return svn_error_trace(
+           svn_txdelta__read_svndiff_window_with_dict(window, stream,
+                                                      svndiff_version, NULL,
+                                                      pool));
 }
 
 
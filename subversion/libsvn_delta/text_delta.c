@@ -32,7 +32,9 @@
 #include "svn_io.h"
 #include "svn_pools.h"
 #include "svn_checksum.h"
+#include "svn_sorts.h"
 
+#include "private/svn_delta_private.h"
 #include "delta.h"
 
 
@@ -61,6 +63,14 @@ struct txdelta_baton {
                                    the checksum. */
   svn_checksum_t *checksum;     /* If non-NULL, the checksum of TARGET. */
 
+  svn_txdelta__engine_t engine; /* Delta algorithm to use. */
+  svn_txdelta__source_index_t *index; /* Index over the whole SOURCE, once
+                                   the indexed engine has read it. */
+  apr_size_t view_offset;       /* Source view start of the last window
+                                   computed with INDEX. */
+  apr_size_t sequential_offset; /* End of the source data used by that
+                                   window. */
+
   apr_pool_t *result_pool;      /* For results (e.g. checksum) */
 };
 
@@ -80,6 +90,12 @@ struct tpush_baton {
   apr_size_t source_len;
   svn_boolean_t source_done;
   apr_size_t target_len;
+
+  /* Used by the indexed delta engine only. */
+  svn_txdelta__engine_t engine;
+  svn_txdelta__source_index_t *index;
+  apr_size_t view_offset;
+  apr_size_t sequential_offset;
 };
 
 
@@ -167,6 +183,64 @@ compute_window(const char *data, apr_size_t source_len, apr_size_t target_len,
   return window;
 }
 
+/* Compute and return a delta window for the TARGET_LEN bytes at TARGET
+   against the source indexed in INDEX.  *VIEW_OFFSET is the source view
+   offset of the previous window and will be set to that of the new one.
+   *SEQUENTIAL_OFFSET will be updated as in svn_txdelta__xdelta_indexed. */
+static svn_txdelta_window_t *
+compute_indexed_window(const svn_txdelta__source_index_t *index,
+                       apr_size_t *view_offset,
+                       apr_size_t *sequential_offset,
+                       const char *target,
+                       apr_size_t target_len,
+                       apr_pool_t *pool)
+{
+  svn_txdelta__ops_baton_t build_baton = { 0 };
+  svn_txdelta_window_t *window;
+  apr_size_t view_len;
+
+  /* Compute the delta operations. */
+  build_baton.new_data = svn_stringbuf_create_empty(pool);
+  svn_txdelta__xdelta_indexed(&build_baton, view_offset, &view_len,
+                              sequential_offset, index, target, target_len,
+                              pool);
+
+  /* Create and return the delta window. */
+  window = svn_txdelta__make_window(&build_baton, pool);
+  window->sview_offset = *view_offset;
+  window->sview_len = view_len;
+  window->tview_len = target_len;
+  return window;
+}
+
+/* Read all of SOURCE, up to SVN_TXDELTA__MAX_INDEXED_SOURCE bytes, and
+   return an index over it in *INDEX.  Allocate the index and the source
+   data in POOL. */
+static svn_error_t *
+index_source(svn_txdelta__source_index_t **index,
+             svn_stream_t *source,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_t *text
+    = svn_stringbuf_create_ensure(SVN_DELTA_WINDOW_SIZE, pool);
+  apr_size_t len;
+
+  do
+    {
+      len = MIN(SVN_DELTA_WINDOW_SIZE,
+                SVN_TXDELTA__MAX_INDEXED_SOURCE - text->len);
+      svn_stringbuf_ensure(text, text->len + len);
+      SVN_ERR(svn_stream_read_full(source, text->data + text->len, &len));
+      text->len += len;
+    }
+  while (len == SVN_DELTA_WINDOW_SIZE);
+
+  text->data[text->len] = '\0';
+  *index = svn_txdelta__index_source(text->data, text->len, pool);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 svn_txdelta_window_t *
@@ -362,8 +436,15 @@ txdelta_next_window(svn_txdelta_window_t **window,
   apr_size_t source_len = SVN_DELTA_WINDOW_SIZE;
   apr_size_t target_len = SVN_DELTA_WINDOW_SIZE;
 
-  /* Read the source stream. */
-  if (b->more_source)
+  /* Read the source stream.  The indexed engine reads all of it once. */
+  if (b->engine == svn_txdelta__engine_indexed)
+    {
+      if (b->index == NULL)
+        SVN_ERR(index_source(&b->index, b->source, b->result_pool));
+
+      source_len = 0;
+    }
+  else if (b->more_source)
     {
       SVN_ERR(svn_stream_read_full(b->source, b->buf, &source_len));
       b->more_source = (source_len == SVN_DELTA_WINDOW_SIZE);
@@ -388,8 +469,13 @@ txdelta_next_window(svn_txdelta_window_t **window,
   else if (b->context != NULL)
     SVN_ERR(svn_checksum_update(b->context, b->buf + source_len, target_len));
 
-  *window = compute_window(b->buf, source_len, target_len,
-                           b->pos - source_len, pool);
+  if (b->index)
+    *window = compute_indexed_window(b->index, &b->view_offset,
+                                     &b->sequential_offset, b->buf,
+                                     target_len, pool);
+  else
+    *window = compute_window(b->buf, source_len, target_len,
+                             b->pos - source_len, pool);
 
   /* That's it. */
   return SVN_NO_ERROR;
@@ -467,11 +553,12 @@ svn_txdelta_run(svn_stream_t *source,
 
 
 void
-svn_txdelta2(svn_txdelta_stream_t **stream,
-             svn_stream_t *source,
-             svn_stream_t *target,
-             svn_boolean_t calculate_checksum,
-             apr_pool_t *pool)
+svn_txdelta__create(svn_txdelta_stream_t **stream,
+                    svn_stream_t *source,
+                    svn_stream_t *target,
+                    svn_boolean_t calculate_checksum,
+                    svn_txdelta__engine_t engine,
+                    apr_pool_t *pool)
 {
   struct txdelta_baton *b = apr_pcalloc(pool, sizeof(*b));
 
@@ -483,12 +570,24 @@ svn_txdelta2(svn_txdelta_stream_t **stream,
   b->context = calculate_checksum
              ? svn_checksum_ctx_create(svn_checksum_md5, pool)
              : NULL;
+  b->engine = engine;
   b->result_pool = pool;
 
   *stream = svn_txdelta_stream_create(b, txdelta_next_window,
                                       txdelta_md5_digest, pool);
 }
 
+void
+svn_txdelta2(svn_txdelta_stream_t **stream,
+             svn_stream_t *source,
+             svn_stream_t *target,
+             svn_boolean_t calculate_checksum,
+             apr_pool_t *pool)
+{
+  svn_txdelta__create(stream, source, target, calculate_checksum,
+                      svn_txdelta__engine_xdelta, pool);
+}
+
 void
 svn_txdelta(svn_txdelta_stream_t **stream,
             svn_stream_t *source,
@@ -502,6 +601,19 @@ svn_txdelta(svn_txdelta_stream_t **stream,
 
 /* Functions for implementing a "target push" delta. */
 
+/* Compute the delta window for the target data buffered in TB. */
+static svn_txdelta_window_t *
+tpush_compute_window(struct tpush_baton *tb, apr_pool_t *pool)
+{
+  if (tb->index)
+    return compute_indexed_window(tb->index, &tb->view_offset,
+                                  &tb->sequential_offset,
+                                  tb->buf, tb->target_len, pool);
+
+  return compute_window(tb->buf, tb->source_len, tb->target_len,
+                        tb->source_offset, pool);
+}
+
 /* This is the write handler for a target-push delta stream.  It reads
  * source data, buffers target data, and fires off delta windows when
  * the target data buffer is full. */
@@ -517,8 +629,14 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
     {
       svn_pool_clear(pool);
 
-      /* Make sure we're all full up on source data, if possible. */
-      if (tb->source_len == 0 && !tb->source_done)
+      /* Make sure we're all full up on source data, if possible.
+         The indexed engine reads all of it upfront. */
+      if (tb->engine == svn_txdelta__engine_indexed)
+        {
+          if (tb->index == NULL)
+            SVN_ERR(index_source(&tb->index, tb->source, tb->pool));
+        }
+      else if (tb->source_len == 0 && !tb->source_done)
         {
           tb->source_len = SVN_DELTA_WINDOW_SIZE;
           SVN_ERR(svn_stream_read_full(tb->source, tb->buf, &tb->source_len));
@@ -538,8 +656,7 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       /* If we're full of target data, compute and fire off a window. */
       if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
         {
-          window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                                  tb->source_offset, pool);
+          window = tpush_compute_window(tb, pool);
           SVN_ERR(tb->wh(window, tb->whb));
           tb->source_offset += tb->source_len;
           tb->source_len = 0;
@@ -564,8 +681,7 @@ tpush_close_handler(void *baton)
   /* Send a final window if we have any residual target data. */
   if (tb->target_len > 0)
     {
-      window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                              tb->source_offset, tb->pool);
+      window = tpush_compute_window(tb, tb->pool);
       SVN_ERR(tb->wh(window, tb->whb));
     }
 
@@ -575,9 +691,11 @@ tpush_close_handler(void *baton)
 
 
 svn_stream_t *
-svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
-                        void *handler_baton, svn_stream_t *source,
-                        apr_pool_t *pool)
+svn_txdelta__target_push(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         svn_txdelta__engine_t engine,
+                         apr_pool_t *pool)
 {
   struct tpush_baton *tb;
   svn_stream_t *stream;
@@ -593,6 +711,10 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
   tb->source_len = 0;
   tb->source_done = FALSE;
   tb->target_len = 0;
+  tb->engine = engine;
+  tb->index = NULL;
+  tb->view_offset = 0;
+  tb->sequential_offset = 0;
 
   /* Create and return writable stream. */
   stream = svn_stream_create(tb, pool);
@@ -601,6 +723,15 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
   return stream;
 }
 
+svn_stream_t *
+svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
+                        void *handler_baton, svn_stream_t *source,
+                        apr_pool_t *pool)
+{
+  return svn_txdelta__target_push(handler, handler_baton, source,
+                                  svn_txdelta__engine_xdelta, pool);
+}
+
 
 
 /* Functions for applying deltas.  */
@@ -628,17 +759,53 @@ size_buffer(char **buf, apr_size_t *buf_size,
 static APR_INLINE char *
 patterning_copy(char *target, const char *source, apr_size_t len)
 {
-  /* If the source and target overlap, repeat the overlapping pattern
-     in the target buffer. Always copy from the source buffer because
-     presumably it will be in the L1 cache after the first iteration
-     and doing this should avoid pipeline stalls due to write/read
-     dependencies. */
   const apr_size_t overlap = target - source;
-  while (len > overlap)
+
+  /* Runs of a single byte value are common enough to deserve their own
+     short-cut. */
+  if (overlap == 1)
+    {
+      memset(target, *source, len);
+      return target + len;
+    }
+
+  /* For short patterns, copy a 16 byte block of whole pattern repetitions
+     at a time.  The fixed-size memcpy() compiles into a single vector
+     load / store pair on all relevant platforms.  Consecutive stores
+     overlap by less than one pattern length and write identical data
+     into the overlapping parts. */
+  if (overlap < 16 && len >= 16)
+    {
+      char pattern[16];
+      const apr_size_t step = sizeof(pattern) - sizeof(pattern) % overlap;
+      apr_size_t i;
+
+      for (i = 0; i < sizeof(pattern); ++i)
+        pattern[i] = source[i % overlap];
+
+      while (len >= sizeof(pattern))
+        {
+          memcpy(target, pattern, sizeof(pattern));
+          target += step;
+          len -= step;
+        }
+
+      /* TARGET is at the start of a pattern repetition again. */
+      memcpy(target, pattern, len);
+      return target + len;
+    }
+
+  /* Longer patterns.  Everything between SOURCE and TARGET is a sequence
+     of whole pattern repetitions, so we can double the size of each copy
+     and need only O(log(LEN / OVERLAP)) memcpy() calls.  The source and
+     target ranges of each copy are adjacent but never overlap. */
+  while (len > (apr_size_t)(target - source))
     {
-      memcpy(target, source, overlap);
-      target += overlap;
-      len -= overlap;
+      const apr_size_t chunk = target - source;
+
+      memcpy(target, source, chunk);
+      target += chunk;
+      len -= chunk;
     }
 
   /* Copy any remaining source pattern. */
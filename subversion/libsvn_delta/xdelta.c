@@ -23,14 +23,26 @@
 
 
 #include <assert.h>
+#include <stdlib.h>
 
 #include <apr_general.h>        /* for APR_INLINE */
 #include <apr_hash.h>
 
 #include "svn_hash.h"
 #include "svn_delta.h"
+#include "svn_sorts.h"
 #include "private/svn_string_private.h"
 #include "delta.h"
+
+/* The compiler provides the vector instructions that init_adler32()
+ * needs. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#  define SVN_XDELTA_SSE2
+#  include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON) && defined(__GNUC__)
+#  define SVN_XDELTA_NEON
+#  include <arm_neon.h>
+#endif
 
 /* This is pseudo-adler32. It is adler32 without the prime modulus.
    The idea is borrowed from monotone, and is a translation of the C++
@@ -77,11 +89,87 @@ adler32_replace(apr_uint32_t adler32, const char c_out, const char c_in)
 }
 
 /* Calculate an pseudo-adler32 checksum for MATCH_BLOCKSIZE bytes starting
-   at DATA.  Return the checksum value.  */
+   at DATA.  Return the checksum value.
+
+   S1 is the sum of all bytes and S2 the sum of all prefix sums, i.e. the
+   sum of all bytes weighted by their distance from the end of the block.
+   The vectorized variants use the latter form and process 16 bytes at
+   once instead of running through one long chain of dependent adds.  */
 
 static APR_INLINE apr_uint32_t
 init_adler32(const char *data)
 {
+#if defined(SVN_XDELTA_SSE2)
+
+  /* Weights of the first 16 bytes in a block. */
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i step = _mm_set1_epi16(16);
+  __m128i weights_lo = _mm_set_epi16(MATCH_BLOCKSIZE - 7, MATCH_BLOCKSIZE - 6,
+                                     MATCH_BLOCKSIZE - 5, MATCH_BLOCKSIZE - 4,
+                                     MATCH_BLOCKSIZE - 3, MATCH_BLOCKSIZE - 2,
+                                     MATCH_BLOCKSIZE - 1, MATCH_BLOCKSIZE);
+  __m128i weights_hi = _mm_sub_epi16(weights_lo, _mm_set1_epi16(8));
+  __m128i s1 = zero;
+  __m128i s2 = zero;
+  int i;
+
+  for (i = 0; i < MATCH_BLOCKSIZE; i += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+
+      s1 = _mm_add_epi64(s1, _mm_sad_epu8(chunk, zero));
+      s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(chunk, zero),
+                                            weights_lo));
+      s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpackhi_epi8(chunk, zero),
+                                            weights_hi));
+
+      weights_lo = _mm_sub_epi16(weights_lo, step);
+      weights_hi = _mm_sub_epi16(weights_hi, step);
+    }
+
+  /* Horizontal sums. */
+  s1 = _mm_add_epi64(s1, _mm_unpackhi_epi64(s1, s1));
+  s2 = _mm_add_epi32(s2, _mm_unpackhi_epi64(s2, s2));
+  s2 = _mm_add_epi32(s2, _mm_shuffle_epi32(s2, 1));
+
+  return (apr_uint32_t)_mm_cvtsi128_si32(s2) * 0x10000
+       + (apr_uint32_t)_mm_cvtsi128_si32(s1);
+
+#elif defined(SVN_XDELTA_NEON)
+
+  /* Weights of the first 16 bytes in a block.  The weighted sums per
+     lane stay below 64k for our MATCH_BLOCKSIZE. */
+  static const uint8_t initial_weights[16]
+    = { MATCH_BLOCKSIZE,      MATCH_BLOCKSIZE - 1,  MATCH_BLOCKSIZE - 2,
+        MATCH_BLOCKSIZE - 3,  MATCH_BLOCKSIZE - 4,  MATCH_BLOCKSIZE - 5,
+        MATCH_BLOCKSIZE - 6,  MATCH_BLOCKSIZE - 7,  MATCH_BLOCKSIZE - 8,
+        MATCH_BLOCKSIZE - 9,  MATCH_BLOCKSIZE - 10, MATCH_BLOCKSIZE - 11,
+        MATCH_BLOCKSIZE - 12, MATCH_BLOCKSIZE - 13, MATCH_BLOCKSIZE - 14,
+        MATCH_BLOCKSIZE - 15 };
+  const uint8x16_t step = vdupq_n_u8(16);
+  uint8x16_t weights = vld1q_u8(initial_weights);
+  uint16x8_t s1 = vdupq_n_u16(0);
+  uint16x8_t s2_lo = vdupq_n_u16(0);
+  uint16x8_t s2_hi = vdupq_n_u16(0);
+  int i;
+
+  for (i = 0; i < MATCH_BLOCKSIZE; i += 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *)data + i);
+
+      s1 = vpadalq_u8(s1, chunk);
+      s2_lo = vmlal_u8(s2_lo, vget_low_u8(chunk), vget_low_u8(weights));
+      s2_hi = vmlal_u8(s2_hi, vget_high_u8(chunk), vget_high_u8(weights));
+
+      weights = vsubq_u8(weights, step);
+    }
+
+  return (vaddvq_u32(vpaddlq_u16(s2_lo)) + vaddvq_u32(vpaddlq_u16(s2_hi)))
+         * 0x10000
+       + vaddvq_u16(s1);
+
+#else
+
   const unsigned char *input = (const unsigned char *)data;
   const unsigned char *last = input + MATCH_BLOCKSIZE;
 
@@ -101,6 +189,8 @@ init_adler32(const char *data)
     }
 
   return s2 * 0x10000 + s1;
+
+#endif
 }
 
 /* Information for a block of the delta source.  The length of the
@@ -167,18 +257,23 @@ static apr_uint32_t hash_flags(apr_uint32_t sum)
 
 /* Insert a block with the checksum ADLERSUM at position POS in the source
    data into the table BLOCKS.  Ignore true duplicates, i.e. blocks with
-   actually the same content. */
+   actually the same content, once there are MAX_COPIES of them. */
 static void
-add_block(struct blocks *blocks, apr_uint32_t adlersum, apr_uint32_t pos)
+add_block(struct blocks *blocks,
+          apr_uint32_t adlersum,
+          apr_uint32_t pos,
+          int max_copies)
 {
   apr_uint32_t h = hash_func(adlersum) & blocks->max;
+  int copies = 0;
 
   /* This will terminate, since we know that we will not fill the table. */
   for (; blocks->slots[h].pos != NO_POSITION; h = (h + 1) & blocks->max)
     if (blocks->slots[h].adlersum == adlersum)
       if (memcmp(blocks->data + blocks->slots[h].pos, blocks->data + pos,
                  MATCH_BLOCKSIZE) == 0)
-        return;
+        if (++copies == max_copies)
+          return;
 
   blocks->slots[h].adlersum = adlersum;
   blocks->slots[h].pos = pos;
@@ -205,21 +300,25 @@ find_block(const struct blocks *blocks,
 }
 
 /* Initialize the matches table from DATA of size DATALEN.  This goes
-   through every block of MATCH_BLOCKSIZE bytes in the source and
-   checksums it, inserting the result into the BLOCKS table.  */
+   through every block of MATCH_BLOCKSIZE bytes at multiples of STRIDE
+   in the source and checksums it, inserting the result into the BLOCKS
+   table.  STRIDE must be a multiple of MATCH_BLOCKSIZE.  Keep the first
+   MAX_COPIES positions of blocks with identical content.  */
 static void
 init_blocks_table(const char *data,
                   apr_size_t datalen,
+                  apr_size_t stride,
+                  int max_copies,
                   struct blocks *blocks,
                   apr_pool_t *pool)
 {
   apr_size_t nblocks;
   apr_size_t wnslots = 1;
   apr_uint32_t nslots;
-  apr_uint32_t i;
+  apr_size_t i;
 
   /* Be pessimistic about the block count. */
-  nblocks = datalen / MATCH_BLOCKSIZE + 1;
+  nblocks = datalen / stride + 1;
   /* Find nearest larger power of two. */
   while (wnslots <= nblocks)
     wnslots *= 2;
@@ -253,8 +352,8 @@ init_blocks_table(const char *data,
   /* If there is an odd block at the end of the buffer, we will
      not use that shorter block for deltification (only indirectly
      as an extension of some previous block). */
-  for (i = 0; i + MATCH_BLOCKSIZE <= datalen; i += MATCH_BLOCKSIZE)
-    add_block(blocks, init_adler32(data + i), i);
+  for (i = 0; i + MATCH_BLOCKSIZE <= datalen; i += stride)
+    add_block(blocks, init_adler32(data + i), (apr_uint32_t)i, max_copies);
 }
 
 /* Try to find a match for the target data B in BLOCKS, and then
@@ -278,7 +377,7 @@ find_match(const struct blocks *blocks,
            apr_size_t pending_insert_start)
 {
   apr_size_t apos, bpos = *bposp;
-  apr_size_t delta, max_delta;
+  apr_size_t delta, max_delta, back;
 
   apos = find_block(blocks, rolling, b + bpos);
 
@@ -296,12 +395,12 @@ find_match(const struct blocks *blocks,
 
   /* See if we can extend backwards (max MATCH_BLOCKSIZE-1 steps because A's
      content has been sampled only every MATCH_BLOCKSIZE positions).  */
-  while (apos > 0 && bpos > pending_insert_start && a[apos-1] == b[bpos-1])
-    {
-      --apos;
-      --bpos;
-      ++delta;
-    }
+  back = svn_cstring__reverse_match_length(a + apos, b + bpos,
+                                           MIN(apos,
+                                               bpos - pending_insert_start));
+  apos -= back;
+  bpos -= back;
+  delta += back;
 
   *aposp = apos;
   *bposp = bpos;
@@ -403,7 +502,7 @@ compute_delta(svn_txdelta__ops_baton_t *build_baton,
   upper = bsize - MATCH_BLOCKSIZE; /* this is now known to be >= LO */
 
   /* Initialize the matches table.  */
-  init_blocks_table(a, asize, &blocks, pool);
+  init_blocks_table(a, asize, MATCH_BLOCKSIZE, 1, &blocks, pool);
 
   /* Initialize our rolling checksum.  */
   rolling = init_adler32(b + lo);
@@ -413,12 +512,31 @@ compute_delta(svn_txdelta__ops_baton_t *build_baton,
       apr_size_t apos;
 
       /* Quickly skip positions whose respective ROLLING checksums
-         definitely do not match any SLOT in BLOCKS. */
-      while (!(blocks.flags[hash_flags(rolling)] & (1 << (rolling & 7)))
-             && lo < upper)
+         definitely do not match any SLOT in BLOCKS.
+
+         This is the hottest loop for dissimilar data.  Roll both halves
+         of the checksum separately, which is equivalent to
+         adler32_replace() but keeps the chain of dependent operations
+         per byte short.  Only the flags lookup needs the checksum. */
+      if (!(blocks.flags[hash_flags(rolling)] & (1 << (rolling & 7))))
         {
-          rolling = adler32_replace(rolling, b[lo], b[lo+MATCH_BLOCKSIZE]);
-          lo++;
+          apr_uint32_t s1 = rolling & 0xffff;
+          apr_uint32_t s2 = rolling >> 16;
+
+          while (lo < upper)
+            {
+              unsigned char c_out = (unsigned char)b[lo];
+              unsigned char c_in = (unsigned char)b[lo + MATCH_BLOCKSIZE];
+
+              s1 = s1 - c_out + c_in;
+              s2 = s2 - MATCH_BLOCKSIZE * c_out + s1;
+              lo++;
+
+              if (blocks.flags[hash_flags(s2 * 0x10000)] & (1 << (s1 & 7)))
+                break;
+            }
+
+          rolling = s2 * 0x10000 + s1;
         }
 
       /* LO is still <= UPPER, i.e. the following lookup is legal:
@@ -494,3 +612,270 @@ svn_txdelta__xdelta(svn_txdelta__ops_baton_t *build_baton,
                 data + source_len, target_len,
                 pool);
 }
+
+/* Upper limit to the number of blocks in a source index.  Larger sources
+   get sampled sparser to keep the index within about 32MB.  */
+#define MAX_INDEXED_BLOCKS (1024 * 1024)
+
+/* Number of positions that a source index keeps for blocks with the same
+   content.  Repeated blocks will then count for more than just the first
+   of the source ranges they occur in.  */
+#define MAX_INDEXED_COPIES 4
+
+struct svn_txdelta__source_index_t
+{
+  /* Sampled blocks of the whole source. */
+  struct blocks blocks;
+
+  /* Distance between the sampled blocks.  A multiple of MATCH_BLOCKSIZE. */
+  apr_size_t stride;
+
+  /* Length of the source in BLOCKS.DATA. */
+  apr_size_t len;
+};
+
+svn_txdelta__source_index_t *
+svn_txdelta__index_source(const char *data,
+                          apr_size_t len,
+                          apr_pool_t *pool)
+{
+  svn_txdelta__source_index_t *index = apr_palloc(pool, sizeof(*index));
+
+  SVN_ERR_ASSERT_NO_RETURN(len <= SVN_TXDELTA__MAX_INDEXED_SOURCE);
+
+  index->stride = MATCH_BLOCKSIZE;
+  while (len / index->stride > MAX_INDEXED_BLOCKS)
+    index->stride *= 2;
+
+  index->len = len;
+  init_blocks_table(data, len, index->stride, MAX_INDEXED_COPIES,
+                    &index->blocks, pool);
+
+  return index;
+}
+
+/* A source block found in the target data. */
+typedef struct hit_t
+{
+  /* Position of the block in the source. */
+  apr_uint32_t pos;
+
+  /* Number of the target block that matched it.  With repeated blocks in
+     the source, multiple hits may share the same target block. */
+  apr_uint32_t target_block;
+} hit_t;
+
+/* Comparison function for hit_t by source position, to be used with
+   qsort. */
+static int
+compare_hits(const void *lhs, const void *rhs)
+{
+  apr_uint32_t lhs_pos = ((const hit_t *)lhs)->pos;
+  apr_uint32_t rhs_pos = ((const hit_t *)rhs)->pos;
+
+  return lhs_pos < rhs_pos ? -1 : (lhs_pos > rhs_pos ? 1 : 0);
+}
+
+/* Find all blocks in BLOCKS with the checksum ADLERSUM and matching the
+   content at DATA that start at or after MIN_POS.  Append them to HITS,
+   tagged with TARGET_BLOCK, and return their number.  */
+static int
+find_blocks(const struct blocks *blocks,
+            apr_uint32_t adlersum,
+            const char *data,
+            apr_size_t min_pos,
+            apr_uint32_t target_block,
+            hit_t *hits)
+{
+  apr_uint32_t h = hash_func(adlersum) & blocks->max;
+  int count = 0;
+
+  for (; blocks->slots[h].pos != NO_POSITION; h = (h + 1) & blocks->max)
+    if (   blocks->slots[h].adlersum == adlersum
+        && blocks->slots[h].pos >= min_pos
+        && memcmp(blocks->data + blocks->slots[h].pos, data,
+                  MATCH_BLOCKSIZE) == 0)
+      {
+        hits[count].pos = blocks->slots[h].pos;
+        hits[count].target_block = target_block;
+        ++count;
+      }
+
+  return count;
+}
+
+/* Return the number of different target blocks in the HIT_COUNT HITS that
+   lie completely within the source view starting at OFFSET.  Use and
+   leave the TARGET_BLOCK_HITS counters all at 0.  */
+static int
+count_target_blocks(const hit_t *hits,
+                    int hit_count,
+                    apr_size_t offset,
+                    apr_uint32_t *target_block_hits)
+{
+  int count = 0;
+  int i;
+
+  for (i = 0; i < hit_count; ++i)
+    if (   hits[i].pos >= offset
+        && hits[i].pos + MATCH_BLOCKSIZE <= offset + SVN_DELTA_WINDOW_SIZE
+        && target_block_hits[hits[i].target_block]++ == 0)
+      ++count;
+
+  for (i = 0; i < hit_count; ++i)
+    target_block_hits[hits[i].target_block] = 0;
+
+  return count;
+}
+
+/* Return the offset of the source view in INDEX to use for the TARGET_LEN
+   bytes at TARGET.  The view will not start before MIN_OFFSET.
+
+   Prefer the view that starts at SEQUENTIAL_OFFSET, i.e. where the source
+   data used by the previous window ends.  Only if another view covers
+   clearly more of the TARGET's blocks, return that one instead.  Allocate
+   temporary data from POOL.  */
+static apr_size_t
+locate_view(const svn_txdelta__source_index_t *index,
+            apr_size_t min_offset,
+            apr_size_t sequential_offset,
+            const char *target,
+            apr_size_t target_len,
+            apr_pool_t *pool)
+{
+  const struct blocks *blocks = &index->blocks;
+  apr_size_t max_target_blocks = target_len / MATCH_BLOCKSIZE + 1;
+  hit_t *hits;
+  apr_uint32_t *target_block_hits;
+  apr_uint32_t target_block = 0;
+  int hit_count = 0;
+  int first, last, covered_blocks = 0;
+  int best_first = 0, best_last = 0, best_count = 0, sequential_count;
+  apr_size_t pos, covered, offset;
+  apr_size_t max_offset = index->len > SVN_DELTA_WINDOW_SIZE
+                        ? index->len - SVN_DELTA_WINDOW_SIZE
+                        : 0;
+  apr_uint32_t rolling;
+
+  sequential_offset = MIN(MAX(sequential_offset, min_offset), max_offset);
+  if (target_len < MATCH_BLOCKSIZE || min_offset >= max_offset)
+    return sequential_offset;
+
+  /* Collect the source positions of all sampled blocks that occur in
+     TARGET.  There is at most one block per MATCH_BLOCKSIZE target bytes
+     and the index holds at most MAX_INDEXED_COPIES positions for it. */
+  hits = apr_palloc(pool, max_target_blocks * MAX_INDEXED_COPIES
+                          * sizeof(*hits));
+  rolling = init_adler32(target);
+  for (pos = 0; pos + MATCH_BLOCKSIZE <= target_len; )
+    {
+      int found = 0;
+
+      if (blocks->flags[hash_flags(rolling)] & (1 << (rolling & 7)))
+        found = find_blocks(blocks, rolling, target + pos, min_offset,
+                            target_block, hits + hit_count);
+
+      if (found)
+        {
+          hit_count += found;
+          ++target_block;
+
+          /* Continue behind the matching block. */
+          pos += MATCH_BLOCKSIZE;
+          if (pos + MATCH_BLOCKSIZE <= target_len)
+            rolling = init_adler32(target + pos);
+        }
+      else
+        {
+          if (pos + MATCH_BLOCKSIZE < target_len)
+            rolling = adler32_replace(rolling, target[pos],
+                                      target[pos + MATCH_BLOCKSIZE]);
+          ++pos;
+        }
+    }
+
+  /* Nothing to gain by moving the view? */
+  if (hit_count == 0)
+    return sequential_offset;
+
+  /* Find the view-sized source range that covers the most target blocks.
+     Count every target block only once, even if it occurs repeatedly
+     within that range. */
+  target_block_hits = apr_pcalloc(pool, target_block
+                                        * sizeof(*target_block_hits));
+  qsort(hits, hit_count, sizeof(*hits), compare_hits);
+  for (first = 0, last = 0; first < hit_count; ++first)
+    {
+      while (   last < hit_count
+             && hits[last].pos + MATCH_BLOCKSIZE
+                  <= (apr_size_t)hits[first].pos + SVN_DELTA_WINDOW_SIZE)
+        {
+          if (target_block_hits[hits[last].target_block]++ == 0)
+            ++covered_blocks;
+          ++last;
+        }
+
+      if (covered_blocks > best_count)
+        {
+          best_count = covered_blocks;
+          best_first = first;
+          best_last = last;
+        }
+
+      if (--target_block_hits[hits[first].target_block] == 0)
+        --covered_blocks;
+    }
+
+  /* Views can't slide backwards.  So, don't jump for a few more hits but
+     stay with the sequential view unless the other one is clearly better.
+     Otherwise, a few repeated blocks might lure us towards the end of the
+     source with no way back. */
+  sequential_count = count_target_blocks(hits, hit_count, sequential_offset,
+                                         target_block_hits);
+  if (best_count <= sequential_count + sequential_count / 4 + 2)
+    return sequential_offset;
+
+  /* Center the hits within the view, such that the matches may be
+     extended in either direction. */
+  covered = hits[best_last - 1].pos + MATCH_BLOCKSIZE - hits[best_first].pos;
+  offset = hits[best_first].pos;
+  offset -= MIN(offset, (SVN_DELTA_WINDOW_SIZE - covered) / 2);
+
+  return MIN(MAX(offset, min_offset), max_offset);
+}
+
+void
+svn_txdelta__xdelta_indexed(svn_txdelta__ops_baton_t *build_baton,
+                            apr_size_t *view_offset,
+                            apr_size_t *view_len,
+                            apr_size_t *sequential_offset,
+                            const svn_txdelta__source_index_t *index,
+                            const char *target,
+                            apr_size_t target_len,
+                            apr_pool_t *pool)
+{
+  int i;
+
+  *view_offset = locate_view(index, *view_offset, *sequential_offset,
+                             target, target_len, pool);
+  *view_len = MIN(index->len - *view_offset, SVN_DELTA_WINDOW_SIZE);
+
+  if (*view_len == 0)
+    svn_txdelta__insert_op(build_baton, svn_txdelta_new, 0, target_len,
+                           target, pool);
+  else
+    compute_delta(build_baton, index->blocks.data + *view_offset,
+                  *view_len, target, target_len, pool);
+
+  /* The next window will most likely continue where the last source copy
+     ended.  Without any, assume that source and target advance evenly. */
+  for (i = build_baton->num_ops - 1; i >= 0; --i)
+    if (build_baton->ops[i].action_code == svn_txdelta_source)
+      {
+        *sequential_offset = *view_offset + build_baton->ops[i].offset
+                           + build_baton->ops[i].length;
+        return;
+      }
+
+  *sequential_offset += target_len;
+}
@@ -1227,6 +1227,11 @@ struct rep_read_baton
   /* Pool used to store file handles and other data that is persistent
      for the entire stream read. */
   apr_pool_t *filehandle_pool;
+
+  /* Lazily allocated array of RS_LIST->NELTS entries.  Element I, if not
+     NULL, reconstructs the fulltext of the delta base of RS_LIST[I] for
+     windows whose source views are not aligned with the base windows. */
+  struct base_reader_t **base_readers;
 };
 
 /* Set window key in *KEY to address the window described by RS.
@@ -1244,6 +1249,7 @@ get_window_key(window_cache_key_t *key, rep_state_t *rs)
 
 /* Implement svn_cache__partial_getter_func_t for raw txdelta windows.
  * Parse the raw data and return a svn_fs_fs__txdelta_cached_window_t.
+ * BATON is the fs_fs_data_t of the file system the window belongs to.
  */
 static svn_error_t *
 parse_raw_window(void **out,
@@ -1252,6 +1258,7 @@ parse_raw_window(void **out,
                  void *baton,
                  apr_pool_t *result_pool)
 {
+  fs_fs_data_t *ffd = baton;
   svn_string_t raw_window;
   svn_stream_t *stream;
 
@@ -1268,8 +1275,10 @@ parse_raw_window(void **out,
   stream = svn_stream_from_string(&raw_window, result_pool);
 
   /* parse it */
-  SVN_ERR(svn_txdelta_read_svndiff_window(&result->window, stream, window->ver,
-                                          result_pool));
+  SVN_ERR(svn_txdelta__read_svndiff_window_with_dict(&result->window, stream,
+                                                     window->ver,
+                                                     ffd->zstd_dict,
+                                                     result_pool));
 
   /* complete the window and return it */
   result->end_offset = window->end_offset;
@@ -1320,7 +1329,9 @@ get_cached_window(svn_txdelta_window_t **window_p,
         {
           SVN_ERR(svn_cache__get_partial((void **) &cached_window, is_cached,
                                          rs->raw_window_cache, &key,
-                                         parse_raw_window, NULL, result_pool));
+                                         parse_raw_window,
+                                         rs->sfile->fs->fsap_data,
+                                         result_pool));
           if (*is_cached)
             SVN_ERR(svn_cache__set(rs->window_cache, &key, cached_window,
                                    scratch_pool));
@@ -1422,6 +1433,64 @@ set_cached_combined_window(svn_stringbuf_t *window,
   return SVN_NO_ERROR;
 }
 
+/* Set *KEY to the key of the combined window CHUNK_INDEX of the delta
+ * base RS and return KEY.  These windows use negative chunk indexes,
+ * i.e. a key space separate from that of the windows that contain whole
+ * representations.  Only the latter may be used by build_rep_list(). */
+static window_cache_key_t *
+get_base_window_key(window_cache_key_t *key,
+                    rep_state_t *rs,
+                    int chunk_index)
+{
+  get_window_key(key, rs);
+  key->chunk_index = -1 - (apr_int64_t)chunk_index;
+
+  return key;
+}
+
+/* Read the combined WINDOW_P number CHUNK_INDEX of the delta base RS from
+ * the current FSFS session's cache.  Set IS_CACHED to indicate whether it
+ * could be found.  Allocations will be made from POOL. */
+static svn_error_t *
+get_cached_base_window(svn_stringbuf_t **window_p,
+                       rep_state_t *rs,
+                       int chunk_index,
+                       svn_boolean_t *is_cached,
+                       apr_pool_t *pool)
+{
+  window_cache_key_t key = { 0 };
+
+  *is_cached = FALSE;
+  if (!rs->combined_cache || !SVN_IS_VALID_REVNUM(rs->revision))
+    return SVN_NO_ERROR;
+
+  return svn_cache__get((void **)window_p,
+                        is_cached,
+                        rs->combined_cache,
+                        get_base_window_key(&key, rs, chunk_index),
+                        pool);
+}
+
+/* Store the combined WINDOW number CHUNK_INDEX of the delta base RS in
+ * the current FSFS session's cache.  This will be a no-op if no cache has
+ * been given.  Temporary allocations will be made from SCRATCH_POOL. */
+static svn_error_t *
+set_cached_base_window(svn_stringbuf_t *window,
+                       rep_state_t *rs,
+                       int chunk_index,
+                       apr_pool_t *scratch_pool)
+{
+  window_cache_key_t key = { 0 };
+
+  if (!rs->combined_cache || !SVN_IS_VALID_REVNUM(rs->revision))
+    return SVN_NO_ERROR;
+
+  return svn_cache__set(rs->combined_cache,
+                        get_base_window_key(&key, rs, chunk_index),
+                        window,
+                        scratch_pool);
+}
+
 /* Build an array of rep_state structures in *LIST giving the delta
    reps from first_rep to a plain-text or self-compressed rep.  Set
    *SRC_STATE to the plain-text rep we find at the end of the chain,
@@ -1444,7 +1513,7 @@ build_rep_list(apr_array_header_t **list,
   svn_fs_fs__rep_header_t *rep_header;
   svn_boolean_t is_cached = FALSE;
   shared_file_t *shared_file = NULL;
-  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool__acquire_scratch(pool);
 
   *list = apr_array_make(pool, 1, sizeof(rep_state_t *));
   rep = *first_rep;
@@ -1499,7 +1568,7 @@ build_rep_list(apr_array_header_t **list,
 
       rs = NULL;
     }
-  svn_pool_destroy(iterpool);
+  svn_pool__release_scratch(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -1549,6 +1618,7 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
                   rep_state_t *rs, apr_pool_t *result_pool,
                   apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = rs->sfile->fs->fsap_data;
   svn_boolean_t is_cached;
   apr_off_t start_offset;
   apr_off_t end_offset;
@@ -1597,8 +1667,9 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   start_offset = rs->start + rs->current;
   SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, scratch_pool));
 
-  /* Skip windows to reach the current chunk if we aren't there yet. */
-  iterpool = svn_pool_create(scratch_pool);
+  /* Skip windows to reach the current chunk if we aren't there yet.
+   * This runs for every window read, so use a recycled scratch pool. */
+  iterpool = svn_pool__acquire_scratch(scratch_pool);
   while (rs->chunk_index < this_chunk)
     {
       svn_pool_clear(iterpool);
@@ -1613,11 +1684,13 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
                                   "beyond the end of the "
                                   "representation"));
     }
-  svn_pool_destroy(iterpool);
+  svn_pool__release_scratch(iterpool);
 
   /* Actually read the next window. */
-  SVN_ERR(svn_txdelta_read_svndiff_window(nwin, rs->sfile->rfile->stream,
-                                          rs->ver, result_pool));
+  SVN_ERR(svn_txdelta__read_svndiff_window_with_dict(nwin,
+                                                     rs->sfile->rfile->stream,
+                                                     rs->ver, ffd->zstd_dict,
+                                                     result_pool));
   SVN_ERR(get_file_offset(&end_offset, rs, scratch_pool));
   rs->current = end_offset - rs->start;
   if (rs->current > rs->size)
@@ -1661,13 +1734,195 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
   return SVN_NO_ERROR;
 }
 
-/* Skip SIZE bytes from the PLAIN representation RS. */
+/* forward-declare. See implementation for the docstring */
 static svn_error_t *
-skip_plain_window(rep_state_t *rs,
-                  apr_size_t size)
+get_combined_window(svn_stringbuf_t **result,
+                    struct rep_read_baton *rb);
+
+/* Reconstructs the fulltext of a delta base chunk by chunk and provides
+   arbitrary, non-decreasing ranges of it.  Delta windows created by
+   svn_txdelta__engine_indexed may use any such range as their source
+   view, independent of how the delta base is split into windows. */
+typedef struct base_reader_t
 {
-  /* Update RS. */
-  rs->current += (apr_off_t)size;
+  /* Reads the delta base.  Its states are private copies and do not
+     interfere with those of the parent baton. */
+  struct rep_read_baton *rb;
+
+  /* The last two reconstructed chunks.  PREVIOUS may be NULL. */
+  svn_stringbuf_t *previous;
+  svn_stringbuf_t *current;
+
+  /* Pools holding PREVIOUS and CURRENT, respectively. */
+  apr_pool_t *previous_pool;
+  apr_pool_t *current_pool;
+
+  /* Offset within the fulltext of the end of CURRENT. */
+  apr_size_t end;
+} base_reader_t;
+
+/* Return a new reader for the fulltext of the delta base of
+   RB->RS_LIST[LEVEL], allocated in RESULT_POOL. */
+static base_reader_t *
+create_base_reader(struct rep_read_baton *rb,
+                   int level,
+                   apr_pool_t *result_pool)
+{
+  base_reader_t *reader = apr_pcalloc(result_pool, sizeof(*reader));
+  struct rep_read_baton *sub = apr_pcalloc(result_pool, sizeof(*sub));
+  int i;
+
+  sub->fs = rb->fs;
+  sub->base_window = rb->base_window;
+  sub->rs_list = apr_array_make(result_pool,
+                                rb->rs_list->nelts - level - 1,
+                                sizeof(rep_state_t *));
+  for (i = level + 1; i < rb->rs_list->nelts; ++i)
+    {
+      rep_state_t *rs = apr_pmemdup(result_pool,
+                                    APR_ARRAY_IDX(rb->rs_list, i,
+                                                  rep_state_t *),
+                                    sizeof(*rs));
+
+      /* Start over at the first window. */
+      rs->ver = -1;
+      rs->current = 0;
+      rs->chunk_index = 0;
+      APR_ARRAY_PUSH(sub->rs_list, rep_state_t *) = rs;
+    }
+
+  if (rb->src_state)
+    sub->src_state = apr_pmemdup(result_pool, rb->src_state,
+                                 sizeof(*rb->src_state));
+
+  sub->pool = svn_pool_create(result_pool);
+  sub->filehandle_pool = result_pool;
+
+  reader->rb = sub;
+  reader->previous_pool = svn_pool_create(result_pool);
+  reader->current_pool = svn_pool_create(result_pool);
+
+  return reader;
+}
+
+/* Set *DATA to the LEN bytes at OFFSET within the fulltext provided by
+   READER.  OFFSET must not be smaller than in any previous call that
+   returned a different chunk.  If the range spans two chunks, allocate
+   the copy in RESULT_POOL. */
+static svn_error_t *
+read_base_range(const char **data,
+                base_reader_t *reader,
+                apr_size_t offset,
+                apr_size_t len,
+                apr_pool_t *result_pool)
+{
+  apr_size_t current_start;
+  apr_size_t previous_start;
+
+  if (len == 0)
+    {
+      *data = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Reconstruct base chunks until the range is covered. */
+  while (reader->end < offset + len)
+    {
+      svn_stringbuf_t *chunk;
+      rep_state_t *rs = APR_ARRAY_IDX(reader->rb->rs_list, 0, rep_state_t *);
+      apr_pool_t *pool = reader->previous_pool;
+
+      if (rs->current == rs->size)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("svndiff source view exceeds the "
+                                  "delta base"));
+
+      SVN_ERR(get_combined_window(&chunk, reader->rb));
+      reader->rb->chunk_index++;
+
+      svn_pool_clear(pool);
+      reader->previous = reader->current;
+      reader->previous_pool = reader->current_pool;
+      reader->current = svn_stringbuf_dup(chunk, pool);
+      reader->current_pool = pool;
+      reader->end += chunk->len;
+
+      svn_pool_clear(reader->rb->pool);
+    }
+
+  current_start = reader->end - (reader->current ? reader->current->len : 0);
+  previous_start = current_start
+                 - (reader->previous ? reader->previous->len : 0);
+
+  if (offset >= current_start)
+    {
+      *data = reader->current->data + (offset - current_start);
+    }
+  else if (offset < previous_start)
+    {
+      return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                              _("svndiff source views are not "
+                                "in ascending order"));
+    }
+  else if (offset + len <= current_start)
+    {
+      *data = reader->previous->data + (offset - previous_start);
+    }
+  else
+    {
+      /* The range spans both chunks. */
+      apr_size_t head = current_start - offset;
+      char *copy = apr_palloc(result_pool, len);
+
+      memcpy(copy, reader->previous->data + (offset - previous_start), head);
+      memcpy(copy + head, reader->current->data, len - head);
+      *data = copy;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SOURCE to the source view of WINDOW at level LEVEL of RB's delta
+   chain, taking the data from the plain or cached base at the end of the
+   chain.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+read_chain_base(const char **source,
+                struct rep_read_baton *rb,
+                const svn_txdelta_window_t *window,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *plain;
+
+  if (rb->base_window)
+    {
+      if (   window->sview_offset > rb->base_window->len
+          || window->sview_len > rb->base_window->len - window->sview_offset)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("svndiff source view exceeds the "
+                                  "delta base"));
+
+      *source = rb->base_window->data + window->sview_offset;
+      return SVN_NO_ERROR;
+    }
+
+  if (rb->src_state == NULL)
+    {
+      *source = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Source views usually follow each other seamlessly but they don't
+     have to. */
+  if (window->sview_offset + window->sview_len > rb->src_state->size)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("svndiff source view exceeds the "
+                              "delta base"));
+
+  rb->src_state->current = window->sview_offset;
+  SVN_ERR(read_plain_window(&plain, rb->src_state, window->sview_len,
+                            result_pool, scratch_pool));
+  *source = plain->data;
 
   return SVN_NO_ERROR;
 }
@@ -1682,20 +1937,25 @@ get_combined_window(svn_stringbuf_t **result,
   apr_pool_t *pool, *new_pool, *window_pool;
   int i;
   apr_array_header_t *windows;
-  svn_stringbuf_t *source, *buf = rb->base_window;
+  svn_stringbuf_t *buf = NULL;
   rep_state_t *rs;
   apr_pool_t *iterpool;
+  svn_boolean_t cache_base = TRUE;
 
   /* Read all windows that we need to combine. This is fine because
      the size of each window is relatively small (100kB) and skip-
      delta limits the number of deltas in a chain to well under 100.
-     Stop early if one of them does not depend on its predecessors. */
+     Stop early if one of them does not depend on its predecessors or
+     if its predecessor's window has already been combined before. */
+  pool = svn_pool_create(rb->pool);
   window_pool = svn_pool_create(rb->pool);
   windows = apr_array_make(window_pool, 0, sizeof(svn_txdelta_window_t *));
   iterpool = svn_pool_create(rb->pool);
   for (i = 0; i < rb->rs_list->nelts; ++i)
     {
       svn_txdelta_window_t *window;
+      rep_state_t *base_rs;
+      svn_boolean_t is_cached = FALSE;
 
       svn_pool_clear(iterpool);
 
@@ -1704,42 +1964,80 @@ get_combined_window(svn_stringbuf_t **result,
                                 iterpool));
 
       APR_ARRAY_PUSH(windows, svn_txdelta_window_t *) = window;
-      if (window->src_ops == 0)
+
+      /* The base window of the same index will not provide the source
+         if there is none or the source view is not aligned with it. */
+      if (   window->src_ops == 0
+          || window->sview_offset
+               != (svn_filesize_t)rb->chunk_index * SVN_DELTA_WINDOW_SIZE)
         {
           ++i;
           break;
         }
+
+      /* Delta bases tend to be shared by many reps.  If we or some
+         other reader reconstructed the base window before, continue
+         from there instead of walking the rest of the chain. */
+      if (i + 1 == rb->rs_list->nelts)
+        continue;
+
+      base_rs = APR_ARRAY_IDX(rb->rs_list, i + 1, rep_state_t *);
+      SVN_ERR(get_cached_base_window(&buf, base_rs, rb->chunk_index,
+                                     &is_cached, pool));
+
+      if (is_cached && window->sview_len <= buf->len)
+        {
+          /* The chain has already been short-cut for this chunk. */
+          cache_base = FALSE;
+          ++i;
+          break;
+        }
+
+      buf = NULL;
     }
 
   /* Combine in the windows from the other delta reps. */
-  pool = svn_pool_create(rb->pool);
   for (--i; i >= 0; --i)
     {
       svn_txdelta_window_t *window;
+      const char *source = NULL;
 
       svn_pool_clear(iterpool);
 
       rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
       window = APR_ARRAY_IDX(windows, i, svn_txdelta_window_t *);
 
-      /* Maybe, we've got a PLAIN start representation.  If we do, read
-         as much data from it as the needed for the txdelta window's source
-         view.
-         Note that BUF / SOURCE may only be NULL in the first iteration.
-         Also note that we may have short-cut reading the delta chain --
-         in which case SRC_OPS is 0 and it might not be a PLAIN rep. */
-      source = buf;
-      if (source == NULL && rb->src_state != NULL)
+      /* Find the source view.  Usually, it is the base window that we
+         just reconstructed.  At the end of the delta chain, it is in the
+         PLAIN base rep or the cached base window.  Otherwise, reconstruct
+         the base separately.
+         Note that we may have short-cut reading the delta chain -- in
+         which case SRC_OPS is 0 and we don't need a source at all. */
+      if (window->src_ops == 0)
         {
-          /* Even if we don't need the source rep now, we still must keep
-           * its read offset in sync with what we might need for the next
-           * window. */
-          if (window->src_ops)
-            SVN_ERR(read_plain_window(&source, rb->src_state,
-                                      window->sview_len,
-                                      pool, iterpool));
-          else
-            SVN_ERR(skip_plain_window(rb->src_state, window->sview_len));
+          source = NULL;
+        }
+      else if (buf && window->sview_len <= buf->len)
+        {
+          source = buf->data;
+        }
+      else if (i + 1 < rb->rs_list->nelts)
+        {
+          if (rb->base_readers == NULL)
+            rb->base_readers = apr_pcalloc(rb->filehandle_pool,
+                                           rb->rs_list->nelts
+                                             * sizeof(*rb->base_readers));
+          if (rb->base_readers[i] == NULL)
+            rb->base_readers[i] = create_base_reader(rb, i,
+                                                     rb->filehandle_pool);
+
+          SVN_ERR(read_base_range(&source, rb->base_readers[i],
+                                  (apr_size_t)window->sview_offset,
+                                  window->sview_len, pool));
+        }
+      else
+        {
+          SVN_ERR(read_chain_base(&source, rb, window, pool, iterpool));
         }
 
       /* Combine this window with the current one. */
@@ -1747,8 +2045,7 @@ get_combined_window(svn_stringbuf_t **result,
       buf = svn_stringbuf_create_ensure(window->tview_len, new_pool);
       buf->len = window->tview_len;
 
-      svn_txdelta_apply_instructions(window, source ? source->data : NULL,
-                                     buf->data, &buf->len);
+      svn_txdelta_apply_instructions(window, source, buf->data, &buf->len);
       if (buf->len != window->tview_len)
         return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                                 _("svndiff window length is "
@@ -1759,7 +2056,23 @@ get_combined_window(svn_stringbuf_t **result,
          list than the cached chunk. */
       if (   (rb->chunk_index == 0) && (rs->current == rs->size)
           && SVN_IS_VALID_REVNUM(rs->revision))
-        SVN_ERR(set_cached_combined_window(buf, rs, new_pool));
+        {
+          SVN_ERR(set_cached_combined_window(buf, rs, new_pool));
+        }
+
+      /* Also remember a single chunk of one delta base, so the loop above
+         will find it when reading this chunk again, be it for this or any
+         other rep that is based on it.  To not flood the cache when
+         reading large files, store only the deepest one that we had to
+         reconstruct from its own base.  In skip-delta chains, that is the
+         one shared by most other reps.  Skip this if the chain has
+         already been short-cut. */
+      else if (cache_base && i > 0 && source)
+        {
+          SVN_ERR(set_cached_base_window(buf, rs, rb->chunk_index,
+                                         new_pool));
+          cache_base = FALSE;
+        }
 
       rs->chunk_index++;
 
@@ -2578,122 +2891,152 @@ compare_dirent_name(const void *a, const void *b)
   return strcmp(lhs->name, rhs);
 }
 
-/* Into *ENTRIES_P, read all directories entries from the key-value text in
- * STREAM.  If INCREMENTAL is TRUE, read until the end of the STREAM and
- * update the data.  ID is provided for nicer error messages.
+/* Baton type for parse_dir_entry. */
+typedef struct dir_entry_baton_t
+{
+  /* Parsed entries in non-incremental mode.  NULL otherwise. */
+  apr_array_header_t *entries;
+
+  /* Parsed entries keyed by name in incremental mode.  NULL otherwise. */
+  apr_hash_t *hash;
+
+  /* ID of the directory, for nicer error messages. */
+  const svn_fs_id_t *id;
+
+  /* Allocate the dirents in this pool. */
+  apr_pool_t *result_pool;
+} dir_entry_baton_t;
+
+/* Implements svn_hash__entry_func_t.  Convert ENTRY into a directory
+ * entry and add it to the dir_entry_baton_t BATON.
  */
 static svn_error_t *
-read_dir_entries(apr_array_header_t **entries_p,
-                 svn_stream_t *stream,
-                 svn_boolean_t incremental,
-                 const svn_fs_id_t *id,
-                 apr_pool_t *result_pool,
-                 apr_pool_t *scratch_pool)
+parse_dir_entry(void *baton,
+                svn_hash__entry_t *entry,
+                apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_hash_t *hash = NULL;
-  const char *terminator = SVN_HASH_TERMINATOR;
-  apr_array_header_t *entries = NULL;
-
-  if (incremental)
-    hash = svn_hash__make(scratch_pool);
-  else
-    entries = apr_array_make(result_pool, 16, sizeof(svn_fs_dirent_t *));
+  dir_entry_baton_t *b = baton;
+  svn_fs_dirent_t *dirent;
+  char *val = entry->val;
+  char *str;
 
-  /* Read until the terminator (non-incremental) or the end of STREAM
-     (incremental mode).  In the latter mode, we use a temporary HASH
-     to make updating and removing entries cheaper. */
-  while (1)
+  /* Deleted entry? */
+  if (val == NULL)
     {
-      svn_hash__entry_t entry;
-      svn_fs_dirent_t *dirent;
-      char *str;
+      /* We must be in incremental mode */
+      assert(b->hash);
+      apr_hash_set(b->hash, entry->key, entry->keylen, NULL);
+      return SVN_NO_ERROR;
+    }
 
-      svn_pool_clear(iterpool);
-      SVN_ERR_W(svn_hash__read_entry(&entry, stream, terminator,
-                                     incremental, iterpool),
-                apr_psprintf(iterpool,
-                             _("Directory representation corrupt in '%s'"),
-                             svn_fs_fs__id_unparse(id, scratch_pool)->data));
-
-      /* End of directory? */
-      if (entry.key == NULL)
-        {
-          /* In incremental mode, we skip the terminator and read the
-             increments following it until the end of the stream. */
-          if (incremental && terminator)
-            terminator = NULL;
-          else
-            break;
-        }
+  /* Add a new directory entry. */
+  dirent = apr_pcalloc(b->result_pool, sizeof(*dirent));
+  dirent->name = apr_pstrmemdup(b->result_pool, entry->key, entry->keylen);
 
-      /* Deleted entry? */
-      if (entry.val == NULL)
-        {
-          /* We must be in incremental mode */
-          assert(hash);
-          apr_hash_set(hash, entry.key, entry.keylen, NULL);
-          continue;
-        }
+  str = svn_cstring_tokenize(" ", &val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(b->id, scratch_pool)->data);
 
-      /* Add a new directory entry. */
-      dirent = apr_pcalloc(result_pool, sizeof(*dirent));
-      dirent->name = apr_pstrmemdup(result_pool, entry.key, entry.keylen);
+  if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
+    {
+      dirent->kind = svn_node_file;
+    }
+  else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
+    {
+      dirent->kind = svn_node_dir;
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(b->id, scratch_pool)->data);
+    }
 
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
+  str = svn_cstring_tokenize(" ", &val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(b->id, scratch_pool)->data);
 
-      if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
-        {
-          dirent->kind = svn_node_file;
-        }
-      else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
-        {
-          dirent->kind = svn_node_dir;
-        }
-      else
-        {
-          return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-        }
+  SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, b->result_pool));
 
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
+  /* In incremental mode, update the hash; otherwise, write to the
+   * final array.  Be sure to use hash keys that survive the buffer.
+   */
+  if (b->hash)
+    apr_hash_set(b->hash, dirent->name, entry->keylen, dirent);
+  else
+    APR_ARRAY_PUSH(b->entries, svn_fs_dirent_t *) = dirent;
 
-      SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, result_pool));
+  return SVN_NO_ERROR;
+}
 
-      /* In incremental mode, update the hash; otherwise, write to the
-       * final array.  Be sure to use hash keys that survive this iteration.
-       */
-      if (incremental)
-        apr_hash_set(hash, dirent->name, entry.keylen, dirent);
-      else
-        APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = dirent;
-    }
+/* Into *ENTRIES_P, read all directories entries from the key-value text in
+ * TEXT.  If INCREMENTAL is TRUE, read until the end of TEXT and update the
+ * data.  ID is provided for nicer error messages.
+ *
+ * The entries are parsed in place, i.e. the contents of TEXT get modified.
+ */
+static svn_error_t *
+read_dir_entries(apr_array_header_t **entries_p,
+                 svn_stringbuf_t *text,
+                 svn_boolean_t incremental,
+                 const svn_fs_id_t *id,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  dir_entry_baton_t baton = { NULL };
+  char *data = text->data;
+  const char *end = text->data + text->len;
+  apr_array_header_t *entries;
+
+  baton.id = id;
+  baton.result_pool = result_pool;
+
+  /* In incremental mode, we use a temporary HASH to make updating and
+     removing entries cheaper. */
+  if (incremental)
+    baton.hash = svn_hash__make(scratch_pool);
+  else
+    baton.entries = apr_array_make(result_pool, 16,
+                                   sizeof(svn_fs_dirent_t *));
+
+  /* Read until the terminator.  In incremental mode, skip it and read the
+     increments following it until the end of TEXT. */
+  SVN_ERR_W(svn_hash__parse(&data, end, SVN_HASH_TERMINATOR, incremental,
+                            parse_dir_entry, &baton, scratch_pool),
+            apr_psprintf(scratch_pool,
+                         _("Directory representation corrupt in '%s'"),
+                         svn_fs_fs__id_unparse(id, scratch_pool)->data));
+  if (incremental)
+    SVN_ERR_W(svn_hash__parse(&data, end, NULL, TRUE,
+                              parse_dir_entry, &baton, scratch_pool),
+              apr_psprintf(scratch_pool,
+                           _("Directory representation corrupt in '%s'"),
+                           svn_fs_fs__id_unparse(id, scratch_pool)->data));
 
   /* Convert container to a sorted array. */
   if (incremental)
     {
       apr_hash_index_t *hi;
 
-      entries = apr_array_make(result_pool, apr_hash_count(hash),
+      entries = apr_array_make(result_pool, apr_hash_count(baton.hash),
                                sizeof(svn_fs_dirent_t *));
-      for (hi = apr_hash_first(iterpool, hash); hi; hi = apr_hash_next(hi))
+      for (hi = apr_hash_first(scratch_pool, baton.hash);
+           hi;
+           hi = apr_hash_next(hi))
         APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = apr_hash_this_val(hi);
     }
+  else
+    {
+      entries = baton.entries;
+    }
 
   if (!sorted(entries))
     svn_sort__array(entries, compare_dirents);
 
-  svn_pool_destroy(iterpool);
-
   *entries_p = entries;
   return SVN_NO_ERROR;
 }
@@ -2739,6 +3082,7 @@ get_dir_contents(svn_fs_fs__dir_data_t *dir,
                  apr_pool_t *scratch_pool)
 {
   svn_stream_t *contents;
+  svn_stringbuf_t *text;
 
   /* Initialize the result. */
   dir->txn_filesize = SVN_INVALID_FILESIZE;
@@ -2759,13 +3103,14 @@ get_dir_contents(svn_fs_fs__dir_data_t *dir,
       SVN_ERR(svn_io_file_open(&file, filename, APR_READ | APR_BUFFERED,
                                APR_OS_DEFAULT, scratch_pool));
 
-      /* Obtain txn children file size. */
-      SVN_ERR(svn_io_file_size_get(&dir->txn_filesize, file, scratch_pool));
+      /* Read the whole file and parse it in memory.  Its size is what
+         we actually read, i.e. the state that our entries reflect. */
+      SVN_ERR(svn_stringbuf_from_aprfile(&text, file, scratch_pool));
+      SVN_ERR(svn_io_file_close(file, scratch_pool));
+      dir->txn_filesize = text->len;
 
-      contents = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
-      SVN_ERR(read_dir_entries(&dir->entries, contents, TRUE, noderev->id,
+      SVN_ERR(read_dir_entries(&dir->entries, text, TRUE, noderev->id,
                                result_pool, scratch_pool));
-      SVN_ERR(svn_stream_close(contents));
     }
   else if (noderev->data_rep)
     {
@@ -2773,7 +3118,6 @@ get_dir_contents(svn_fs_fs__dir_data_t *dir,
        * parse it byte-by-byte.
        */
       apr_size_t len = noderev->data_rep->expanded_size;
-      svn_stringbuf_t *text;
 
       /* The representation is immutable.  Read it normally. */
       SVN_ERR(svn_fs_fs__get_contents(&contents, fs, noderev->data_rep,
@@ -2782,8 +3126,7 @@ get_dir_contents(svn_fs_fs__dir_data_t *dir,
       SVN_ERR(svn_stream_close(contents));
 
       /* de-serialize hash */
-      contents = svn_stream_from_stringbuf(text, scratch_pool);
-      SVN_ERR(read_dir_entries(&dir->entries, contents, FALSE, noderev->id,
+      SVN_ERR(read_dir_entries(&dir->entries, text, FALSE, noderev->id,
                                result_pool, scratch_pool));
     }
   else
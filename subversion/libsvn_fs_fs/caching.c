@@ -276,6 +276,19 @@ init_callbacks(svn_cache__t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Return the name under which to collect the access statistics of the
+ * cache with the key PREFIX, i.e. its type without the repository or
+ * transaction specific parts.  Allocate the result in POOL.
+ */
+static const char *
+metrics_name(const char *prefix,
+             apr_pool_t *pool)
+{
+  const char *type = strrchr(prefix, ':');
+
+  return apr_pstrcat(pool, "fsfs:", type ? type + 1 : prefix, SVN_VA_NULL);
+}
+
 /* Sets *CACHE_P to cache instance based on provided options.
  * Creates memcache if MEMCACHE is not NULL. Creates membuffer cache if
  * MEMBUFFER is not NULL. Fallbacks to inprocess cache if MEMCACHE and
@@ -343,6 +356,12 @@ create_cache(svn_cache__t **cache_p,
 
   SVN_ERR(init_callbacks(*cache_p, fs, error_handler, result_pool));
 
+  /* Collect access statistics per type of cache. */
+  if (*cache_p)
+    SVN_ERR(svn_cache__enable_metrics(*cache_p,
+                                      metrics_name(prefix, scratch_pool),
+                                      scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -33,9 +33,11 @@
 #include "svn_config.h"
 #include "private/svn_atomic.h"
 #include "private/svn_cache.h"
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
 
 #include "rev_file.h"
 
@@ -78,6 +80,7 @@ extern "C" {
                                                     to-log index */
 /* If you change this, look at tests/svn_test_fs.c(maybe_install_fsfs_conf) */
 #define PATH_CONFIG           "fsfs.conf"        /* Configuration */
+#define PATH_ZSTD_DICT        "zstd-dict"        /* Zstandard dictionary */
 
 /* Names of special files and file extensions for transactions */
 #define PATH_CHANGES       "changes"       /* Records changes made so far */
@@ -119,6 +122,9 @@ extern "C" {
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
 #define CONFIG_OPTION_COMPRESSION        "compression"
+#define CONFIG_OPTION_DELTA_ENGINE       "delta-engine"
+#define CONFIG_OPTION_COMPRESSION_THREADS "compression-threads"
+#define CONFIG_OPTION_ZSTD_DICT_ID       "zstd-dictionary-id"
 
 /* The format number of this filesystem.
    This is independent of the repository format number, and
@@ -127,7 +133,7 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   8
+#define SVN_FS_FS__FORMAT_NUMBER   9
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -200,6 +206,14 @@ extern "C" {
     database. */
 #define SVN_FS_FS__MIN_REP_CACHE_SCHEMA_V2_FORMAT 8
 
+/* The minimum format number that supports svndiff version 3. */
+#define SVN_FS_FS__MIN_SVNDIFF3_FORMAT 9
+
+/* The minimum format number that supports delta windows whose source
+   views are not aligned with the windows of their delta base, as
+   created by svn_txdelta__engine_indexed. */
+#define SVN_FS_FS__MIN_INDEXED_DELTA_FORMAT 9
+
 /* On most operating systems apr implements file locks per process, not
    per file.  On Windows apr implements the locking as per file handle
    locks, so we don't have to add our own mutex for just in-process
@@ -304,7 +318,8 @@ typedef struct window_cache_key_t
   /* The object's revision.  Use the 64 data type to prevent padding. */
   apr_int64_t revision;
 
-  /* Window number within that representation. */
+  /* Window number within that representation.  The combined window
+     cache uses negative numbers for individual windows of delta bases. */
   apr_int64_t chunk_index;
 
   /* Item index of the representation */
@@ -315,7 +330,8 @@ typedef enum compression_type_t
 {
   compression_type_none,
   compression_type_zlib,
-  compression_type_lz4
+  compression_type_lz4,
+  compression_type_zstd
 } compression_type_t;
 
 /* Private (non-shared) FSFS-specific data for each svn_fs_t object.
@@ -496,9 +512,23 @@ typedef struct fs_fs_data_t
   /* Compression type to use with txdelta storage format in new revs. */
   compression_type_t delta_compression_type;
 
-  /* Compression level (currently, only used with compression_type_zlib). */
+  /* Compression level (only used with compression_type_zlib and
+   * compression_type_zstd). */
   int delta_compression_level;
 
+  /* Delta algorithm to use for new representations. */
+  svn_txdelta__engine_t delta_engine;
+
+  /* Maximum number of delta windows to compress concurrently when
+   * writing new representations.  1 disables concurrent compression. */
+  apr_int64_t delta_compression_threads;
+
+  /* The repository's Zstandard dictionary as found in PATH_ZSTD_DICT.
+   * NULL if there is none.  Once present, it must never change as
+   * existing svndiff3 representations may depend on it.  Its ID has
+   * been verified against CONFIG_OPTION_ZSTD_DICT_ID. */
+  const svn__zstd_dict_t *zstd_dict;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
@@ -693,7 +693,8 @@ parse_compression_option(compression_type_t *compression_type_p,
   int level;
   svn_boolean_t is_valid = TRUE;
 
-  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 */
+  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 |
+   *               zstd | zstd-1 ... zstd-19 */
   if (strcmp(value, "none") == 0)
     {
       type = compression_type_none;
@@ -723,6 +724,25 @@ parse_compression_option(compression_type_t *compression_type_p,
       else
         is_valid = FALSE;
     }
+  else if (strncmp(value, "zstd", 4) == 0)
+    {
+      const char *p = value + 4;
+
+      type = compression_type_zstd;
+      if (*p == 0)
+        {
+          level = SVN__ZSTD_DEFAULT_LEVEL;
+        }
+      else if (*p == '-')
+        {
+          p++;
+          SVN_ERR(svn_cstring_atoi(&level, p));
+          if (level < 1 || level > SVN__ZSTD_MAX_LEVEL)
+            is_valid = FALSE;
+        }
+      else
+        is_valid = FALSE;
+    }
   else
     {
       is_valid = FALSE;
@@ -738,6 +758,81 @@ parse_compression_option(compression_type_t *compression_type_p,
   return SVN_NO_ERROR;
 }
 
+/* Set FFD->ZSTD_DICT to the Zstandard dictionary stored in the file system
+ * at FS_PATH, or to NULL if there is none or this build does not support
+ * Zstandard.  Its ID must match the one recorded in CONFIG, i.e. both
+ * must be present or absent.  FFD's compression settings must already
+ * have been read.  Allocate the dictionary in RESULT_POOL and use
+ * SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_zstd_dict(fs_fs_data_t *ffd,
+               const char *fs_path,
+               svn_config_t *config,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  svn__zstd_dict_t *dict;
+  svn_error_t *err;
+  apr_int64_t expected_id;
+  apr_uint32_t id;
+  int level;
+  const char *path = svn_dirent_join(fs_path, PATH_ZSTD_DICT, scratch_pool);
+
+  ffd->zstd_dict = NULL;
+  if (!svn__zstd_available())
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_config_get_int64(config, &expected_id,
+                               CONFIG_SECTION_DELTIFICATION,
+                               CONFIG_OPTION_ZSTD_DICT_ID, 0));
+
+  err = svn_stringbuf_from_file2(&contents, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      if (expected_id)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Zstandard dictionary '%s' with ID "
+                                   "%" APR_INT64_T_FMT " is missing"),
+                                 svn_dirent_local_style(path, scratch_pool),
+                                 expected_id);
+
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* The compression level gets baked into the digested dictionary. */
+  level = ffd->delta_compression_type == compression_type_zstd
+        ? ffd->delta_compression_level
+        : SVN__ZSTD_DEFAULT_LEVEL;
+
+  SVN_ERR(svn__zstd_dict_create(&dict, contents->data, contents->len, level,
+                                result_pool));
+
+  /* Data compressed with a different dictionary can't be read anymore. */
+  id = svn__zstd_dict_id(dict);
+  if (expected_id == 0)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Zstandard dictionary '%s' has not been "
+                               "registered; set '%s = %u' in the [%s] "
+                               "section of '%s' to use it"),
+                             svn_dirent_local_style(path, scratch_pool),
+                             CONFIG_OPTION_ZSTD_DICT_ID, id,
+                             CONFIG_SECTION_DELTIFICATION, PATH_CONFIG);
+  if (expected_id != id)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Zstandard dictionary '%s' has ID %u but "
+                               "ID %" APR_INT64_T_FMT " is expected"),
+                             svn_dirent_local_style(path, scratch_pool),
+                             id, expected_id);
+
+  ffd->zstd_dict = dict;
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the configuration information of the file system at FS_PATH
  * and set the respective values in FFD.  Use pools as usual.
  */
@@ -891,6 +986,17 @@ read_config(fs_fs_data_t *ffd,
                                       _("Compression type 'lz4' requires "
                                         "filesystem format 8 or higher"));
             }
+          if (ffd->delta_compression_type == compression_type_zstd)
+            {
+              if (ffd->format < SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' requires "
+                                          "filesystem format 9 or higher"));
+              if (!svn__zstd_available())
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' is not "
+                                          "supported by this build"));
+            }
         }
       else if (compression_level_val)
         {
@@ -926,6 +1032,63 @@ read_config(fs_fs_data_t *ffd,
       ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
     }
 
+  /* Initialize the delta algorithm. */
+  if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
+    {
+      const char *engine_val;
+
+      svn_config_get(config, &engine_val, CONFIG_SECTION_DELTIFICATION,
+                     CONFIG_OPTION_DELTA_ENGINE, "xdelta");
+      if (strcmp(engine_val, "xdelta") == 0)
+        {
+          ffd->delta_engine = svn_txdelta__engine_xdelta;
+        }
+      else if (strcmp(engine_val, "indexed") == 0)
+        {
+          if (ffd->format < SVN_FS_FS__MIN_INDEXED_DELTA_FORMAT)
+            return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                    _("Delta engine 'indexed' requires "
+                                      "filesystem format 9 or higher"));
+
+          ffd->delta_engine = svn_txdelta__engine_indexed;
+        }
+      else
+        {
+          return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                   _("Invalid 'delta-engine' value '%s' "
+                                     "in the config"),
+                                   engine_val);
+        }
+    }
+  else
+    {
+      ffd->delta_engine = svn_txdelta__engine_xdelta;
+    }
+
+  /* Initialize the number of compression threads. */
+  if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
+    {
+      SVN_ERR(svn_config_get_int64(config, &ffd->delta_compression_threads,
+                                   CONFIG_SECTION_DELTIFICATION,
+                                   CONFIG_OPTION_COMPRESSION_THREADS,
+                                   1));
+      if (ffd->delta_compression_threads < 1)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("Invalid 'compression-threads' value "
+                                   "'%" APR_INT64_T_FMT "' in the config"),
+                                 ffd->delta_compression_threads);
+    }
+  else
+    {
+      ffd->delta_compression_threads = 1;
+    }
+
+  /* Representations may depend on the repository's Zstandard dictionary
+   * even if we don't use Zstandard for new revisions. */
+  if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+    SVN_ERR(read_zstd_dict(ffd, fs_path, config, result_pool,
+                           scratch_pool));
+
 #ifdef SVN_DEBUG
   SVN_ERR(svn_config_get_bool(config, &ffd->verify_before_commit,
                               CONFIG_SECTION_DEBUG,
@@ -1059,27 +1222,66 @@ write_config(svn_fs_t *fs,
 "### After deltification, we compress the data to minimize on-disk size."    NL
 "### This setting controls the compression algorithm, which will be used in" NL
 "### future revisions.  It can be used to either disable compression or to"  NL
-"### select between available algorithms (zlib, lz4).  zlib is a general-"   NL
-"### purpose compression algorithm.  lz4 is a fast compression algorithm"    NL
-"### which should be preferred for repositories with large and, possibly,"   NL
-"### incompressible files.  Note that the compression ratio of lz4 is"       NL
-"### usually lower than the one provided by zlib, but using it can"          NL
+"### select between available algorithms (zlib, lz4, zstd).  zlib is a"      NL
+"### general-purpose compression algorithm.  lz4 is a fast compression"      NL
+"### algorithm which should be preferred for repositories with large and,"   NL
+"### possibly, incompressible files.  Note that the compression ratio of"    NL
+"### lz4 is usually lower than the one provided by zlib, but using it can"   NL
 "### significantly speed up commits as well as reading the data."            NL
 "### lz4 compression algorithm is supported, starting from format 8"         NL
 "### repositories, available in Subversion 1.10 and higher."                 NL
+"### zstd (Zstandard) usually compresses better than zlib at a speed close" NL
+"### to lz4.  It is supported, starting from format 9 repositories,"         NL
+"### available in Subversion 1.15 and higher, if Subversion has been built"  NL
+"### with Zstandard support.  If the file '" PATH_ZSTD_DICT "' exists in the"   NL
+"### repository's db directory, it will be used as Zstandard dictionary."    NL
+"### Such a dictionary may be trained with e.g. 'zstd --train' on typical"   NL
+"### file contents.  Its ID must be registered with the"                     NL
+"### '" CONFIG_OPTION_ZSTD_DICT_ID "' option below."                         NL
 "### The syntax of this option is:"                                          NL
-"###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9" NL
+"###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9 |" NL
+"###                 zstd | zstd-1 ... zstd-19"                              NL
 "### Versions prior to Subversion 1.10 will ignore this option."             NL
 "### The default value is 'lz4' if supported by the repository format and"   NL
-"### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5'."         NL
+"### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5' and"      NL
+"### 'zstd' is equivalent to 'zstd-3'."                                      NL
 "# " CONFIG_OPTION_COMPRESSION " = lz4"                                      NL
 "###"                                                                        NL
+"### This setting registers the ID of the Zstandard dictionary in the file"  NL
+"### '" PATH_ZSTD_DICT "'.  The repository can't be opened if that file is"  NL
+"### present but not registered, missing although registered or has a"      NL
+"### different ID.  Once revisions have been written with the dictionary,"  NL
+"### neither the file nor this setting must be changed.  The default value"  NL
+"### is 0, i.e. no dictionary."                                              NL
+"# " CONFIG_OPTION_ZSTD_DICT_ID " = 0"                                       NL
+"###"                                                                        NL
 "### DEPRECATED: The new '" CONFIG_OPTION_COMPRESSION "' option deprecates previously used" NL
 "### '" CONFIG_OPTION_COMPRESSION_LEVEL "' option, which was used to configure zlib compression." NL
 "### For compatibility with previous versions of Subversion, this option can"NL
 "### still be used (and it will result in zlib compression with the"         NL
 "### corresponding compression level)."                                      NL
 "###   " CONFIG_OPTION_COMPRESSION_LEVEL " = 0 ... 9 (default is 5)"         NL
+"###"                                                                        NL
+"### This setting selects the algorithm that computes the deltas.  'xdelta'" NL
+"### compares each 100 kBytes of new contents with the same range of the"    NL
+"### delta base.  'indexed' indexes the whole delta base and compares the"   NL
+"### new contents with the range of the base that matches them best.  This"  NL
+"### produces much smaller deltas for large files where data has been"       NL
+"### inserted, removed or moved around.  However, it needs to keep the"      NL
+"### whole delta base in memory while writing the new representation and"    NL
+"### reading such deltas may need to reconstruct their base separately."     NL
+"### The 'indexed' engine requires format 9 repositories, available in"      NL
+"### Subversion 1.15 and higher.  The default value is 'xdelta'."            NL
+"# " CONFIG_OPTION_DELTA_ENGINE " = xdelta"                                  NL
+"###"                                                                        NL
+"### Compressing the deltas may take more time than computing them.  This"   NL
+"### setting allows to compress up to the given number of delta windows"     NL
+"### (100 kBytes each) concurrently while writing new representations."      NL
+"### Larger values speed up commits and 'svnadmin load' of large files on"   NL
+"### multi-core servers but use more memory.  The data written to the"       NL
+"### repository will be the same.  Uncompressed deltas are not affected."    NL
+"### The default value is 1, i.e. compression is not parallelized."          NL
+"# " CONFIG_OPTION_COMPRESSION_THREADS " = 1"                                NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1952,6 +2154,13 @@ svn_fs_fs__create(svn_fs_t *fs,
           case 9: format = 7;
                   break;
 
+          case 10:
+          case 11:
+          case 12:
+          case 13:
+          case 14: format = 8;
+                  break;
+
           default:format = SVN_FS_FS__FORMAT_NUMBER;
         }
 
@@ -2323,8 +2532,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 8:
       (*supports_version)->minor = 10;
       break;
+    case 9:
+      (*supports_version)->minor = 15;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 8
+# if SVN_FS_FS__FORMAT_NUMBER != 9
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
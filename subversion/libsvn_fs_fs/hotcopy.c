@@ -510,6 +510,45 @@ hotcopy_incremental_check_preconditions(svn_fs_t *src_fs,
   return SVN_NO_ERROR;
 }
 
+/* Copy the Zstandard dictionary of SRC_FS, if any, to DST_FS.  Refuse to
+ * replace a different dictionary that DST_FS already has because its
+ * revisions may depend on it.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+hotcopy_zstd_dict(svn_fs_t *src_fs,
+                  svn_fs_t *dst_fs,
+                  apr_pool_t *pool)
+{
+  const char *src_path = svn_dirent_join(src_fs->path, PATH_ZSTD_DICT, pool);
+  const char *dst_path = svn_dirent_join(dst_fs->path, PATH_ZSTD_DICT, pool);
+  svn_node_kind_t src_kind;
+  svn_node_kind_t dst_kind;
+  svn_boolean_t same = FALSE;
+
+  SVN_ERR(svn_io_check_path(src_path, &src_kind, pool));
+  SVN_ERR(svn_io_check_path(dst_path, &dst_kind, pool));
+
+  if (dst_kind == svn_node_none)
+    {
+      if (src_kind != svn_node_none)
+        SVN_ERR(svn_io_copy_file(src_path, dst_path, TRUE, pool));
+
+      return SVN_NO_ERROR;
+    }
+
+  if (src_kind != svn_node_none)
+    SVN_ERR(svn_io_files_contents_same_p(&same, src_path, dst_path, pool));
+
+  if (!same)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("The Zstandard dictionary '%s' of the hotcopy "
+                               "destination differs from the one of the "
+                               "hotcopy source and won't be overwritten"),
+                             svn_dirent_local_style(dst_path, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Remove folder PATH.  Ignore errors due to the sub-tree not being empty.
  * CANCEL_FUNC and CANCEL_BATON do the usual thing.
  * Use POOL for temporary allocations.
@@ -829,6 +868,13 @@ hotcopy_body(void *baton, apr_pool_t *pool)
   const char *dst_subdir;
   svn_node_kind_t kind;
 
+  /* Revisions may depend on the Zstandard dictionary, so copy it before
+   * them.  Do that even before the config, which records its ID, such
+   * that we won't touch a destination that has a different dictionary.
+   * Most repositories don't have one. */
+  if (src_ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+    SVN_ERR(hotcopy_zstd_dict(src_fs, dst_fs, pool));
+
   /* Try to copy the config.
    *
    * ### We try copying the config file before doing anything else,
@@ -625,23 +625,6 @@ copy_rep_to_temp(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
-/* Directories first, dirs / files sorted by name in reverse lexical order.
- * This maximizes the chance of two items being located close to one another
- * in *all* pack files independent of their change order.  It also groups
- * multi-project repos nicely according to their sub-projects.  The reverse
- * order aspect gives "trunk" preference over "tags" and "branches", so
- * trunk-related items are more likely to be contiguous.
- */
-static int
-compare_dir_entries_format7(const svn_sort__item_t *a,
-                            const svn_sort__item_t *b)
-{
-  const svn_fs_dirent_t *lhs = (const svn_fs_dirent_t *) a->value;
-  const svn_fs_dirent_t *rhs = (const svn_fs_dirent_t *) b->value;
-
-  return strcmp(lhs->name, rhs->name);
-}
-
 /* Directories entries sorted by revision (decreasing - to max cache hits)
  * and offset (increasing - to max benefit from APR file buffering).
  */
@@ -674,10 +657,16 @@ svn_fs_fs__order_dir_entries(svn_fs_t *fs,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool)
 {
+  /* With logical addressing, directories entries are sorted by name.
+   * This maximizes the chance of two items being located close to one
+   * another in *all* pack files independent of their change order.  It
+   * also groups multi-project repos nicely according to their
+   * sub-projects.  The hash keys are the entry names, so we can use the
+   * fast standard ordering on them. */
   apr_array_header_t *ordered
     = svn_sort__hash(directory,
                      svn_fs_fs__use_log_addressing(fs)
-                       ? compare_dir_entries_format7
+                       ? svn_sort_compare_items_lexically
                        : compare_dir_entries_format6,
                      scratch_pool);
 
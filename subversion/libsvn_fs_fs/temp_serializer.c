@@ -37,6 +37,8 @@
 #include "low_level.h"
 #include "cached_data.h"
 
+#include "svn_private_config.h"
+
 /* Utility to encode a signed NUMBER into a variable-length sequence of
  * 8-bit chars in KEY_BUFFER and return the last written position.
  *
@@ -881,16 +883,47 @@ svn_fs_fs__extract_dir_filesize(void **out,
   return SVN_NO_ERROR;
 }
 
-/* Utility function that returns the lowest index of the first entry in
- * *ENTRIES that points to a dir entry with a name equal or larger than NAME.
- * If an exact match has been found, *FOUND will be set to TRUE. COUNT is
- * the number of valid entries in ENTRIES.
+/* Set *NAME to the name of the dir entry at index IDX in the serialized
+ * ENTRIES array, which is accessed in place through VIEW.  Return
+ * SVN_ERR_FS_CORRUPT if the entry does not resolve to a valid location
+ * within VIEW.
  */
-static apr_size_t
-find_entry(svn_fs_dirent_t **entries,
+static svn_error_t *
+get_entry_name(const char **name,
+               const svn_temp_deserializer__view_t *view,
+               svn_fs_dirent_t **entries,
+               apr_size_t idx)
+{
+  const svn_fs_dirent_t *entry
+    = svn_temp_deserializer__view_ptr(view, entries,
+                                      (const void *const *)&entries[idx],
+                                      sizeof(*entry));
+  *name = entry ? svn_temp_deserializer__view_string(view, entry,
+                                                     &entry->name)
+                : NULL;
+  if (*name == NULL)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Invalid directory entry in cache"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Utility function that sets *POS to the lowest index of the first entry
+ * in *ENTRIES that points to a dir entry with a name equal or larger than
+ * NAME.  If an exact match has been found, *FOUND will be set to TRUE.
+ * COUNT is the number of valid entries in ENTRIES.
+ *
+ * ENTRIES is accessed in place through VIEW, i.e. neither the entries nor
+ * their names get copied.  Return SVN_ERR_FS_CORRUPT if an entry does not
+ * resolve to a valid location within VIEW.
+ */
+static svn_error_t *
+find_entry(apr_size_t *pos,
+           svn_boolean_t *found,
+           const svn_temp_deserializer__view_t *view,
+           svn_fs_dirent_t **entries,
            const char *name,
-           apr_size_t count,
-           svn_boolean_t *found)
+           apr_size_t count)
 {
   /* binary search for the desired entry by name */
   apr_size_t lower = 0;
@@ -899,13 +932,10 @@ find_entry(svn_fs_dirent_t **entries,
 
   for (middle = upper / 2; lower < upper; middle = (upper + lower) / 2)
     {
-      const svn_fs_dirent_t *entry =
-          svn_temp_deserializer__ptr(entries, (const void *const *)&entries[middle]);
-      const char* entry_name =
-          svn_temp_deserializer__ptr(entry, (const void *const *)&entry->name);
+      const char *entry_name;
+      SVN_ERR(get_entry_name(&entry_name, view, entries, middle));
 
-      int diff = strcmp(entry_name, name);
-      if (diff < 0)
+      if (strcmp(entry_name, name) < 0)
         lower = middle + 1;
       else
         upper = middle;
@@ -915,16 +945,15 @@ find_entry(svn_fs_dirent_t **entries,
   *found = FALSE;
   if (lower < count)
     {
-      const svn_fs_dirent_t *entry =
-          svn_temp_deserializer__ptr(entries, (const void *const *)&entries[lower]);
-      const char* entry_name =
-          svn_temp_deserializer__ptr(entry, (const void *const *)&entry->name);
+      const char *entry_name;
+      SVN_ERR(get_entry_name(&entry_name, view, entries, lower));
 
       if (strcmp(entry_name, name) == 0)
         *found = TRUE;
     }
 
-  return lower;
+  *pos = lower;
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -936,43 +965,70 @@ svn_fs_fs__extract_dir_entry(void **out,
 {
   const dir_data_t *dir_data = data;
   extract_dir_entry_baton_t *entry_baton = baton;
+  svn_temp_deserializer__view_t view;
+  const svn_fs_dirent_t * const *entries;
+  const apr_uint32_t *lengths;
   svn_boolean_t found;
+  apr_size_t pos;
 
-  /* resolve the reference to the entries array */
-  const svn_fs_dirent_t * const *entries =
-    svn_temp_deserializer__ptr(data, (const void *const *)&dir_data->entries);
-
-  /* resolve the reference to the lengths array */
-  const apr_uint32_t *lengths =
-    svn_temp_deserializer__ptr(data, (const void *const *)&dir_data->lengths);
-
-  /* binary search for the desired entry by name */
-  apr_size_t pos = find_entry((svn_fs_dirent_t **)entries,
-                              entry_baton->name,
-                              dir_data->count,
-                              &found);
-
-  /* de-serialize that entry or return NULL, if no match has been found.
-   * Be sure to check that the directory contents is still up-to-date. */
+  /* Check that the directory contents is still up-to-date before doing
+   * any actual work. */
+  *out = NULL;
   entry_baton->out_of_date
     = dir_data->txn_filesize != entry_baton->txn_filesize;
+  if (entry_baton->out_of_date)
+    return SVN_NO_ERROR;
+
+  /* Access the serialized directory in place.  Only the entry that we
+   * are looking for will be copied -- if it exists. */
+  svn_temp_deserializer__view_init(&view, data, data_len);
+
+  /* resolve the reference to the entries and lengths arrays */
+  entries = svn_temp_deserializer__view_ptr(&view, dir_data,
+                                    (const void *const *)&dir_data->entries,
+                                    dir_data->count * sizeof(*entries));
+  lengths = svn_temp_deserializer__view_ptr(&view, dir_data,
+                                    (const void *const *)&dir_data->lengths,
+                                    dir_data->count * sizeof(*lengths));
+  if (dir_data->count && (entries == NULL || lengths == NULL))
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Invalid directory index in cache"));
 
-  *out = NULL;
-  if (found && !entry_baton->out_of_date)
-    {
-      const svn_fs_dirent_t *source =
-          svn_temp_deserializer__ptr(entries, (const void *const *)&entries[pos]);
+  /* binary search for the desired entry by name */
+  SVN_ERR(find_entry(&pos, &found, &view, (svn_fs_dirent_t **)entries,
+                     entry_baton->name, dir_data->count));
 
+  /* de-serialize that entry or return NULL, if no match has been found. */
+  if (found)
+    {
       /* Entries have been serialized one-by-one, each time including all
        * nested structures and strings. Therefore, they occupy a single
        * block of memory whose end-offset is either the beginning of the
        * next entry or the end of the buffer
        */
       apr_size_t size = lengths[pos];
-
-      /* copy & deserialize the entry */
-      svn_fs_dirent_t *new_entry = apr_pmemdup(pool, source, size);
-
+      const svn_fs_dirent_t *source
+        = svn_temp_deserializer__view_ptr(&view, entries,
+                                          (const void *const *)&entries[pos],
+                                          size);
+      svn_temp_deserializer__view_t entry_view;
+      svn_fs_dirent_t *new_entry;
+      if (source == NULL || size < sizeof(*source))
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Invalid directory entry in cache"));
+
+      /* Copy the entry.  Its sub-structures must be part of that copy. */
+      new_entry = apr_pmemdup(pool, source, size);
+      svn_temp_deserializer__view_init(&entry_view, new_entry, size);
+      if (   !svn_temp_deserializer__view_string(&entry_view, new_entry,
+                                                 &new_entry->name)
+          || !svn_temp_deserializer__view_ptr(&entry_view, new_entry,
+                                        (const void *const *)&new_entry->id,
+                                        sizeof(*new_entry->id)))
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Invalid directory entry in cache"));
+
+      /* deserialize the copy */
       svn_temp_deserializer__resolve(new_entry, (void **)&new_entry->name);
       svn_fs_fs__id_deserialize(new_entry, (svn_fs_id_t **)&new_entry->id);
       *(svn_fs_dirent_t **)out = new_entry;
@@ -1038,6 +1094,7 @@ svn_fs_fs__replace_dir_entry(void **data,
   apr_uint32_t *lengths;
   apr_uint32_t length;
   apr_size_t pos;
+  svn_temp_deserializer__view_t view;
 
   svn_temp_serializer__context_t *context;
 
@@ -1064,7 +1121,9 @@ svn_fs_fs__replace_dir_entry(void **data,
                                (const void *const *)&dir_data->lengths);
 
   /* binary search for the desired entry by name */
-  pos = find_entry(entries, replace_baton->name, dir_data->count, &found);
+  svn_temp_deserializer__view_init(&view, dir_data, dir_data->len);
+  SVN_ERR(find_entry(&pos, &found, &view, entries, replace_baton->name,
+                     dir_data->count));
 
   /* handle entry removal (if found at all) */
   if (replace_baton->new_entry == NULL)
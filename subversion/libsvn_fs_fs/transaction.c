@@ -43,6 +43,7 @@
 #include "lock.h"
 #include "rep-cache.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -1958,8 +1959,8 @@ rep_write_contents(void *baton,
 {
   struct rep_write_baton *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum__update_pair(b->md5_checksum_ctx,
+                                    b->sha1_checksum_ctx, data, *len));
   b->rep_size += *len;
 
   /* If we are writing a delta, use that stream. */
@@ -2169,7 +2170,12 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
   fs_fs_data_t *ffd = fs->fsap_data;
   int svndiff_version;
 
-  if (ffd->delta_compression_type == compression_type_lz4)
+  if (ffd->delta_compression_type == compression_type_zstd)
+    {
+      SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT);
+      svndiff_version = 3;
+    }
+  else if (ffd->delta_compression_type == compression_type_lz4)
     {
       SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
       svndiff_version = 2;
@@ -2184,8 +2190,13 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
       svndiff_version = 0;
     }
 
-  svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
-                          ffd->delta_compression_level, pool);
+  svn_txdelta__to_svndiff_parallel(handler, handler_baton, output,
+                                   svndiff_version,
+                                   ffd->delta_compression_level,
+                                   ffd->zstd_dict,
+                                   (int)MIN(ffd->delta_compression_threads,
+                                            APR_INT32_MAX),
+                                   pool);
 }
 
 /* Get a rep_write_baton and store it in *WB_P for the representation
@@ -2198,6 +2209,7 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                     node_revision_t *noderev,
                     apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   struct rep_write_baton *b;
   apr_file_t *file;
   representation_t *base_rep;
@@ -2261,8 +2273,9 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   /* Prepare to write the svndiff data. */
   txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+  b->delta_stream = svn_txdelta__target_push(wh, whb, source,
+                                             ffd->delta_engine,
+                                             b->scratch_pool);
 
   *wb_p = b;
 
@@ -2729,9 +2742,8 @@ write_container_handler(void *baton,
 {
   struct write_container_baton *whb = baton;
 
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  if (whb->sha1_ctx)
-    SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  SVN_ERR(svn_checksum__update_pair(whb->md5_ctx, whb->sha1_ctx, data,
+                                    *len));
 
   SVN_ERR(svn_stream_write(whb->stream, data, len));
   whb->size += *len;
@@ -2900,6 +2912,7 @@ write_container_delta_rep(representation_t *rep,
                           apr_uint32_t item_type,
                           apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   svn_txdelta_window_handler_t diff_wh;
   void *diff_whb;
 
@@ -2950,8 +2963,8 @@ write_container_delta_rep(representation_t *rep,
   txdelta_to_svndiff(&diff_wh, &diff_whb, file_stream, fs, scratch_pool);
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-  whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
-                                        scratch_pool);
+  whb->stream = svn_txdelta__target_push(diff_wh, diff_whb, source,
+                                         ffd->delta_engine, scratch_pool);
   whb->size = 0;
   whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
   if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
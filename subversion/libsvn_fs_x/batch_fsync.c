@@ -20,82 +20,16 @@
  * ====================================================================
  */
 
-#include <apr_thread_pool.h>
-#include <apr_thread_cond.h>
-
 #include "batch_fsync.h"
 #include "svn_pools.h"
 #include "svn_hash.h"
 #include "svn_dirent_uri.h"
 #include "svn_private_config.h"
 
-#include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 
-/* Handy macro to check APR function results and turning them into
- * svn_error_t upon failure. */
-#define WRAP_APR_ERR(x,msg)                     \
-  {                                             \
-    apr_status_t status_ = (x);                 \
-    if (status_)                                \
-      return svn_error_wrap_apr(status_, msg);  \
-  }
-
-
-/* A simple SVN-wrapper around the apr_thread_cond_* API */
-#if APR_HAS_THREADS
-typedef apr_thread_cond_t svn_thread_cond__t;
-#else
-typedef int svn_thread_cond__t;
-#endif
-
-static svn_error_t *
-svn_thread_cond__create(svn_thread_cond__t **cond,
-                        apr_pool_t *result_pool)
-{
-#if APR_HAS_THREADS
-
-  WRAP_APR_ERR(apr_thread_cond_create(cond, result_pool),
-               _("Can't create condition variable"));
-
-#else
-
-  *cond = apr_pcalloc(result_pool, sizeof(**cond));
-
-#endif
-
-  return SVN_NO_ERROR;
-}
-
-static svn_error_t *
-svn_thread_cond__broadcast(svn_thread_cond__t *cond)
-{
-#if APR_HAS_THREADS
-
-  WRAP_APR_ERR(apr_thread_cond_broadcast(cond),
-               _("Can't broadcast condition variable"));
-
-#endif
-
-  return SVN_NO_ERROR;
-}
-
-static svn_error_t *
-svn_thread_cond__wait(svn_thread_cond__t *cond,
-                      svn_mutex__t *mutex)
-{
-#if APR_HAS_THREADS
-
-  WRAP_APR_ERR(apr_thread_cond_wait(cond, svn_mutex__get(mutex)),
-               _("Can't broadcast condition variable"));
-
-#endif
-
-  return SVN_NO_ERROR;
-}
-
 /* Utility construct:  Clients can efficiently wait for the encapsulated
  * counter to reach a certain value.  Currently, only increments have been
  * implemented.  This whole structure can be opaque to the API users.
@@ -209,96 +143,15 @@ struct svn_fs_x__batch_fsync_t
   svn_boolean_t flush_to_disk;
 };
 
-/* Data structures for concurrent fsync execution are only available if
- * we have threading support.
- */
-#if APR_HAS_THREADS
-
-/* Number of microseconds that an unused thread remains in the pool before
- * being terminated.
- *
- * Higher values are useful if clients frequently send small requests and
- * you want to minimize the latency for those.
- */
-#define THREADPOOL_THREAD_IDLE_LIMIT 1000000
-
-/* Maximum number of threads in THREAD_POOL, i.e. number of paths we can
- * fsync concurrently throughout the process. */
-#define MAX_THREADS 16
-
-/* Thread pool to execute the fsync tasks. */
-static apr_thread_pool_t *thread_pool = NULL;
-
-#endif
-
-/* Keep track on whether we already created the THREAD_POOL . */
-static svn_atomic_t thread_pool_initialized = FALSE;
-
 /* We open non-directory files with these flags. */
 #define FILE_FLAGS (APR_READ | APR_WRITE | APR_BUFFERED | APR_CREATE)
 
-#if APR_HAS_THREADS
-
-/* Destructor function that implicitly cleans up any running threads
-   in the TRHEAD_POOL *once*.
-
-   Must be run as a pre-cleanup hook.
- */
-static apr_status_t
-thread_pool_pre_cleanup(void *data)
-{
-  apr_thread_pool_t *tp = thread_pool;
-  if (!thread_pool)
-    return APR_SUCCESS;
-
-  thread_pool = NULL;
-  thread_pool_initialized = FALSE;
-
-  return apr_thread_pool_destroy(tp);
-}
-
-#endif
-
-/* Core implementation of svn_fs_x__batch_fsync_init. */
-static svn_error_t *
-create_thread_pool(void *baton,
-                   apr_pool_t *owning_pool)
-{
-#if APR_HAS_THREADS
-  /* The thread-pool must be allocated from a thread-safe pool.
-     GLOBAL_POOL may be single-threaded, though. */
-  apr_pool_t *pool = svn_pool_create(NULL);
-
-  /* This thread pool will get cleaned up automatically when GLOBAL_POOL
-     gets cleared.  No additional cleanup callback is needed. */
-  WRAP_APR_ERR(apr_thread_pool_create(&thread_pool, 0, MAX_THREADS, pool),
-               _("Can't create fsync thread pool in FSX"));
-
-  /* Work around an APR bug:  The cleanup must happen in the pre-cleanup
-     hook instead of the normal cleanup hook.  Otherwise, the sub-pools
-     containing the thread objects would already be invalid. */
-  apr_pool_pre_cleanup_register(pool, NULL, thread_pool_pre_cleanup);
-  apr_pool_pre_cleanup_register(owning_pool, NULL, thread_pool_pre_cleanup);
-
-  /* let idle threads linger for a while in case more requests are
-     coming in */
-  apr_thread_pool_idle_wait_set(thread_pool, THREADPOOL_THREAD_IDLE_LIMIT);
-
-  /* don't queue requests unless we reached the worker thread limit */
-  apr_thread_pool_threshold_set(thread_pool, 0);
-
-#endif
-
-  return SVN_NO_ERROR;
-}
-
 svn_error_t *
 svn_fs_x__batch_fsync_init(apr_pool_t *owning_pool)
 {
-  /* Protect against multiple calls. */
-  return svn_error_trace(svn_atomic__init_once(&thread_pool_initialized,
-                                               create_thread_pool,
-                                               NULL, owning_pool));
+  /* The fsync tasks run in the process-wide worker pool provided by
+   * svn_thread_pool__push(), which gets created upon first use. */
+  return SVN_NO_ERROR;
 }
 
 /* Destructor for svn_fs_x__batch_fsync_t.  Releases all global pool memory
@@ -531,21 +384,13 @@ svn_fs_x__batch_fsync_run(svn_fs_x__batch_fsync_t *batch,
 
 #if APR_HAS_THREADS
 
-          /* Forgot to call _init() or cleaned up the owning pool too early?
-           */
-          SVN_ERR_ASSERT(thread_pool);
-
           /* If there are multiple fsyncs to perform, run them in parallel.
            * Otherwise, skip the thread-pool and synchronization overhead. */
           if (apr_hash_count(batch->files) > 1)
             {
-              apr_status_t status = APR_SUCCESS;
-              status = apr_thread_pool_push(thread_pool, flush_task, to_sync,
-                                            0, NULL);
-              if (status)
-                to_sync->result = svn_error_wrap_apr(status,
-                                                     _("Can't push task"));
-              else
+              to_sync->result = svn_thread_pool__push(flush_task, to_sync,
+                                                      NULL, scratch_pool);
+              if (!to_sync->result)
                 tasks++;
             }
           else
@@ -44,8 +44,9 @@
  */
 typedef struct svn_fs_x__batch_fsync_t svn_fs_x__batch_fsync_t;
 
-/* Initialize the concurrent fsync infrastructure.  Clean it up when
- * OWNING_POOL gets cleared.
+/* Initialize the concurrent fsync infrastructure.  OWNING_POOL is
+ * currently unused because the fsync tasks run in the process-wide
+ * worker pool that libsvn_subr creates upon first use.
  *
  * This function must be called before using any of the other functions in
  * in this module.  It should only be called once.
@@ -347,6 +347,7 @@ svn_fs_x__read_changes_container(svn_fs_x__changes_t **changes_p,
 {
   apr_size_t i;
   apr_size_t count;
+  apr_uint64_t *offsets;
 
   svn_fs_x__changes_t *changes = apr_pcalloc(result_pool, sizeof(*changes));
 
@@ -362,12 +363,15 @@ svn_fs_x__read_changes_container(svn_fs_x__changes_t **changes_p,
   offsets_stream = svn_packed__first_int_stream(root);
   changes_stream = svn_packed__next_int_stream(offsets_stream);
 
-  /* read offsets array */
+  /* read offsets array; there are no sub-streams to interleave */
   count = svn_packed__int_count(offsets_stream);
+  offsets = apr_palloc(scratch_pool, count * sizeof(*offsets));
+  if (svn_packed__get_uints(offsets_stream, offsets, count) != count)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Truncated offsets in changes container"));
   changes->offsets = apr_array_make(result_pool, (int)count, sizeof(int));
   for (i = 0; i < count; ++i)
-    APR_ARRAY_PUSH(changes->offsets, int)
-      = (int)svn_packed__get_uint(offsets_stream);
+    APR_ARRAY_PUSH(changes->offsets, int) = (int)offsets[i];
 
   /* read changes array */
   count
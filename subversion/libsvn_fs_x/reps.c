@@ -775,6 +775,7 @@ svn_fs_x__read_reps_container(svn_fs_x__reps_t **container,
 
   base_t *bases;
   apr_uint32_t *first_instructions;
+  apr_uint64_t *rep_values;
   instruction_t *instructions;
 
   svn_fs_x__reps_t *reps = apr_pcalloc(result_pool, sizeof(*reps));
@@ -839,9 +840,16 @@ svn_fs_x__read_reps_container(svn_fs_x__reps_t **container,
                  (reps->rep_count + 1) * sizeof(*first_instructions));
   reps->first_instructions = first_instructions;
 
+  /* REPS_STREAM has no sub-streams, so it can be read in bulk. */
+  rep_values = apr_palloc(scratch_pool,
+                          reps->rep_count * sizeof(*rep_values));
+  if (svn_packed__get_uints(reps_stream, rep_values, reps->rep_count)
+      != reps->rep_count)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Truncated representation list in reps "
+                              "container"));
   for (i = 0; i < reps->rep_count; ++i)
-    first_instructions[i]
-      = (apr_uint32_t)svn_packed__get_uint(reps_stream);
+    first_instructions[i] = (apr_uint32_t)rep_values[i];
   first_instructions[reps->rep_count] = (apr_uint32_t)reps->instruction_count;
 
   /* other elements */
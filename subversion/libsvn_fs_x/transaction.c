@@ -2031,8 +2031,8 @@ rep_write_contents(void *baton,
 {
   rep_write_baton_t *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum__update_pair(b->md5_checksum_ctx,
+                                    b->sha1_checksum_ctx, data, *len));
   b->rep_size += *len;
 
   return svn_stream_write(b->delta_stream, data, len);
@@ -2794,9 +2794,8 @@ write_container_handler(void *baton,
 {
   write_container_baton_t *whb = baton;
 
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  if (whb->sha1_ctx)
-    SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  SVN_ERR(svn_checksum__update_pair(whb->md5_ctx, whb->sha1_ctx, data,
+                                    *len));
 
   SVN_ERR(svn_stream_write(whb->stream, data, len));
   whb->size += *len;
@@ -747,7 +747,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww?w)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
@@ -756,6 +756,9 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  svn__zstd_available()
+                                    ? SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED
+                                    : NULL,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
@@ -273,13 +273,17 @@ svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
   if (svn_ra_svn_compression_level(conn) <= 0)
     return 0;
 
-  /* Prefer SVNDIFF2 over SVNDIFF1. */
+  /* Prefer SVNDIFF3 over SVNDIFF2 over SVNDIFF1.  We can only produce
+   * SVNDIFF3 if we have been built with Zstandard support. */
+  if (svn__zstd_available()
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+    return 3;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
     return 2;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
     return 1;
 
-  /* The connection does not support SVNDIFF1/2; default to "version 0". */
+  /* The connection does not support SVNDIFF1/2/3; default to "version 0". */
   return 0;
 }
 
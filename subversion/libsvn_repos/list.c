@@ -146,18 +146,6 @@ typedef struct filtered_dirent_t
   svn_boolean_t is_match;
 } filtered_dirent_t;
 
-/* Implement a standard sort function for filtered_dirent_t *, sorting them
- * by entry name. */
-static int
-compare_filtered_dirent(const void *lhs,
-                        const void *rhs)
-{
-  const filtered_dirent_t *lhs_dirent = (const filtered_dirent_t *)lhs;
-  const filtered_dirent_t *rhs_dirent = (const filtered_dirent_t *)rhs;
-
-  return strcmp(lhs_dirent->dirent->name, rhs_dirent->dirent->name);
-}
-
 /* Core of svn_repos_list with the same parameter list.
  *
  * However, DEPTH is not svn_depth_empty and PATH has already been reported.
@@ -183,6 +171,7 @@ do_list(svn_fs_root_t *root,
   apr_hash_t *entries;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_index_t *hi;
+  apr_array_header_t *filtered_dirents;
   apr_array_header_t *sorted;
   int i;
 
@@ -195,8 +184,8 @@ do_list(svn_fs_root_t *root,
    * want to do this twice while authz will rarely filter paths out.
    */
   SVN_ERR(svn_fs_dir_entries(&entries, root, path, scratch_pool));
-  sorted = apr_array_make(scratch_pool, apr_hash_count(entries),
-                          sizeof(filtered_dirent_t));
+  filtered_dirents = apr_array_make(scratch_pool, apr_hash_count(entries),
+                                    sizeof(filtered_dirent_t));
   for (hi = apr_hash_first(scratch_pool, entries); hi; hi = apr_hash_next(hi))
     {
       filtered_dirent_t filtered;
@@ -214,10 +203,23 @@ do_list(svn_fs_root_t *root,
       if (!filtered.is_match && filtered.dirent->kind == svn_node_file)
         continue;
 
-      APR_ARRAY_PUSH(sorted, filtered_dirent_t) = filtered;
+      APR_ARRAY_PUSH(filtered_dirents, filtered_dirent_t) = filtered;
+    }
+
+  /* Sort by entry name.  Sorting items keyed by name lets large
+   * directories use the radix sort in svn_sort__items(). */
+  sorted = apr_array_make(scratch_pool, filtered_dirents->nelts,
+                          sizeof(svn_sort__item_t));
+  for (i = 0; i < filtered_dirents->nelts; ++i)
+    {
+      svn_sort__item_t *item = apr_array_push(sorted);
+
+      item->value = &APR_ARRAY_IDX(filtered_dirents, i, filtered_dirent_t);
+      item->key = ((filtered_dirent_t *)item->value)->dirent->name;
+      item->klen = strlen(item->key);
     }
 
-  svn_sort__array(sorted, compare_filtered_dirent);
+  svn_sort__items(sorted, svn_sort_compare_items_lexically, scratch_pool);
 
   /* Iterate over all remaining directory entries and report them.
    * Recurse into sub-directories if requested. */
@@ -229,7 +231,7 @@ do_list(svn_fs_root_t *root,
 
       svn_pool_clear(iterpool);
 
-      filtered = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
+      filtered = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
       dirent = filtered->dirent;
 
       /* Skip paths that we don't have access to? */
@@ -1162,7 +1162,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 {
   apr_hash_t *s_entries = NULL, *t_entries;
   apr_hash_index_t *hi;
-  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_pool_t *subpool = svn_pool__acquire_scratch(pool);
   apr_array_header_t *t_ordered_entries = NULL;
   int i;
 
@@ -1350,10 +1350,10 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                iterpool));
         }
 
-      /* iterpool is destroyed by destroying its parent (subpool) below */
+      /* iterpool is destroyed by releasing its parent (subpool) below */
     }
 
-  svn_pool_destroy(subpool);
+  svn_pool__release_scratch(subpool);
 
   return SVN_NO_ERROR;
 }
@@ -37,6 +37,7 @@
 #include "svn_config.h"
 
 #include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "svn_private_config.h" /* for SVN_TEMPLATE_ROOT_DIR */
 
@@ -2092,3 +2093,115 @@ svn_repos__fs_type(const char **fs_type,
                      svn_dirent_join(repos_path, SVN_REPOS__DB_DIR, pool),
                      pool);
 }
+
+/* Append the contents of the file NAME in the FS directory of the
+ * repository at REPOS_PATH to RESULT, with line breaks replaced by
+ * spaces.  Return FALSE if the file could not be read.  Use SCRATCH_POOL
+ * for temporary allocations. */
+static svn_boolean_t
+append_fs_file(svn_stringbuf_t *result,
+               const char *repos_path,
+               const char *name,
+               apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_size_t i;
+  svn_error_t *err
+    = svn_stringbuf_from_file2(&contents,
+                               svn_dirent_join_many(scratch_pool, repos_path,
+                                                    SVN_REPOS__DB_DIR, name,
+                                                    SVN_VA_NULL),
+                               scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return FALSE;
+    }
+
+  svn_stringbuf_strip_whitespace(contents);
+  for (i = 0; i < contents->len; ++i)
+    if (contents->data[i] == '\n' || contents->data[i] == '\r')
+      contents->data[i] = ' ';
+
+  svn_stringbuf_appendbyte(result, ' ');
+  svn_stringbuf_appendstr(result, contents);
+
+  return TRUE;
+}
+
+svn_error_t *
+svn_repos__cache_snapshot_tag(const char **tag,
+                              const apr_array_header_t *repos_paths,
+                              const apr_array_header_t *parent_paths,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths = apr_array_copy(scratch_pool, repos_paths);
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(result_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Find all repository candidates.  Sub-directories that are no
+   * repositories will simply be reported as unavailable below. */
+  for (i = 0; i < parent_paths->nelts; ++i)
+    {
+      const char *parent_path = APR_ARRAY_IDX(parent_paths, i, const char *);
+      apr_hash_t *dirents;
+      apr_hash_index_t *hi;
+      svn_error_t *err;
+
+      err = svn_io_get_dirents3(&dirents, parent_path, TRUE,
+                                scratch_pool, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_stringbuf_appendcstr(result,
+                                   apr_pstrcat(iterpool, parent_path, " -\n",
+                                               SVN_VA_NULL));
+          continue;
+        }
+
+      for (hi = apr_hash_first(scratch_pool, dirents); hi;
+           hi = apr_hash_next(hi))
+        {
+          const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+          if (dirent->kind == svn_node_dir)
+            APR_ARRAY_PUSH(paths, const char *)
+              = svn_dirent_join(parent_path, apr_hash_this_key(hi),
+                                scratch_pool);
+        }
+    }
+
+  /* Directory listings are not ordered. */
+  svn_sort__array(paths, svn_sort_compare_paths);
+
+  /* Opening each repository would be expensive for large parent paths.
+   * The FSFS and FSX back-ends keep the UUID, which includes the instance
+   * ID changed by hotcopies and restores, as well as the youngest revision
+   * in tiny files.  Any replacement or rollback changes their contents. */
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      apr_size_t len = result->len;
+
+      svn_pool_clear(iterpool);
+      svn_stringbuf_appendcstr(result, path);
+      if (   append_fs_file(result, path, "uuid", iterpool)
+          && append_fs_file(result, path, "current", iterpool))
+        {
+          svn_stringbuf_appendbyte(result, '\n');
+        }
+      else
+        {
+          svn_stringbuf_chop(result, result->len - len);
+          svn_stringbuf_appendcstr(result,
+                                   apr_pstrcat(iterpool, path, " -\n",
+                                               SVN_VA_NULL));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *tag = result->data;
+
+  return SVN_NO_ERROR;
+}
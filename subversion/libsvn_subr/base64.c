@@ -50,6 +50,391 @@
 static const char base64tab[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ" \
                                 "abcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/* Lookup table for base64 characters; reverse_base64[ch] gives a
+   negative value if ch is not a valid base64 character, or otherwise
+   the value of the byte represented; 'A' => 0 etc. */
+static const signed char reverse_base64[256] = {
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+-1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+
+/* Vectorized codecs */
+
+/* Select the vector instruction sets the compiler can generate code for.
+ * NEON is part of the base architecture while AVX2 support will be tested
+ * at run-time.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#  define SVN_BASE64_X86_AVX2
+#  include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  define SVN_BASE64_NEON
+#  include <arm_neon.h>
+#endif
+
+/* Signature of the vectorized encoders.  Encode a prefix of the LEN bytes
+ * at IN to OUT and return the length of that prefix, which is a multiple
+ * of 3.  The output for the remainder must be identical to what
+ * encode_group() produces.  OUT must have room for LEN / 3 * 4 chars.
+ */
+typedef apr_size_t (*encode_blocks_func_t)(const unsigned char *in,
+                                           apr_size_t len,
+                                           char *out);
+
+/* Signature of the vectorized decoders.  Decode a prefix of the LEN chars
+ * at IN to OUT and return the length of that prefix, which is a multiple
+ * of 4.  The prefix ends before the first block that contains any char
+ * that is not in base64tab.  OUT must have room for LEN / 4 * 3 bytes.
+ */
+typedef apr_size_t (*decode_blocks_func_t)(const unsigned char *in,
+                                           apr_size_t len,
+                                           char *out);
+
+/* Fallback for platforms without vectorized encoder. */
+static apr_size_t
+encode_blocks_generic(const unsigned char *in, apr_size_t len, char *out)
+{
+  return 0;
+}
+
+/* Fallback for platforms without vectorized decoder. */
+static apr_size_t
+decode_blocks_generic(const unsigned char *in, apr_size_t len, char *out)
+{
+  return 0;
+}
+
+#ifdef SVN_BASE64_X86_AVX2
+
+/* Return TRUE, if the CPU and the OS support AVX2.
+ */
+static svn_boolean_t
+x86_has_avx2(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+/* Implementation of encode_blocks_func_t using AVX2.  Each iteration
+ * encodes 24 bytes into 32 chars.  The input is loaded as two 16 byte
+ * halves of which 12 bytes each get used, i.e. we read 4 bytes ahead.
+ */
+__attribute__((target("avx2")))
+static apr_size_t
+encode_blocks_avx2(const unsigned char *in, apr_size_t len, char *out)
+{
+  /* Spread 3 bytes over 4 bytes, in the order expected below. */
+  const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                          7, 6, 8, 7, 10, 9, 11, 10,
+                                          1, 0, 2, 1, 4, 3, 5, 4,
+                                          7, 6, 8, 7, 10, 9, 11, 10);
+  /* Offsets to add to the 6 bit values depending on their range. */
+  const __m256i offsets = _mm256_setr_epi8('A', 'a' - 26,
+                                           '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '+' - 62, '/' - 63,
+                                           0, 0,
+                                           'A', 'a' - 26,
+                                           '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '+' - 62, '/' - 63,
+                                           0, 0);
+  const unsigned char *start = in;
+
+  for (; len >= 28; in += 24, out += 32, len -= 24)
+    {
+      __m256i input = _mm256_inserti128_si256(
+                        _mm256_castsi128_si256(
+                          _mm_loadu_si128((const __m128i *)in)),
+                        _mm_loadu_si128((const __m128i *)(in + 12)), 1);
+      __m256i values, range;
+
+      /* Extract the four 6 bit values from each 3 byte group. */
+      input = _mm256_shuffle_epi8(input, spread);
+      values = _mm256_or_si256(
+                 _mm256_mulhi_epu16(
+                   _mm256_and_si256(input, _mm256_set1_epi32(0x0fc0fc00)),
+                   _mm256_set1_epi32(0x04000040)),
+                 _mm256_mullo_epi16(
+                   _mm256_and_si256(input, _mm256_set1_epi32(0x003f03f0)),
+                   _mm256_set1_epi32(0x01000010)));
+
+      /* Map 0..25 to 0, 26..51 to 1, 52..61 to 2..11, 62 to 12 and 63 to
+         13 and use that to look up the offset to the respective char. */
+      range = _mm256_sub_epi8(
+                _mm256_subs_epu8(values, _mm256_set1_epi8(51)),
+                _mm256_cmpgt_epi8(values, _mm256_set1_epi8(25)));
+      values = _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, range));
+
+      _mm256_storeu_si256((__m256i *)out, values);
+    }
+
+  return in - start;
+}
+
+/* Implementation of decode_blocks_func_t using AVX2.  Each iteration
+ * decodes 32 chars into 24 bytes.
+ */
+__attribute__((target("avx2")))
+static apr_size_t
+decode_blocks_avx2(const unsigned char *in, apr_size_t len, char *out)
+{
+  /* Classify the chars by their low and high nibbles.  A char is valid
+     iff the bitwise AND of both classes is 0. */
+  const __m256i low_classes = _mm256_setr_epi8(
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m256i high_classes = _mm256_setr_epi8(
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  /* Offsets to add to the valid chars, by high nibble.  '/' gets looked
+     up with the high nibble decremented by one. */
+  const __m256i offsets = _mm256_setr_epi8(
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  /* Gather the 3 bytes from each 4 byte group. */
+  const __m256i gather = _mm256_setr_epi8(
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m256i slash = _mm256_set1_epi8('/');
+  const unsigned char *start = in;
+
+  for (; len >= 32; in += 32, out += 24, len -= 32)
+    {
+      __m256i input = _mm256_loadu_si256((const __m256i *)in);
+      __m256i high_nibbles = _mm256_and_si256(_mm256_srli_epi32(input, 4),
+                                              slash);
+      __m256i low_nibbles = _mm256_and_si256(input, slash);
+      __m256i values;
+
+      if (!_mm256_testz_si256(_mm256_shuffle_epi8(low_classes, low_nibbles),
+                              _mm256_shuffle_epi8(high_classes,
+                                                  high_nibbles)))
+        break;
+
+      values = _mm256_add_epi8(
+                 input,
+                 _mm256_shuffle_epi8(
+                   offsets,
+                   _mm256_add_epi8(_mm256_cmpeq_epi8(input, slash),
+                                   high_nibbles)));
+
+      /* Pack 4x6 bits into 3x8 bits per group, then the 12 bytes of each
+         lane next to each other. */
+      values = _mm256_madd_epi16(
+                 _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)),
+                 _mm256_set1_epi32(0x00011000));
+      values = _mm256_permutevar8x32_epi32(
+                 _mm256_shuffle_epi8(values, gather),
+                 _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+      _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(values));
+      _mm_storel_epi64((__m128i *)(out + 16),
+                       _mm256_extracti128_si256(values, 1));
+    }
+
+  return in - start;
+}
+
+#endif /* SVN_BASE64_X86_AVX2 */
+
+#ifdef SVN_BASE64_NEON
+
+/* Implementation of encode_blocks_func_t using NEON.  Each iteration
+ * encodes 48 bytes into 64 chars.
+ */
+static apr_size_t
+encode_blocks_neon(const unsigned char *in, apr_size_t len, char *out)
+{
+  const unsigned char *table = (const unsigned char *)base64tab;
+  uint8x16x4_t chars;
+  const uint8x16_t mask = vdupq_n_u8(0x3f);
+  const unsigned char *start = in;
+
+  chars.val[0] = vld1q_u8(table);
+  chars.val[1] = vld1q_u8(table + 16);
+  chars.val[2] = vld1q_u8(table + 32);
+  chars.val[3] = vld1q_u8(table + 48);
+
+  for (; len >= 48; in += 48, out += 64, len -= 48)
+    {
+      uint8x16x3_t input = vld3q_u8(in);
+      uint8x16x4_t values;
+
+      values.val[0] = vshrq_n_u8(input.val[0], 2);
+      values.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(input.val[0], 4),
+                                        vshrq_n_u8(input.val[1], 4)),
+                               mask);
+      values.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(input.val[1], 2),
+                                        vshrq_n_u8(input.val[2], 6)),
+                               mask);
+      values.val[3] = vandq_u8(input.val[2], mask);
+
+      values.val[0] = vqtbl4q_u8(chars, values.val[0]);
+      values.val[1] = vqtbl4q_u8(chars, values.val[1]);
+      values.val[2] = vqtbl4q_u8(chars, values.val[2]);
+      values.val[3] = vqtbl4q_u8(chars, values.val[3]);
+
+      vst4q_u8((unsigned char *)out, values);
+    }
+
+  return in - start;
+}
+
+/* Implementation of decode_blocks_func_t using NEON.  Each iteration
+ * decodes 64 chars into 48 bytes.
+ */
+static apr_size_t
+decode_blocks_neon(const unsigned char *in, apr_size_t len, char *out)
+{
+  const unsigned char *table = (const unsigned char *)reverse_base64;
+  uint8x16x4_t low_table, high_table;
+  const uint8x16_t high_half = vdupq_n_u8(0x40);
+  const unsigned char *start = in;
+  int i;
+
+  for (i = 0; i < 4; ++i)
+    {
+      low_table.val[i] = vld1q_u8(table + 16 * i);
+      high_table.val[i] = vld1q_u8(table + 64 + 16 * i);
+    }
+
+  for (; len >= 64; in += 64, out += 48, len -= 64)
+    {
+      uint8x16x4_t input = vld4q_u8(in);
+      uint8x16x4_t values;
+      uint8x16x3_t output;
+      uint8x16_t invalid = vdupq_n_u8(0);
+
+      /* Look up chars 0..63 in the low and 64..127 in the high table.
+         Chars >= 128 as well as invalid table entries have bit 7 set. */
+      for (i = 0; i < 4; ++i)
+        {
+          values.val[i] = vqtbx4q_u8(vqtbl4q_u8(low_table, input.val[i]),
+                                     high_table,
+                                     veorq_u8(input.val[i], high_half));
+          invalid = vorrq_u8(invalid, vorrq_u8(values.val[i],
+                                               input.val[i]));
+        }
+
+      if (vmaxvq_u8(invalid) & 0x80)
+        break;
+
+      output.val[0] = vorrq_u8(vshlq_n_u8(values.val[0], 2),
+                               vshrq_n_u8(values.val[1], 4));
+      output.val[1] = vorrq_u8(vshlq_n_u8(values.val[1], 4),
+                               vshrq_n_u8(values.val[2], 2));
+      output.val[2] = vorrq_u8(vshlq_n_u8(values.val[2], 6),
+                               values.val[3]);
+
+      vst3q_u8((unsigned char *)out, output);
+    }
+
+  return in - start;
+}
+
+#endif /* SVN_BASE64_NEON */
+
+/* The codec to use on this machine, selected by select_codec().
+ * Concurrent initialization is harmless since all threads will select
+ * the same functions.
+ */
+static volatile encode_blocks_func_t encode_blocks = NULL;
+static volatile decode_blocks_func_t decode_blocks = NULL;
+
+/* Name of the implementation in ENCODE_BLOCKS and DECODE_BLOCKS. */
+static const char *codec_name = NULL;
+
+/* Select the fastest codec that this machine supports.
+ */
+static void
+select_codec(void)
+{
+  encode_blocks_func_t encoder = encode_blocks_generic;
+  decode_blocks_func_t decoder = decode_blocks_generic;
+  const char *name = "generic";
+
+#ifdef SVN_BASE64_X86_AVX2
+  if (x86_has_avx2())
+    {
+      encoder = encode_blocks_avx2;
+      decoder = decode_blocks_avx2;
+      name = "AVX2";
+    }
+#endif
+
+#ifdef SVN_BASE64_NEON
+  encoder = encode_blocks_neon;
+  decoder = decode_blocks_neon;
+  name = "NEON";
+#endif
+
+  codec_name = name;
+  decode_blocks = decoder;
+  encode_blocks = encoder;
+}
+
+/* Return the fastest encoder that this machine supports.
+ */
+static encode_blocks_func_t
+get_encode_blocks_func(void)
+{
+  encode_blocks_func_t result = encode_blocks;
+  if (!result)
+    {
+      select_codec();
+      result = encode_blocks;
+    }
+
+  return result;
+}
+
+/* Return the fastest decoder that this machine supports.
+ */
+static decode_blocks_func_t
+get_decode_blocks_func(void)
+{
+  decode_blocks_func_t result = decode_blocks;
+  if (!result)
+    {
+      select_codec();
+      result = decode_blocks;
+    }
+
+  return result;
+}
+
+const char *
+svn_base64__implementation(void)
+{
+  get_encode_blocks_func();
+  return codec_name;
+}
+
 
 /* Binary input --> base64-encoded output */
 
@@ -85,30 +470,33 @@ encode_group(const unsigned char *in, char *out)
   out[3] = base64tab[part2 & 0x3f];
 }
 
-/* Base64-encode a line, i.e. BYTES_PER_LINE bytes from DATA into
-   BASE64_LINELEN chars and append it to STR.  It does not assume that
-   a new line char will be appended, though.
+/* Base64-encode LEN bytes from DATA into LEN / 3 * 4 chars and append
+   them to STR.  LEN must be a multiple of 3.  This is typically a line,
+   i.e. BYTES_PER_LINE bytes.  It does not assume that a new line char
+   will be appended, though.
    The code in this function will simply transform the data without
-   performing any boundary checks.  Therefore, DATA must have at least
-   BYTES_PER_LINE left and space for at least another BASE64_LINELEN
-   chars must have been pre-allocated in STR before calling this
-   function. */
+   performing any boundary checks.  Therefore, space for at least
+   another LEN / 3 * 4 chars must have been pre-allocated in STR before
+   calling this function. */
 static void
-encode_line(svn_stringbuf_t *str, const char *data)
+encode_chunk(svn_stringbuf_t *str, const char *data, apr_size_t len)
 {
   /* Translate directly from DATA to STR->DATA. */
   const unsigned char *in = (const unsigned char *)data;
   char *out = str->data + str->len;
-  char *end = out + BASE64_LINELEN;
+  char *end = out + len / 3 * 4;
+
+  /* Let the vectorized code handle as much as possible. */
+  apr_size_t done = get_encode_blocks_func()(in, len, out);
+  in += done;
+  out += done / 3 * 4;
 
-  /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
-     a multiple of 4. */
   for ( ; out != end; in += 3, out += 4)
     encode_group(in, out);
 
   /* Expand and terminate the string. */
   *out = '\0';
-  str->len += BASE64_LINELEN;
+  str->len = out - str->data;
 }
 
 /* (Continue to) Base64-encode the byte string DATA (of length LEN)
@@ -150,10 +538,13 @@ encode_bytes(svn_stringbuf_t *str, const void *data, apr_size_t len,
           && (*linelen == 0 || !break_lines)
           && (end - p >= BYTES_PER_LINE))
         {
-          /* Yes, we can encode a whole chunk of data at once. */
-          encode_line(str, p);
-          p += BYTES_PER_LINE;
-          *linelen += BASE64_LINELEN;
+          /* Yes, we can encode a whole chunk of data at once.  Without
+             line breaks, that is all complete groups left in DATA. */
+          apr_size_t chunk = break_lines ? BYTES_PER_LINE
+                                         : (end - p) / 3 * 3;
+          encode_chunk(str, p, chunk);
+          p += chunk;
+          *linelen += chunk / 3 * 4;
         }
       else
         {
@@ -317,28 +708,6 @@ decode_group(const unsigned char *in, char *out)
   out[2] = (char)(((in[2] & 0x3) << 6) | in[3]);
 }
 
-/* Lookup table for base64 characters; reverse_base64[ch] gives a
-   negative value if ch is not a valid base64 character, or otherwise
-   the value of the byte represented; 'A' => 0 etc. */
-static const signed char reverse_base64[256] = {
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
-52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
--1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
--1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
--1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
-};
-
 /* Similar to decode_group but this function also translates the
    6-bit values from the IN buffer before translating them.
    Return FALSE if a non-base64 char (e.g. '=' or new line)
@@ -379,6 +748,12 @@ decode_line(svn_stringbuf_t *str, const char **data)
   char *out = str->data + str->len;
   char *end = out + BYTES_PER_LINE;
 
+  /* Let the vectorized code handle as much as possible.  It stops
+     before the first block that contains a special char. */
+  apr_size_t done = get_decode_blocks_func()(p, BASE64_LINELEN, out);
+  p += done;
+  out += done / 4 * 3;
+
   /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
      a multiple of 4.  Stop translation as soon as we encounter a special
      char.  Leave the entire group untouched in that case. */
@@ -23,12 +23,15 @@
 
 #include <assert.h>
 #include <apr_md5.h>
+#include <apr_shm.h>
 #include <apr_thread_rwlock.h>
+#include <apr_time.h>
 
 #include "svn_pools.h"
 #include "svn_checksum.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
+#include "svn_io.h"
 #include "svn_string.h"
 #include "svn_sorts.h"  /* get the MIN macro */
 
@@ -129,6 +132,16 @@
  * to scale well despite that bottleneck, we simply segment the cache into
  * a number of independent caches (segments). Items will be multiplexed based
  * on their hash key.
+ *
+ * Where atomic operations and memory barriers are available, cache hits
+ * don't take the segment lock at all.  Writers bump a per-segment change
+ * counter before and after every modification.  Readers sample it, copy
+ * the data and then check that the counter did not change in the meantime.
+ * Only if it did, they fall back to the locked code path.
+ *
+ * Pre-fork servers may put all segments into shared memory to have all
+ * worker processes use the same cache.  Segment locks are then robust
+ * process-shared mutexes in that shared memory.
  */
 
 /* APR's read-write lock implementation on Windows is horribly inefficient.
@@ -146,6 +159,62 @@
 #  define USE_SIMPLE_MUTEX 0
 #endif
 
+/* Even an uncontended r/w lock needs to modify the lock object, i.e. all
+ * readers of a segment compete for the same cache line.  With many cores
+ * and hot cache entries, that limits scalability of cache hits severely.
+ *
+ * Therefore, we allow readers to access thread-safe segments without any
+ * lock, "seqlock" style:  Every writer increments the segment's
+ * CHANGE_COUNTER once after acquiring the lock and once before releasing
+ * it.  A reader first samples the counter, then performs the lookup and
+ * copies the data, and finally re-reads the counter.  If the counter was
+ * odd (writer active) or changed, the result may be inconsistent and the
+ * reader falls back to the traditional, locked access.
+ *
+ * This requires full memory barriers.  If we don't know how to get them
+ * on this platform, always take the lock.  The debug tagging code cannot
+ * cope with data being modified while it is being checked, so it has to
+ * use locked reads as well.
+ */
+#if APR_HAS_THREADS && !defined(SVN_DEBUG_CACHE_MEMBUFFER) \
+ && defined(SVN_HAS_ATOMIC_BUILTINS)
+#  define USE_OPTIMISTIC_READS 1
+#  define MEMORY_BARRIER() __sync_synchronize()
+#elif APR_HAS_THREADS && !defined(SVN_DEBUG_CACHE_MEMBUFFER) \
+   && defined(_MSC_VER)
+#  define USE_OPTIMISTIC_READS 1
+#  define MEMORY_BARRIER() MemoryBarrier()
+#else
+#  define USE_OPTIMISTIC_READS 0
+#endif
+
+/* Pre-fork servers may place the whole cache into an anonymous shared
+ * memory region that gets created before the first fork() and is then
+ * inherited by all worker processes.  Because the region will be mapped
+ * to the same address in every process, all pointers into it remain valid.
+ *
+ * The segment locks must then synchronize processes as well.  Worker
+ * processes may get killed or crash at any time, possibly while holding
+ * a segment lock.  We therefore use robust process-shared POSIX mutexes
+ * living in the shared region.  The next process to acquire the lock of
+ * a dead owner will be told so and will reset the segment, which may have
+ * been left in an inconsistent state.  APR's process mutexes would need
+ * per-child initialization and don't report dead owners to the caller.
+ *
+ * The change counters used by optimistic reads live in the shared region
+ * as well and are only guaranteed to work across processes if the atomics
+ * map to CPU instructions.
+ */
+#if USE_OPTIMISTIC_READS && !USE_SIMPLE_MUTEX \
+ && APR_HAS_SHARED_MEMORY && APR_HAS_FORK && defined(SVN_HAS_ATOMIC_BUILTINS) \
+ && defined(HAVE_PTHREAD_MUTEX_CONSISTENT)
+#  define USE_SHARED_MEMORY 1
+#  include <errno.h>
+#  include <pthread.h>
+#else
+#  define USE_SHARED_MEMORY 0
+#endif
+
 /* For more efficient copy operations, let's align all data items properly.
  * Since we can't portably align pointers, this is rather the item size
  * granularity which ensures *relative* alignment within the cache - still
@@ -197,6 +266,30 @@
  */
 #define MAX_ITEM_SIZE ((apr_uint32_t)(0 - ITEM_ALIGNMENT))
 
+/* The TinyLFU admission policy keeps a count-min sketch of recent key
+ * accesses per segment.  Each access increments SKETCH_DEPTH counters,
+ * the estimated access frequency is the smallest of them.
+ */
+#define SKETCH_DEPTH 4
+
+/* The sketch uses 4 bit counters, i.e. they saturate at this value.
+ * Small counters let the sketch adapt quickly to changes in the access
+ * pattern.
+ */
+#define SKETCH_MAX_COUNT 15
+
+/* Number of sketch counters per directory entry.  Must be a power of two.
+ * Together with SKETCH_SAMPLE_FACTOR, this limits the number of collisions
+ * and keeps the frequency estimates reasonably accurate.
+ */
+#define SKETCH_COUNTERS_PER_ENTRY 16
+
+/* After SKETCH_SAMPLE_FACTOR times as many accesses as there are entries
+ * in the directory, all counters get halved.  This "ages" the access
+ * history.
+ */
+#define SKETCH_SAMPLE_FACTOR 10
+
 /* We use this structure to identify cache entries. There cannot be two
  * entries with the same entry key. However unlikely, though, two different
  * full keys (see full_key_t) may have the same entry key.  That is a
@@ -777,25 +870,61 @@ struct svn_membuffer_t
 
   /* Total number of calls to membuffer_cache_get.
    * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
+   * Lock-free readers update it as well, so always access it through the
+   * 64 bit atomics of svn_atomic.h.
    */
   apr_uint64_t total_reads;
 
   /* Total number of calls to membuffer_cache_set.
    * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
+   * Lock-free readers update it as well, so always access it through the
+   * 64 bit atomics of svn_atomic.h.
    */
   apr_uint64_t total_writes;
 
   /* Total number of hits since the cache's creation.
    * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
+   * Lock-free readers update it as well, so always access it through the
+   * 64 bit atomics of svn_atomic.h.
    */
   apr_uint64_t total_hits;
 
+  /* Number of items that the admission policy refused to put into L2
+   * because the data they would have replaced was used more frequently.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_rejects;
+
+  /* Number of items removed from the cache to make room for new data.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_evictions;
+
+  /* Policy used to decide whether items from L1 may replace L2 contents.
+   */
+  svn_cache__admission_policy_t admission_policy;
+
+  /* Count-min sketch of recent key accesses, SKETCH_MASK + 1 counters
+   * of 4 bits each.
+   * NULL unless ADMISSION_POLICY is svn_cache__admission_tinylfu.
+   * Readers update it without holding the write lock.  Since this is
+   * only an estimate, lost updates are not a problem.
+   */
+  unsigned char *sketch;
+
+  /* Number of counters in SKETCH minus 1.  The number of counters is a
+   * power of two.
+   */
+  apr_uint32_t sketch_mask;
+
+  /* Number of accesses recorded in SKETCH since it has last been aged.
+   */
+  svn_atomic_t sketch_additions;
+
+  /* Age SKETCH when SKETCH_ADDITIONS reaches this value.
+   */
+  apr_uint32_t sketch_sample_size;
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   /* A lock for intra-process synchronization to the cache, or NULL if
    * the cache's creator doesn't feel the cache needs to be
@@ -817,17 +946,154 @@ struct svn_membuffer_t
    * This one is only used in debug assertions to verify that you used
    * the correct multi-threading settings. */
   svn_atomic_t write_lock_count;
+
+#if USE_OPTIMISTIC_READS
+  /* If set, readers may try to access this segment without taking the
+   * lock.  Only enabled for thread-safe segments. */
+  svn_boolean_t optimistic_reads;
+
+  /* Number of times that a writer started or finished modifying this
+   * segment.  Odd while there is a modification in progress.  See the
+   * USE_OPTIMISTIC_READS comment at the top of this file. */
+  volatile svn_atomic_t change_counter;
+#endif
+
+#if USE_SHARED_MEMORY
+  /* If set, this segment lives in a memory region shared by several
+   * processes and SHARED_MUTEX is being used instead of LOCK. */
+  svn_boolean_t process_shared;
+
+  /* Robust process-shared mutex.  See shared_lock() for details. */
+  pthread_mutex_t shared_mutex;
+#endif
 };
 
 /* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
 
+/* Mark all entries in SEGMENT as unused and release all of its data
+ * buffer space.  The caller must hold the write lock.
+ */
+static void
+reset_segment(svn_membuffer_t *segment)
+{
+  /* Length of the group_initialized array in bytes.
+     See also svn_cache__membuffer_cache_create(). */
+  apr_size_t group_init_size
+    = 1 + (segment->group_count + segment->spare_group_count)
+            / (8 * GROUP_INIT_GRANULARITY);
+
+  /* Mark all groups as "not initialized", which implies "empty". */
+  segment->first_spare_group = NO_INDEX;
+  segment->max_spare_used = 0;
+
+  memset(segment->group_initialized, 0, group_init_size);
+
+  /* Unlink L1 contents. */
+  segment->l1.first = NO_INDEX;
+  segment->l1.last = NO_INDEX;
+  segment->l1.next = NO_INDEX;
+  segment->l1.current_data = segment->l1.start_offset;
+
+  /* Unlink L2 contents. */
+  segment->l2.first = NO_INDEX;
+  segment->l2.last = NO_INDEX;
+  segment->l2.next = NO_INDEX;
+  segment->l2.current_data = segment->l2.start_offset;
+
+  /* Reset content counters. */
+  segment->data_used = 0;
+  segment->used_entries = 0;
+}
+
+#if USE_SHARED_MEMORY
+
+/* Initialize the robust process-shared mutex of SEGMENT.
+ */
+static svn_error_t *
+shared_lock_init(svn_membuffer_t *segment)
+{
+  pthread_mutexattr_t attr;
+  int status = pthread_mutexattr_init(&attr);
+
+  if (!status)
+    status = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  if (!status)
+    status = pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+  if (!status)
+    status = pthread_mutex_init(&segment->shared_mutex, &attr);
+
+  pthread_mutexattr_destroy(&attr);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create shared cache mutex"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Acquire the process-shared mutex of SEGMENT.  If WAIT is not set and
+ * the mutex is currently held by someone else, set *SUCCESS to FALSE and
+ * leave it untouched otherwise.
+ *
+ * If the previous owner died while holding the mutex, it may have left
+ * the segment in an inconsistent state.  Reset the segment then and make
+ * the mutex usable again.  Optimistic readers will notice the change and
+ * don't get stuck on a change counter left odd by the dead owner.
+ */
+static svn_error_t *
+shared_lock(svn_membuffer_t *segment,
+            svn_boolean_t wait,
+            svn_boolean_t *success)
+{
+  int status = wait ? pthread_mutex_lock(&segment->shared_mutex)
+                    : pthread_mutex_trylock(&segment->shared_mutex);
+
+  if (status == EBUSY && !wait)
+    {
+      *success = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  if (status == EOWNERDEAD)
+    {
+#if USE_OPTIMISTIC_READS
+      if ((svn_atomic_read(&segment->change_counter) & 1) == 0)
+        svn_atomic_inc(&segment->change_counter);
+#endif
+
+      reset_segment(segment);
+
+#if USE_OPTIMISTIC_READS
+      svn_atomic_inc(&segment->change_counter);
+#endif
+
+      status = pthread_mutex_consistent(&segment->shared_mutex);
+      if (status)
+        pthread_mutex_unlock(&segment->shared_mutex);
+    }
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock shared cache mutex"));
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
 read_lock_cache(svn_membuffer_t *cache)
 {
+#if USE_SHARED_MEMORY
+  if (cache->process_shared)
+    {
+      svn_boolean_t success;
+      return svn_error_trace(shared_lock(cache, TRUE, &success));
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -851,6 +1117,12 @@ read_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+#if USE_SHARED_MEMORY
+  if (cache->process_shared)
+    return svn_error_trace(shared_lock(cache, cache->allow_blocking_writes,
+                                       success));
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -888,10 +1160,22 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+#if (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+  apr_status_t status;
+#endif
+
+#if USE_SHARED_MEMORY
+  if (cache->process_shared)
+    {
+      svn_boolean_t success;
+      return svn_error_trace(shared_lock(cache, TRUE, &success));
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  apr_status_t status = apr_thread_rwlock_wrlock(cache->lock);
+  status = apr_thread_rwlock_wrlock(cache->lock);
   if (status)
     return svn_error_wrap_apr(status,
                               _("Can't write-lock cache mutex"));
@@ -908,6 +1192,21 @@ force_write_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
+#if USE_SHARED_MEMORY
+  if (cache->process_shared)
+    {
+      int status = pthread_mutex_unlock(&cache->shared_mutex);
+      if (err)
+        return err;
+
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't unlock shared cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -927,6 +1226,31 @@ unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 #endif
 }
 
+/* Tell optimistic readers that CACHE is about to be modified.  The caller
+ * must hold the write lock.
+ */
+static APR_INLINE void
+begin_modification(svn_membuffer_t *cache)
+{
+#if USE_OPTIMISTIC_READS
+  svn_atomic_inc(&cache->change_counter);
+#endif
+}
+
+/* Tell optimistic readers that the modification of CACHE that has been
+ * started by begin_modification() is complete.  The caller must still
+ * hold the write lock.  Return ERR.
+ */
+static APR_INLINE svn_error_t *
+end_modification(svn_membuffer_t *cache, svn_error_t *err)
+{
+#if USE_OPTIMISTIC_READS
+  svn_atomic_inc(&cache->change_counter);
+#endif
+
+  return err;
+}
+
 /* If supported, guard the execution of EXPR with a read lock to CACHE.
  * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
  */
@@ -945,6 +1269,9 @@ do {                                        \
  * Once we discovered such an entry, we unconditionally do a blocking
  * wait for the write lock.  In case no old content could be found, a
  * failing lock attempt is simply a no-op and we exit the macro.
+ *
+ * EXPR is being bracketed by begin_modification / end_modification such
+ * that optimistic readers will notice any change made by it.
  */
 #define WITH_WRITE_LOCK(cache, expr)                            \
 do {                                                            \
@@ -959,7 +1286,8 @@ do {                                                            \
       else                                                      \
         break;                                                  \
     }                                                           \
-  SVN_ERR(unlock_cache(cache, (expr)));                         \
+  begin_modification(cache);                                    \
+  SVN_ERR(unlock_cache(cache, end_modification(cache, (expr))));\
 } while (0)
 
 /* Returns 0 if the entry group identified by GROUP_INDEX in CACHE has not
@@ -1314,7 +1642,7 @@ insert_entry(svn_membuffer_t *cache, entry_t *entry)
    */
   cache->used_entries++;
   cache->data_used += entry->size;
-  entry->hit_count = 0;
+  svn_atomic_set(&entry->hit_count, 0);
   group->header.used++;
 
   /* update entry chain
@@ -1353,16 +1681,135 @@ get_group_index(svn_membuffer_t **cache,
 static APR_INLINE void
 let_entry_age(svn_membuffer_t *cache, entry_t *entry)
 {
-  apr_uint32_t hits_removed = (entry->hit_count + 1) >> 1;
+  /* Lock-free readers may increment the hit count concurrently, so
+   * don't lose their updates. */
+  apr_uint32_t hit_count;
+  apr_uint32_t hits_removed;
 
-  if (hits_removed)
+  do
     {
-      entry->hit_count -= hits_removed;
+      hit_count = svn_atomic_read(&entry->hit_count);
+      hits_removed = (hit_count + 1) >> 1;
     }
-  else
+  while (hits_removed
+         && svn_atomic_cas(&entry->hit_count, hit_count - hits_removed,
+                           hit_count) != hit_count);
+
+  if (!hits_removed)
+    entry->priority /= 2;
+}
+
+/* Return the hash value of KEY used to select sketch counters.  Keys are
+ * not necessarily well-distributed (short keys are stored verbatim), so
+ * mix all bits.
+ */
+static APR_INLINE apr_uint64_t
+get_sketch_hash(const entry_key_t *key)
+{
+  apr_uint64_t hash = key->fingerprint[0] * APR_UINT64_C(0x9e3779b97f4a7c15)
+                    ^ key->fingerprint[1] * APR_UINT64_C(0xc2b2ae3d27d4eb4f);
+  return hash ^ (hash >> 29);
+}
+
+/* Return the value of counter number IDX in CACHE's sketch.
+ */
+static APR_INLINE apr_uint32_t
+get_sketch_counter(svn_membuffer_t *cache,
+                   apr_uint32_t idx)
+{
+  return (cache->sketch[idx / 2] >> (4 * (idx % 2))) & SKETCH_MAX_COUNT;
+}
+
+/* Halve all counters in CACHE's sketch.
+ */
+static void
+age_sketch(svn_membuffer_t *cache)
+{
+  apr_uint32_t i;
+  apr_uint32_t count = (cache->sketch_mask + 1) / 2;
+
+  /* Shift both 4 bit counters in each byte at once. */
+  for (i = 0; i < count; ++i)
+    cache->sketch[i] = (cache->sketch[i] >> 1) & 0x77;
+
+  svn_atomic_set(&cache->sketch_additions, cache->sketch_sample_size / 2);
+}
+
+/* Record an access to KEY in CACHE's sketch, if CACHE has one.
+ */
+static void
+record_access(svn_membuffer_t *cache,
+              const entry_key_t *key)
+{
+  apr_uint64_t hash;
+  apr_uint32_t hash1, hash2;
+  int i;
+
+  if (cache->sketch == NULL)
+    return;
+
+  /* Double hashing.  HASH2 is odd, i.e. all counters will be different. */
+  hash = get_sketch_hash(key);
+  hash1 = (apr_uint32_t)hash;
+  hash2 = (apr_uint32_t)(hash >> 32) | 1;
+
+  for (i = 0; i < SKETCH_DEPTH; ++i)
     {
-      entry->priority /= 2;
+      apr_uint32_t idx = (hash1 + i * hash2) & cache->sketch_mask;
+      if (get_sketch_counter(cache, idx) < SKETCH_MAX_COUNT)
+        cache->sketch[idx / 2] += (unsigned char)(1 << (4 * (idx % 2)));
     }
+
+  /* Only one of any number of concurrent readers will trigger the aging. */
+  if (svn_atomic_inc(&cache->sketch_additions) + 1
+      == cache->sketch_sample_size)
+    age_sketch(cache);
+}
+
+/* Return the estimated number of recent accesses to KEY in CACHE.
+ * CACHE must have a sketch.
+ */
+static apr_uint32_t
+estimate_frequency(svn_membuffer_t *cache,
+                   const entry_key_t *key)
+{
+  apr_uint64_t hash = get_sketch_hash(key);
+  apr_uint32_t hash1 = (apr_uint32_t)hash;
+  apr_uint32_t hash2 = (apr_uint32_t)(hash >> 32) | 1;
+  apr_uint32_t result = SKETCH_MAX_COUNT;
+  int i;
+
+  for (i = 0; i < SKETCH_DEPTH; ++i)
+    result = MIN(result,
+                 get_sketch_counter(cache,
+                                    (hash1 + i * hash2) & cache->sketch_mask));
+
+  return result;
+}
+
+/* Return whether the admission policy of CACHE allows TO_FIT_IN to replace
+ * VICTIM.  Count rejections.
+ *
+ * Note that we can't exempt low-priority victims here because
+ * let_entry_age() lowers the priority of entries that get moved around
+ * in L2 a lot - which is exactly what happens to popular data during
+ * a long scan.
+ */
+static svn_boolean_t
+is_admitted(svn_membuffer_t *cache,
+            entry_t *to_fit_in,
+            entry_t *victim)
+{
+  if (cache->admission_policy != svn_cache__admission_tinylfu)
+    return TRUE;
+
+  /* TinyLFU: Keep the victim unless the new item is more popular. */
+  if (  estimate_frequency(cache, &to_fit_in->key)
+      > estimate_frequency(cache, &victim->key))
+    return TRUE;
+
+  cache->total_rejects++;
+  return FALSE;
 }
 
 /* Return whether the keys in LHS and RHS match.
@@ -1539,6 +1986,7 @@ find_entry(svn_membuffer_t *cache,
               let_entry_age(cache, &to_shrink->entries[i]);
 
           drop_entry(cache, entry);
+          cache->total_evictions++;
         }
 
       /* initialize entry for the new key
@@ -1550,6 +1998,110 @@ find_entry(svn_membuffer_t *cache,
   return entry;
 }
 
+#if USE_OPTIMISTIC_READS
+
+/* Start a lock-free read from CACHE and return the current value of its
+ * change counter in *COUNTER.  Return FALSE if a writer is currently
+ * modifying CACHE, i.e. if the caller should not even try to read.
+ */
+static APR_INLINE svn_boolean_t
+begin_optimistic_read(svn_membuffer_t *cache,
+                      apr_uint32_t *counter)
+{
+  *counter = svn_atomic_read(&cache->change_counter);
+  MEMORY_BARRIER();
+
+  return (*counter & 1) == 0;
+}
+
+/* Return TRUE if CACHE has not been modified since begin_optimistic_read
+ * returned COUNTER, i.e. if all data read from CACHE in between is
+ * consistent.
+ */
+static APR_INLINE svn_boolean_t
+end_optimistic_read(svn_membuffer_t *cache,
+                    apr_uint32_t counter)
+{
+  MEMORY_BARRIER();
+  return svn_atomic_read(&cache->change_counter) == counter;
+}
+
+/* Lock-free variant of find_entry() for FIND_EMPTY being FALSE.
+ *
+ * Writers may modify CACHE while we are reading it.  Therefore, every
+ * index, count and offset read from the directory gets checked before
+ * it is being used, such that we will never access memory outside the
+ * CACHE's buffers nor loop endlessly.  The result may still be bogus and
+ * is only valid if end_optimistic_read() succeeds afterwards.
+ *
+ * If a matching entry has been found, return it and copy its data offset
+ * and size into *OFFSET and *SIZE, respectively.  Those copies are
+ * guaranteed to be within the CACHE's data buffer.  Return NULL otherwise.
+ */
+static entry_t *
+find_entry_optimistic(svn_membuffer_t *cache,
+                      apr_uint32_t group_index,
+                      const full_key_t *to_find,
+                      apr_uint64_t *offset,
+                      apr_size_t *size)
+{
+  apr_uint64_t data_size = cache->l1.size + cache->l2.size;
+  apr_uint32_t group_limit = cache->group_count + cache->spare_group_count;
+  apr_size_t key_len = to_find->entry_key.key_len;
+  entry_group_t *group = &cache->directory[group_index];
+  apr_uint32_t chain_length;
+
+  if (! is_group_initialized(cache, group_index))
+    return NULL;
+
+  for (chain_length = 0;
+       chain_length < MAX_GROUP_CHAIN_LENGTH;
+       ++chain_length)
+    {
+      apr_size_t i;
+      apr_size_t used = MIN(group->header.used, GROUP_SIZE);
+      apr_uint32_t next;
+
+      for (i = 0; i < used; ++i)
+        if (entry_keys_match(&group->entries[i].key, &to_find->entry_key))
+          {
+            entry_t *entry = &group->entries[i];
+            apr_uint64_t entry_offset = entry->offset;
+            apr_size_t entry_size = entry->size;
+
+            /* Only use consistent, in-bounds locations. */
+            if (   entry_offset > data_size
+                || entry_size > data_size - entry_offset
+                || ALIGN_VALUE(entry_size) > data_size - entry_offset
+                || key_len > entry_size)
+              return NULL;
+
+            /* Compare the full key, if there is one. */
+            if (   key_len
+                && memcmp(to_find->full_key.data,
+                          cache->data + entry_offset,
+                          key_len) != 0)
+              return NULL;
+
+            *offset = entry_offset;
+            *size = entry_size;
+
+            return entry;
+          }
+
+      /* end of chain? */
+      next = group->header.next;
+      if (next == NO_INDEX || next >= group_limit)
+        break;
+
+      group = &cache->directory[next];
+    }
+
+  return NULL;
+}
+
+#endif /* USE_OPTIMISTIC_READS */
+
 /* Move a surviving ENTRY from just behind the insertion window to
  * its beginning and move the insertion window up accordingly.
  */
@@ -1735,6 +2287,10 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                    : entry->priority > to_fit_in->priority;
             }
 
+          /* Don't let one-time accesses push out popular data. */
+          if (!keep && !is_admitted(cache, to_fit_in, entry))
+            return FALSE;
+
           /* keepers or destroyers? */
           if (keep)
             {
@@ -1756,6 +2312,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                 drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
 
               drop_entry(cache, entry);
+              cache->total_evictions++;
             }
         }
     }
@@ -1823,7 +2380,10 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
               if (keep)
                 promote_entry(cache, entry);
               else
-                drop_entry(cache, entry);
+                {
+                  drop_entry(cache, entry);
+                  cache->total_evictions++;
+                }
             }
         }
     }
@@ -1832,17 +2392,48 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
    * right answer. */
 }
 
-svn_error_t *
-svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
-                                  apr_size_t total_size,
-                                  apr_size_t directory_size,
-                                  apr_size_t segment_count,
-                                  svn_boolean_t thread_safe,
-                                  svn_boolean_t allow_blocking_writes,
-                                  apr_pool_t *pool)
+/* Allocate SIZE bytes of cache segment memory and return them.  Zero the
+ * memory if CLEAR is set.  If *SHARED_NEXT is not NULL, take the memory
+ * from the shared memory region at that address and advance *SHARED_NEXT
+ * accordingly.  Otherwise, allocate it in POOL.
+ */
+static void *
+segment_alloc(char **shared_next,
+              apr_size_t size,
+              svn_boolean_t clear,
+              apr_pool_t *pool)
+{
+  void *result = *shared_next;
+  if (result == NULL)
+    return clear ? apr_pcalloc(pool, size) : apr_palloc(pool, size);
+
+  *shared_next += ALIGN_VALUE(size);
+  if (clear)
+    memset(result, 0, size);
+
+  return result;
+}
+
+/* Implement svn_cache__membuffer_cache_create and
+ * svn_cache__membuffer_cache_create_shared.  If PROCESS_SHARED is set,
+ * put all segments into a shared memory region that will be inherited by
+ * child processes.
+ */
+static svn_error_t *
+membuffer_cache_create(svn_membuffer_t **cache,
+                       apr_size_t total_size,
+                       apr_size_t directory_size,
+                       apr_size_t segment_count,
+                       svn_boolean_t thread_safe,
+                       svn_boolean_t allow_blocking_writes,
+                       svn_cache__admission_policy_t admission_policy,
+                       svn_boolean_t process_shared,
+                       apr_pool_t *pool)
 {
   svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
+  apr_size_t prefix_pool_size;
+  char *shared_next = NULL;
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
@@ -1851,12 +2442,16 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   apr_uint32_t group_init_size;
   apr_uint64_t data_size;
   apr_uint64_t max_entry_size;
+  apr_uint32_t sketch_size;
 
   /* Allocate 1% of the cache capacity to the prefix string pool.
+   * Prefix indexes are process-local and can't be stored in a shared
+   * cache.  An empty prefix pool makes all front-ends use full keys.
    */
-  SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
+  prefix_pool_size = process_shared ? 0 : total_size / 100;
+  SVN_ERR(prefix_pool_create(&prefix_pool, prefix_pool_size, thread_safe,
                              pool));
-  total_size -= total_size / 100;
+  total_size -= prefix_pool_size;
 
   /* Limit the total size (only relevant if we can address > 4GB)
    */
@@ -1910,9 +2505,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
-
   /* Split total cache size into segments of equal size
    */
   total_size /= segment_count;
@@ -1963,6 +2555,46 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  /* Number of counters in the frequency sketch.  Must be a power of two.
+   */
+  sketch_size = 2;
+  while (   sketch_size / SKETCH_COUNTERS_PER_ENTRY
+              < (apr_uint64_t)main_group_count * GROUP_SIZE
+         && sketch_size < APR_UINT32_MAX / 2 + 1)
+    sketch_size *= 2;
+
+  /* Shared caches get a single memory region for all segments.
+   * Since we don't name it, only child processes will be able to use it.
+   */
+#if USE_SHARED_MEMORY
+  if (process_shared)
+    {
+      apr_shm_t *shm;
+      apr_status_t status;
+      apr_size_t segment_size
+        = ALIGN_VALUE(group_count * sizeof(entry_group_t))
+        + ALIGN_VALUE(group_init_size)
+        + (apr_size_t)ALIGN_VALUE(data_size)
+        + (admission_policy == svn_cache__admission_tinylfu
+             ? ALIGN_VALUE(sketch_size / 2)
+             : 0);
+
+      status = apr_shm_create(&shm,
+                              ALIGN_VALUE(segment_count * sizeof(*c))
+                                + segment_count * segment_size,
+                              NULL, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create shared memory cache"));
+
+      shared_next = apr_shm_baseaddr_get(shm);
+    }
+#endif
+
+  /* allocate cache as an array of segments / cache objects */
+  c = segment_alloc(&shared_next, segment_count * sizeof(*c), FALSE, pool);
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
@@ -1978,12 +2610,14 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      c[seg].directory = segment_alloc(&shared_next,
+                                       group_count * sizeof(entry_group_t),
+                                       FALSE, pool);
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      c[seg].group_initialized = segment_alloc(&shared_next,
+                                               group_init_size, TRUE, pool);
 
       /* Allocate 1/4th of the data buffer to L1
        */
@@ -2004,7 +2638,9 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
       /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      c[seg].data = segment_alloc(&shared_next,
+                                  (apr_size_t)ALIGN_VALUE(data_size),
+                                  FALSE, pool);
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
@@ -2012,11 +2648,27 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].total_reads = 0;
       c[seg].total_writes = 0;
       c[seg].total_hits = 0;
+      c[seg].total_rejects = 0;
+      c[seg].total_evictions = 0;
+
+      /* Only TinyLFU needs an access history. */
+      c[seg].admission_policy = admission_policy;
+      c[seg].sketch = admission_policy == svn_cache__admission_tinylfu
+                    ? segment_alloc(&shared_next, sketch_size / 2, TRUE,
+                                    pool)
+                    : NULL;
+      c[seg].sketch_mask = sketch_size - 1;
+      c[seg].sketch_additions = 0;
+      c[seg].sketch_sample_size = sketch_size / SKETCH_COUNTERS_PER_ENTRY
+                                * SKETCH_SAMPLE_FACTOR;
 
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
        */
-      if (c[seg].data == NULL || c[seg].directory == NULL)
+      if (   c[seg].data == NULL
+          || c[seg].directory == NULL
+          || (   admission_policy == svn_cache__admission_tinylfu
+              && c[seg].sketch == NULL))
         {
           /* We are OOM. There is no need to proceed with "half a cache".
            */
@@ -2032,7 +2684,7 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
       /* Same for read-write lock. */
       c[seg].lock = NULL;
-      if (thread_safe)
+      if (thread_safe && !process_shared)
         {
           apr_status_t status =
               apr_thread_rwlock_create(&(c[seg].lock), pool);
@@ -2046,6 +2698,19 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
 #endif
       /* No writers at the moment. */
       c[seg].write_lock_count = 0;
+
+#if USE_OPTIMISTIC_READS
+      /* Without locks, there is nothing to synchronize with. */
+      c[seg].optimistic_reads = thread_safe;
+      c[seg].change_counter = 0;
+#endif
+
+#if USE_SHARED_MEMORY
+      /* Shared segments use their own lock type. */
+      c[seg].process_shared = process_shared;
+      if (process_shared)
+        SVN_ERR(shared_lock_init(&c[seg]));
+#endif
     }
 
   /* done here
@@ -2054,18 +2719,56 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  apr_size_t segment_count,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t allow_blocking_writes,
+                                  svn_cache__admission_policy_t admission_policy,
+                                  apr_pool_t *pool)
+{
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count,
+                                                thread_safe,
+                                                allow_blocking_writes,
+                                                admission_policy,
+                                                FALSE, pool));
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(
+  svn_membuffer_t **cache,
+  apr_size_t total_size,
+  apr_size_t directory_size,
+  apr_size_t segment_count,
+  svn_boolean_t allow_blocking_writes,
+  svn_cache__admission_policy_t admission_policy,
+  apr_pool_t *result_pool)
+{
+#if USE_SHARED_MEMORY
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count,
+                                                TRUE,
+                                                allow_blocking_writes,
+                                                admission_policy,
+                                                TRUE, result_pool));
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Shared memory caches are not supported "
+                            "on this platform"));
+#endif
+}
+
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache)
 {
   apr_size_t seg;
   apr_size_t segment_count = cache->segment_count;
 
-  /* Length of the group_initialized array in bytes.
-     See also svn_cache__membuffer_cache_create(). */
-  apr_size_t group_init_size
-    = 1 + (cache->group_count + cache->spare_group_count)
-            / (8 * GROUP_INIT_GRANULARITY);
-
   /* Clear segment by segment.  This implies that other thread may read
      and write to other segments after we cleared them and before the
      last segment is done.
@@ -2078,31 +2781,13 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
     {
       /* Unconditionally acquire the write lock. */
       SVN_ERR(force_write_lock_cache(&cache[seg]));
+      begin_modification(&cache[seg]);
 
-      /* Mark all groups as "not initialized", which implies "empty". */
-      cache[seg].first_spare_group = NO_INDEX;
-      cache[seg].max_spare_used = 0;
-
-      memset(cache[seg].group_initialized, 0, group_init_size);
-
-      /* Unlink L1 contents. */
-      cache[seg].l1.first = NO_INDEX;
-      cache[seg].l1.last = NO_INDEX;
-      cache[seg].l1.next = NO_INDEX;
-      cache[seg].l1.current_data = cache[seg].l1.start_offset;
-
-      /* Unlink L2 contents. */
-      cache[seg].l2.first = NO_INDEX;
-      cache[seg].l2.last = NO_INDEX;
-      cache[seg].l2.next = NO_INDEX;
-      cache[seg].l2.current_data = cache[seg].l2.start_offset;
-
-      /* Reset content counters. */
-      cache[seg].data_used = 0;
-      cache[seg].used_entries = 0;
+      reset_segment(&cache[seg]);
 
       /* Segment may be used again. */
-      SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
+      SVN_ERR(unlock_cache(&cache[seg],
+                           end_modification(&cache[seg], SVN_NO_ERROR)));
     }
 
   /* done here */
@@ -2125,6 +2810,36 @@ entry_exists_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Lock-free variant of entry_exists_internal().  Return FALSE if the
+ * lookup could not be done reliably without locking CACHE.  In that case,
+ * *FOUND is undefined and the caller must retry using entry_exists().
+ */
+static svn_boolean_t
+entry_exists_optimistic(svn_membuffer_t *cache,
+                        apr_uint32_t group_index,
+                        const full_key_t *to_find,
+                        svn_boolean_t *found)
+{
+#if USE_OPTIMISTIC_READS
+  apr_uint32_t counter;
+  apr_uint64_t offset;
+  apr_size_t size;
+  entry_t *entry;
+
+  if (!cache->optimistic_reads || !begin_optimistic_read(cache, &counter))
+    return FALSE;
+
+  entry = find_entry_optimistic(cache, group_index, to_find, &offset, &size);
+  if (!end_optimistic_read(cache, counter))
+    return FALSE;
+
+  *found = entry != NULL;
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
  * by the hash value TO_FIND and set *FOUND accordingly.
  */
@@ -2134,6 +2849,9 @@ entry_exists(svn_membuffer_t *cache,
              const full_key_t *to_find,
              svn_boolean_t *found)
 {
+  if (entry_exists_optimistic(cache, group_index, to_find, found))
+    return SVN_NO_ERROR;
+
   WITH_READ_LOCK(cache,
                  entry_exists_internal(cache,
                                        group_index,
@@ -2143,12 +2861,13 @@ entry_exists(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
-/* Given the SIZE and PRIORITY of a new item, return the cache level
+/* Given the KEY, SIZE and PRIORITY of a new item, return the cache level
    (L1 or L2) in fragment CACHE that this item shall be inserted into.
    If we can't find nor make enough room for the item, return NULL.
  */
 static cache_level_t *
 select_level(svn_membuffer_t *cache,
+             const entry_key_t *key,
              apr_size_t size,
              apr_uint32_t priority)
 {
@@ -2165,6 +2884,7 @@ select_level(svn_membuffer_t *cache,
     {
       /* Large but important items go into L2. */
       entry_t dummy_entry = { { { 0 } } };
+      dummy_entry.key = *key;
       dummy_entry.priority = priority;
       dummy_entry.size = size;
 
@@ -2247,7 +2967,7 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
         memcpy(cache->data + entry->offset + entry->key.key_len, buffer,
                item_size);
 
-      cache->total_writes++;
+      svn_atomic__add64(&cache->total_writes, 1);
 
       /* Putting the decrement into an assert() to make it disappear
        * in production code. */
@@ -2257,7 +2977,9 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
 
   /* if necessary, enlarge the insertion window.
    */
-  level = buffer ? select_level(cache, size, priority) : NULL;
+  level = buffer
+        ? select_level(cache, &to_find->entry_key, size, priority)
+        : NULL;
   if (level)
     {
       /* Remove old data for this key, if that exists.
@@ -2291,7 +3013,7 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
         memcpy(cache->data + entry->offset + entry->key.key_len, buffer,
                item_size);
 
-      cache->total_writes++;
+      svn_atomic__add64(&cache->total_writes, 1);
     }
   else
     {
@@ -2310,6 +3032,371 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Cache snapshots start with this string.  Change it whenever the
+ * snapshot format or the fingerprint calculation changes.
+ */
+#define SNAPSHOT_MAGIC "SVN membuffer snapshot v1\n"
+
+/* Written directly after SNAPSHOT_MAGIC to detect snapshots created on
+ * platforms with a different byte order.
+ */
+#define SNAPSHOT_BYTE_ORDER_MARK 0x01020304
+
+/* Values of snapshot_entry_t.TYPE.
+ */
+#define SNAPSHOT_END 0
+#define SNAPSHOT_ENTRY 1
+
+/* Header of a cache entry in a snapshot.  In the snapshot, it is followed
+ * by SIZE bytes of data: the full key (KEY_LEN bytes) plus the serialized
+ * item.  All members are fixed-size and the struct has no padding.
+ */
+typedef struct snapshot_entry_t
+{
+  /* entry_key_t.FINGERPRINT */
+  apr_uint64_t fingerprint[2];
+
+  /* SNAPSHOT_ENTRY or SNAPSHOT_END.  All other members are undefined for
+   * the latter. */
+  apr_uint32_t type;
+
+  /* Index of the key prefix in the snapshot's prefix table.  NO_INDEX if
+   * the entry uses a full key. */
+  apr_uint32_t prefix_idx;
+
+  /* entry_key_t.KEY_LEN */
+  apr_uint32_t key_len;
+
+  /* entry_t.SIZE, i.e. including the key. */
+  apr_uint32_t size;
+
+  /* entry_t.PRIORITY */
+  apr_uint32_t priority;
+
+  /* entry_t.HIT_COUNT */
+  apr_uint32_t hit_count;
+
+  /* FNV-1a checksum over the SIZE data bytes that follow. */
+  apr_uint32_t checksum;
+
+  /* Keep the struct size a multiple of 8. */
+  apr_uint32_t padding;
+} snapshot_entry_t;
+
+/* Write the LEN bytes at DATA to STREAM.
+ */
+static svn_error_t *
+write_snapshot_data(svn_stream_t *stream,
+                    const void *data,
+                    apr_size_t len)
+{
+  return svn_error_trace(svn_stream_write(stream, data, &len));
+}
+
+/* Write the string DATA with length LEN to STREAM, prefixed by its length.
+ */
+static svn_error_t *
+write_snapshot_string(svn_stream_t *stream,
+                      const char *data,
+                      apr_uint32_t len)
+{
+  SVN_ERR(write_snapshot_data(stream, &len, sizeof(len)));
+  return svn_error_trace(write_snapshot_data(stream, data, len));
+}
+
+/* Write all entries of level LEVEL in SEGMENT to STREAM.  Ignore entries
+ * whose key prefix index is PREFIX_COUNT or larger.
+ *
+ * Note: This function requires the caller to serialize access.
+ */
+static svn_error_t *
+save_cache_level(svn_stream_t *stream,
+                 svn_membuffer_t *segment,
+                 cache_level_t *level,
+                 apr_uint32_t prefix_count)
+{
+  apr_uint32_t idx;
+  entry_t *entry;
+
+  for (idx = level->first; idx != NO_INDEX; idx = entry->next)
+    {
+      const unsigned char *data;
+      snapshot_entry_t header = { { 0 } };
+
+      entry = get_entry(segment, idx);
+      if (   entry->key.prefix_idx != NO_INDEX
+          && entry->key.prefix_idx >= prefix_count)
+        continue;
+
+      data = segment->data + entry->offset;
+
+      header.fingerprint[0] = entry->key.fingerprint[0];
+      header.fingerprint[1] = entry->key.fingerprint[1];
+      header.type = SNAPSHOT_ENTRY;
+      header.prefix_idx = entry->key.prefix_idx;
+      header.key_len = (apr_uint32_t)entry->key.key_len;
+      header.size = (apr_uint32_t)entry->size;
+      header.priority = entry->priority;
+      header.hit_count = entry->hit_count;
+      header.checksum = svn__fnv1a_32(data, entry->size);
+
+      SVN_ERR(write_snapshot_data(stream, &header, sizeof(header)));
+      SVN_ERR(write_snapshot_data(stream, data, entry->size));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write all entries in SEGMENT to STREAM, older ones first.  Ignore
+ * entries whose key prefix index is PREFIX_COUNT or larger.
+ *
+ * Note: This function requires the caller to serialize access.
+ */
+static svn_error_t *
+save_segment(svn_stream_t *stream,
+             svn_membuffer_t *segment,
+             apr_uint32_t prefix_count)
+{
+  SVN_ERR(save_cache_level(stream, segment, &segment->l2, prefix_count));
+  SVN_ERR(save_cache_level(stream, segment, &segment->l1, prefix_count));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          const char *validation_tag,
+                          apr_pool_t *scratch_pool)
+{
+  prefix_pool_t *prefix_pool = cache->prefix_pool;
+  apr_uint32_t byte_order_mark = SNAPSHOT_BYTE_ORDER_MARK;
+  apr_uint32_t prefix_count;
+  apr_uint32_t seg;
+  apr_uint32_t i;
+  snapshot_entry_t end = { { 0 } };
+
+  SVN_ERR(write_snapshot_data(stream, SNAPSHOT_MAGIC,
+                              sizeof(SNAPSHOT_MAGIC) - 1));
+  SVN_ERR(write_snapshot_data(stream, &byte_order_mark,
+                              sizeof(byte_order_mark)));
+  SVN_ERR(write_snapshot_string(stream, validation_tag,
+                                (apr_uint32_t)strlen(validation_tag)));
+
+  /* Prefix indexes are process-specific.  Therefore, store the prefixes
+   * themselves.  Prefixes never change once they have been added to the
+   * pool but new ones may be added while we write the snapshot. */
+  SVN_ERR(svn_mutex__lock(prefix_pool->mutex));
+  prefix_count = prefix_pool->values_used;
+  SVN_ERR(svn_mutex__unlock(prefix_pool->mutex, SVN_NO_ERROR));
+
+  SVN_ERR(write_snapshot_data(stream, &prefix_count, sizeof(prefix_count)));
+  for (i = 0; i < prefix_count; ++i)
+    SVN_ERR(write_snapshot_string(stream, prefix_pool->values[i],
+                              (apr_uint32_t)strlen(prefix_pool->values[i])));
+
+  /* Segment by segment, copy the cache contents. */
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    WITH_READ_LOCK(&cache[seg],
+                   save_segment(stream, &cache[seg], prefix_count));
+
+  end.type = SNAPSHOT_END;
+  SVN_ERR(write_snapshot_data(stream, &end, sizeof(end)));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read exactly LEN bytes from STREAM into BUFFER.  Return an error if
+ * the snapshot ends prematurely.
+ */
+static svn_error_t *
+read_snapshot_data(svn_stream_t *stream,
+                   void *buffer,
+                   apr_size_t len)
+{
+  apr_size_t bytes_read = len;
+  SVN_ERR(svn_stream_read_full(stream, buffer, &bytes_read));
+  if (bytes_read != len)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Unexpected end of cache snapshot"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read a string written by write_snapshot_string from STREAM and return
+ * it in *DATA.  Allocate it in RESULT_POOL.
+ */
+static svn_error_t *
+read_snapshot_string(const char **data,
+                     svn_stream_t *stream,
+                     apr_pool_t *result_pool)
+{
+  apr_uint32_t len;
+  char *buffer;
+
+  SVN_ERR(read_snapshot_data(stream, &len, sizeof(len)));
+  if (len >= SVN_MAX_OBJECT_SIZE)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Corrupt cache snapshot"));
+
+  buffer = apr_palloc(result_pool, len + 1);
+  SVN_ERR(read_snapshot_data(stream, buffer, len));
+  buffer[len] = '\0';
+
+  *data = buffer;
+  return SVN_NO_ERROR;
+}
+
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Put the entry described by HEADER with DATA into CACHE.  PREFIX_MAP
+ * translates the snapshot's prefix indexes into those of CACHE.
+ */
+static svn_error_t *
+load_entry(svn_membuffer_t *cache,
+           const snapshot_entry_t *header,
+           char *data,
+           const apr_uint32_t *prefix_map,
+           apr_pool_t *scratch_pool)
+{
+  full_key_t key;
+  apr_uint32_t group_index;
+  svn_membuffer_t *segment = cache;
+  svn_error_t *err;
+  entry_t *entry;
+
+  key.entry_key.fingerprint[0] = header->fingerprint[0];
+  key.entry_key.fingerprint[1] = header->fingerprint[1];
+  key.entry_key.key_len = header->key_len;
+  key.entry_key.prefix_idx = header->prefix_idx == NO_INDEX
+                           ? NO_INDEX
+                           : prefix_map[header->prefix_idx];
+
+  /* The cache ran out of space for prefixes.  Without a prefix index, we
+   * can't put this item into the cache. */
+  if (header->prefix_idx != NO_INDEX && key.entry_key.prefix_idx == NO_INDEX)
+    return SVN_NO_ERROR;
+
+  key.full_key.data = data;
+  key.full_key.size = header->key_len;
+
+  group_index = get_group_index(&segment, &key.entry_key);
+
+  /* Unlike regular writes, we always wait for the lock. */
+  SVN_ERR(force_write_lock_cache(segment));
+  begin_modification(segment);
+
+  err = membuffer_cache_set_internal(segment, &key, group_index,
+                                     data + header->key_len,
+                                     header->size - header->key_len,
+                                     header->priority, scratch_pool);
+
+  /* Restore the hit count such that the entry will have the same chance
+   * of being kept in the cache as before. */
+  entry = err ? NULL : find_entry(segment, group_index, &key, FALSE);
+  if (entry)
+    entry->hit_count = header->hit_count;
+
+  return svn_error_trace(unlock_cache(segment,
+                                      end_modification(segment, err)));
+}
+
+#endif
+
+svn_error_t *
+svn_cache__membuffer_load(svn_boolean_t *loaded,
+                          svn_membuffer_t *cache,
+                          svn_stream_t *stream,
+                          const char *validation_tag,
+                          apr_pool_t *scratch_pool)
+{
+#ifdef SVN_DEBUG_CACHE_MEMBUFFER
+
+  /* We can't reconstruct the debug tags for the loaded entries. */
+  *loaded = FALSE;
+  return SVN_NO_ERROR;
+
+#else
+
+  char magic[sizeof(SNAPSHOT_MAGIC) - 1];
+  apr_uint32_t byte_order_mark;
+  apr_uint32_t prefix_count;
+  apr_uint32_t *prefix_map;
+  const char *tag;
+  apr_uint32_t i;
+  apr_pool_t *iterpool;
+  apr_size_t len = sizeof(magic);
+
+  *loaded = FALSE;
+
+  /* Silently ignore snapshots that have been written by a different
+   * version or on a different platform. */
+  SVN_ERR(svn_stream_read_full(stream, magic, &len));
+  if (len != sizeof(magic) || memcmp(magic, SNAPSHOT_MAGIC, len))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_snapshot_data(stream, &byte_order_mark,
+                             sizeof(byte_order_mark)));
+  if (byte_order_mark != SNAPSHOT_BYTE_ORDER_MARK)
+    return SVN_NO_ERROR;
+
+  /* Reject outdated contents. */
+  SVN_ERR(read_snapshot_string(&tag, stream, scratch_pool));
+  if (strcmp(tag, validation_tag))
+    return SVN_NO_ERROR;
+
+  /* Map the snapshot's prefix indexes to ours. */
+  SVN_ERR(read_snapshot_data(stream, &prefix_count, sizeof(prefix_count)));
+  if (prefix_count >= SVN_MAX_OBJECT_SIZE / sizeof(*prefix_map))
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Corrupt cache snapshot"));
+
+  prefix_map = apr_palloc(scratch_pool, prefix_count * sizeof(*prefix_map));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < prefix_count; ++i)
+    {
+      const char *prefix;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_snapshot_string(&prefix, stream, iterpool));
+      SVN_ERR(prefix_pool_get(&prefix_map[i], cache->prefix_pool, prefix));
+    }
+
+  /* Add the entries to the cache. */
+  while (TRUE)
+    {
+      snapshot_entry_t header;
+      char *data;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_snapshot_data(stream, &header, sizeof(header)));
+      if (header.type == SNAPSHOT_END)
+        break;
+
+      if (   header.type != SNAPSHOT_ENTRY
+          || header.key_len > header.size
+          || (   header.prefix_idx != NO_INDEX
+              && header.prefix_idx >= prefix_count))
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Corrupt cache snapshot"));
+
+      data = apr_palloc(iterpool, header.size);
+      SVN_ERR(read_snapshot_data(stream, data, header.size));
+      if (svn__fnv1a_32(data, header.size) != header.checksum)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Corrupt cache snapshot"));
+
+      SVN_ERR(load_entry(cache, &header, data, prefix_map, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  *loaded = TRUE;
+
+  return SVN_NO_ERROR;
+
+#endif
+}
+
 /* Try to insert the ITEM and use the KEY to uniquely identify it.
  * However, there is no guarantee that it will actually be put into
  * the cache. If there is already some data associated to the KEY,
@@ -2367,9 +3454,29 @@ increment_hit_counters(svn_membuffer_t *cache, entry_t *entry)
   svn_atomic_inc(&entry->hit_count);
 
   /* That one is for stats only. */
-  cache->total_hits++;
+  svn_atomic__add64(&cache->total_hits, 1);
 }
 
+#if USE_OPTIMISTIC_READS
+
+/* Revert the hit count increment for ENTRY done by a lock-free read that
+ * turned out to be inconsistent.  A writer may have reset or reduced the
+ * hit count in the meantime, so never go below 0.
+ */
+static void
+take_back_hit(entry_t *entry)
+{
+  apr_uint32_t hit_count;
+
+  do
+    hit_count = svn_atomic_read(&entry->hit_count);
+  while (hit_count
+         && svn_atomic_cas(&entry->hit_count, hit_count - 1, hit_count)
+              != hit_count);
+}
+
+#endif
+
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
  * by the hash value TO_FIND. If no item has been stored for KEY,
  * *BUFFER will be NULL. Otherwise, return a copy of the serialized
@@ -2394,7 +3501,7 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   /* The actual cache data access needs to sync'ed
    */
   entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  svn_atomic__add64(&cache->total_reads, 1);
   if (entry == NULL)
     {
       /* no such entry found.
@@ -2433,6 +3540,74 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Lock-free variant of membuffer_cache_get_internal().  Return FALSE if
+ * the lookup could not be done reliably without locking CACHE.  In that
+ * case, the caller must retry using membuffer_cache_get_internal().
+ * Otherwise, *BUFFER and *ITEM_SIZE will have been set as in the locked
+ * variant.
+ */
+static svn_boolean_t
+membuffer_cache_get_optimistic(svn_membuffer_t *cache,
+                               apr_uint32_t group_index,
+                               const full_key_t *to_find,
+                               char **buffer,
+                               apr_size_t *item_size,
+                               apr_pool_t *result_pool)
+{
+#if USE_OPTIMISTIC_READS
+  apr_uint32_t counter;
+  apr_uint64_t offset;
+  apr_size_t size;
+  apr_size_t key_len = to_find->entry_key.key_len;
+  entry_t *entry;
+
+  if (!cache->optimistic_reads || !begin_optimistic_read(cache, &counter))
+    return FALSE;
+
+  /* Don't allocate memory based on inconsistent data. */
+  entry = find_entry_optimistic(cache, group_index, to_find, &offset, &size);
+  if (!end_optimistic_read(cache, counter))
+    return FALSE;
+
+  if (entry == NULL)
+    {
+      svn_atomic__add64(&cache->total_reads, 1);
+      *buffer = NULL;
+      *item_size = 0;
+
+      return TRUE;
+    }
+
+  /* Copy the item data.  A writer may have modified it while we were
+   * copying it, so check again afterwards.  In that case, we lose the
+   * allocated buffer until RESULT_POOL gets cleaned up but that should
+   * be rare. */
+  *buffer = apr_palloc(result_pool, ALIGN_VALUE(size) - key_len);
+  memcpy(*buffer, cache->data + offset + key_len,
+         ALIGN_VALUE(size) - key_len);
+
+  /* Count the hit before the final check such that we never credit it
+   * to some other entry that a writer put into the same slot meanwhile.
+   */
+  svn_atomic_inc(&entry->hit_count);
+  if (!end_optimistic_read(cache, counter))
+    {
+      take_back_hit(entry);
+      return FALSE;
+    }
+
+  /* update hit statistics
+   */
+  svn_atomic__add64(&cache->total_reads, 1);
+  svn_atomic__add64(&cache->total_hits, 1);
+  *item_size = size - key_len;
+
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
 /* Look for the *ITEM identified by KEY. If no item has been stored
  * for KEY, *ITEM will be NULL. Otherwise, the DESERIALIZER is called
  * to re-construct the proper object from the serialized data.
@@ -2453,14 +3628,18 @@ membuffer_cache_get(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, &key->entry_key);
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_internal(cache,
-                                              group_index,
-                                              key,
-                                              &buffer,
-                                              &size,
-                                              DEBUG_CACHE_MEMBUFFER_TAG
-                                              result_pool));
+  record_access(cache, &key->entry_key);
+
+  if (!membuffer_cache_get_optimistic(cache, group_index, key,
+                                      &buffer, &size, result_pool))
+    WITH_READ_LOCK(cache,
+                   membuffer_cache_get_internal(cache,
+                                                group_index,
+                                                key,
+                                                &buffer,
+                                                &size,
+                                                DEBUG_CACHE_MEMBUFFER_TAG
+                                                result_pool));
 
   /* re-construct the original data object from its serialized form.
    */
@@ -2502,6 +3681,52 @@ membuffer_cache_has_key_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Lock-free variant of membuffer_cache_has_key_internal().  Return FALSE
+ * if the lookup could not be done reliably without locking CACHE.  In that
+ * case, *FOUND is undefined and the caller must retry using the locked
+ * variant.
+ */
+static svn_boolean_t
+membuffer_cache_has_key_optimistic(svn_membuffer_t *cache,
+                                   apr_uint32_t group_index,
+                                   const full_key_t *to_find,
+                                   svn_boolean_t *found)
+{
+#if USE_OPTIMISTIC_READS
+  apr_uint32_t counter;
+  apr_uint64_t offset;
+  apr_size_t size;
+  entry_t *entry;
+
+  if (!cache->optimistic_reads || !begin_optimistic_read(cache, &counter))
+    return FALSE;
+
+  entry = find_entry_optimistic(cache, group_index, to_find, &offset, &size);
+
+  /* See membuffer_cache_has_key_internal() for why we count this as a
+   * hit.  As in membuffer_cache_get_optimistic(), do that before the
+   * final consistency check. */
+  if (entry)
+    svn_atomic_inc(&entry->hit_count);
+
+  if (!end_optimistic_read(cache, counter))
+    {
+      if (entry)
+        take_back_hit(entry);
+
+      return FALSE;
+    }
+
+  if (entry)
+    svn_atomic__add64(&cache->total_hits, 1);
+
+  *found = entry != NULL;
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
 /* Look for an entry identified by KEY.  If no item has been stored
  * for KEY, *FOUND will be set to FALSE and TRUE otherwise.
  */
@@ -2515,13 +3740,14 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
-  cache->total_reads++;
+  svn_atomic__add64(&cache->total_reads, 1);
 
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_has_key_internal(cache,
-                                                  group_index,
-                                                  key,
-                                                  found));
+  if (!membuffer_cache_has_key_optimistic(cache, group_index, key, found))
+    WITH_READ_LOCK(cache,
+                   membuffer_cache_has_key_internal(cache,
+                                                    group_index,
+                                                    key,
+                                                    found));
 
   return SVN_NO_ERROR;
 }
@@ -2549,7 +3775,7 @@ membuffer_cache_get_partial_internal(svn_membuffer_t *cache,
                                      apr_pool_t *result_pool)
 {
   entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  svn_atomic__add64(&cache->total_reads, 1);
   if (entry == NULL)
     {
       *item = NULL;
@@ -2600,6 +3826,7 @@ membuffer_cache_get_partial(svn_membuffer_t *cache,
                             apr_pool_t *result_pool)
 {
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
+  record_access(cache, &key->entry_key);
 
   WITH_READ_LOCK(cache,
                  membuffer_cache_get_partial_internal
@@ -2632,7 +3859,7 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
   /* cache item lookup
    */
   entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  svn_atomic__add64(&cache->total_reads, 1);
 
   /* this function is a no-op if the item is not in cache
    */
@@ -2647,7 +3874,7 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
       apr_size_t item_size = entry->size - key_len;
 
       increment_hit_counters(cache, entry);
-      cache->total_writes++;
+      svn_atomic__add64(&cache->total_writes, 1);
 
 #ifdef SVN_DEBUG_CACHE_MEMBUFFER
 
@@ -3131,6 +4358,8 @@ svn_membuffer_get_segment_info(svn_membuffer_t *segment,
 
   info->used_entries += segment->used_entries;
   info->total_entries += segment->group_count * GROUP_SIZE;
+  info->rejects += segment->total_rejects;
+  info->evictions += segment->total_evictions;
 
   if (include_histogram)
     for (i = 0; i < segment->group_count; ++i)
@@ -3448,9 +4677,9 @@ static svn_error_t *
 svn_membuffer_get_global_segment_info(svn_membuffer_t *segment,
                                       svn_cache__info_t *info)
 {
-  info->gets += segment->total_reads;
-  info->sets += segment->total_writes;
-  info->hits += segment->total_hits;
+  info->gets += svn_atomic__read64(&segment->total_reads);
+  info->sets += svn_atomic__read64(&segment->total_writes);
+  info->hits += svn_atomic__read64(&segment->total_hits);
 
   WITH_READ_LOCK(segment,
                   svn_membuffer_get_segment_info(segment, info, TRUE));
@@ -21,6 +21,11 @@
  * ====================================================================
  */
 
+#include <apr_time.h>
+
+#include "svn_sorts.h"
+#include "private/svn_atomic.h"
+
 #include "cache.h"
 
 svn_error_t *
@@ -45,6 +50,59 @@ svn_cache__is_cachable(svn_cache__t *cache,
   return cache->vtable->is_cachable(cache->cache_internal, size);
 }
 
+/* Return the start time to use with count_get() for a getter call on
+   CACHE, or 0 if we don't measure its duration. */
+static apr_time_t
+get_start_time(svn_cache__t *cache)
+{
+  return cache->metrics && svn_cache__config_get_latency_tracking()
+       ? apr_time_now()
+       : 0;
+}
+
+/* Count a getter call on CACHE that returned data if FOUND is set.  If
+   START is not 0, record the time since then as the call's duration. */
+static void
+count_get(svn_cache__t *cache,
+          svn_boolean_t found,
+          apr_time_t start)
+{
+  svn_cache__metrics_t *metrics = cache->metrics;
+
+  svn_atomic__add64(&cache->reads, 1);
+  if (found)
+    svn_atomic__add64(&cache->hits, 1);
+
+  if (metrics)
+    {
+      svn_atomic__add64(&metrics->gets, 1);
+      if (found)
+        svn_atomic__add64(&metrics->hits, 1);
+
+      if (start)
+        {
+          apr_time_t duration = MAX(apr_time_now() - start, 0);
+          int bucket = 0;
+
+          while (   bucket < SVN_CACHE__LATENCY_BUCKETS - 1
+                 && duration >= ((apr_time_t)1 << bucket))
+            ++bucket;
+
+          svn_atomic__add64(&metrics->latency[bucket], 1);
+          svn_atomic__add64(&metrics->latency_sum, (apr_uint64_t)duration);
+        }
+    }
+}
+
+/* Count a setter call on CACHE. */
+static void
+count_set(svn_cache__t *cache)
+{
+  svn_atomic__add64(&cache->writes, 1);
+  if (cache->metrics)
+    svn_atomic__add64(&cache->metrics->sets, 1);
+}
+
 /* Give the error handler callback a chance to replace or ignore the
    error. */
 static svn_error_t *
@@ -54,7 +112,9 @@ handle_error(svn_cache__t *cache,
 {
   if (err)
     {
-      cache->failures++;
+      svn_atomic__add64(&cache->failures, 1);
+      if (cache->metrics)
+        svn_atomic__add64(&cache->metrics->failures, 1);
       if (cache->error_handler)
         err = (cache->error_handler)(err, cache->error_baton, pool);
     }
@@ -71,6 +131,7 @@ svn_cache__get(void **value_p,
                apr_pool_t *result_pool)
 {
   svn_error_t *err;
+  apr_time_t start;
 
   /* In case any errors happen and are quelched, make sure we start
      out with FOUND set to false. */
@@ -80,7 +141,7 @@ svn_cache__get(void **value_p,
     return SVN_NO_ERROR;
 #endif
 
-  cache->reads++;
+  start = get_start_time(cache);
   err = handle_error(cache,
                      (cache->vtable->get)(value_p,
                                           found,
@@ -89,8 +150,7 @@ svn_cache__get(void **value_p,
                                           result_pool),
                      result_pool);
 
-  if (*found)
-    cache->hits++;
+  count_get(cache, *found, start);
 
   return err;
 }
@@ -121,7 +181,7 @@ svn_cache__set(svn_cache__t *cache,
                void *value,
                apr_pool_t *scratch_pool)
 {
-  cache->writes++;
+  count_set(cache);
   return handle_error(cache,
                       (cache->vtable->set)(cache->cache_internal,
                                            key,
@@ -161,6 +221,7 @@ svn_cache__get_partial(void **value,
                        apr_pool_t *result_pool)
 {
   svn_error_t *err;
+  apr_time_t start;
 
   /* In case any errors happen and are quelched, make sure we start
   out with FOUND set to false. */
@@ -170,7 +231,7 @@ svn_cache__get_partial(void **value,
     return SVN_NO_ERROR;
 #endif
 
-  cache->reads++;
+  start = get_start_time(cache);
   err = handle_error(cache,
                      (cache->vtable->get_partial)(value,
                                                   found,
@@ -181,8 +242,7 @@ svn_cache__get_partial(void **value,
                                                   result_pool),
                      result_pool);
 
-  if (*found)
-    cache->hits++;
+  count_get(cache, *found, start);
 
   return err;
 }
@@ -194,7 +254,7 @@ svn_cache__set_partial(svn_cache__t *cache,
                        void *baton,
                        apr_pool_t *scratch_pool)
 {
-  cache->writes++;
+  count_set(cache);
   return handle_error(cache,
                       (cache->vtable->set_partial)(cache->cache_internal,
                                                    key,
@@ -213,10 +273,10 @@ svn_cache__get_info(svn_cache__t *cache,
   /* write general statistics */
 
   memset(info, 0, sizeof(*info));
-  info->gets = cache->reads;
-  info->hits = cache->hits;
-  info->sets = cache->writes;
-  info->failures = cache->failures;
+  info->gets = svn_atomic__read64(&cache->reads);
+  info->hits = svn_atomic__read64(&cache->hits);
+  info->sets = svn_atomic__read64(&cache->writes);
+  info->failures = svn_atomic__read64(&cache->failures);
 
   /* Call the cache implementation for filling the blanks.
    * It might also replace some of the general stats but
@@ -231,10 +291,10 @@ svn_cache__get_info(svn_cache__t *cache,
 
   if (reset)
     {
-      cache->reads = 0;
-      cache->hits = 0;
-      cache->writes = 0;
-      cache->failures = 0;
+      svn_atomic__set64(&cache->reads, 0);
+      svn_atomic__set64(&cache->hits, 0);
+      svn_atomic__set64(&cache->writes, 0);
+      svn_atomic__set64(&cache->failures, 0);
     }
 
   return SVN_NO_ERROR;
@@ -296,6 +356,8 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             "sets    : %" APR_UINT64_T_FMT
                             " (%5.2f%% of misses)\n"
                             "failures: %" APR_UINT64_T_FMT "\n"
+                            "rejects : %" APR_UINT64_T_FMT "\n"
+                            "evicted : %" APR_UINT64_T_FMT "\n"
                             "used    : %" APR_UINT64_T_FMT " MB (%5.2f%%)"
                             " of %" APR_UINT64_T_FMT " MB data cache"
                             " / %" APR_UINT64_T_FMT " MB total cache memory\n"
@@ -308,6 +370,8 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             info->hits, hit_rate,
                             info->sets, write_rate,
                             info->failures,
+                            info->rejects,
+                            info->evictions,
 
                             info->used_size / _1MB, data_usage_rate,
                             info->data_size / _1MB,
@@ -84,6 +84,33 @@ typedef struct svn_cache__vtable_t {
                            apr_pool_t *result_pool);
 } svn_cache__vtable_t;
 
+/* Process-wide access statistics shared by all cache instances that got
+ * registered under the same NAME by svn_cache__enable_metrics().  Updates
+ * are atomic but not synchronized with each other.
+ */
+typedef struct svn_cache__metrics_t {
+  /* Name under which the caches were registered. */
+  const char *name;
+
+  /* Total number of calls to getters. */
+  volatile apr_uint64_t gets;
+
+  /* Total number of getter calls that returned a cached item. */
+  volatile apr_uint64_t hits;
+
+  /* Total number of calls to setters. */
+  volatile apr_uint64_t sets;
+
+  /* Total number of function calls that returned an error. */
+  volatile apr_uint64_t failures;
+
+  /* Number of getter calls by duration, see svn_cache__metrics_info_t. */
+  volatile apr_uint64_t latency[SVN_CACHE__LATENCY_BUCKETS];
+
+  /* Total duration of all getter calls counted in LATENCY. */
+  volatile apr_uint64_t latency_sum;
+} svn_cache__metrics_t;
+
 struct svn_cache__t {
   const svn_cache__vtable_t *vtable;
 
@@ -95,16 +122,20 @@ struct svn_cache__t {
   void *cache_internal;
 
   /* Total number of calls to getters. */
-  apr_uint64_t reads;
+  volatile apr_uint64_t reads;
 
   /* Total number of calls to set(). */
-  apr_uint64_t writes;
+  volatile apr_uint64_t writes;
 
   /* Total number of getter calls that returned a cached item. */
-  apr_uint64_t hits;
+  volatile apr_uint64_t hits;
 
   /* Total number of function calls that returned an error. */
-  apr_uint64_t failures;
+  volatile apr_uint64_t failures;
+
+  /* Process-wide statistics to update as well.  NULL if this cache has
+     not been registered with svn_cache__enable_metrics(). */
+  svn_cache__metrics_t *metrics;
 
   /* Cause all getters to act as though the cache contains no data.
      (Currently this never becomes set except in maintainer builds.) */
@@ -64,6 +64,25 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* Admission policy to use for the global membuffer cache.  This is not
+ * part of svn_cache_config_t because that struct must not be extended.
+ */
+static svn_cache__admission_policy_t admission_policy
+  = svn_cache__admission_default;
+
+/* Whether the global membuffer cache shall be shared with child processes.
+ */
+static svn_boolean_t process_shared = FALSE;
+
+/* Whether svn_cache__enable_metrics() shall actually attach caches to
+ * the process-wide statistics records.
+ */
+static svn_boolean_t metrics = FALSE;
+
+/* Whether to measure the duration of cache lookups.
+ */
+static svn_boolean_t latency_tracking = FALSE;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -120,14 +139,34 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
         return SVN_NO_ERROR;
       apr_allocator_owner_set(allocator, pool);
 
-      err = svn_cache__membuffer_cache_create(
-          &cache,
-          (apr_size_t)cache_size,
-          (apr_size_t)(cache_size / 5),
-          0,
-          ! svn_cache_config_get()->single_threaded,
-          FALSE,
-          pool);
+      err = process_shared
+          ? svn_cache__membuffer_cache_create_shared(
+                &cache,
+                (apr_size_t)cache_size,
+                (apr_size_t)(cache_size / 5),
+                0,
+                FALSE,
+                admission_policy,
+                pool)
+          : SVN_NO_ERROR;
+
+      /* Use a process-local cache if we can't or shan't share it. */
+      if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+        }
+
+      if (!err && !cache)
+        err = svn_cache__membuffer_cache_create(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            ! svn_cache_config_get()->single_threaded,
+            FALSE,
+            admission_policy,
+            pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
        * really care. Simply release all cache memory and disable caching
@@ -179,3 +218,50 @@ svn_cache_config_set(const svn_cache_config_t *settings)
   cache_settings = *settings;
 }
 
+void
+svn_cache__config_set_admission_policy(svn_cache__admission_policy_t policy)
+{
+  admission_policy = policy;
+}
+
+svn_cache__admission_policy_t
+svn_cache__config_get_admission_policy(void)
+{
+  return admission_policy;
+}
+
+void
+svn_cache__config_set_process_shared(svn_boolean_t shared)
+{
+  process_shared = shared;
+}
+
+svn_boolean_t
+svn_cache__config_get_process_shared(void)
+{
+  return process_shared;
+}
+
+void
+svn_cache__config_set_metrics(svn_boolean_t enabled)
+{
+  metrics = enabled;
+}
+
+svn_boolean_t
+svn_cache__config_get_metrics(void)
+{
+  return metrics;
+}
+
+void
+svn_cache__config_set_latency_tracking(svn_boolean_t enabled)
+{
+  latency_tracking = enabled;
+}
+
+svn_boolean_t
+svn_cache__config_get_latency_tracking(void)
+{
+  return latency_tracking;
+}
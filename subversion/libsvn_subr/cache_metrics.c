@@ -0,0 +1,417 @@
+/*
+ * cache_metrics.c: process-wide cache access statistics
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_general.h>
+#include <apr_hash.h>
+
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
+
+#include "cache.h"
+
+/* All statistics records of this process.  Records never get removed,
+ * so caches may keep pointers to them without holding the lock.
+ */
+typedef struct metrics_registry_t
+{
+  /* svn_cache__metrics_t *, keyed by their NAME. */
+  apr_hash_t *metrics;
+
+  /* Serializes access to METRICS. */
+  svn_mutex__t *mutex;
+} metrics_registry_t;
+
+/* The process-wide registry.  Use get_registry() to access it. */
+static metrics_registry_t *registry = NULL;
+
+/* Initialization state of REGISTRY. */
+static volatile svn_atomic_t registry_initialized = 0;
+
+/* Initializer function as required by svn_atomic__init_once.  Allocate
+ * the process-wide REGISTRY in its own root pool, i.e. for the lifetime
+ * of the process.  BATON and UNUSED_POOL are unused.
+ */
+static svn_error_t *
+initialize_registry(void *baton, apr_pool_t *unused_pool)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  metrics_registry_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  result->metrics = apr_hash_make(pool);
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+
+  registry = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *RESULT to the process-wide REGISTRY, creating it if necessary.
+ * Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+get_registry(metrics_registry_t **result,
+             apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_atomic__init_once(&registry_initialized, initialize_registry,
+                                NULL, scratch_pool));
+  *result = registry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *METRICS to the record for NAME in REGISTRY, adding it if it does
+ * not exist, yet.  The caller must hold REGISTRY's lock.
+ */
+static svn_error_t *
+get_record(svn_cache__metrics_t **metrics,
+           metrics_registry_t *registry,
+           const char *name)
+{
+  svn_cache__metrics_t *record = svn_hash_gets(registry->metrics, name);
+  if (record == NULL)
+    {
+      apr_pool_t *pool = apr_hash_pool_get(registry->metrics);
+
+      record = apr_pcalloc(pool, sizeof(*record));
+      record->name = apr_pstrdup(pool, name);
+      svn_hash_sets(registry->metrics, record->name, record);
+    }
+
+  *metrics = record;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__enable_metrics(svn_cache__t *cache,
+                          const char *name,
+                          apr_pool_t *scratch_pool)
+{
+  metrics_registry_t *metrics_registry;
+
+  /* Keep the lookups free of contended counter updates unless requested. */
+  if (!svn_cache__config_get_metrics())
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_registry(&metrics_registry, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(metrics_registry->mutex,
+                       get_record(&cache->metrics, metrics_registry, name));
+
+  return SVN_NO_ERROR;
+}
+
+/* Compare the names of the svn_cache__metrics_info_t given in **A and
+ * **B. */
+static int
+compare_metrics_info(const void *a,
+                     const void *b)
+{
+  const svn_cache__metrics_info_t *lhs
+    = *(const svn_cache__metrics_info_t * const *)a;
+  const svn_cache__metrics_info_t *rhs
+    = *(const svn_cache__metrics_info_t * const *)b;
+
+  return strcmp(lhs->name, rhs->name);
+}
+
+/* Append snapshots of all records in REGISTRY to RESULT, allocated in
+ * RESULT's pool.  The caller must hold REGISTRY's lock.
+ */
+static svn_error_t *
+collect_metrics(apr_array_header_t *result,
+                metrics_registry_t *registry)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(result->pool, registry->metrics);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_cache__metrics_t *record = apr_hash_this_val(hi);
+      svn_cache__metrics_info_t *info = apr_pcalloc(result->pool,
+                                                    sizeof(*info));
+      int i;
+
+      /* The name is immutable and lives as long as the process. */
+      info->name = record->name;
+      info->gets = svn_atomic__read64(&record->gets);
+      info->hits = svn_atomic__read64(&record->hits);
+      info->sets = svn_atomic__read64(&record->sets);
+      info->failures = svn_atomic__read64(&record->failures);
+      for (i = 0; i < SVN_CACHE__LATENCY_BUCKETS; ++i)
+        info->latency[i] = svn_atomic__read64(&record->latency[i]);
+      info->latency_sum = svn_atomic__read64(&record->latency_sum);
+
+      APR_ARRAY_PUSH(result, svn_cache__metrics_info_t *) = info;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__get_metrics(apr_array_header_t **metrics,
+                       apr_pool_t *result_pool)
+{
+  metrics_registry_t *metrics_registry;
+  apr_array_header_t *result
+    = apr_array_make(result_pool, 16, sizeof(svn_cache__metrics_info_t *));
+
+  SVN_ERR(get_registry(&metrics_registry, result_pool));
+  SVN_MUTEX__WITH_LOCK(metrics_registry->mutex,
+                       collect_metrics(result, metrics_registry));
+  svn_sort__array(result, compare_metrics_info);
+
+  *metrics = result;
+  return SVN_NO_ERROR;
+}
+
+/* Return NAME escaped for use as a label value in the Prometheus text
+ * format.  Allocate the result in POOL.
+ */
+static const char *
+escape_label(const char *name,
+             apr_pool_t *pool)
+{
+  svn_stringbuf_t *result;
+
+  if (strpbrk(name, "\\\"\n") == NULL)
+    return name;
+
+  result = svn_stringbuf_create_empty(pool);
+  for (; *name; ++name)
+    switch (*name)
+      {
+        case '\\': svn_stringbuf_appendcstr(result, "\\\\"); break;
+        case '"':  svn_stringbuf_appendcstr(result, "\\\""); break;
+        case '\n': svn_stringbuf_appendcstr(result, "\\n"); break;
+        default:   svn_stringbuf_appendbyte(result, *name); break;
+      }
+
+  return result->data;
+}
+
+/* Append the HELP and TYPE lines for metric NAME of the given TYPE with
+ * the description HELP to TEXT.
+ */
+static void
+append_header(svn_stringbuf_t *text,
+              const char *name,
+              const char *type,
+              const char *help)
+{
+  svn_stringbuf_appendcstr(text, "# HELP ");
+  svn_stringbuf_appendcstr(text, name);
+  svn_stringbuf_appendbyte(text, ' ');
+  svn_stringbuf_appendcstr(text, help);
+  svn_stringbuf_appendcstr(text, "\n# TYPE ");
+  svn_stringbuf_appendcstr(text, name);
+  svn_stringbuf_appendbyte(text, ' ');
+  svn_stringbuf_appendcstr(text, type);
+  svn_stringbuf_appendbyte(text, '\n');
+}
+
+/* Append one line per element in METRICS to TEXT, giving the counter
+ * found at OFFSET within the svn_cache__metrics_info_t as the value of
+ * the counter NAME that is described by HELP.  LABELS contains the
+ * escaped cache names.  Use POOL for temporaries.
+ */
+static void
+append_counter(svn_stringbuf_t *text,
+               const apr_array_header_t *metrics,
+               const char **labels,
+               apr_size_t offset,
+               const char *name,
+               const char *help,
+               apr_pool_t *pool)
+{
+  int i;
+
+  append_header(text, name, "counter", help);
+  for (i = 0; i < metrics->nelts; ++i)
+    {
+      const svn_cache__metrics_info_t *info
+        = APR_ARRAY_IDX(metrics, i, const svn_cache__metrics_info_t *);
+      const apr_uint64_t *value
+        = (const apr_uint64_t *)((const char *)info + offset);
+
+      svn_stringbuf_appendcstr(text,
+                               apr_psprintf(pool,
+                                            "%s{cache=\"%s\"} %"
+                                            APR_UINT64_T_FMT "\n",
+                                            name, labels[i], *value));
+    }
+}
+
+/* Append the metric NAME of the given TYPE with the description HELP and
+ * the VALUE to TEXT.  Use POOL for temporaries.
+ */
+static void
+append_value(svn_stringbuf_t *text,
+             const char *name,
+             const char *type,
+             const char *help,
+             apr_uint64_t value,
+             apr_pool_t *pool)
+{
+  append_header(text, name, type, help);
+  svn_stringbuf_appendcstr(text,
+                           apr_psprintf(pool, "%s %" APR_UINT64_T_FMT "\n",
+                                        name, value));
+}
+
+svn_error_t *
+svn_cache__format_metrics(svn_string_t **text,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(result_pool);
+  apr_array_header_t *metrics;
+  const char **labels;
+  int i;
+
+  SVN_ERR(svn_cache__get_metrics(&metrics, scratch_pool));
+
+  labels = apr_pcalloc(scratch_pool, (metrics->nelts + 1) * sizeof(*labels));
+  for (i = 0; i < metrics->nelts; ++i)
+    labels[i] = escape_label(APR_ARRAY_IDX(metrics, i,
+                                           svn_cache__metrics_info_t *)->name,
+                             scratch_pool);
+
+  /* Per-cache access counters. */
+  append_counter(result, metrics, labels,
+                 APR_OFFSETOF(svn_cache__metrics_info_t, gets),
+                 "svn_cache_gets_total",
+                 "Number of cache lookups.", scratch_pool);
+  append_counter(result, metrics, labels,
+                 APR_OFFSETOF(svn_cache__metrics_info_t, hits),
+                 "svn_cache_hits_total",
+                 "Number of cache lookups that found the item.",
+                 scratch_pool);
+  append_counter(result, metrics, labels,
+                 APR_OFFSETOF(svn_cache__metrics_info_t, sets),
+                 "svn_cache_sets_total",
+                 "Number of items added to the cache.", scratch_pool);
+  append_counter(result, metrics, labels,
+                 APR_OFFSETOF(svn_cache__metrics_info_t, failures),
+                 "svn_cache_failures_total",
+                 "Number of cache operations that failed.", scratch_pool);
+
+  /* Lookup latency histograms.  Bucket I counts durations below 2^I
+   * microseconds, i.e. up to and including 2^I - 1. */
+  append_header(result, "svn_cache_lookup_duration_microseconds",
+                "histogram", "Duration of cache lookups.");
+  for (i = 0; i < metrics->nelts; ++i)
+    {
+      const svn_cache__metrics_info_t *info
+        = APR_ARRAY_IDX(metrics, i, const svn_cache__metrics_info_t *);
+      apr_uint64_t count = 0;
+      int k;
+
+      for (k = 0; k < SVN_CACHE__LATENCY_BUCKETS; ++k)
+        {
+          count += info->latency[k];
+          svn_stringbuf_appendcstr(result,
+            k < SVN_CACHE__LATENCY_BUCKETS - 1
+              ? apr_psprintf(scratch_pool,
+                             "svn_cache_lookup_duration_microseconds_bucket"
+                             "{cache=\"%s\",le=\"%" APR_UINT64_T_FMT "\"} %"
+                             APR_UINT64_T_FMT "\n",
+                             labels[i], ((apr_uint64_t)1 << k) - 1, count)
+              : apr_psprintf(scratch_pool,
+                             "svn_cache_lookup_duration_microseconds_bucket"
+                             "{cache=\"%s\",le=\"+Inf\"} %"
+                             APR_UINT64_T_FMT "\n",
+                             labels[i], count));
+        }
+
+      svn_stringbuf_appendcstr(result,
+        apr_psprintf(scratch_pool,
+                     "svn_cache_lookup_duration_microseconds_sum"
+                     "{cache=\"%s\"} %" APR_UINT64_T_FMT "\n"
+                     "svn_cache_lookup_duration_microseconds_count"
+                     "{cache=\"%s\"} %" APR_UINT64_T_FMT "\n",
+                     labels[i], info->latency_sum, labels[i], count));
+    }
+
+  /* All membuffer caches share the same memory.  Report it as a whole. */
+  if (svn_cache__get_global_membuffer_cache())
+    {
+      svn_cache__info_t *info
+        = svn_cache__membuffer_get_global_info(scratch_pool);
+
+      append_value(result, "svn_membuffer_gets_total", "counter",
+                   "Number of lookups in the shared memory cache.",
+                   info->gets, scratch_pool);
+      append_value(result, "svn_membuffer_hits_total", "counter",
+                   "Number of lookups in the shared memory cache that"
+                   " found the item.",
+                   info->hits, scratch_pool);
+      append_value(result, "svn_membuffer_sets_total", "counter",
+                   "Number of items added to the shared memory cache.",
+                   info->sets, scratch_pool);
+      append_value(result, "svn_membuffer_rejects_total", "counter",
+                   "Number of items refused by the admission policy.",
+                   info->rejects, scratch_pool);
+      append_value(result, "svn_membuffer_evictions_total", "counter",
+                   "Number of items evicted to make room for new data.",
+                   info->evictions, scratch_pool);
+      append_value(result, "svn_membuffer_used_bytes", "gauge",
+                   "Size of the data in the shared memory cache.",
+                   info->used_size, scratch_pool);
+      append_value(result, "svn_membuffer_data_bytes", "gauge",
+                   "Memory reserved for data in the shared memory cache.",
+                   info->data_size, scratch_pool);
+      append_value(result, "svn_membuffer_total_bytes", "gauge",
+                   "Total memory of the shared memory cache.",
+                   info->total_size, scratch_pool);
+      append_value(result, "svn_membuffer_used_entries", "gauge",
+                   "Number of items in the shared memory cache.",
+                   info->used_entries, scratch_pool);
+      append_value(result, "svn_membuffer_total_entries", "gauge",
+                   "Capacity of the shared memory cache index.",
+                   info->total_entries, scratch_pool);
+    }
+
+  *text = svn_stringbuf__morph_into_string(result);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__write_metrics(const char *path,
+                         apr_pool_t *scratch_pool)
+{
+  svn_string_t *text;
+
+  SVN_ERR(svn_cache__format_metrics(&text, scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_write_atomic2(path, text->data, text->len, NULL, FALSE,
+                               scratch_pool));
+
+  return SVN_NO_ERROR;
+}
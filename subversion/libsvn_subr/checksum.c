@@ -35,6 +35,7 @@
 
 #include "checksum.h"
 #include "fnv1a.h"
+#include "sha1.h"
 
 #include "private/svn_subr_private.h"
 
@@ -475,8 +476,6 @@ svn_checksum(svn_checksum_t **checksum,
              apr_size_t len,
              apr_pool_t *pool)
 {
-  apr_sha1_ctx_t sha1_ctx;
-
   SVN_ERR(validate_kind(kind));
   *checksum = svn_checksum_create(kind, pool);
 
@@ -487,9 +486,7 @@ svn_checksum(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_init(&sha1_ctx);
-        apr_sha1_update(&sha1_ctx, data, (unsigned int)len);
-        apr_sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
+        svn__sha1((unsigned char *)(*checksum)->digest, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -550,8 +547,7 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
         break;
 
       case svn_checksum_sha1:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        ctx->apr_ctx = svn_sha1__context_create(pool);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -580,8 +576,7 @@ svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
         break;
 
       case svn_checksum_sha1:
-        memset(ctx->apr_ctx, 0, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        svn_sha1__context_reset(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -611,7 +606,7 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_update(ctx->apr_ctx, data, (unsigned int)len);
+        svn_sha1__update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -630,6 +625,38 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
   return SVN_NO_ERROR;
 }
 
+/* Number of bytes to feed into one checksum context before switching to
+ * the other one in svn_checksum__update_pair().  Small enough for the
+ * chunk to still be in the L1 cache when the second context reads it.
+ */
+#define UPDATE_PAIR_CHUNK_SIZE 0x2000
+
+svn_error_t *
+svn_checksum__update_pair(svn_checksum_ctx_t *ctx1,
+                          svn_checksum_ctx_t *ctx2,
+                          const void *data,
+                          apr_size_t len)
+{
+  const char *chunk = data;
+
+  if (ctx1 == NULL || ctx2 == NULL)
+    return svn_error_trace(svn_checksum_update(ctx1 ? ctx1 : ctx2,
+                                               data, len));
+
+  while (len > 0)
+    {
+      apr_size_t chunk_len = MIN(len, UPDATE_PAIR_CHUNK_SIZE);
+
+      SVN_ERR(svn_checksum_update(ctx1, chunk, chunk_len));
+      SVN_ERR(svn_checksum_update(ctx2, chunk, chunk_len));
+
+      chunk += chunk_len;
+      len -= chunk_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_checksum_final(svn_checksum_t **checksum,
                    const svn_checksum_ctx_t *ctx,
@@ -644,7 +671,7 @@ svn_checksum_final(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_sha1__finalize((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
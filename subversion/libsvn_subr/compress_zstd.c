@@ -0,0 +1,472 @@
+/*
+ * compress_zstd.c:  Zstandard data compression routines
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <assert.h>
+
+#include <apr_thread_proc.h>
+
+#include "private/svn_atomic.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+#include "pools.h"
+
+#ifdef SVN_HAVE_ZSTD
+
+#include <zstd.h>
+#include <zdict.h>
+
+struct svn__zstd_dict_t
+{
+  /* Dictionary digested for compression at a fixed level. */
+  ZSTD_CDict *cdict;
+
+  /* Dictionary digested for decompression. */
+  ZSTD_DDict *ddict;
+
+  /* Dictionary ID as recorded in the compressed frames. */
+  apr_uint32_t id;
+};
+
+/* (De-)compression contexts are expensive to create and keep large
+ * buffers.  Each thread therefore gets its own pair of contexts that it
+ * re-uses for all operations.
+ */
+typedef struct contexts_t
+{
+  ZSTD_CCtx *cctx;
+  ZSTD_DCtx *dctx;
+} contexts_t;
+
+/* Free the contexts_t in DATA. */
+static void
+free_contexts(void *data)
+{
+  contexts_t *contexts = data;
+  if (contexts)
+    {
+      ZSTD_freeCCtx(contexts->cctx);
+      ZSTD_freeDCtx(contexts->dctx);
+      free(contexts);
+    }
+}
+
+/* Initialization state of the thread-local storage. */
+static volatile svn_atomic_t contexts_key_init_state = 0;
+
+#if APR_HAS_THREADS
+
+/* Key to the current thread's contexts_t. */
+static apr_threadkey_t *contexts_key = NULL;
+
+/* Implements svn_atomic__str_init_func_t. */
+static const char *
+init_contexts_key(void *baton)
+{
+  if (apr_threadkey_private_create(&contexts_key, free_contexts,
+                                   svn_pool__create_unmanaged(FALSE)))
+    return "Can't create Zstandard context key";
+
+  return NULL;
+}
+
+#else
+
+/* The only thread's contexts. */
+static contexts_t *global_contexts = NULL;
+
+/* Implements svn_atomic__str_init_func_t. */
+static const char *
+init_contexts_key(void *baton)
+{
+  return NULL;
+}
+
+#endif
+
+/* Return the current thread's Zstandard contexts.  Create them if
+ * necessary.  Return NULL if we ran out of memory.
+ */
+static contexts_t *
+get_contexts(void)
+{
+  contexts_t *contexts;
+
+  if (svn_atomic__init_once_no_error(&contexts_key_init_state,
+                                     init_contexts_key, NULL))
+    return NULL;
+
+#if APR_HAS_THREADS
+  {
+    void *data = NULL;
+    if (apr_threadkey_private_get(&data, contexts_key))
+      return NULL;
+
+    contexts = data;
+  }
+#else
+  contexts = global_contexts;
+#endif
+
+  if (contexts)
+    return contexts;
+
+  contexts = calloc(1, sizeof(*contexts));
+  if (!contexts)
+    return NULL;
+
+  contexts->cctx = ZSTD_createCCtx();
+  contexts->dctx = ZSTD_createDCtx();
+  if (!contexts->cctx || !contexts->dctx)
+    {
+      free_contexts(contexts);
+      return NULL;
+    }
+
+#if APR_HAS_THREADS
+  if (apr_threadkey_private_set(contexts, contexts_key))
+    {
+      free_contexts(contexts);
+      return NULL;
+    }
+#else
+  global_contexts = contexts;
+#endif
+
+  return contexts;
+}
+
+/* Pool cleanup function freeing the svn__zstd_dict_t in DATA. */
+static apr_status_t
+free_dict(void *data)
+{
+  svn__zstd_dict_t *dict = data;
+
+  ZSTD_freeCDict(dict->cdict);
+  ZSTD_freeDDict(dict->ddict);
+
+  return APR_SUCCESS;
+}
+
+svn_boolean_t
+svn__zstd_available(void)
+{
+  return TRUE;
+}
+
+svn_error_t *
+svn__zstd_dict_create(svn__zstd_dict_t **dict,
+                      const void *data,
+                      apr_size_t len,
+                      int compression_level,
+                      apr_pool_t *result_pool)
+{
+  svn__zstd_dict_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->id = ZDICT_getDictID(data, len);
+  if (result->id == 0)
+    return svn_error_create(SVN_ERR_ZSTD_COMPRESSION_FAILED, NULL,
+                            _("Invalid Zstandard dictionary"));
+
+  result->cdict = ZSTD_createCDict(data, len, compression_level);
+  result->ddict = ZSTD_createDDict(data, len);
+  apr_pool_cleanup_register(result_pool, result, free_dict,
+                            apr_pool_cleanup_null);
+
+  if (!result->cdict || !result->ddict)
+    return svn_error_create(SVN_ERR_ZSTD_COMPRESSION_FAILED, NULL,
+                            _("Can't create Zstandard dictionary"));
+
+  *dict = result;
+  return SVN_NO_ERROR;
+}
+
+apr_uint32_t
+svn__zstd_dict_id(const svn__zstd_dict_t *dict)
+{
+  return dict->id;
+}
+
+svn_error_t *
+svn__zstd_train_dict(svn_stringbuf_t **dict,
+                     const apr_array_header_t *samples,
+                     apr_size_t max_size,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buffer;
+  size_t *sizes;
+  size_t result;
+  int i;
+
+  /* ZDICT wants all samples in one contiguous buffer. */
+  buffer = svn_stringbuf_create_empty(scratch_pool);
+  sizes = apr_palloc(scratch_pool, (samples->nelts + 1) * sizeof(*sizes));
+  for (i = 0; i < samples->nelts; ++i)
+    {
+      const svn_string_t *sample = APR_ARRAY_IDX(samples, i,
+                                                 const svn_string_t *);
+      svn_stringbuf_appendbytes(buffer, sample->data, sample->len);
+      sizes[i] = sample->len;
+    }
+
+  *dict = svn_stringbuf_create_ensure(max_size, result_pool);
+  result = ZDICT_trainFromBuffer((*dict)->data, max_size,
+                                 buffer->data, sizes, samples->nelts);
+  if (ZDICT_isError(result))
+    return svn_error_createf(SVN_ERR_ZSTD_COMPRESSION_FAILED, NULL,
+                             _("Can't train Zstandard dictionary: %s"),
+                             ZDICT_getErrorName(result));
+
+  (*dict)->len = result;
+  (*dict)->data[result] = 0;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int compression_level,
+                   const svn__zstd_dict_t *dict)
+{
+  apr_size_t hdrlen;
+  unsigned char buf[SVN__MAX_ENCODED_UINT_LEN];
+  unsigned char *p;
+  apr_size_t max_compressed_data_len;
+  size_t compressed_data_len;
+  contexts_t *contexts = get_contexts();
+
+  if (!contexts)
+    return svn_error_create(SVN_ERR_ZSTD_COMPRESSION_FAILED, NULL,
+                            _("Can't allocate Zstandard context"));
+
+  assert(compression_level >= 1 && compression_level <= SVN__ZSTD_MAX_LEVEL);
+
+  p = svn__encode_uint(buf, (apr_uint64_t)len);
+  hdrlen = p - buf;
+  max_compressed_data_len = ZSTD_compressBound(len);
+  svn_stringbuf_setempty(out);
+  svn_stringbuf_ensure(out, max_compressed_data_len + hdrlen);
+  svn_stringbuf_appendbytes(out, (const char *)buf, hdrlen);
+
+  /* We store the original length ourselves, so there is no need to
+   * repeat it in the frame header.  Keep the dictionary ID, though,
+   * such that we may detect dictionary mismatches. */
+  ZSTD_CCtx_reset(contexts->cctx, ZSTD_reset_session_and_parameters);
+  ZSTD_CCtx_setParameter(contexts->cctx, ZSTD_c_contentSizeFlag, 0);
+  ZSTD_CCtx_setParameter(contexts->cctx, ZSTD_c_checksumFlag, 0);
+  if (dict)
+    ZSTD_CCtx_refCDict(contexts->cctx, dict->cdict);
+  else
+    ZSTD_CCtx_setParameter(contexts->cctx, ZSTD_c_compressionLevel,
+                           compression_level);
+
+  compressed_data_len = ZSTD_compress2(contexts->cctx,
+                                       out->data + out->len,
+                                       max_compressed_data_len,
+                                       data, len);
+  if (ZSTD_isError(compressed_data_len))
+    return svn_error_create(SVN_ERR_ZSTD_COMPRESSION_FAILED, NULL,
+                            ZSTD_getErrorName(compressed_data_len));
+
+  if (compressed_data_len >= len)
+    {
+      /* Compression didn't help :(, just append the original text */
+      svn_stringbuf_appendbytes(out, data, len);
+    }
+  else
+    {
+      out->len += compressed_data_len;
+      out->data[out->len] = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn__decompress_zstd(const void *data, apr_size_t len,
+                     svn_stringbuf_t *out,
+                     apr_size_t limit,
+                     const svn__zstd_dict_t *dict)
+{
+  apr_size_t hdrlen;
+  apr_size_t compressed_data_len;
+  apr_size_t decompressed_data_len;
+  apr_uint64_t u64;
+  const unsigned char *p = data;
+  contexts_t *contexts;
+  size_t rv;
+
+  /* First thing in the string is the original length.  */
+  p = svn__decode_uint(&u64, p, p + len);
+  if (p == NULL)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of compressed data failed: "
+                              "no size"));
+  if (u64 > limit)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of compressed data failed: "
+                              "size too large"));
+  decompressed_data_len = (apr_size_t)u64;
+  hdrlen = p - (const unsigned char *)data;
+  compressed_data_len = len - hdrlen;
+
+  svn_stringbuf_setempty(out);
+  svn_stringbuf_ensure(out, decompressed_data_len);
+
+  if (compressed_data_len == decompressed_data_len)
+    {
+      /* Data is in the original, uncompressed form. */
+      memcpy(out->data, p, decompressed_data_len);
+    }
+  else
+    {
+      unsigned int dict_id = ZSTD_getDictID_fromFrame(p,
+                                                      compressed_data_len);
+      if (dict_id && (!dict || dict->id != dict_id))
+        return svn_error_createf(SVN_ERR_ZSTD_DECOMPRESSION_FAILED, NULL,
+                                 _("Compressed data requires the "
+                                   "Zstandard dictionary %u"), dict_id);
+
+      contexts = get_contexts();
+      if (!contexts)
+        return svn_error_create(SVN_ERR_ZSTD_DECOMPRESSION_FAILED, NULL,
+                                _("Can't allocate Zstandard context"));
+
+      if (dict_id)
+        rv = ZSTD_decompress_usingDDict(contexts->dctx,
+                                        out->data, decompressed_data_len,
+                                        p, compressed_data_len,
+                                        dict->ddict);
+      else
+        rv = ZSTD_decompressDCtx(contexts->dctx,
+                                 out->data, decompressed_data_len,
+                                 p, compressed_data_len);
+
+      if (ZSTD_isError(rv))
+        return svn_error_create(SVN_ERR_ZSTD_DECOMPRESSION_FAILED, NULL,
+                                ZSTD_getErrorName(rv));
+
+      if (rv != decompressed_data_len)
+        return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA,
+                                NULL,
+                                _("Size of uncompressed data "
+                                  "does not match stored original length"));
+    }
+
+  out->data[decompressed_data_len] = 0;
+  out->len = decompressed_data_len;
+
+  return SVN_NO_ERROR;
+}
+
+const char *
+svn_zstd__compiled_version(void)
+{
+  static const char zstd_version_str[] = ZSTD_VERSION_STRING;
+
+  return zstd_version_str;
+}
+
+const char *
+svn_zstd__runtime_version(void)
+{
+  return ZSTD_versionString();
+}
+
+#else /* !SVN_HAVE_ZSTD */
+
+/* Return the error to report for any Zstandard operation. */
+static svn_error_t *
+zstd_not_available(void)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Zstandard compression is not available "
+                            "in this build"));
+}
+
+svn_boolean_t
+svn__zstd_available(void)
+{
+  return FALSE;
+}
+
+svn_error_t *
+svn__zstd_dict_create(svn__zstd_dict_t **dict,
+                      const void *data,
+                      apr_size_t len,
+                      int compression_level,
+                      apr_pool_t *result_pool)
+{
+  return zstd_not_available();
+}
+
+apr_uint32_t
+svn__zstd_dict_id(const svn__zstd_dict_t *dict)
+{
+  return 0;
+}
+
+svn_error_t *
+svn__zstd_train_dict(svn_stringbuf_t **dict,
+                     const apr_array_header_t *samples,
+                     apr_size_t max_size,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  return zstd_not_available();
+}
+
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int compression_level,
+                   const svn__zstd_dict_t *dict)
+{
+  return zstd_not_available();
+}
+
+svn_error_t *
+svn__decompress_zstd(const void *data, apr_size_t len,
+                     svn_stringbuf_t *out,
+                     apr_size_t limit,
+                     const svn__zstd_dict_t *dict)
+{
+  return zstd_not_available();
+}
+
+const char *
+svn_zstd__compiled_version(void)
+{
+  return NULL;
+}
+
+const char *
+svn_zstd__runtime_version(void)
+{
+  return NULL;
+}
+
+#endif /* SVN_HAVE_ZSTD */
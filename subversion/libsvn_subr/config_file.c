@@ -1552,6 +1552,23 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set to 'wal' to use SQLite's write-ahead log for working copy"  NL
+        "### databases.  This speeds up operations that modify many nodes"   NL
+        "### and lets readers proceed while a writer is active.  It does not"NL
+        "### work for working copies on network file systems.  All clients"  NL
+        "### accessing a working copy should use the same setting."          NL
+        "### Possible values:"                                               NL
+        "###   truncate           (rollback journal, the default)"           NL
+        "###   wal                (write-ahead log)"                         NL
+        "# journal-mode = truncate"                                          NL
+        "### Set how often SQLite flushes working copy databases to disk."   NL
+        "### 'off' only guarantees atomic commits on application crashes"    NL
+        "### while 'normal' and 'full' also protect against power failures"  NL
+        "### at the expense of performance."                                 NL
+        "# synchronous = off"                                                NL
+        "### Set the size in MB up to which working copy databases will be"  NL
+        "### accessed through memory mapping.  The default is 0, i.e. off."  NL
+        "# mmap-size = 0"                                                    NL
         ;
 
       err = svn_io_file_open(&f, path,
@@ -30,9 +30,32 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#  define SVN_EOL_SSE2
+#  include <emmintrin.h>
+#endif
+
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len)
 {
+#ifdef SVN_EOL_SSE2
+
+  /* Scan the input 16 bytes at a time. */
+  const __m128i r_mask = _mm_set1_epi8('\r');
+  const __m128i n_mask = _mm_set1_epi8('\n');
+
+  for (; len >= 16; buf += 16, len -= 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)buf);
+      int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, r_mask),
+                                                _mm_cmpeq_epi8(chunk,
+                                                               n_mask)));
+      if (mask)
+        return buf + __builtin_ctz(mask);
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
@@ -24,6 +24,7 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 
 #include <apr_version.h>
@@ -214,6 +215,176 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
   return SVN_NO_ERROR;
 }
 
+/* Find the line starting at *DATA in the buffer ending at END, which must
+ * be followed by a NUL.  Replace the line's newline with a NUL, return
+ * the start of the line in *LINE and its length in *LEN, and advance
+ * *DATA to the start of the next line.  Set *EOF if the line was not
+ * terminated by a newline, i.e. ran up to END.
+ */
+static void
+parse_line(char **line,
+           apr_size_t *len,
+           svn_boolean_t *eof,
+           char **data,
+           const char *end)
+{
+  char *eol = memchr(*data, '\n', end - *data);
+
+  *line = *data;
+  *eof = (eol == NULL);
+  if (*eof)
+    {
+      *len = end - *data;
+      *data += *len;
+    }
+  else
+    {
+      *len = eol - *data;
+      *eol = '\0';
+      *data = eol + 1;
+    }
+}
+
+/* Parse the decimal length in the NUL-terminated LINE following its two
+ * char prefix into *LEN.  Return an error with MESSAGE if that fails.
+ */
+static svn_error_t *
+parse_length(apr_size_t *len,
+             const char *line,
+             const char *message)
+{
+  apr_uint64_t ui64;
+  svn_error_t *err = svn_cstring_strtoui64(&ui64, line + 2,
+                                           0, APR_SIZE_MAX, 10);
+  if (err)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, err, message);
+
+  *len = (apr_size_t)ui64;
+  return SVN_NO_ERROR;
+}
+
+/* Return the LEN bytes of data at *DATA in *STRING, NUL-terminate them in
+ * place of their trailing newline and advance *DATA past that newline.
+ * END is the end of the buffer.  Return an error with MESSAGE if the data
+ * is truncated or not followed by a newline.
+ */
+static svn_error_t *
+parse_data(char **string,
+           char **data,
+           const char *end,
+           apr_size_t len,
+           const char *message)
+{
+  if (len >= (apr_size_t)(end - *data) || (*data)[len] != '\n')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, message);
+
+  *string = *data;
+  (*string)[len] = '\0';
+  *data += len + 1;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_hash__parse_entry(svn_hash__entry_t *entry,
+                      char **data,
+                      const char *end,
+                      const char *terminator,
+                      svn_boolean_t incremental)
+{
+  char *line;
+  apr_size_t len;
+  svn_boolean_t eof;
+
+  /* Read a key length line.  Might be END, though. */
+  parse_line(&line, &len, &eof, data, end);
+
+  /* Check for the end of the hash.  There may be a NUL in the middle of
+   * LINE, so compare lengths as well. */
+  if ((!terminator && eof && len == 0)
+      || (terminator && (strcmp(line, terminator) == 0)
+          && (len == strlen(terminator))))
+  {
+    entry->key = NULL;
+    entry->keylen = 0;
+    entry->val = NULL;
+    entry->vallen = 0;
+
+    return SVN_NO_ERROR;
+  }
+
+  /* Check for unexpected end of data */
+  if (eof)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Serialized hash missing terminator"));
+
+  if ((len >= 3) && (line[0] == 'K') && (line[1] == ' '))
+    {
+      SVN_ERR(parse_length(&entry->keylen, line,
+                           _("Serialized hash malformed key length")));
+      SVN_ERR(parse_data(&entry->key, data, end, entry->keylen,
+                         _("Serialized hash malformed key data")));
+
+      /* Read a val length line */
+      parse_line(&line, &len, &eof, data, end);
+      if ((len >= 3) && (line[0] == 'V') && (line[1] == ' '))
+        {
+          SVN_ERR(parse_length(&entry->vallen, line,
+                               _("Serialized hash malformed value length")));
+          SVN_ERR(parse_data(&entry->val, data, end, entry->vallen,
+                             _("Serialized hash malformed value data")));
+        }
+      else
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Serialized hash malformed"));
+    }
+  else if (incremental && (len >= 3)
+           && (line[0] == 'D') && (line[1] == ' '))
+    {
+      SVN_ERR(parse_length(&entry->keylen, line,
+                           _("Serialized hash malformed key length")));
+      SVN_ERR(parse_data(&entry->key, data, end, entry->keylen,
+                         _("Serialized hash malformed key data")));
+
+      /* Remove this hash entry. */
+      entry->vallen = 0;
+      entry->val = NULL;
+    }
+  else
+    {
+      return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                              _("Serialized hash malformed"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_hash__parse(char **data,
+                const char *end,
+                const char *terminator,
+                svn_boolean_t incremental,
+                svn_hash__entry_func_t entry_func,
+                void *baton,
+                apr_pool_t *scratch_pool)
+{
+  while (1)
+    {
+      svn_hash__entry_t entry;
+
+      SVN_ERR(svn_hash__parse_entry(&entry, data, end, terminator,
+                                    incremental));
+
+      /* end of hash? */
+      if (entry.key == NULL)
+        break;
+
+      SVN_ERR(entry_func(baton, &entry, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
           svn_boolean_t incremental, apr_pool_t *pool)
@@ -852,6 +852,48 @@ rangelist_is_sorted(const svn_rangelist_t *rangelist)
   return TRUE;
 }
 
+/* Return the index of the first range in RANGELIST, starting at index
+ * FROM, whose end revision is greater than REV, or RANGELIST->NELTS if
+ * there is none.
+ *
+ * RANGELIST must be sorted and free of overlaps, i.e. the range ends must
+ * be ascending.  We gallop from FROM and then bisect, so skipping D ranges
+ * takes O(log D) comparisons. */
+static int
+rangelist_skip_to(const svn_rangelist_t *rangelist,
+                  int from,
+                  svn_revnum_t rev)
+{
+  int lo = from;
+  int hi = from;
+  int step = 1;
+
+  /* All ranges before LO end at or before REV.  Widen the window until
+     HI is either past the end or a range that ends after REV. */
+  while (hi < rangelist->nelts
+         && APR_ARRAY_IDX(rangelist, hi, svn_merge_range_t *)->end <= rev)
+    {
+      lo = hi + 1;
+      hi += step;
+      step *= 2;
+    }
+
+  if (hi > rangelist->nelts)
+    hi = rangelist->nelts;
+
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (APR_ARRAY_IDX(rangelist, mid, svn_merge_range_t *)->end <= rev)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
 /* Mergeinfo inheritance or absence in a rangelist interval */
 enum rangelist_interval_kind_t { MI_NONE, MI_NON_INHERITABLE, MI_INHERITABLE };
 
@@ -1082,6 +1124,77 @@ rangelist_merge(svn_rangelist_t *rl_out,
   return SVN_NO_ERROR;
 }
 
+/* Rangelists with at least this many ranges will be updated in place by
+ * svn_rangelist_merge2() instead of being rebuilt from scratch. */
+#define RANGELIST_IN_PLACE_MERGE_THRESHOLD 64
+
+/* Merge CHG into RANGELIST like rangelist_merge() but only rebuild the
+ * section of RANGELIST that overlaps or touches the span of CHG.  The
+ * ranges before and after that section are left untouched and get found
+ * by rangelist_skip_to(), so merging a few ranges into a long rangelist
+ * costs O(log N) comparisons plus a single memmove.
+ *
+ * RANGELIST must be sorted and free of overlaps.  Adjacent ranges outside
+ * the rebuilt section will not be combined, i.e. a non-canonical RANGELIST
+ * may not become canonical.
+ *
+ * New ranges will be allocated in RESULT_POOL.
+ */
+static svn_error_t *
+rangelist_merge_in_place(svn_rangelist_t *rangelist,
+                         const svn_rangelist_t *chg,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  const int elt_size = rangelist->elt_size;
+  svn_rangelist_t *section;
+  svn_rangelist_t *merged;
+  svn_revnum_t chg_start, chg_end;
+  int first, last, tail, delta, i;
+
+  if (chg->nelts == 0)
+    return SVN_NO_ERROR;
+
+  chg_start = APR_ARRAY_IDX(chg, 0, svn_merge_range_t *)->start;
+  chg_end = chg_start;
+  for (i = 0; i < chg->nelts; i++)
+    chg_end = MAX(chg_end, APR_ARRAY_IDX(chg, i, svn_merge_range_t *)->end);
+
+  /* The section [FIRST, LAST) consists of all ranges that end at or after
+     CHG_START and start at or before CHG_END. */
+  first = rangelist_skip_to(rangelist, 0, chg_start - 1);
+  last = rangelist_skip_to(rangelist, first, chg_end);
+  if (last < rangelist->nelts
+      && APR_ARRAY_IDX(rangelist, last, svn_merge_range_t *)->start <= chg_end)
+    last++;
+
+  section = apr_array_make(scratch_pool, MAX(last - first, 1), elt_size);
+  memcpy(section->elts, rangelist->elts + first * elt_size,
+         (last - first) * elt_size);
+  section->nelts = last - first;
+
+  merged = apr_array_make(scratch_pool, section->nelts + chg->nelts,
+                          elt_size);
+  SVN_ERR(rangelist_merge(merged, section, chg, result_pool, scratch_pool));
+
+  /* Replace the section with the merged ranges, moving the tail. */
+  tail = rangelist->nelts - last;
+  delta = merged->nelts - section->nelts;
+  for (i = 0; i < delta; i++)
+    apr_array_push(rangelist);
+
+  memmove(rangelist->elts + (last + delta) * elt_size,
+          rangelist->elts + last * elt_size,
+          tail * elt_size);
+  if (delta < 0)
+    rangelist->nelts += delta;
+
+  memcpy(rangelist->elts + first * elt_size, merged->elts,
+         merged->nelts * elt_size);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_rangelist_merge2(svn_rangelist_t *rangelist,
                      const svn_rangelist_t *chg,
@@ -1089,19 +1202,35 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
                      apr_pool_t *scratch_pool)
 {
   svn_error_t *err;
-  svn_rangelist_t *rangelist_orig;
+  svn_rangelist_t *rangelist_orig = NULL;
 
 #ifdef SVN_DEBUG
   SVN_ERR_ASSERT(rangelist_is_sorted(rangelist));
   SVN_ERR_ASSERT(rangelist_is_sorted(chg));
-#endif
 
-  /* Move the original rangelist aside. A shallow copy suffices,
-   * as rangelist_merge() won't modify its inputs. */
+  /* Keep the original around for the diagnostics below. */
   rangelist_orig = apr_array_copy(scratch_pool, rangelist);
-  apr_array_clear(rangelist);
-  err = svn_error_trace(rangelist_merge(rangelist, rangelist_orig, chg,
-                                        result_pool, scratch_pool));
+#endif
+
+  if (rangelist->nelts >= RANGELIST_IN_PLACE_MERGE_THRESHOLD)
+    {
+      /* Large mergeinfo typically receives small changes.  Only touch
+       * the affected part. */
+      err = svn_error_trace(rangelist_merge_in_place(rangelist, chg,
+                                                     result_pool,
+                                                     scratch_pool));
+    }
+  else
+    {
+      /* Move the original rangelist aside. A shallow copy suffices,
+       * as rangelist_merge() won't modify its inputs. */
+      if (!rangelist_orig)
+        rangelist_orig = apr_array_copy(scratch_pool, rangelist);
+
+      apr_array_clear(rangelist);
+      err = svn_error_trace(rangelist_merge(rangelist, rangelist_orig, chg,
+                                            result_pool, scratch_pool));
+    }
 
 #ifdef SVN_DEBUG
   if (err)
@@ -1393,7 +1522,16 @@ rangelist_intersect_or_remove(svn_rangelist_t **output,
              need to output the rangelist2 and increment the
              rangelist2.  */
           if (svn_sort_compare_ranges(&elt1, &elt2) < 0)
-            i1++;
+            {
+              /* Skip all rangelist1 ranges that end before elt2 starts. */
+              i1 = rangelist_skip_to(rangelist1, i1 + 1, elt2->start);
+            }
+          else if (!do_remove)
+            {
+              /* Nothing to output for any rangelist2 range that ends
+                 before elt1 starts. */
+              i2 = rangelist_skip_to(rangelist2, i2 + 1, elt1->start);
+            }
           else
             {
               svn_merge_range_t *lastrange;
@@ -1748,6 +1886,7 @@ svn_mergeinfo_catalog_merge(svn_mergeinfo_catalog_t mergeinfo_cat,
 {
   int i = 0;
   int j = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_array_header_t *sorted_cat =
     svn_sort__hash(mergeinfo_cat, svn_sort_compare_items_as_paths,
                    scratch_pool);
@@ -1769,8 +1908,9 @@ svn_mergeinfo_catalog_merge(svn_mergeinfo_catalog_t mergeinfo_cat,
           svn_mergeinfo_t mergeinfo = cat_elt.value;
           svn_mergeinfo_t changes_mergeinfo = change_elt.value;
 
+          svn_pool_clear(iterpool);
           SVN_ERR(svn_mergeinfo_merge2(mergeinfo, changes_mergeinfo,
-                                       result_pool, scratch_pool));
+                                       result_pool, iterpool));
           apr_hash_set(mergeinfo_cat, cat_elt.key, cat_elt.klen, mergeinfo);
           i++;
           j++;
@@ -1800,6 +1940,7 @@ svn_mergeinfo_catalog_merge(svn_mergeinfo_catalog_t mergeinfo_cat,
                    svn_mergeinfo_dup(elt.value, result_pool));
     }
 
+  svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
 
@@ -22,7 +22,10 @@
  */
 
 #include <apr_portable.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_pool.h>
 
+#include "svn_pools.h"
 #include "svn_private_config.h"
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
@@ -115,3 +118,145 @@ svn_mutex__get(svn_mutex__t *mutex)
 }
 
 #endif
+
+struct svn_thread_cond__t
+{
+#if APR_HAS_THREADS
+
+  apr_thread_cond_t *cond;
+
+#else
+
+  /* Truly empty structs are not allowed. */
+  int dummy;
+
+#endif
+};
+
+svn_error_t *
+svn_thread_cond__create(svn_thread_cond__t **cond_p,
+                        apr_pool_t *result_pool)
+{
+  svn_thread_cond__t *cond = apr_pcalloc(result_pool, sizeof(*cond));
+
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_cond_create(&cond->cond, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+#endif
+
+  *cond_p = cond;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_thread_cond__broadcast(svn_thread_cond__t *cond)
+{
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_cond_broadcast(cond->cond);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't broadcast condition variable"));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_thread_cond__wait(svn_thread_cond__t *cond,
+                      svn_mutex__t *mutex)
+{
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_cond_wait(cond->cond, mutex->mutex);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't wait for condition variable"));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Number of microseconds that an unused thread remains in the pool before
+ * being terminated.
+ *
+ * Higher values are useful if clients frequently send small requests and
+ * you want to minimize the latency for those.
+ */
+#define THREADPOOL_THREAD_IDLE_LIMIT 1000000
+
+/* The process-wide worker pool used by svn_thread_pool__push(). */
+static apr_thread_pool_t *thread_pool = NULL;
+
+/* Keep track on whether we already created the THREAD_POOL . */
+static svn_atomic_t thread_pool_initialized = FALSE;
+
+/* Destructor function that implicitly cleans up any running threads
+   in the THREAD_POOL *once*.
+
+   Must be run as a pre-cleanup hook.
+ */
+static apr_status_t
+thread_pool_pre_cleanup(void *data)
+{
+  apr_thread_pool_t *tp = thread_pool;
+  if (!thread_pool)
+    return APR_SUCCESS;
+
+  thread_pool = NULL;
+  thread_pool_initialized = FALSE;
+
+  return apr_thread_pool_destroy(tp);
+}
+
+/* Implements svn_atomic__err_init_func_t creating THREAD_POOL. */
+static svn_error_t *
+create_thread_pool(void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  /* The thread-pool must be allocated from a thread-safe pool and has
+     to live as long as the process does. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  apr_status_t status = apr_thread_pool_create(&thread_pool, 0,
+                                               SVN_THREAD_POOL__MAX_THREADS,
+                                               pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create thread pool"));
+
+  /* Work around an APR bug:  The cleanup must happen in the pre-cleanup
+     hook instead of the normal cleanup hook.  Otherwise, the sub-pools
+     containing the thread objects would already be invalid. */
+  apr_pool_pre_cleanup_register(pool, NULL, thread_pool_pre_cleanup);
+
+  /* let idle threads linger for a while in case more requests are
+     coming in */
+  apr_thread_pool_idle_wait_set(thread_pool, THREADPOOL_THREAD_IDLE_LIMIT);
+
+  /* don't queue requests unless we reached the worker thread limit */
+  apr_thread_pool_threshold_set(thread_pool, 0);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_thread_pool__push(apr_thread_start_t func,
+                      void *data,
+                      void *owner,
+                      apr_pool_t *scratch_pool)
+{
+  apr_status_t status;
+
+  SVN_ERR(svn_atomic__init_once(&thread_pool_initialized,
+                                create_thread_pool, NULL, scratch_pool));
+
+  status = apr_thread_pool_push(thread_pool, func, data, 0, owner);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't push task"));
+
+  return SVN_NO_ERROR;
+}
+
+#endif
@@ -31,6 +31,15 @@
 
 #include "svn_private_config.h"
 
+/* The compiler provides the vector instructions and bit scan intrinsics
+ * that decode_packed_uints() needs. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#  define SVN_PACKED_SSE2
+#  include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON) && defined(__GNUC__)
+#  define SVN_PACKED_NEON
+#  include <arm_neon.h>
+#endif
 
 
 /* Private int stream data referenced by svn_packed__int_stream_t.
@@ -773,6 +782,159 @@ read_packed_uint(svn_stringbuf_t *packed)
   return result;
 }
 
+/* Read one 7b/8b encoded value starting at *P but not reading beyond END.
+ * Return it in *RESULT and the first position after the parsed data.
+ *
+ * Missing bytes at END are treated as 0.  Bits beyond the 64th will be
+ * dropped, i.e. the result is undefined for overlong representations.
+ */
+static const unsigned char *
+read_packed_uint_bounded(const unsigned char *p,
+                         const unsigned char *end,
+                         apr_uint64_t *result)
+{
+  apr_uint64_t value = 0;
+  int shift = 0;
+
+  for (; p < end && *p >= 0x80; ++p, shift += 7)
+    if (shift < 64)
+      value += (apr_uint64_t)(*p & 0x7f) << shift;
+
+  if (p < end)
+    {
+      if (shift < 64)
+        value += (apr_uint64_t)*p << shift;
+      ++p;
+    }
+
+  *result = value;
+  return p;
+}
+
+/* Decode up to COUNT 7b/8b encoded values from the data between P and END
+ * and write them in order to VALUES.  If the data ends early, the missing
+ * values will be 0.  Return the first position after the parsed data.
+ *
+ * Most values are small and fit into a single byte.  So, we look at the
+ * continuation bits of 16 bytes at a time.  Runs of single-byte values
+ * are then simply widened and multi-byte values get assembled from the
+ * bytes up to the respective terminator.
+ */
+static const unsigned char *
+decode_packed_uints(apr_uint64_t *values,
+                    apr_size_t count,
+                    const unsigned char *p,
+                    const unsigned char *end)
+{
+  apr_size_t i = 0;
+
+#if defined(SVN_PACKED_SSE2) || defined(SVN_PACKED_NEON)
+
+  while (count - i >= 16 && end - p >= 16)
+    {
+      const unsigned char *q = p;
+      unsigned int terminators;
+
+#if defined(SVN_PACKED_SSE2)
+      __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+      terminators = ~(unsigned int)_mm_movemask_epi8(chunk) & 0xffff;
+#else
+      /* NEON has no movemask.  Weigh the MSBs and add them up per half. */
+      static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128,
+                                           1, 2, 4, 8, 16, 32, 64, 128 };
+      uint8x16_t msbs = vshrq_n_u8(vld1q_u8(p), 7);
+      uint8x16_t bits = vmulq_u8(msbs, vld1q_u8(weights));
+      terminators = ~((unsigned int)vaddv_u8(vget_low_u8(bits))
+                      | ((unsigned int)vaddv_u8(vget_high_u8(bits)) << 8))
+                  & 0xffff;
+#endif
+
+      if (terminators == 0xffff)
+        {
+          int k;
+          for (k = 0; k < 16; ++k)
+            values[i + k] = p[k];
+
+          i += 16;
+          p += 16;
+          continue;
+        }
+
+      /* Process all values that end within this chunk. */
+      while (terminators)
+        {
+          const unsigned char *last = p + __builtin_ctz(terminators);
+          apr_uint64_t value = 0;
+          int shift = 0;
+
+          /* Leave overlong representations to the fallback code. */
+          if (last - q > 9)
+            break;
+
+          for (; q < last; ++q, shift += 7)
+            value += (apr_uint64_t)(*q & 0x7f) << shift;
+
+          values[i++] = value + ((apr_uint64_t)*q++ << shift);
+          terminators &= terminators - 1;
+        }
+
+      /* No progress, e.g. because of a value spanning the whole chunk? */
+      if (q == p)
+        break;
+
+      p = q;
+    }
+
+#endif
+
+  for (; i < count; ++i)
+    p = read_packed_uint_bounded(p, end, &values[i]);
+
+  return p;
+}
+
+/* Decode the next COUNT values from the PACKED data in PRIVATE_DATA,
+ * which must not have sub-streams, and write them in order to VALUES.
+ * Undo deltification and sign handling as configured.
+ */
+static void
+unpack_uints(packed_int_private_t *private_data,
+             apr_uint64_t *values,
+             apr_size_t count)
+{
+  svn_stringbuf_t *packed = private_data->packed;
+  const unsigned char *start = (const unsigned char *)packed->data;
+  apr_size_t packed_read;
+  apr_size_t i;
+
+  /* unpack numbers */
+  packed_read = decode_packed_uints(values, count, start, start + packed->len)
+              - start;
+
+  /* adjust remaining packed data buffer */
+  packed->data += packed_read;
+  packed->len -= packed_read;
+  packed->blocksize -= packed_read;
+
+  /* undeltify numbers, if configured */
+  if (private_data->diff)
+    {
+      apr_uint64_t last_value = private_data->last_value;
+      for (i = 0; i < count; ++i)
+        {
+          last_value += unmap_uint(values[i]);
+          values[i] = last_value;
+        }
+
+      private_data->last_value = last_value;
+    }
+
+  /* handle signed values, if configured and not handled already */
+  if (!private_data->diff && private_data->is_signed)
+    for (i = 0; i < count; ++i)
+      values[i] = unmap_uint(values[i]);
+}
+
 /* Ensure that STREAM contains at least one item in its buffer.
  */
 static void
@@ -800,55 +962,13 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
       }
   else
     {
-      /* use this local buffer only if the packed data is shorter than this.
-         The goal is that read_packed_uint_body doesn't need check for
-         overflows. */
-      unsigned char local_buffer[10 * SVN__PACKED_DATA_BUFFER_SIZE];
-      unsigned char *p;
-      unsigned char *start;
-      apr_size_t packed_read;
-
-      if (private_data->packed->len < sizeof(local_buffer))
-        {
-          apr_size_t trail = sizeof(local_buffer) - private_data->packed->len;
-          memcpy(local_buffer,
-                 private_data->packed->data,
-                 private_data->packed->len);
-          memset(local_buffer + private_data->packed->len, 0, MIN(trail, end));
-
-          p = local_buffer;
-        }
-      else
-        p = (unsigned char *)private_data->packed->data;
-
-      /* unpack numbers */
-      start = p;
-      for (i = end; i > 0; --i)
-        p = read_packed_uint_body(p, &stream->buffer[i-1]);
-
-      /* adjust remaining packed data buffer */
-      packed_read = p - start;
-      private_data->packed->data += packed_read;
-      private_data->packed->len -= packed_read;
-      private_data->packed->blocksize -= packed_read;
-
-      /* undeltify numbers, if configured */
-      if (private_data->diff)
-        {
-          apr_uint64_t last_value = private_data->last_value;
-          for (i = end; i > 0; --i)
-            {
-              last_value += unmap_uint(stream->buffer[i-1]);
-              stream->buffer[i-1] = last_value;
-            }
+      apr_uint64_t values[SVN__PACKED_DATA_BUFFER_SIZE];
 
-          private_data->last_value = last_value;
-        }
+      unpack_uints(private_data, values, end);
 
-      /* handle signed values, if configured and not handled already */
-      if (!private_data->diff && private_data->is_signed)
-        for (i = 0; i < end; ++i)
-          stream->buffer[i] = unmap_uint(stream->buffer[i]);
+      /* The buffer gets consumed from its end. */
+      for (i = 0; i < end; ++i)
+        stream->buffer[end - 1 - i] = values[i];
     }
 
   stream->buffer_used = end;
@@ -870,6 +990,36 @@ svn_packed__get_int(svn_packed__int_stream_t *stream)
   return (apr_int64_t)svn_packed__get_uint(stream);
 }
 
+apr_size_t
+svn_packed__get_uints(svn_packed__int_stream_t *stream,
+                      apr_uint64_t *values,
+                      apr_size_t count)
+{
+  packed_int_private_t *private_data = stream->private_data;
+  apr_size_t i = 0;
+
+  /* Hand out what has already been prefetched. */
+  while (i < count && stream->buffer_used)
+    values[i++] = stream->buffer[--stream->buffer_used];
+
+  /* Decode the remainder directly into VALUES, if possible. */
+  if (private_data->current_substream)
+    {
+      for (; i < count && svn_packed__int_count(stream); ++i)
+        values[i] = svn_packed__get_uint(stream);
+    }
+  else if (i < count && private_data->item_count)
+    {
+      apr_size_t to_read = MIN(count - i, private_data->item_count);
+
+      unpack_uints(private_data, values + i, to_read);
+      private_data->item_count -= to_read;
+      i += to_read;
+    }
+
+  return i;
+}
+
 const char *
 svn_packed__get_bytes(svn_packed__byte_stream_t *stream,
                       apr_size_t *len)
@@ -0,0 +1,373 @@
+/*
+ * scratch_pools.c :  per-thread recycling of short-lived sub-pools
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_thread_proc.h>
+
+#include "svn_pools.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_subr_private.h"
+
+#include "pools.h"
+
+/* Maximum number of cleared pools that we keep per thread.  Hot code
+ * paths rarely nest scratch pools deeper than this.
+ */
+#define MAX_UNUSED_POOLS 16
+
+typedef struct scratch_cache_t scratch_cache_t;
+
+/* A scratch pool and its bookkeeping.
+ */
+typedef struct scratch_pool_t
+{
+  /* The pool itself.  NULL for a spare record. */
+  apr_pool_t *pool;
+
+  /* The pool that POOL pretends to be a sub-pool of, while in use. */
+  apr_pool_t *parent;
+
+  /* The cache that this record belongs to. */
+  scratch_cache_t *cache;
+
+  /* Next record in the same list of CACHE. */
+  struct scratch_pool_t *next;
+} scratch_pool_t;
+
+/* Per-thread collection of scratch pools.
+ */
+struct scratch_cache_t
+{
+  /* Unmanaged root pool with a private allocator.  All scratch pools as
+   * well as this structure are allocated from it. */
+  apr_pool_t *root;
+
+#if APR_HAS_THREADS
+  /* Serializes access to the lists below as well as to the allocator.
+   * The owning thread is virtually the only one to ever take it.  Only
+   * when a parent pool gets cleared by another thread, that thread will
+   * release our scratch pool, see put_back(). */
+  apr_thread_mutex_t *mutex;
+#endif
+
+  /* Cleared pools, ready to be handed out. */
+  scratch_pool_t *unused;
+
+  /* Number of entries in UNUSED. */
+  int unused_count;
+
+  /* Pools currently handed out, most recently acquired first. */
+  scratch_pool_t *used;
+
+  /* Records without a pool, ready for re-use. */
+  scratch_pool_t *spare;
+};
+
+#if !APR_POOL_DEBUG
+
+#if APR_HAS_THREADS
+#  define LOCK_CACHE(cache) apr_thread_mutex_lock((cache)->mutex)
+#  define UNLOCK_CACHE(cache) apr_thread_mutex_unlock((cache)->mutex)
+#else
+#  define LOCK_CACHE(cache) ((void)0)
+#  define UNLOCK_CACHE(cache) ((void)0)
+#endif
+
+/* Initialization state of the thread-local storage. */
+static volatile svn_atomic_t cache_key_init_state = 0;
+
+#if APR_HAS_THREADS
+
+/* Key to the current thread's scratch_cache_t. */
+static apr_threadkey_t *cache_key = NULL;
+
+/* Thread exit handler.  Destroy the scratch_cache_t in DATA, unless some
+ * of its pools are still in use. */
+static void
+destroy_cache(void *data)
+{
+  scratch_cache_t *cache = data;
+  svn_boolean_t in_use;
+
+  if (!cache)
+    return;
+
+  LOCK_CACHE(cache);
+  in_use = cache->used != NULL;
+  UNLOCK_CACHE(cache);
+
+  if (!in_use)
+    svn_pool_destroy(cache->root);
+}
+
+/* Implements svn_atomic__str_init_func_t. */
+static const char *
+init_cache_key(void *baton)
+{
+  if (apr_threadkey_private_create(&cache_key, destroy_cache,
+                                   svn_pool__create_unmanaged(FALSE)))
+    return "Can't create scratch pool cache key";
+
+  return NULL;
+}
+
+#else
+
+/* The only thread's scratch_cache_t. */
+static scratch_cache_t *global_cache = NULL;
+
+/* Implements svn_atomic__str_init_func_t. */
+static const char *
+init_cache_key(void *baton)
+{
+  return NULL;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Return the current thread's scratch pool cache or NULL if it has not
+ * been created, yet.
+ */
+static scratch_cache_t *
+find_cache(void)
+{
+#if APR_HAS_THREADS
+  void *data = NULL;
+  if (apr_threadkey_private_get(&data, cache_key))
+    return NULL;
+
+  return data;
+#else
+  return global_cache;
+#endif
+}
+
+/* Return the current thread's scratch pool cache, creating it if
+ * necessary.  Return NULL if thread-local storage is not available.
+ */
+static scratch_cache_t *
+get_cache(void)
+{
+  scratch_cache_t *cache;
+  apr_allocator_t *allocator;
+  apr_pool_t *root;
+
+  if (svn_atomic__init_once_no_error(&cache_key_init_state, init_cache_key,
+                                     NULL))
+    return NULL;
+
+  cache = find_cache();
+  if (cache)
+    return cache;
+
+  /* The allocator is private to this thread, so its lock will virtually
+   * never be contended.  The root pool is unmanaged such that it will not
+   * get destroyed before any of the parent pools that our scratch pools
+   * got registered with. */
+  if (apr_allocator_create(&allocator))
+    return NULL;
+
+  apr_allocator_max_free_set(allocator, SVN_ALLOCATOR_RECOMMENDED_MAX_FREE);
+  if (apr_pool_create_unmanaged_ex(&root, NULL, allocator))
+    {
+      apr_allocator_destroy(allocator);
+      return NULL;
+    }
+
+  apr_allocator_owner_set(allocator, root);
+  cache = apr_pcalloc(root, sizeof(*cache));
+  cache->root = root;
+
+#if APR_HAS_THREADS
+  if (apr_thread_mutex_create(&cache->mutex, APR_THREAD_MUTEX_DEFAULT, root))
+    {
+      svn_pool_destroy(root);
+      return NULL;
+    }
+
+  apr_allocator_mutex_set(allocator, cache->mutex);
+#endif
+
+#if APR_HAS_THREADS
+  if (apr_threadkey_private_set(cache, cache_key))
+    {
+      svn_pool_destroy(root);
+      return NULL;
+    }
+#else
+  global_cache = cache;
+#endif
+
+  return cache;
+}
+
+/* Remove RECORD from its cache's list of used pools, clear its pool and
+ * return it to the cache's unused pools.
+ *
+ * If the current thread does not own RECORD, e.g. because it cleared or
+ * destroyed a parent pool shared with the owner, destroy the pool instead.
+ * Only the owning thread may hand out its pools again.
+ */
+static void
+put_back(scratch_pool_t *record)
+{
+  scratch_cache_t *cache = record->cache;
+  scratch_pool_t **link;
+  svn_boolean_t recycle = find_cache() == cache;
+
+  LOCK_CACHE(cache);
+  for (link = &cache->used; *link != record; link = &(*link)->next)
+    ;
+  *link = record->next;
+  UNLOCK_CACHE(cache);
+
+  /* Clearing or destroying the pool may release further scratch pools
+   * that have been acquired with this one as their parent.  So, don't
+   * hold the lock while doing it. */
+  record->parent = NULL;
+  if (recycle)
+    {
+      svn_pool_clear(record->pool);
+
+      LOCK_CACHE(cache);
+      recycle = cache->unused_count < MAX_UNUSED_POOLS;
+      if (recycle)
+        {
+          record->next = cache->unused;
+          cache->unused = record;
+          cache->unused_count++;
+        }
+      UNLOCK_CACHE(cache);
+
+      if (recycle)
+        return;
+    }
+
+  svn_pool_destroy(record->pool);
+
+  LOCK_CACHE(cache);
+  record->pool = NULL;
+  record->next = cache->spare;
+  cache->spare = record;
+  UNLOCK_CACHE(cache);
+}
+
+/* Pool cleanup function releasing the scratch_pool_t in DATA when its
+ * parent pool gets cleared or destroyed.
+ */
+static apr_status_t
+release_with_parent(void *data)
+{
+  put_back(data);
+  return APR_SUCCESS;
+}
+
+#endif /* !APR_POOL_DEBUG */
+
+apr_pool_t *
+svn_pool__acquire_scratch(apr_pool_t *parent)
+{
+#if !APR_POOL_DEBUG
+  scratch_cache_t *cache = get_cache();
+  scratch_pool_t *record;
+
+  if (!cache)
+    return svn_pool_create(parent);
+
+  /* Creating pools takes the allocator's lock, which is the same as the
+   * cache's.  So, only hold it while accessing the lists. */
+  LOCK_CACHE(cache);
+  if (cache->unused)
+    {
+      record = cache->unused;
+      cache->unused = record->next;
+      cache->unused_count--;
+    }
+  else if (cache->spare)
+    {
+      record = cache->spare;
+      cache->spare = record->next;
+    }
+  else
+    {
+      record = NULL;
+    }
+  UNLOCK_CACHE(cache);
+
+  if (!record)
+    {
+      record = apr_palloc(cache->root, sizeof(*record));
+      record->cache = cache;
+      record->pool = NULL;
+    }
+
+  if (!record->pool)
+    record->pool = svn_pool_create(cache->root);
+
+  record->parent = parent;
+
+  LOCK_CACHE(cache);
+  record->next = cache->used;
+  cache->used = record;
+  UNLOCK_CACHE(cache);
+
+  apr_pool_cleanup_register(parent, record, release_with_parent,
+                            apr_pool_cleanup_null);
+
+  return record->pool;
+#else
+  /* Let the pool debugging code see every individual pool. */
+  return svn_pool_create(parent);
+#endif
+}
+
+void
+svn_pool__release_scratch(apr_pool_t *pool)
+{
+#if !APR_POOL_DEBUG
+  scratch_cache_t *cache = get_cache();
+  scratch_pool_t *record = NULL;
+
+  if (cache)
+    {
+      /* Most of the time, POOL has been acquired last. */
+      LOCK_CACHE(cache);
+      for (record = cache->used;
+           record && record->pool != pool;
+           record = record->next)
+        ;
+      UNLOCK_CACHE(cache);
+    }
+
+  if (record)
+    {
+      apr_pool_cleanup_kill(record->parent, record, release_with_parent);
+      put_back(record);
+      return;
+    }
+#endif
+
+  /* Not a recycled pool. */
+  svn_pool_destroy(pool);
+}
@@ -0,0 +1,466 @@
+/*
+ * sha1.c :  SHA-1 implementation with run-time CPU dispatch
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr.h>
+
+#include "sha1.h"
+
+/* Most of the time spent in checksumming large fulltexts goes into the
+ * SHA-1 compression function.  APR only provides a portable, byte-oriented
+ * implementation.  We have our own, word-oriented one and use the SHA
+ * instruction set extensions of x86 and ARMv8 CPUs when available.
+ * The implementation gets selected once, upon first use.
+ */
+
+/* Select the hardware accelerated block functions the compiler can
+ * generate code for.  The CPU may still lack support for them, which
+ * will be tested at run-time.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#  define SVN_SHA1_X86_SHA
+#  include <cpuid.h>
+#  include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) \
+    && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#  define SVN_SHA1_ARMV8
+#  include <arm_neon.h>
+#  if defined(__linux__)
+#    include <sys/auxv.h>
+#    include <asm/hwcap.h>
+#  endif
+#endif
+
+/* SHA-1 block size in bytes.
+ */
+#define SHA1_BLOCKSIZE 64
+
+struct svn_sha1__context_t
+{
+  /* Intermediate hash value. */
+  apr_uint32_t state[5];
+
+  /* Total number of bytes fed into the context so far. */
+  apr_uint64_t length;
+
+  /* Incomplete block data.  The number of bytes used is LENGTH modulo
+   * SHA1_BLOCKSIZE. */
+  unsigned char buffer[SHA1_BLOCKSIZE];
+};
+
+/* Signature of a SHA-1 compression function.  Update STATE with the
+ * COUNT complete blocks starting at DATA.
+ */
+typedef void (*sha1_blocks_func_t)(apr_uint32_t state[5],
+                                   const unsigned char *data,
+                                   apr_size_t count);
+
+/* Return the big-endian 32 bit word at P.
+ */
+static APR_INLINE apr_uint32_t
+load_be32(const unsigned char *p)
+{
+  return ((apr_uint32_t)p[0] << 24) | ((apr_uint32_t)p[1] << 16)
+       | ((apr_uint32_t)p[2] << 8) | (apr_uint32_t)p[3];
+}
+
+/* Store VALUE as big-endian 32 bit word at P.
+ */
+static APR_INLINE void
+store_be32(unsigned char *p, apr_uint32_t value)
+{
+  p[0] = (unsigned char)(value >> 24);
+  p[1] = (unsigned char)(value >> 16);
+  p[2] = (unsigned char)(value >> 8);
+  p[3] = (unsigned char)value;
+}
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Portable implementation of sha1_blocks_func_t.
+ */
+static void
+sha1_blocks_generic(apr_uint32_t state[5],
+                    const unsigned char *data,
+                    apr_size_t count)
+{
+  for (; count > 0; --count, data += SHA1_BLOCKSIZE)
+    {
+      apr_uint32_t w[80];
+      apr_uint32_t a = state[0];
+      apr_uint32_t b = state[1];
+      apr_uint32_t c = state[2];
+      apr_uint32_t d = state[3];
+      apr_uint32_t e = state[4];
+      apr_uint32_t temp;
+      int i;
+
+      for (i = 0; i < 16; ++i)
+        w[i] = load_be32(data + 4 * i);
+      for (; i < 80; ++i)
+        {
+          temp = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+          w[i] = ROTL32(temp, 1);
+        }
+
+#define SHA1_ROUND(f, k)                                   \
+      temp = ROTL32(a, 5) + (f) + e + (k) + w[i];          \
+      e = d;                                               \
+      d = c;                                               \
+      c = ROTL32(b, 30);                                   \
+      b = a;                                               \
+      a = temp
+
+      for (i = 0; i < 20; ++i)
+        {
+          SHA1_ROUND(d ^ (b & (c ^ d)), 0x5a827999);
+        }
+      for (; i < 40; ++i)
+        {
+          SHA1_ROUND(b ^ c ^ d, 0x6ed9eba1);
+        }
+      for (; i < 60; ++i)
+        {
+          SHA1_ROUND((b & c) | (d & (b | c)), 0x8f1bbcdc);
+        }
+      for (; i < 80; ++i)
+        {
+          SHA1_ROUND(b ^ c ^ d, 0xca62c1d6);
+        }
+
+#undef SHA1_ROUND
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+    }
+}
+
+#ifdef SVN_SHA1_X86_SHA
+
+/* Return TRUE, if the CPU supports the SHA extensions as well as the
+ * SSSE3 and SSE4.1 instructions that we need alongside them.
+ */
+static svn_boolean_t
+x86_has_sha(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return FALSE;
+  if (!(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+    return FALSE;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return FALSE;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+  /* CPUID.(EAX=07H, ECX=0):EBX[bit 29] */
+  return (ebx & (1u << 29)) != 0;
+}
+
+/* Implementation of sha1_blocks_func_t using the x86 SHA extensions.
+ */
+__attribute__((target("sha,ssse3,sse4.1")))
+static void
+sha1_blocks_x86_sha(apr_uint32_t state[5],
+                    const unsigned char *data,
+                    apr_size_t count)
+{
+  const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607ULL,
+                                           0x08090a0b0c0d0e0fULL);
+  __m128i abcd, abcd_saved, e0, e0_saved, e1;
+  __m128i w[20];
+  int i;
+
+  /* The SHA instructions expect A in the most significant word. */
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+  e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+  for (; count > 0; --count, data += SHA1_BLOCKSIZE)
+    {
+      abcd_saved = abcd;
+      e0_saved = e0;
+
+      /* Message schedule, 4 words per vector. */
+      for (i = 0; i < 4; ++i)
+        w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data + i),
+                                byte_swap);
+      for (; i < 20; ++i)
+        w[i] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w[i - 4],
+                                                                   w[i - 3]),
+                                                w[i - 2]),
+                                  w[i - 1]);
+
+      /* Rounds 0 .. 3 */
+      e0 = _mm_add_epi32(e0, w[0]);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+      /* Each group of 4 rounds derives E from the A value 4 rounds back.
+       * The round function selector must be a compile-time constant. */
+#define SHA1_X86_ROUNDS(first, last, func)                 \
+      for (i = first; i <= last; ++i)                      \
+        {                                                  \
+          e0 = _mm_sha1nexte_epu32(e1, w[i]);              \
+          e1 = abcd;                                       \
+          abcd = _mm_sha1rnds4_epu32(abcd, e0, func);      \
+        }
+
+      SHA1_X86_ROUNDS(1, 4, 0);
+      SHA1_X86_ROUNDS(5, 9, 1);
+      SHA1_X86_ROUNDS(10, 14, 2);
+      SHA1_X86_ROUNDS(15, 19, 3);
+
+#undef SHA1_X86_ROUNDS
+
+      e0 = _mm_sha1nexte_epu32(e1, e0_saved);
+      abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (apr_uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+#endif /* SVN_SHA1_X86_SHA */
+
+#ifdef SVN_SHA1_ARMV8
+
+/* Return TRUE, if the CPU supports the ARMv8 SHA-1 instructions.
+ */
+static svn_boolean_t
+armv8_has_sha1(void)
+{
+#if defined(__linux__) && defined(HWCAP_SHA1)
+  return (getauxval(AT_HWCAP) & HWCAP_SHA1) != 0;
+#else
+  /* The compiler has been told that the target CPU supports them. */
+  return TRUE;
+#endif
+}
+
+/* Implementation of sha1_blocks_func_t using the ARMv8 crypto extensions.
+ */
+static void
+sha1_blocks_armv8(apr_uint32_t state[5],
+                  const unsigned char *data,
+                  apr_size_t count)
+{
+  static const apr_uint32_t round_constants[4]
+    = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
+  uint32x4_t abcd = vld1q_u32(state);
+  uint32_t e0 = state[4];
+  uint32x4_t w[20];
+  int i;
+
+  for (; count > 0; --count, data += SHA1_BLOCKSIZE)
+    {
+      uint32x4_t abcd_saved = abcd;
+      uint32_t e0_saved = e0;
+      uint32_t e1;
+
+      /* Message schedule, 4 words per vector. */
+      for (i = 0; i < 4; ++i)
+        w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+      for (; i < 20; ++i)
+        w[i] = vsha1su1q_u32(vsha1su0q_u32(w[i - 4], w[i - 3], w[i - 2]),
+                             w[i - 1]);
+
+      for (i = 0; i < 20; ++i)
+        {
+          uint32x4_t wk = vaddq_u32(w[i],
+                                    vdupq_n_u32(round_constants[i / 5]));
+          e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+          if (i < 5)
+            abcd = vsha1cq_u32(abcd, e0, wk);
+          else if (i < 10 || i >= 15)
+            abcd = vsha1pq_u32(abcd, e0, wk);
+          else
+            abcd = vsha1mq_u32(abcd, e0, wk);
+          e0 = e1;
+        }
+
+      abcd = vaddq_u32(abcd, abcd_saved);
+      e0 += e0_saved;
+    }
+
+  vst1q_u32(state, abcd);
+  state[4] = e0;
+}
+
+#endif /* SVN_SHA1_ARMV8 */
+
+/* The block function to use on this machine, selected by
+ * select_blocks_func().  Concurrent initialization is harmless since all
+ * threads will select the same function.
+ */
+static volatile sha1_blocks_func_t sha1_blocks = NULL;
+
+/* Name of the implementation in SHA1_BLOCKS. */
+static const char *sha1_blocks_name = NULL;
+
+/* Return the fastest SHA-1 block function that this machine supports.
+ */
+static sha1_blocks_func_t
+select_blocks_func(void)
+{
+  sha1_blocks_func_t result = sha1_blocks;
+  if (result)
+    return result;
+
+  result = sha1_blocks_generic;
+  sha1_blocks_name = "generic";
+
+#ifdef SVN_SHA1_X86_SHA
+  if (x86_has_sha())
+    {
+      result = sha1_blocks_x86_sha;
+      sha1_blocks_name = "x86 SHA extensions";
+    }
+#endif
+
+#ifdef SVN_SHA1_ARMV8
+  if (armv8_has_sha1())
+    {
+      result = sha1_blocks_armv8;
+      sha1_blocks_name = "ARMv8 crypto extensions";
+    }
+#endif
+
+  sha1_blocks = result;
+  return result;
+}
+
+/* Initial hash value as defined in FIPS 180-4.
+ */
+static const apr_uint32_t sha1_initial_state[5]
+  = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+svn_sha1__context_t *
+svn_sha1__context_create(apr_pool_t *pool)
+{
+  svn_sha1__context_t *context = apr_palloc(pool, sizeof(*context));
+  svn_sha1__context_reset(context);
+
+  return context;
+}
+
+void
+svn_sha1__context_reset(svn_sha1__context_t *context)
+{
+  memcpy(context->state, sha1_initial_state, sizeof(context->state));
+  context->length = 0;
+}
+
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len)
+{
+  const unsigned char *input = data;
+  apr_size_t buffered = (apr_size_t)(context->length % SHA1_BLOCKSIZE);
+  sha1_blocks_func_t blocks = select_blocks_func();
+
+  context->length += len;
+
+  /* Complete a partially filled block first. */
+  if (buffered)
+    {
+      apr_size_t to_copy = SHA1_BLOCKSIZE - buffered;
+      if (to_copy > len)
+        to_copy = len;
+
+      memcpy(context->buffer + buffered, input, to_copy);
+      input += to_copy;
+      len -= to_copy;
+      if (buffered + to_copy < SHA1_BLOCKSIZE)
+        return;
+
+      blocks(context->state, context->buffer, 1);
+    }
+
+  /* Process all complete blocks in-place. */
+  if (len >= SHA1_BLOCKSIZE)
+    {
+      apr_size_t count = len / SHA1_BLOCKSIZE;
+      blocks(context->state, input, count);
+      input += count * SHA1_BLOCKSIZE;
+      len -= count * SHA1_BLOCKSIZE;
+    }
+
+  /* Keep the remainder for later. */
+  if (len)
+    memcpy(context->buffer, input, len);
+}
+
+void
+svn_sha1__finalize(unsigned char digest[SVN_SHA1__DIGESTSIZE],
+                   const svn_sha1__context_t *context)
+{
+  apr_uint32_t state[5];
+  unsigned char padding[2 * SHA1_BLOCKSIZE];
+  apr_size_t buffered = (apr_size_t)(context->length % SHA1_BLOCKSIZE);
+  apr_size_t padded_len = buffered < SHA1_BLOCKSIZE - 8
+                        ? SHA1_BLOCKSIZE
+                        : 2 * SHA1_BLOCKSIZE;
+  apr_uint64_t bit_count = context->length * 8;
+  int i;
+
+  /* Pad the remaining data with a single 1 bit, zeros and the message
+   * length in bits, without modifying CONTEXT. */
+  memcpy(padding, context->buffer, buffered);
+  padding[buffered] = 0x80;
+  memset(padding + buffered + 1, 0, padded_len - buffered - 1 - 8);
+  store_be32(padding + padded_len - 8, (apr_uint32_t)(bit_count >> 32));
+  store_be32(padding + padded_len - 4, (apr_uint32_t)bit_count);
+
+  memcpy(state, context->state, sizeof(state));
+  select_blocks_func()(state, padding, padded_len / SHA1_BLOCKSIZE);
+
+  for (i = 0; i < 5; ++i)
+    store_be32(digest + 4 * i, state[i]);
+}
+
+void
+svn__sha1(unsigned char digest[SVN_SHA1__DIGESTSIZE],
+          const void *input,
+          apr_size_t len)
+{
+  svn_sha1__context_t context;
+
+  svn_sha1__context_reset(&context);
+  svn_sha1__update(&context, input, len);
+  svn_sha1__finalize(digest, &context);
+}
+
+const char *
+svn_sha1__implementation(void)
+{
+  select_blocks_func();
+  return sha1_blocks_name;
+}
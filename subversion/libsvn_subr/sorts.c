@@ -27,9 +27,11 @@
 #include <apr_hash.h>
 #include <apr_tables.h>
 #include <stdlib.h>       /* for qsort()   */
+#include <string.h>
 #include <assert.h>
 #include "svn_hash.h"
 #include "svn_path.h"
+#include "svn_pools.h"
 #include "svn_sorts.h"
 #include "svn_error.h"
 #include "private/svn_sorts_private.h"
@@ -136,11 +138,169 @@ svn_sort_compare_ranges(const void *a, const void *b)
   return item1->start < item2->start ? -1 : 1;
 }
 
+/* Ranges of fewer than this many items will be sorted by qsort() instead
+ * of being split up further by radix_sort_items(). */
+#define RADIX_SORT_THRESHOLD 64
+
+/* Number of buckets used by radix_sort_items(). */
+#define RADIX_SORT_BUCKETS 257
+
+/* Return the bucket of ITEM for the key char at offset DEPTH.  Keys that
+ * end before DEPTH map to bucket 0, i.e. sort before any longer key.
+ *
+ * If AS_PATHS is set, '/' maps to bucket 1 and all other chars sort after
+ * that.  This gives the same order as svn_path_compare_paths().  Otherwise,
+ * the order is that of svn_sort_compare_items_lexically().
+ */
+static APR_INLINE int
+key_bucket(const svn_sort__item_t *item,
+           apr_size_t depth,
+           svn_boolean_t as_paths)
+{
+  unsigned char c;
+
+  if (depth >= (apr_size_t)item->klen)
+    return 0;
+
+  c = ((const unsigned char *)item->key)[depth];
+  return (as_paths && c == '/') ? 1 : c + 1;
+}
+
+/* Sort the COUNT ITEMS by their keys, of which the first DEPTH chars are
+ * known to be equal.  BUFFER must provide space for COUNT items.  See
+ * key_bucket() for AS_PATHS.  Small ranges are left to qsort() using
+ * COMPARISON_FUNC, which must define the same order.
+ *
+ * This is a most-significant-digit-first radix sort.  We recurse into all
+ * but the largest bucket and iterate on that one, so the recursion depth
+ * is limited to log2(COUNT).
+ */
+static void
+radix_sort_items(svn_sort__item_t *items,
+                 svn_sort__item_t *buffer,
+                 int count,
+                 apr_size_t depth,
+                 svn_boolean_t as_paths,
+                 int (*comparison_func)(const void *, const void *))
+{
+  while (count >= RADIX_SORT_THRESHOLD)
+    {
+      int offsets[RADIX_SORT_BUCKETS + 1];
+      int next[RADIX_SORT_BUCKETS];
+      int i, bucket, largest;
+
+      /* Count the keys per bucket, offset by one for the prefix sum. */
+      memset(offsets, 0, sizeof(offsets));
+      for (i = 0; i < count; ++i)
+        ++offsets[key_bucket(&items[i], depth, as_paths) + 1];
+
+      /* Skip common prefixes without shuffling the items around. */
+      bucket = key_bucket(&items[0], depth, as_paths);
+      if (offsets[bucket + 1] == count)
+        {
+          /* All keys ended?  Then they are all equal. */
+          if (bucket == 0)
+            return;
+
+          ++depth;
+          continue;
+        }
+
+      for (bucket = 0; bucket < RADIX_SORT_BUCKETS; ++bucket)
+        {
+          offsets[bucket + 1] += offsets[bucket];
+          next[bucket] = offsets[bucket];
+        }
+
+      for (i = 0; i < count; ++i)
+        buffer[next[key_bucket(&items[i], depth, as_paths)]++] = items[i];
+      memcpy(items, buffer, count * sizeof(*items));
+
+      /* Bucket 0 contains equal keys and needs no further sorting. */
+      largest = 1;
+      for (bucket = 2; bucket < RADIX_SORT_BUCKETS; ++bucket)
+        if (   offsets[bucket + 1] - offsets[bucket]
+            > offsets[largest + 1] - offsets[largest])
+          largest = bucket;
+
+      for (bucket = 1; bucket < RADIX_SORT_BUCKETS; ++bucket)
+        if (bucket != largest && offsets[bucket + 1] - offsets[bucket] > 1)
+          radix_sort_items(items + offsets[bucket], buffer + offsets[bucket],
+                           offsets[bucket + 1] - offsets[bucket], depth + 1,
+                           as_paths, comparison_func);
+
+      items += offsets[largest];
+      buffer += offsets[largest];
+      count = offsets[largest + 1] - offsets[largest];
+      ++depth;
+    }
+
+  if (count > 1)
+    qsort(items, count, sizeof(*items), comparison_func);
+}
+
+void
+svn_sort__items(apr_array_header_t *items,
+                int (*comparison_func)(const svn_sort__item_t *,
+                                       const svn_sort__item_t *),
+                apr_pool_t *scratch_pool)
+{
+  int (*compare)(const void *, const void *)
+    = (int (*)(const void *, const void *))comparison_func;
+
+  /* Path keys and plain strings can be sorted by their chars. */
+  if (items->nelts >= RADIX_SORT_THRESHOLD
+      && (   comparison_func == svn_sort_compare_items_as_paths
+          || comparison_func == svn_sort_compare_items_lexically))
+    {
+      svn_sort__item_t *buffer
+        = apr_palloc(scratch_pool, items->nelts * sizeof(*buffer));
+
+      radix_sort_items((svn_sort__item_t *)items->elts, buffer, items->nelts,
+                       0,
+                       comparison_func == svn_sort_compare_items_as_paths,
+                       compare);
+    }
+  else
+    {
+      qsort(items->elts, items->nelts, items->elt_size, compare);
+    }
+}
+
 void
 svn_sort__array(apr_array_header_t *array,
                 int (*comparison_func)(const void *,
                                        const void *))
 {
+  /* Large arrays of paths get sorted by svn_sort__items(). */
+  if (   array->nelts >= RADIX_SORT_THRESHOLD
+      && comparison_func == svn_sort_compare_paths
+      && array->elt_size == sizeof(const char *))
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(array->pool);
+      apr_array_header_t *items = apr_array_make(scratch_pool, array->nelts,
+                                                 sizeof(svn_sort__item_t));
+      int i;
+
+      for (i = 0; i < array->nelts; ++i)
+        {
+          svn_sort__item_t *item = apr_array_push(items);
+
+          item->value = APR_ARRAY_IDX(array, i, const char *);
+          item->key = item->value;
+          item->klen = strlen(item->value);
+        }
+
+      svn_sort__items(items, svn_sort_compare_items_as_paths, scratch_pool);
+
+      for (i = 0; i < array->nelts; ++i)
+        APR_ARRAY_IDX(array, i, const char *)
+          = APR_ARRAY_IDX(items, i, svn_sort__item_t).value;
+
+      svn_pool_destroy(scratch_pool);
+      return;
+    }
+
   qsort(array->elts, array->nelts, array->elt_size, comparison_func);
 }
 
@@ -180,10 +340,11 @@ svn_sort__hash(apr_hash_t *ht,
         }
     }
 
-  /* quicksort the array if it isn't already sorted.  */
+  /* sort the array if it isn't already sorted.  A radix sort needs a
+     buffer as large as ARY, which is cheaper to take from POOL than
+     to create a sub-pool for every call. */
   if (!sorted)
-    svn_sort__array(ary,
-          (int (*)(const void *, const void *))comparison_func);
+    svn_sort__items(ary, comparison_func, pool);
 
   return ary;
 }
@@ -375,6 +375,49 @@ svn_sqlite__insert(apr_int64_t *row_id, svn_sqlite__stmt_t *stmt)
   return svn_error_trace(svn_sqlite__reset(stmt));
 }
 
+/* Bind the values of row number ROW to STMT using BIND_ROW and BATON,
+   execute it and rewind STMT for the next row, keeping the bindings.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+insert_row(svn_sqlite__stmt_t *stmt,
+           int row,
+           svn_sqlite__bind_row_func_t bind_row,
+           void *baton,
+           apr_pool_t *scratch_pool)
+{
+  SVN_ERR(bind_row(stmt, row, baton, scratch_pool));
+  SVN_ERR(step_with_expectation(stmt, FALSE));
+
+  /* Unlike svn_sqlite__reset(), this does not clear the bindings. */
+  SQLITE_ERR(sqlite3_reset(stmt->s3stmt), stmt->db);
+  stmt->needs_reset = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_sqlite__insert_rows(svn_sqlite__stmt_t *stmt,
+                        int row_count,
+                        svn_sqlite__bind_row_func_t bind_row,
+                        void *baton,
+                        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  for (i = 0; i < row_count && !err; ++i)
+    {
+      svn_pool_clear(iterpool);
+      err = insert_row(stmt, i, bind_row, baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_error_compose_create(err,
+                                                  svn_sqlite__reset(stmt)));
+}
+
 svn_error_t *
 svn_sqlite__update(int *affected_rows, svn_sqlite__stmt_t *stmt)
 {
@@ -781,6 +824,25 @@ svn_sqlite__read_schema_version(int *version,
 }
 
 
+/* Set *WAL to TRUE, if DB uses a write-ahead log, and to FALSE otherwise.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+uses_wal(svn_boolean_t *wal,
+         svn_sqlite__db_t *db,
+         apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA journal_mode;", scratch_pool));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+
+  *wal = svn_cstring_casecmp(svn_sqlite__column_text(stmt, 0, NULL),
+                             "wal") == 0;
+
+  return svn_error_trace(svn_sqlite__finalize(stmt));
+}
+
+
 static volatile svn_atomic_t sqlite_init_state = 0;
 
 /* If possible, verify that SQLite was compiled in a thread-safe
@@ -1070,12 +1132,18 @@ like_ucs_nfd(sqlite3_context *context,
 #endif /* SVN_UNICODE_NORMALIZATION_FIXES */
 
 svn_error_t *
-svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
-                 svn_sqlite__mode_t mode, const char * const statements[],
-                 int unused1, const char * const *unused2,
-                 apr_int32_t timeout,
-                 apr_pool_t *result_pool, apr_pool_t *scratch_pool)
+svn_sqlite__open2(svn_sqlite__db_t **db, const char *path,
+                  svn_sqlite__mode_t mode, const char * const statements[],
+                  const svn_sqlite__open_options_t *options,
+                  apr_int32_t timeout,
+                  apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
+  static const svn_sqlite__open_options_t default_options
+    = { FALSE, svn_sqlite__sync_off, 0 };
+
+  if (options == NULL)
+    options = &default_options;
+
   SVN_ERR(svn_atomic__init_once(&sqlite_init_state,
                                 init_sqlite, NULL, scratch_pool));
 
@@ -1142,19 +1210,6 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  insensitive depending on the value of the case_sensitive_like
                  pragma. */
               "PRAGMA case_sensitive_like=1;"
-              /* Disable synchronization to disable the explicit disk flushes
-                 that make Sqlite up to 50 times slower; especially on small
-                 transactions.
-
-                 This removes some stability guarantees on specific hardware
-                 and power failures, but still guarantees atomic commits on
-                 application crashes. With our dependency on external data
-                 like pristine files (Wc) and revision files (repository),
-                 we can't keep up these additional guarantees anyway.
-
-                 ### Maybe switch to NORMAL(1) when we use larger transaction
-                     scopes */
-              "PRAGMA synchronous=OFF;"
               /* Enable recursive triggers so that a user trigger will fire
                  in the deletion phase of an INSERT OR REPLACE statement.
                  Requires SQLite >= 3.6.18  */
@@ -1164,11 +1219,71 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  affects application(read: Subversion) performance/behavior. */
               "PRAGMA foreign_keys=OFF;"      /* SQLITE_DEFAULT_FOREIGN_KEYS*/
               "PRAGMA locking_mode = NORMAL;" /* SQLITE_DEFAULT_LOCKING_MODE */
-              /* Testing shows TRUNCATE is faster than DELETE on Windows. */
-              "PRAGMA journal_mode = TRUNCATE;"
               ),
                 *db);
 
+  /* By default, disable synchronization to disable the explicit disk
+     flushes that make Sqlite up to 50 times slower; especially on small
+     transactions.
+
+     This removes some stability guarantees on specific hardware and power
+     failures, but still guarantees atomic commits on application crashes.
+     With our dependency on external data like pristine files (Wc) and
+     revision files (repository), we can't keep up these additional
+     guarantees anyway.  Callers using larger transaction scopes or a
+     write-ahead log may opt for NORMAL, though. */
+  switch (options->synchronous)
+    {
+      case svn_sqlite__sync_off:
+        SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA synchronous=OFF;"), *db);
+        break;
+      case svn_sqlite__sync_normal:
+        SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA synchronous=NORMAL;"),
+                              *db);
+        break;
+      case svn_sqlite__sync_full:
+        SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA synchronous=FULL;"), *db);
+        break;
+      default:
+        SVN_ERR_MALFUNCTION();
+    }
+
+  /* Read-only connections use whatever journal mode the database is in. */
+  if (mode != svn_sqlite__mode_readonly && options->wal)
+    {
+      /* The journal mode is persistent, i.e. once switched, all following
+         connections will use the write-ahead log as well.  SQLite silently
+         stays with the current mode if the WAL is not supported, e.g. on
+         some network file systems. */
+      SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA journal_mode = WAL;"),
+                            *db);
+    }
+  else if (mode != svn_sqlite__mode_readonly)
+    {
+      svn_boolean_t wal;
+
+      /* Don't switch a database that uses a write-ahead log back.  That
+         would require exclusive access and affect all other users. */
+      SVN_SQLITE__ERR_CLOSE(uses_wal(&wal, *db, scratch_pool), *db);
+
+      /* Testing shows TRUNCATE is faster than DELETE on Windows. */
+      if (!wal)
+        SVN_SQLITE__ERR_CLOSE(exec_sql(*db,
+                                       "PRAGMA journal_mode = TRUNCATE;"),
+                              *db);
+    }
+
+#if SQLITE_VERSION_AT_LEAST(3,7,17)
+  /* Don't fail if memory mapping has been disabled in the sqlite
+     compilation by setting SQLITE_MAX_MMAP_SIZE to 0. */
+  if (options->mmap_size > 0)
+    svn_error_clear(exec_sql(*db,
+                             apr_psprintf(scratch_pool,
+                                          "PRAGMA mmap_size = %"
+                                          APR_INT64_T_FMT ";",
+                                          options->mmap_size)));
+#endif
+
 #if defined(SVN_DEBUG)
   /* When running in debug mode, enable the checking of foreign key
      constraints.  This has possible performance implications, so we don't
@@ -1221,6 +1336,18 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
+                 svn_sqlite__mode_t mode, const char * const statements[],
+                 int unused1, const char * const *unused2,
+                 apr_int32_t timeout,
+                 apr_pool_t *result_pool, apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_sqlite__open2(db, path, mode, statements, NULL,
+                                           timeout, result_pool,
+                                           scratch_pool));
+}
+
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db)
 {
@@ -31,6 +31,7 @@
 #include <apr_errno.h>
 #include <apr_poll.h>
 #include <apr_portable.h>
+#include <apr_mmap.h>
 
 #include <zlib.h>
 
@@ -62,6 +63,7 @@ struct svn_stream_t {
   svn_stream_seek_fn_t seek_fn;
   svn_stream_data_available_fn_t data_available_fn;
   svn_stream_readline_fn_t readline_fn;
+  svn_stream__borrow_fn_t borrow_fn;
   apr_file_t *file; /* Maybe NULL */
 };
 
@@ -145,6 +147,13 @@ svn_stream_set_readline(svn_stream_t *stream,
   stream->readline_fn = readline_fn;
 }
 
+void
+svn_stream__set_borrow(svn_stream_t *stream,
+                       svn_stream__borrow_fn_t borrow_fn)
+{
+  stream->borrow_fn = borrow_fn;
+}
+
 /* Standard implementation for svn_stream_read_full() based on
    multiple svn_stream_read2() calls (in separate function to make
    it more likely for svn_stream_read_full to be inlined) */
@@ -194,6 +203,38 @@ svn_stream_read_full(svn_stream_t *stream, char *buffer, apr_size_t *len)
   return svn_error_trace(stream->read_full_fn(stream->baton, buffer, len));
 }
 
+svn_boolean_t
+svn_stream__supports_borrow(svn_stream_t *stream)
+{
+  return stream->borrow_fn != NULL;
+}
+
+svn_error_t *
+svn_stream__borrow(svn_stream_t *stream, const char **data, apr_size_t *len)
+{
+  if (stream->borrow_fn == NULL)
+    return svn_error_create(SVN_ERR_STREAM_NOT_SUPPORTED, NULL, NULL);
+
+  return svn_error_trace(stream->borrow_fn(stream->baton, data, len));
+}
+
+/* Like svn_stream_read_full() but set *DATA to the data read.  If STREAM
+   supports borrowing, *DATA will point into the stream's own memory.
+   Otherwise, the data will be read into BUFFER, which must be able to hold
+   *LEN bytes. */
+static svn_error_t *
+read_or_borrow(svn_stream_t *stream,
+               const char **data,
+               char *buffer,
+               apr_size_t *len)
+{
+  if (stream->borrow_fn)
+    return svn_error_trace(stream->borrow_fn(stream->baton, data, len));
+
+  *data = buffer;
+  return svn_error_trace(svn_stream_read_full(stream, buffer, len));
+}
+
 svn_error_t *
 svn_stream_skip(svn_stream_t *stream, apr_size_t len)
 {
@@ -412,6 +453,7 @@ svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
   while (1)
     {
       apr_size_t len = SVN__STREAM_CHUNK_SIZE;
+      const char *data;
 
       if (cancel_func)
         {
@@ -420,12 +462,12 @@ svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
              break;
         }
 
-      err = svn_stream_read_full(from, buf, &len);
+      err = read_or_borrow(from, &data, buf, &len);
       if (err)
          break;
 
       if (len > 0)
-        err = svn_stream_write(to, buf, &len);
+        err = svn_stream_write(to, data, &len);
 
       if (err || (len != SVN__STREAM_CHUNK_SIZE))
           break;
@@ -453,15 +495,17 @@ svn_stream_contents_same2(svn_boolean_t *same,
   while (bytes_read1 == SVN__STREAM_CHUNK_SIZE
          && bytes_read2 == SVN__STREAM_CHUNK_SIZE)
     {
-      err = svn_stream_read_full(stream1, buf1, &bytes_read1);
+      const char *data1, *data2;
+
+      err = read_or_borrow(stream1, &data1, buf1, &bytes_read1);
       if (err)
         break;
-      err = svn_stream_read_full(stream2, buf2, &bytes_read2);
+      err = read_or_borrow(stream2, &data2, buf2, &bytes_read2);
       if (err)
         break;
 
       if ((bytes_read1 != bytes_read2)
-          || (memcmp(buf1, buf2, bytes_read1)))
+          || (memcmp(data1, data2, bytes_read1)))
         {
           *same = FALSE;
           break;
@@ -654,6 +698,12 @@ readline_handler_disown(void *baton,
                                              eof, pool));
 }
 
+static svn_error_t *
+borrow_handler_disown(void *baton, const char **data, apr_size_t *len)
+{
+  return svn_error_trace(svn_stream__borrow(baton, data, len));
+}
+
 svn_stream_t *
 svn_stream_disown(svn_stream_t *stream, apr_pool_t *pool)
 {
@@ -666,6 +716,8 @@ svn_stream_disown(svn_stream_t *stream, apr_pool_t *pool)
   svn_stream_set_seek(s, seek_handler_disown);
   svn_stream_set_data_available(s, data_available_disown);
   svn_stream_set_readline(s, readline_handler_disown);
+  if (stream->borrow_fn)
+    svn_stream__set_borrow(s, borrow_handler_disown);
 
   return s;
 }
@@ -1536,11 +1588,12 @@ compute_stream_checksum(svn_checksum_t **checksum,
   while (1)
     {
       apr_size_t len = SVN__STREAM_CHUNK_SIZE;
+      const char *data;
 
-      SVN_ERR(svn_stream_read_full(stream, buf, &len));
+      SVN_ERR(read_or_borrow(stream, &data, buf, &len));
 
       if (len > 0)
-        SVN_ERR(svn_checksum_update(ctx, buf, len));
+        SVN_ERR(svn_checksum_update(ctx, data, len));
 
       if (len != SVN__STREAM_CHUNK_SIZE)
           break;
@@ -1772,6 +1825,18 @@ read_handler_string(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+borrow_handler_string(void *baton, const char **data, apr_size_t *len)
+{
+  struct string_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  *data = btn->str->data + btn->amt_read;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 mark_handler_string(void *baton, svn_stream_mark_t **mark, apr_pool_t *pool)
 {
@@ -1875,10 +1940,95 @@ svn_stream_from_string(const svn_string_t *str,
   svn_stream_set_skip(stream, skip_handler_string);
   svn_stream_set_data_available(stream, data_available_handler_string);
   svn_stream_set_readline(stream, readline_handler_string);
+  svn_stream__set_borrow(stream, borrow_handler_string);
   return stream;
 }
 
 
+/*** Streams backed by memory mapped files ***/
+
+/* Don't bother mapping files smaller than this.  Reading them is cheaper.
+ * Windows does not allow files to be deleted while mapped. */
+#if APR_HAS_MMAP && !defined(WIN32)
+#define MMAP_THRESHOLD 0x10000
+#endif
+
+#ifdef MMAP_THRESHOLD
+
+/* Baton for streams over a memory mapped file.  STRING must be the first
+   member such that the string stream handlers can operate on it. */
+struct mmap_stream_baton
+{
+  struct string_stream_baton string;
+  svn_string_t contents;
+  apr_mmap_t *mmap;
+};
+
+static svn_error_t *
+close_handler_mmap(void *baton)
+{
+  struct mmap_stream_baton *btn = baton;
+  apr_status_t status = apr_mmap_delete(btn->mmap);
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't unmap file"));
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* MMAP_THRESHOLD */
+
+svn_error_t *
+svn_stream__from_mapped_aprfile(svn_stream_t **stream,
+                                apr_file_t *file,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+#ifdef MMAP_THRESHOLD
+  apr_off_t size;
+  apr_mmap_t *mmap;
+
+  SVN_ERR(svn_io_file_size_get(&size, file, scratch_pool));
+  if (size >= MMAP_THRESHOLD && size <= APR_SIZE_MAX
+      && apr_mmap_create(&mmap, file, 0, (apr_size_t)size, APR_MMAP_READ,
+                         result_pool) == APR_SUCCESS)
+    {
+      struct mmap_stream_baton *baton = apr_palloc(result_pool,
+                                                   sizeof(*baton));
+      svn_stream_t *s;
+
+      /* The mapping remains valid after closing the file. */
+      SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+      baton->contents.data = mmap->mm;
+      baton->contents.len = mmap->size;
+      baton->string.str = &baton->contents;
+      baton->string.amt_read = 0;
+      baton->mmap = mmap;
+
+      /* The mapped data is not NUL terminated, so we can't use
+         readline_handler_string(). */
+      s = svn_stream_create(baton, result_pool);
+      svn_stream_set_read2(s, read_handler_string, read_handler_string);
+      svn_stream_set_mark(s, mark_handler_string);
+      svn_stream_set_seek(s, seek_handler_string);
+      svn_stream_set_skip(s, skip_handler_string);
+      svn_stream_set_data_available(s, data_available_handler_string);
+      svn_stream_set_close(s, close_handler_mmap);
+      svn_stream__set_borrow(s, borrow_handler_string);
+
+      *stream = s;
+      return SVN_NO_ERROR;
+    }
+
+  /* Mapping failed.  Simply read the file. */
+#endif
+
+  *stream = svn_stream_from_aprfile2(file, FALSE, result_pool);
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_stream_for_stdin2(svn_stream_t **in,
                       svn_boolean_t buffered,
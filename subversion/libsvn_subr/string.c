@@ -37,6 +37,27 @@
 
 #include "svn_private_config.h"
 
+/* The compiler provides the vector instructions and bit scan intrinsics
+ * that svn_cstring__match_length() and its reverse counterpart need. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#  define SVN_STRING_SSE2
+#  include <emmintrin.h>
+#  if defined(__AVX2__)
+#    define SVN_STRING_AVX2
+#    include <immintrin.h>
+#  endif
+#elif defined(__aarch64__) && defined(__ARM_NEON) && defined(__GNUC__)
+#  define SVN_STRING_NEON
+#  include <arm_neon.h>
+#endif
+
+/* Machine words can be compared as a whole and the number of matching
+ * bytes be derived from the number of trailing / leading zero bits. */
+#if SVN_UNALIGNED_ACCESS_IS_OK && defined(__GNUC__) \
+    && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define SVN_STRING_WORD_SCAN
+#endif
+
 
 
 /* Allocate the space for a memory buffer from POOL.
@@ -1508,18 +1529,61 @@ svn_cstring__match_length(const char *a,
 {
   apr_size_t pos = 0;
 
-#if SVN_UNALIGNED_ACCESS_IS_OK
-
   /* Chunky processing is so much faster ...
    *
-   * We can't make this work on architectures that require aligned access
-   * because A and B will probably have different alignment. So, skipping
-   * the first few chars until alignment is reached is not an option.
+   * Compare whole vectors or machine words and locate the first
+   * mismatch within them with a single bit scan.  We can't make the
+   * word-wise variant work on architectures that require aligned access
+   * because A and B will probably have different alignment.
    */
-  for (; max_len - pos >= sizeof(apr_size_t); pos += sizeof(apr_size_t))
-    if (*(const apr_size_t*)(a + pos) != *(const apr_size_t*)(b + pos))
-      break;
+#ifdef SVN_STRING_AVX2
+  for (; max_len - pos >= 32; pos += 32)
+    {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(a + pos));
+      __m256i y = _mm256_loadu_si256((const __m256i *)(b + pos));
+      unsigned int mask
+        = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+      if (mask)
+        return pos + __builtin_ctz(mask);
+    }
+#endif
+
+#if defined(SVN_STRING_SSE2)
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      __m128i x = _mm_loadu_si128((const __m128i *)(a + pos));
+      __m128i y = _mm_loadu_si128((const __m128i *)(b + pos));
+      unsigned int mask
+        = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xffff;
+      if (mask)
+        return pos + __builtin_ctz(mask);
+    }
+#elif defined(SVN_STRING_NEON)
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      uint8x16_t diff = vmvnq_u8(vceqq_u8(vld1q_u8((const uint8_t *)a + pos),
+                                          vld1q_u8((const uint8_t *)b + pos)));
+      uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+                        vshrn_n_u16(vreinterpretq_u16_u8(diff), 4)), 0);
+      if (mask)
+        return pos + (__builtin_ctzll(mask) >> 2);
+    }
+#endif
 
+#if SVN_UNALIGNED_ACCESS_IS_OK
+  for (; max_len - pos >= sizeof(apr_size_t); pos += sizeof(apr_size_t))
+    {
+      apr_size_t diff = *(const apr_size_t *)(a + pos)
+                      ^ *(const apr_size_t *)(b + pos);
+      if (diff)
+        {
+#ifdef SVN_STRING_WORD_SCAN
+          return pos + (__builtin_ctzll(diff) >> 3);
+#else
+          break;
+#endif
+        }
+    }
 #endif
 
   for (; pos < max_len; ++pos)
@@ -1536,31 +1600,67 @@ svn_cstring__reverse_match_length(const char *a,
 {
   apr_size_t pos = 0;
 
-#if SVN_UNALIGNED_ACCESS_IS_OK
-
-  /* Chunky processing is so much faster ...
-   *
-   * We can't make this work on architectures that require aligned access
-   * because A and B will probably have different alignment. So, skipping
-   * the first few chars until alignment is reached is not an option.
+  /* Same as in svn_cstring__match_length() but scanning backwards, i.e.
+   * we are looking for the highest mismatching byte in each chunk.
    */
-  for (pos = sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
-    if (*(const apr_size_t*)(a - pos) != *(const apr_size_t*)(b - pos))
-      break;
+#ifdef SVN_STRING_AVX2
+  for (; max_len - pos >= 32; pos += 32)
+    {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(a - pos - 32));
+      __m256i y = _mm256_loadu_si256((const __m256i *)(b - pos - 32));
+      unsigned int mask
+        = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+      if (mask)
+        return pos + __builtin_clz(mask);
+    }
+#endif
 
-  pos -= sizeof(apr_size_t);
+#if defined(SVN_STRING_SSE2)
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      __m128i x = _mm_loadu_si128((const __m128i *)(a - pos - 16));
+      __m128i y = _mm_loadu_si128((const __m128i *)(b - pos - 16));
+      unsigned int mask
+        = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) << 16;
+      if (mask)
+        return pos + __builtin_clz(mask);
+    }
+#elif defined(SVN_STRING_NEON)
+  for (; max_len - pos >= 16; pos += 16)
+    {
+      uint8x16_t diff
+        = vmvnq_u8(vceqq_u8(vld1q_u8((const uint8_t *)a - pos - 16),
+                            vld1q_u8((const uint8_t *)b - pos - 16)));
+      uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+                        vshrn_n_u16(vreinterpretq_u16_u8(diff), 4)), 0);
+      if (mask)
+        return pos + (__builtin_clzll(mask) >> 2);
+    }
+#endif
 
+#if SVN_UNALIGNED_ACCESS_IS_OK
+  for (; max_len - pos >= sizeof(apr_size_t); pos += sizeof(apr_size_t))
+    {
+      apr_size_t diff = *(const apr_size_t *)(a - pos - sizeof(apr_size_t))
+                      ^ *(const apr_size_t *)(b - pos - sizeof(apr_size_t));
+      if (diff)
+        {
+#ifdef SVN_STRING_WORD_SCAN
+          /* Count the matching bytes at the high end of DIFF. */
+          return pos + ((__builtin_clzll(diff)
+                         - (64 - 8 * sizeof(apr_size_t))) >> 3);
+#else
+          break;
+#endif
+        }
+    }
 #endif
 
-  /* If we find a mismatch at -pos, pos-1 characters matched.
-   */
-  while (++pos <= max_len)
-    if (a[0-pos] != b[0-pos])
-      return pos - 1;
+  for (; pos < max_len; ++pos)
+    if (a[-1 - (apr_ssize_t)pos] != b[-1 - (apr_ssize_t)pos])
+      break;
 
-  /* No mismatch found -> at least MAX_LEN matching chars.
-   */
-  return max_len;
+  return pos;
 }
 
 const char *
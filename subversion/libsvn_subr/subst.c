@@ -52,6 +52,16 @@
 #include "private/svn_string_private.h"
 #include "private/svn_eol_private.h"
 
+/* The compiler provides the vector instructions and bit scan intrinsics
+ * that find_interesting() needs. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#  define SVN_SUBST_SSE2
+#  include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON) && defined(__GNUC__)
+#  define SVN_SUBST_NEON
+#  include <arm_neon.h>
+#endif
+
 /**
  * The textual elements of a detranslated special file.  One of these
  * strings must appear as the first element of any special file as it
@@ -876,6 +886,10 @@ struct translation_baton
      may trigger a translation action, hence are 'interesting' */
   char interesting[256];
 
+  /* The interesting characters, the first one repeated as necessary
+     to fill all slots. */
+  char interesting_chars[3];
+
   /* Length of the string EOL_STR points to. */
   apr_size_t eol_str_len;
 
@@ -946,9 +960,69 @@ create_translation_baton(const char *eol_str,
       b->interesting['\n'] = TRUE;
     }
 
+  b->interesting_chars[0] = keywords ? '$' : '\n';
+  b->interesting_chars[1] = eol_str ? '\r' : b->interesting_chars[0];
+  b->interesting_chars[2] = eol_str ? '\n' : b->interesting_chars[0];
+
   return b;
 }
 
+/* Return the position of the first character between DATA and END that
+ * is one of the three CHARS, or END if there is none.
+ */
+static const char *
+find_interesting(const char *data,
+                 const char *end,
+                 const char chars[3])
+{
+#if defined(SVN_SUBST_SSE2)
+
+  /* Compare 16 bytes at a time against all three characters. */
+  const __m128i c0 = _mm_set1_epi8(chars[0]);
+  const __m128i c1 = _mm_set1_epi8(chars[1]);
+  const __m128i c2 = _mm_set1_epi8(chars[2]);
+
+  for (; end - data >= 16; data += 16)
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)data);
+      int mask = _mm_movemask_epi8(
+                   _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, c0),
+                                             _mm_cmpeq_epi8(chunk, c1)),
+                                _mm_cmpeq_epi8(chunk, c2)));
+      if (mask)
+        return data + __builtin_ctz(mask);
+    }
+
+#elif defined(SVN_SUBST_NEON)
+
+  /* Compare 16 bytes at a time against all three characters.  Narrowing
+   * the comparison result yields 4 bits per input byte. */
+  const uint8x16_t c0 = vdupq_n_u8((unsigned char)chars[0]);
+  const uint8x16_t c1 = vdupq_n_u8((unsigned char)chars[1]);
+  const uint8x16_t c2 = vdupq_n_u8((unsigned char)chars[2]);
+
+  for (; end - data >= 16; data += 16)
+    {
+      uint8x16_t chunk = vld1q_u8((const uint8_t *)data);
+      uint8x16_t found = vorrq_u8(vorrq_u8(vceqq_u8(chunk, c0),
+                                           vceqq_u8(chunk, c1)),
+                                  vceqq_u8(chunk, c2));
+      uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+                        vshrn_n_u16(vreinterpretq_u16_u8(found), 4)), 0);
+      if (mask)
+        return data + (__builtin_ctzll(mask) >> 2);
+    }
+
+#endif
+
+  /* The remaining odd bytes will be examined the naive way: */
+  for (; data < end; ++data)
+    if (*data == chars[0] || *data == chars[1] || *data == chars[2])
+      break;
+
+  return data;
+}
+
 /* Return TRUE if the EOL starting at BUF matches the eol_str member of B.
  * Be aware of special cases like "\n\r\n" and "\n\n\r". For sequences like
  * "\n$" (an EOL followed by a keyword), the result will be FALSE since it is
@@ -1125,24 +1199,11 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
-                    {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
-                        break;
-
-                      len += 4;
-                    }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
+                  /* Find the next '$' or, if we translate EOLs, the next
+                     EOL char. */
+                  const char *start = p + len;
+                  len += find_interesting(start, end,
+                                          b->interesting_chars) - start;
                 }
               else
                 {
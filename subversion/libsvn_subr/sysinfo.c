@@ -141,7 +141,7 @@ const apr_array_header_t *
 svn_sysinfo__linked_libs(apr_pool_t *pool)
 {
   svn_version_ext_linked_lib_t *lib;
-  apr_array_header_t *array = apr_array_make(pool, 7, sizeof(*lib));
+  apr_array_header_t *array = apr_array_make(pool, 8, sizeof(*lib));
   int lz4_version = svn_lz4__runtime_version();
 
   lib = &APR_ARRAY_PUSH(array, svn_version_ext_linked_lib_t);
@@ -191,6 +191,14 @@ svn_sysinfo__linked_libs(apr_pool_t *pool)
                                       (lz4_version / 100) % 100,
                                       lz4_version % 100);
 
+  if (svn__zstd_available())
+    {
+      lib = &APR_ARRAY_PUSH(array, svn_version_ext_linked_lib_t);
+      lib->name = "Zstandard";
+      lib->compiled_version = apr_pstrdup(pool, svn_zstd__compiled_version());
+      lib->runtime_version = apr_pstrdup(pool, svn_zstd__runtime_version());
+    }
+
   return array;
 }
 
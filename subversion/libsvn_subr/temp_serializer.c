@@ -22,6 +22,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "private/svn_temp_serializer.h"
 #include "svn_string.h"
 
@@ -400,3 +401,65 @@ svn_temp_deserializer__ptr(const void *buffer, const void *const *ptr)
       ? NULL
       : (const char*)buffer + (apr_size_t)*ptr;
 }
+
+void
+svn_temp_deserializer__view_init(svn_temp_deserializer__view_t *view,
+                                 const void *data,
+                                 apr_size_t len)
+{
+  view->data = data;
+  view->len = len;
+}
+
+const void *
+svn_temp_deserializer__view_ptr(const svn_temp_deserializer__view_t *view,
+                                const void *parent,
+                                const void *const *ptr,
+                                apr_size_t size)
+{
+  apr_size_t parent_offset;
+  apr_size_t ptr_offset;
+
+  /* PARENT itself must be part of the view. */
+  if (   (const char *)parent < view->data
+      || (const char *)parent > view->data + view->len)
+    return NULL;
+
+  /* So must be the whole pointer slot we are about to read. */
+  if (   (const char *)ptr < view->data
+      || view->len < sizeof(*ptr)
+      || (apr_size_t)((const char *)ptr - view->data)
+           > view->len - sizeof(*ptr))
+    return NULL;
+
+  parent_offset = (const char *)parent - view->data;
+  ptr_offset = (apr_size_t)*ptr;
+
+  /* NULL pointers, and offsets that would point back into PARENT or
+   * beyond the end of the view, cannot be resolved.  Be careful to not
+   * overflow in the range check. */
+  if (   ptr_offset == 0
+      || ptr_offset > view->len - parent_offset
+      || size > view->len - parent_offset - ptr_offset)
+    return NULL;
+
+  return view->data + parent_offset + ptr_offset;
+}
+
+const char *
+svn_temp_deserializer__view_string(const svn_temp_deserializer__view_t *view,
+                                   const void *parent,
+                                   const char *const *ptr)
+{
+  const char *result = svn_temp_deserializer__view_ptr(view, parent,
+                                                       (const void *const *)ptr,
+                                                       0);
+  if (result == NULL)
+    return NULL;
+
+  /* The terminating NUL must be inside the view as well. */
+  if (!memchr(result, 0, view->data + view->len - result))
+    return NULL;
+
+  return result;
+}
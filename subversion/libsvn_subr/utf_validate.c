@@ -60,6 +60,26 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+/* Select the vector instruction sets the compiler can generate code for.
+ * SSE2 and NEON are part of the respective base architectures while AVX2
+ * support will be tested at run-time.
+ */
+#if defined(__SSE2__)
+#  define SVN_UTF_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#  define SVN_UTF_X86_AVX2
+#  include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  define SVN_UTF_NEON
+#  include <arm_neon.h>
+#endif
+
 /* Lookup table to categorise each octet in the string. */
 static const char octet_category[256] = {
   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x00-0x7f */
@@ -258,6 +278,30 @@ static const char machine [9][14] = {
 static const char *
 first_non_fsm_start_char(const char *data, apr_size_t max_len)
 {
+#if defined(SVN_UTF_SSE2)
+
+  /* Scan the input 32 bytes at a time. */
+  for (; max_len >= 32; data += 32, max_len -= 32)
+    {
+      __m128i first = _mm_loadu_si128((const __m128i *)data);
+      __m128i second = _mm_loadu_si128((const __m128i *)data + 1);
+      if (_mm_movemask_epi8(_mm_or_si128(first, second)))
+        break;
+    }
+
+#elif defined(SVN_UTF_NEON)
+
+  /* Scan the input 32 bytes at a time. */
+  for (; max_len >= 32; data += 32, max_len -= 32)
+    {
+      uint8x16_t first = vld1q_u8((const uint8_t *)data);
+      uint8x16_t second = vld1q_u8((const uint8_t *)data + 16);
+      if (vmaxvq_u8(vorrq_u8(first, second)) >= 0x80)
+        break;
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
@@ -276,10 +320,338 @@ first_non_fsm_start_char(const char *data, apr_size_t max_len)
   return data;
 }
 
+/* Vectorized validation following the algorithm by Keiser and Lemire,
+ * "Validating UTF-8 In Less Than One Instruction Per Byte" (2021).
+ *
+ * Each byte gets classified by table lookups on the high and low nibble
+ * of its predecessor and on its own high nibble.  The results are bit sets
+ * of the errors that the respective nibble is compatible with.  The error
+ * is present if all three lookups agree on it.  Only the length of 3 and
+ * 4 byte sequences needs to be checked separately.
+ */
+#if defined(SVN_UTF_X86_AVX2) || defined(SVN_UTF_NEON)
+
+/* Error classes of two consecutive bytes. */
+#define TOO_SHORT       0x01  /* 11______ 0_______ or 11______ 11______ */
+#define TOO_LONG        0x02  /* 0_______ 10______ */
+#define OVERLONG_3      0x04  /* 11100000 100_____ */
+#define TOO_LARGE       0x08  /* 11110100 1001____ and beyond */
+#define SURROGATE       0x10  /* 11101101 101_____ */
+#define OVERLONG_2      0x20  /* 1100000_ 10______ */
+#define TOO_LARGE_1000  0x40  /* 11110101 1000____ and beyond */
+#define OVERLONG_4      0x40  /* 11110000 1000____ */
+#define TWO_CONTS       0x80  /* 10______ 10______ */
+#define CARRY           (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+/* Errors compatible with the high nibble of the first byte. */
+static const unsigned char byte_1_high_errors[16] = {
+  TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,         /* 0_______ */
+  TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+  TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,     /* 10______ */
+  TOO_SHORT | OVERLONG_2,                         /* 1100____ */
+  TOO_SHORT,                                      /* 1101____ */
+  TOO_SHORT | OVERLONG_3 | SURROGATE,             /* 1110____ */
+  TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4 /* 1111____ */
+};
+
+/* Errors compatible with the low nibble of the first byte. */
+static const unsigned char byte_1_low_errors[16] = {
+  CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,   /* ____0000 */
+  CARRY | OVERLONG_2,                             /* ____0001 */
+  CARRY,                                          /* ____001_ */
+  CARRY,
+  CARRY | TOO_LARGE,                              /* ____0100 */
+  CARRY | TOO_LARGE | TOO_LARGE_1000,             /* ____0101 */
+  CARRY | TOO_LARGE | TOO_LARGE_1000,             /* ____011_ */
+  CARRY | TOO_LARGE | TOO_LARGE_1000,
+  CARRY | TOO_LARGE | TOO_LARGE_1000,             /* ____1___ */
+  CARRY | TOO_LARGE | TOO_LARGE_1000,
+  CARRY | TOO_LARGE | TOO_LARGE_1000,
+  CARRY | TOO_LARGE | TOO_LARGE_1000,
+  CARRY | TOO_LARGE | TOO_LARGE_1000,
+  CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, /* ____1101 */
+  CARRY | TOO_LARGE | TOO_LARGE_1000,
+  CARRY | TOO_LARGE | TOO_LARGE_1000
+};
+
+/* Errors compatible with the high nibble of the second byte. */
+static const unsigned char byte_2_high_errors[16] = {
+  TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,     /* 0_______ */
+  TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3  /* 1000____ */
+    | TOO_LARGE_1000 | OVERLONG_4,
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3  /* 1001____ */
+    | TOO_LARGE,
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE   /* 101_____ */
+    | TOO_LARGE,
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE
+    | TOO_LARGE,
+  TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT      /* 11______ */
+};
+
+/* Upper limits for the last bytes of a block that do not start a multi-
+ * byte sequence continuing in the next block.  The last 16 entries apply
+ * to a block of 16 bytes, all 32 apply to a block of 32 bytes. */
+static const unsigned char incomplete_limits[32] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf
+};
+
+/* Return the start of the character that contains the byte before POS in
+ * the valid UTF-8 string starting at START, or POS if there is no such
+ * byte.
+ */
+static const char *
+char_start_before(const char *start, const char *pos)
+{
+  int i;
+  for (i = 1; i <= 3 && pos - i >= start; ++i)
+    if ((pos[-i] & 0xc0) != 0x80)
+      return pos - i;
+
+  return pos;
+}
+
+#endif
+
+#ifdef SVN_UTF_X86_AVX2
+
+/* Return TRUE, if the CPU and the OS support AVX2.
+ */
+static svn_boolean_t
+x86_has_avx2(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+/* Validate the UTF-8 string from DATA to END, which must start at a
+ * character boundary, using AVX2.  Return a character boundary up to
+ * which the string is known to be valid.  The remainder, including the
+ * first invalid character, if any, is at most 67 bytes long.
+ */
+__attribute__((target("avx2")))
+static const char *
+valid_prefix_avx2(const char *data, const char *end)
+{
+  const __m256i byte_1_high = _mm256_broadcastsi128_si256(
+                        _mm_loadu_si128((const __m128i *)byte_1_high_errors));
+  const __m256i byte_1_low = _mm256_broadcastsi128_si256(
+                        _mm_loadu_si128((const __m128i *)byte_1_low_errors));
+  const __m256i byte_2_high = _mm256_broadcastsi128_si256(
+                        _mm_loadu_si128((const __m128i *)byte_2_high_errors));
+  const __m256i limits = _mm256_loadu_si256(
+                        (const __m256i *)incomplete_limits);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+  const __m256i bit_7 = _mm256_set1_epi8((char)0x80);
+  const __m256i third_byte = _mm256_set1_epi8(0xe0 - 0x80);
+  const __m256i fourth_byte = _mm256_set1_epi8((char)(0xf0 - 0x80));
+  __m256i prev_input = _mm256_setzero_si256();
+  __m256i prev_incomplete = _mm256_setzero_si256();
+  const char *prev_block = data;
+  const char *block;
+
+  for (block = data; end - block >= 32; prev_block = block, block += 32)
+    {
+      __m256i input = _mm256_loadu_si256((const __m256i *)block);
+      __m256i error;
+
+      if (_mm256_movemask_epi8(input) == 0)
+        {
+          /* ASCII only.  Just make sure that the previous block did not
+             end in the middle of a multi-byte sequence. */
+          error = prev_incomplete;
+        }
+      else
+        {
+          __m256i shifted = _mm256_permute2x128_si256(prev_input, input,
+                                                      0x21);
+          __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+          __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+          __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+          __m256i special_cases, must_be_continuation;
+
+          special_cases = _mm256_and_si256(
+            _mm256_and_si256(
+              _mm256_shuffle_epi8(byte_1_high,
+                                  _mm256_and_si256(_mm256_srli_epi16(prev1, 4),
+                                                   low_nibble)),
+              _mm256_shuffle_epi8(byte_1_low,
+                                  _mm256_and_si256(prev1, low_nibble))),
+            _mm256_shuffle_epi8(byte_2_high,
+                                _mm256_and_si256(_mm256_srli_epi16(input, 4),
+                                                 low_nibble)));
+
+          /* The third and fourth bytes of longer sequences must be
+             continuation bytes, i.e. match the TWO_CONTS case. */
+          must_be_continuation = _mm256_and_si256(
+            _mm256_or_si256(_mm256_subs_epu8(prev2, third_byte),
+                            _mm256_subs_epu8(prev3, fourth_byte)),
+            bit_7);
+
+          error = _mm256_xor_si256(must_be_continuation, special_cases);
+        }
+
+      /* The error may be caused by a character starting in PREV_BLOCK. */
+      if (!_mm256_testz_si256(error, error))
+        return char_start_before(data, prev_block);
+
+      prev_incomplete = _mm256_subs_epu8(input, limits);
+      prev_input = input;
+    }
+
+  return char_start_before(data, block);
+}
+
+#endif /* SVN_UTF_X86_AVX2 */
+
+#ifdef SVN_UTF_NEON
+
+/* Like valid_prefix_avx2() but use NEON and process 16 bytes at a time.
+ */
+static const char *
+valid_prefix_neon(const char *data, const char *end)
+{
+  const uint8x16_t byte_1_high = vld1q_u8(byte_1_high_errors);
+  const uint8x16_t byte_1_low = vld1q_u8(byte_1_low_errors);
+  const uint8x16_t byte_2_high = vld1q_u8(byte_2_high_errors);
+  const uint8x16_t limits = vld1q_u8(incomplete_limits + 16);
+  const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+  const uint8x16_t bit_7 = vdupq_n_u8(0x80);
+  const uint8x16_t third_byte = vdupq_n_u8(0xe0 - 0x80);
+  const uint8x16_t fourth_byte = vdupq_n_u8(0xf0 - 0x80);
+  uint8x16_t prev_input = vdupq_n_u8(0);
+  uint8x16_t prev_incomplete = vdupq_n_u8(0);
+  const char *prev_block = data;
+  const char *block;
+
+  for (block = data; end - block >= 16; prev_block = block, block += 16)
+    {
+      uint8x16_t input = vld1q_u8((const uint8_t *)block);
+      uint8x16_t error;
+
+      if (vmaxvq_u8(input) < 0x80)
+        {
+          error = prev_incomplete;
+        }
+      else
+        {
+          uint8x16_t prev1 = vextq_u8(prev_input, input, 15);
+          uint8x16_t prev2 = vextq_u8(prev_input, input, 14);
+          uint8x16_t prev3 = vextq_u8(prev_input, input, 13);
+          uint8x16_t special_cases, must_be_continuation;
+
+          special_cases = vandq_u8(
+            vandq_u8(vqtbl1q_u8(byte_1_high, vshrq_n_u8(prev1, 4)),
+                     vqtbl1q_u8(byte_1_low, vandq_u8(prev1, low_nibble))),
+            vqtbl1q_u8(byte_2_high, vshrq_n_u8(input, 4)));
+
+          must_be_continuation = vandq_u8(
+            vorrq_u8(vqsubq_u8(prev2, third_byte),
+                     vqsubq_u8(prev3, fourth_byte)),
+            bit_7);
+
+          error = veorq_u8(must_be_continuation, special_cases);
+        }
+
+      if (vmaxvq_u8(error))
+        return char_start_before(data, prev_block);
+
+      prev_incomplete = vqsubq_u8(input, limits);
+      prev_input = input;
+    }
+
+  return char_start_before(data, block);
+}
+
+#endif /* SVN_UTF_NEON */
+
+/* Signature of the vectorized validators.  Return a character boundary
+ * in the string from DATA to END, which must start at a character
+ * boundary, such that all characters before it are known to be valid.
+ * The remainder, including the first invalid character, if any, must be
+ * short and is to be processed by the FSM.
+ */
+typedef const char *(*valid_prefix_func_t)(const char *data,
+                                           const char *end);
+
+/* Fallback for platforms without vectorized validator. */
+static const char *
+valid_prefix_generic(const char *data, const char *end)
+{
+  return data;
+}
+
+/* The validator to use on this machine, selected by
+ * select_valid_prefix_func().  Concurrent initialization is harmless since
+ * all threads will select the same function.
+ */
+static volatile valid_prefix_func_t valid_prefix = NULL;
+
+/* Name of the implementation in VALID_PREFIX. */
+static const char *valid_prefix_name = NULL;
+
+/* Return the fastest validator that this machine supports.
+ */
+static valid_prefix_func_t
+select_valid_prefix_func(void)
+{
+  valid_prefix_func_t result = valid_prefix;
+  if (result)
+    return result;
+
+  result = valid_prefix_generic;
+  valid_prefix_name = "generic";
+
+#ifdef SVN_UTF_X86_AVX2
+  if (x86_has_avx2())
+    {
+      result = valid_prefix_avx2;
+      valid_prefix_name = "AVX2";
+    }
+#endif
+
+#ifdef SVN_UTF_NEON
+  result = valid_prefix_neon;
+  valid_prefix_name = "NEON";
+#endif
+
+  valid_prefix = result;
+  return result;
+}
+
+/* Skip the leading ASCII chars in the LEN bytes at DATA as well as any
+ * other data that the vectorized validators can verify.  Return the
+ * position at which the FSM shall continue.
+ */
+static const char *
+skip_valid_prefix(const char *data, apr_size_t len)
+{
+  const char *end = data + len;
+
+  data = first_non_fsm_start_char(data, len);
+
+  /* Multi-byte sequences are typically frequent once we have found the
+     first one.  Short strings are not worth the setup overhead. */
+  if (end - data >= 64)
+    data = select_valid_prefix_func()(data, end);
+
+  return data;
+}
+
+const char *
+svn_utf__validator_implementation(void)
+{
+  select_valid_prefix_func();
+  return valid_prefix_name;
+}
+
 const char *
 svn_utf__last_valid(const char *data, apr_size_t len)
 {
-  const char *start = first_non_fsm_start_char(data, len);
+  const char *start = skip_valid_prefix(data, len);
   const char *end = data + len;
   int state = FSM_START;
 
@@ -313,7 +685,7 @@ svn_utf__is_valid(const char *data, apr_size_t len)
   if (!data)
     return FALSE;
 
-  data = first_non_fsm_start_char(data, len);
+  data = skip_valid_prefix(data, len);
 
   while (data < end)
     {
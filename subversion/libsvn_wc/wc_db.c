@@ -905,6 +905,52 @@ blank_iwb(insert_working_baton_t *piwb)
 }
 
 
+/* Baton for bind_incomplete_child(). */
+typedef struct incomplete_children_baton_t
+{
+  /* The parent of the children to insert */
+  const char *local_relpath;
+
+  /* The parent's repository path; NULL if the children have none */
+  const char *repos_path;
+
+  /* The names (const char *) of the children to insert */
+  const apr_array_header_t *children;
+
+  /* Moved-to relpaths to retain, indexed by child name */
+  apr_hash_t *moved_to_relpaths;
+} incomplete_children_baton_t;
+
+/* Implements svn_sqlite__bind_row_func_t for insert_incomplete_children().
+   Bind the values specific to child number ROW of the
+   (incomplete_children_baton_t *) BATON to STMT. */
+static svn_error_t *
+bind_incomplete_child(svn_sqlite__stmt_t *stmt,
+                      int row,
+                      void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  incomplete_children_baton_t *b = baton;
+
+  /* Insert in reverse order, just like we always did. */
+  const char *name = APR_ARRAY_IDX(b->children, b->children->nelts - 1 - row,
+                                   const char *);
+
+  SVN_ERR(svn_sqlite__bind_text(stmt, 2,
+                                svn_relpath_join(b->local_relpath, name,
+                                                 scratch_pool)));
+  if (b->repos_path)
+    SVN_ERR(svn_sqlite__bind_text(stmt, 6,
+                                  svn_relpath_join(b->repos_path, name,
+                                                   scratch_pool)));
+
+  /* 21, moved_to */
+  SVN_ERR(svn_sqlite__bind_text(stmt, 21,
+                                svn_hash_gets(b->moved_to_relpaths, name)));
+
+  return SVN_NO_ERROR;
+}
+
 /* Insert a row in NODES for each (const char *) child name in CHILDREN,
    whose parent directory is LOCAL_RELPATH, at op_depth=OP_DEPTH.  Set each
    child's presence to 'incomplete', kind to 'unknown', repos_id to REPOS_ID,
@@ -927,6 +973,7 @@ insert_incomplete_children(svn_sqlite__db_t *sdb,
   int i;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_t *moved_to_relpaths = apr_hash_make(scratch_pool);
+  incomplete_children_baton_t baton;
 
   SVN_ERR_ASSERT(repos_path != NULL || op_depth > 0);
   SVN_ERR_ASSERT((repos_id != INVALID_REPOS_ID)
@@ -958,39 +1005,28 @@ insert_incomplete_children(svn_sqlite__db_t *sdb,
         }
     }
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_NODE));
-
-  for (i = children->nelts; i--; )
-    {
-      const char *name = APR_ARRAY_IDX(children, i, const char *);
-
-      svn_pool_clear(iterpool);
-
-      SVN_ERR(svn_sqlite__bindf(stmt, "isdsnnrsnsnnnnnnnnnnsn",
-                                wc_id,
-                                svn_relpath_join(local_relpath, name,
-                                                 iterpool),
-                                op_depth,
-                                local_relpath,
-                                revision,
-                                "incomplete", /* 8, presence */
-                                "unknown",    /* 10, kind */
-                                /* 21, moved_to */
-                                svn_hash_gets(moved_to_relpaths, name)));
-      if (repos_id != INVALID_REPOS_ID)
-        {
-          SVN_ERR(svn_sqlite__bind_int64(stmt, 5, repos_id));
-          SVN_ERR(svn_sqlite__bind_text(stmt, 6,
-                                        svn_relpath_join(repos_path, name,
-                                                         iterpool)));
-        }
+  svn_pool_destroy(iterpool);
 
-      SVN_ERR(svn_sqlite__insert(NULL, stmt));
-    }
+  /* Bind the values that are the same for all children only once. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_NODE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "indsnnrsns",
+                            wc_id,
+                            op_depth,
+                            local_relpath,
+                            revision,
+                            "incomplete", /* 8, presence */
+                            "unknown"));  /* 10, kind */
+  if (repos_id != INVALID_REPOS_ID)
+    SVN_ERR(svn_sqlite__bind_int64(stmt, 5, repos_id));
 
-  svn_pool_destroy(iterpool);
+  baton.local_relpath = local_relpath;
+  baton.repos_path = repos_id != INVALID_REPOS_ID ? repos_path : NULL;
+  baton.children = children;
+  baton.moved_to_relpaths = moved_to_relpaths;
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_sqlite__insert_rows(stmt, children->nelts,
+                                                 bind_incomplete_child,
+                                                 &baton, scratch_pool));
 }
 
 
@@ -1432,12 +1468,13 @@ create_db(svn_sqlite__db_t **sdb,
           svn_depth_t root_node_depth,
           svn_boolean_t exclusive,
           apr_int32_t timeout,
+          const svn_sqlite__open_options_t *sqlite_options,
           apr_pool_t *result_pool,
           apr_pool_t *scratch_pool)
 {
   SVN_ERR(svn_wc__db_util_open_db(sdb, dir_abspath, sdb_fname,
                                   svn_sqlite__mode_rwcreate, exclusive,
-                                  timeout,
+                                  timeout, sqlite_options,
                                   NULL /* my_statements */,
                                   result_pool, scratch_pool));
 
@@ -1487,7 +1524,7 @@ svn_wc__db_init(svn_wc__db_t *db,
   SVN_ERR(create_db(&sdb, &repos_id, &wc_id, local_abspath, repos_root_url,
                     repos_uuid, SDB_FILE,
                     repos_relpath, initial_rev, depth, sqlite_exclusive,
-                    sqlite_timeout,
+                    sqlite_timeout, &db->sqlite_options,
                     db->state_pool, scratch_pool));
 
   /* Create the WCROOT for this directory.  */
@@ -13334,6 +13371,7 @@ svn_wc__db_upgrade_begin(svn_sqlite__db_t **sdb,
                     NULL, SVN_INVALID_REVNUM, svn_depth_unknown,
                     TRUE /* exclusive */,
                     0 /* timeout */,
+                    &wc_db->sqlite_options,
                     wc_db->state_pool, scratch_pool));
 
   SVN_ERR(svn_wc__db_pdh_create_wcroot(&wcroot,
@@ -16016,6 +16054,7 @@ svn_wc__db_bump_format(int *result_format,
                                 svn_sqlite__mode_readwrite,
                                 TRUE, /* exclusive */
                                 0, /* default timeout */
+                                &db->sqlite_options,
                                 NULL, /* my statements */
                                 scratch_pool, scratch_pool);
   if (err)
@@ -202,13 +202,17 @@ pristine_read_txn(svn_stream_t **contents,
    * We also don't enable APR_BUFFERED on this file to maximize throughput
    * e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE buffers
    * where needed in streams, there is no point in having another layer of
-   * buffers. */
+   * buffers.
+   *
+   * Pristines never change, so larger ones may be memory mapped, allowing
+   * consumers to access their contents without copying them. */
   if (contents)
     {
       apr_file_t *file;
       SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
                                APR_OS_DEFAULT, result_pool));
-      *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+      SVN_ERR(svn_stream__from_mapped_aprfile(contents, file, result_pool,
+                                              scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -241,6 +241,9 @@ svn_wc__db_open(svn_wc__db_t **db,
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
       apr_int64_t timeout;
+      apr_int64_t mmap_size;
+      const char *journal_mode;
+      const char *synchronous;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -261,6 +264,33 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      /* Invalid journaling settings fall back to the defaults, just like
+         the other options above. */
+      svn_config_get(config, &journal_mode,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SQLITE_JOURNAL_MODE, "truncate");
+      (*db)->sqlite_options.wal = svn_cstring_casecmp(journal_mode,
+                                                      "wal") == 0;
+
+      svn_config_get(config, &synchronous,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SQLITE_SYNCHRONOUS, "off");
+      if (svn_cstring_casecmp(synchronous, "normal") == 0)
+        (*db)->sqlite_options.synchronous = svn_sqlite__sync_normal;
+      else if (svn_cstring_casecmp(synchronous, "full") == 0)
+        (*db)->sqlite_options.synchronous = svn_sqlite__sync_full;
+      else
+        (*db)->sqlite_options.synchronous = svn_sqlite__sync_off;
+
+      err = svn_config_get_int64(config, &mmap_size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE,
+                                 0);
+      if (err || mmap_size < 0 || mmap_size > APR_INT64_MAX / 0x100000)
+        svn_error_clear(err);
+      else
+        (*db)->sqlite_options.mmap_size = mmap_size * 0x100000;
     }
 
   return SVN_NO_ERROR;
@@ -641,7 +671,8 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
              as the filesystem allows. */
           err = svn_wc__db_util_open_db(&sdb, local_abspath, SDB_FILE,
                                         svn_sqlite__mode_readwrite,
-                                        db->exclusive, db->timeout, NULL,
+                                        db->exclusive, db->timeout,
+                                        &db->sqlite_options, NULL,
                                         db->state_pool, scratch_pool);
           if (err == NULL)
             {
@@ -42,7 +42,9 @@
 #include "svn_dso.h"
 #include "mod_dav_svn.h"
 
+#include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
@@ -120,6 +122,112 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* The repositories configured through SVNPath and SVNParentPath.  They
+   are used to detect stale cache snapshots. */
+static apr_array_header_t *all_fs_paths = NULL;
+static apr_array_header_t *all_fs_parent_paths = NULL;
+
+/* File that the in-memory cache contents get saved to upon shutdown and
+   restored from at startup.  NULL if not configured. */
+static const char *cache_snapshot_file = NULL;
+
+/* Set in httpd's child processes.  Only the parent saves cache snapshots. */
+static svn_boolean_t in_child_process = FALSE;
+
+/* Add the contents of CACHE_SNAPSHOT_FILE to the global cache, if the
+   snapshot is still valid.  Use POOL for temporary allocations. */
+static svn_error_t *
+load_cache_snapshot(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  apr_file_t *file;
+  const char *tag;
+  svn_boolean_t loaded;
+  svn_error_t *err;
+
+  if (membuffer == NULL)
+    return SVN_NO_ERROR;
+
+  err = svn_io_file_open(&file, cache_snapshot_file, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_repos__cache_snapshot_tag(&tag, all_fs_paths,
+                                        all_fs_parent_paths, pool, pool));
+  SVN_ERR(svn_cache__membuffer_load(&loaded, membuffer,
+                                    svn_stream_from_aprfile2(file, FALSE,
+                                                             pool),
+                                    tag, pool));
+  if (!loaded)
+    ap_log_perror(APLOG_MARK, APLOG_INFO, 0, pool,
+                  "mod_dav_svn: ignoring outdated cache snapshot '%s'",
+                  cache_snapshot_file);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the global cache contents to CACHE_SNAPSHOT_FILE.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+save_cache_snapshot(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *tmp_path;
+  apr_file_t *file;
+  svn_stream_t *stream;
+  const char *tag;
+
+  if (membuffer == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_repos__cache_snapshot_tag(&tag, all_fs_paths,
+                                        all_fs_parent_paths, pool, pool));
+
+  /* Replace the old snapshot atomically. */
+  tmp_path = apr_pstrcat(pool, cache_snapshot_file, ".tmp", SVN_VA_NULL);
+  SVN_ERR(svn_io_file_open(&file, tmp_path,
+                           APR_WRITE | APR_CREATE | APR_TRUNCATE
+                             | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+  stream = svn_stream_from_aprfile2(file, FALSE, pool);
+  SVN_ERR(svn_cache__membuffer_save(membuffer, stream, tag, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  return svn_error_trace(svn_io_file_rename2(tmp_path, cache_snapshot_file,
+                                             FALSE, pool));
+}
+
+/* Pool cleanup function saving the cache contents upon shutdown or
+   restart of httpd. */
+static apr_status_t
+save_cache_snapshot_cleanup(void *data)
+{
+  apr_pool_t *pool;
+  svn_error_t *serr;
+
+  if (in_child_process)
+    return APR_SUCCESS;
+
+  pool = svn_pool_create(NULL);
+  serr = save_cache_snapshot(pool);
+  if (serr)
+    {
+      ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, pool,
+                    "mod_dav_svn: error saving cache snapshot '%s': '%s'",
+                    cache_snapshot_file,
+                    serr->message ? serr->message : "(no more info)");
+      svn_error_clear(serr);
+    }
+
+  svn_pool_destroy(pool);
+  return APR_SUCCESS;
+}
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
@@ -150,9 +258,44 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  /* A shared cache must be created before httpd forks its children. */
+  if (svn_cache__config_get_process_shared())
+    svn_cache__get_global_membuffer_cache();
+
+  /* Warm up the cache.  Children will inherit its contents. */
+  if (cache_snapshot_file)
+    {
+      serr = load_cache_snapshot(ptemp);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, p,
+                        "mod_dav_svn: error loading cache snapshot '%s': "
+                        "'%s'", cache_snapshot_file,
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+        }
+
+      /* Only a shared cache contains the data from all children. */
+      if (svn_cache__config_get_process_shared())
+        apr_pool_cleanup_register(p, NULL, save_cache_snapshot_cleanup,
+                                  apr_pool_cleanup_null);
+      else
+        ap_log_perror(APLOG_MARK, APLOG_NOTICE, 0, p,
+                      "mod_dav_svn: cache snapshot '%s' will not be "
+                      "updated because SVNSharedMemoryCache is Off",
+                      cache_snapshot_file);
+    }
+
   return OK;
 }
 
+/* Implements the #child_init hook of Apache. */
+static void
+child_init(apr_pool_t *p, server_rec *s)
+{
+  in_child_process = TRUE;
+}
+
 static svn_error_t *
 malfunction_handler(svn_boolean_t can_return,
                     const char *file, int line,
@@ -193,6 +336,11 @@ init_dso(apr_pool_t *pconf, apr_pool_t *plog, apr_pool_t *ptemp)
 
   svn_error_set_malfunction_handler(malfunction_handler);
 
+  /* Forget the previous configuration. */
+  all_fs_paths = apr_array_make(pconf, 1, sizeof(const char *));
+  all_fs_parent_paths = apr_array_make(pconf, 1, sizeof(const char *));
+  cache_snapshot_file = NULL;
+
   return OK;
 }
 
@@ -496,6 +644,7 @@ SVNPath_cmd(cmd_parms *cmd, void *config, const char *arg1)
     return "SVNPath cannot be defined at same time as SVNParentPath.";
 
   conf->fs_path = svn_dirent_internal_style(arg1, cmd->pool);
+  APR_ARRAY_PUSH(all_fs_paths, const char *) = conf->fs_path;
 
   return NULL;
 }
@@ -510,6 +659,7 @@ SVNParentPath_cmd(cmd_parms *cmd, void *config, const char *arg1)
     return "SVNParentPath cannot be defined at same time as SVNPath.";
 
   conf->fs_parent_path = svn_dirent_internal_style(arg1, cmd->pool);
+  APR_ARRAY_PUSH(all_fs_parent_paths, const char *) = conf->fs_parent_path;
 
   return NULL;
 }
@@ -631,6 +781,48 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNSharedMemoryCache_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__config_set_process_shared(arg);
+
+  return NULL;
+}
+
+static const char *
+SVNCacheTinyLFU_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__config_set_admission_policy(arg
+                                           ? svn_cache__admission_tinylfu
+                                           : svn_cache__admission_default);
+
+  return NULL;
+}
+
+static const char *
+SVNCacheMetrics_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__config_set_metrics(arg);
+
+  return NULL;
+}
+
+static const char *
+SVNCacheLatencyTracking_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__config_set_latency_tracking(arg);
+
+  return NULL;
+}
+
+static const char *
+SVNCacheSnapshotFile_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  cache_snapshot_file = svn_dirent_internal_style(arg1, cmd->pool);
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -1395,6 +1587,44 @@ static const command_rec cmds[] =
                 "specifies the maximum size in kB per process of Subversion's "
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
+
+  /* per server */
+  AP_INIT_FLAG("SVNSharedMemoryCache", SVNSharedMemoryCache_cmd, NULL,
+               RSRC_CONF,
+               "enables sharing the in-memory object cache between all "
+               "worker processes such that SVNInMemoryCacheSize is the "
+               "total size for all of them (default is Off)."),
+
+  /* per server */
+  AP_INIT_FLAG("SVNCacheTinyLFU", SVNCacheTinyLFU_cmd, NULL,
+               RSRC_CONF,
+               "enables admitting data to the in-memory object cache only "
+               "if it has been requested more often than the data it "
+               "would replace.  This keeps one-time scans from evicting "
+               "frequently used data (default is Off)."),
+
+  /* per server */
+  AP_INIT_FLAG("SVNCacheMetrics", SVNCacheMetrics_cmd, NULL,
+               RSRC_CONF,
+               "enables per-cache access statistics for the svn-status "
+               "handler.  They are collected per worker process "
+               "(default is Off)."),
+
+  /* per server */
+  AP_INIT_FLAG("SVNCacheLatencyTracking", SVNCacheLatencyTracking_cmd, NULL,
+               RSRC_CONF,
+               "enables measuring the duration of cache lookups for the "
+               "svn-status handler.  Requires SVNCacheMetrics "
+               "(default is Off)."),
+
+  /* per server */
+  AP_INIT_TAKE1("SVNCacheSnapshotFile", SVNCacheSnapshotFile_cmd, NULL,
+                RSRC_CONF,
+                "specifies a file that the in-memory object cache gets "
+                "restored from at startup.  The cache contents only get "
+                "saved there upon shutdown if SVNSharedMemoryCache is On "
+                "because no single process holds all cached data otherwise "
+                "(default is none)."),
   /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
@@ -1436,6 +1666,7 @@ register_hooks(apr_pool_t *pconf)
 {
   ap_hook_pre_config(init_dso, NULL, NULL, APR_HOOK_REALLY_FIRST);
   ap_hook_post_config(init, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_child_init(child_init, NULL, NULL, APR_HOOK_MIDDLE);
 
   /* our provider */
   dav_register_provider(pconf, "svn", &provider);
@@ -66,6 +66,11 @@
      </Location>
 
   and then point a browser at http://server/svn-status.
+
+  Requesting http://server/svn-status?format=prometheus returns the
+  statistics of all caches in the Prometheus text format instead.  Like
+  the default output, they only cover the worker process serving the
+  request.  Per-cache records require "SVNCacheMetrics On".
 */
 int dav_svn__status(request_rec *r)
 {
@@ -77,6 +82,22 @@ int dav_svn__status(request_rec *r)
   if (r->method_number != M_GET || strcmp(r->handler, "svn-status"))
     return DECLINED;
 
+  if (r->args && strcmp(r->args, "format=prometheus") == 0)
+    {
+      svn_error_t *err = svn_cache__format_metrics(&text_stats, r->pool,
+                                                   r->pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          return HTTP_INTERNAL_SERVER_ERROR;
+        }
+
+      ap_set_content_type(r, "text/plain; version=0.0.4");
+      ap_rwrite(text_stats->data, (int)text_stats->len, r);
+
+      return 0;
+    }
+
   info = svn_cache__membuffer_get_global_info(r->pool);
   text_stats = svn_cache__format_info(info, FALSE, r->pool);
   lines = svn_cstring_split(text_stats->data, "\n", FALSE, r->pool);
@@ -137,6 +137,10 @@ typedef struct serve_params_t {
   /* Size of the in-memory cache (used by FSFS only). */
   apr_uint64_t memory_cache_size;
 
+  /* If not NULL, write the cache statistics to this file after serving
+     a connection. */
+  const char *cache_metrics_file;
+
   /* Data compression level to reduce for network traffic. If this
      is 0, no compression should be applied and the protocol may
      fall back to svndiff "version 0" bypassing zlib entirely.
@@ -55,6 +55,7 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 
@@ -222,6 +223,10 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_CACHE_METRICS   277
+#define SVNSERVE_OPT_SHARED_CACHE    278
+#define SVNSERVE_OPT_CACHE_LATENCY   279
+#define SVNSERVE_OPT_CACHE_TINYLFU   280
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -325,6 +330,46 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"shared-memory-cache", SVNSERVE_OPT_SHARED_CACHE, 0,
+     N_("share one in-memory cache between all connection\n"
+        "                             "
+        "processes, such that --memory-cache-size is the\n"
+        "                             "
+        "total size for all of them.\n"
+        "                             "
+        "[used in daemon mode with one process per\n"
+        "                             "
+        " connection only]")},
+    {"cache-tinylfu", SVNSERVE_OPT_CACHE_TINYLFU, 0,
+     N_("admit data to the in-memory cache only if it has\n"
+        "                             "
+        "been requested more often than the data it would\n"
+        "                             "
+        "replace.  This keeps one-time scans, e.g. by\n"
+        "                             "
+        "'svnadmin verify' or large exports, from evicting\n"
+        "                             "
+        "frequently used data.\n"
+        "                             "
+        "[used for FSFS and FSX repositories only]")},
+    {"cache-metrics-file", SVNSERVE_OPT_CACHE_METRICS, 1,
+     N_("write cache statistics in Prometheus text format\n"
+        "                             "
+        "to file ARG whenever a connection has been served.\n"
+        "                             "
+        "Statistics are per server process, i.e. in the\n"
+        "                             "
+        "default fork mode, the file only covers the most\n"
+        "                             "
+        "recently closed connection.  Use --threads for\n"
+        "                             "
+        "totals across all connections.")},
+    {"cache-latency-tracking", SVNSERVE_OPT_CACHE_LATENCY, 0,
+     N_("also measure the duration of cache lookups for\n"
+        "                             "
+        "--cache-metrics-file.  This adds two clock reads\n"
+        "                             "
+        "to every lookup.")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -586,6 +631,26 @@ close_connection(connection_t *connection)
     svn_pool_destroy(connection->pool);
 }
 
+/* If requested by PARAMS, write the cache statistics to the respective
+ * file.  Failures are logged but otherwise ignored.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static void
+write_cache_metrics(serve_params_t *params,
+                    apr_pool_t *scratch_pool)
+{
+  if (params->cache_metrics_file)
+    {
+      svn_error_t *err = svn_cache__write_metrics(params->cache_metrics_file,
+                                                  scratch_pool);
+      if (err)
+        {
+          logger__log_error(params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+        }
+    }
+}
+
 /* Wrapper around serve() that takes a socket instead of a connection.
  * This is to off-load work from the main thread in threaded and fork modes.
  *
@@ -602,6 +667,8 @@ serve_socket(connection_t *connection,
                       get_client_info(connection->conn, connection->params,
                                       pool));
 
+  write_cache_metrics(connection->params, pool);
+
   return svn_error_trace(err);
 }
 
@@ -649,7 +716,10 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 
   /* Close or re-schedule connection. */
   if (done)
-    close_connection(connection);
+    {
+      write_cache_metrics(connection->params, connection->pool);
+      close_connection(connection);
+    }
   else
     apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
 
@@ -725,6 +795,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  svn_boolean_t shared_cache = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -770,6 +841,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.vhost = FALSE;
   params.username_case = CASE_ASIS;
   params.memory_cache_size = (apr_uint64_t)-1;
+  params.cache_metrics_file = NULL;
   params.zero_copy_limit = 0;
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
@@ -925,6 +997,28 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           cache_nodeprops = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_SHARED_CACHE:
+          shared_cache = TRUE;
+          break;
+
+        case SVNSERVE_OPT_CACHE_TINYLFU:
+          svn_cache__config_set_admission_policy(svn_cache__admission_tinylfu);
+          break;
+
+        case SVNSERVE_OPT_CACHE_METRICS:
+          SVN_ERR(svn_utf_cstring_to_utf8(&params.cache_metrics_file, arg,
+                                          pool));
+          params.cache_metrics_file
+            = svn_dirent_internal_style(params.cache_metrics_file, pool);
+          SVN_ERR(svn_dirent_get_absolute(&params.cache_metrics_file,
+                                          params.cache_metrics_file, pool));
+          svn_cache__config_set_metrics(TRUE);
+          break;
+
+        case SVNSERVE_OPT_CACHE_LATENCY:
+          svn_cache__config_set_latency_tracking(TRUE);
+          break;
+
         case SVNSERVE_OPT_BLOCK_READ:
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
@@ -1295,6 +1389,17 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+
+    /* If requested, let all forked connection handlers share a single
+     * cache instead of starting each with its own empty one.  The cache
+     * must be created before the first fork. */
+    if (   shared_cache
+        && run_mode == run_mode_daemon
+        && handling_mode == connection_mode_fork)
+      {
+        svn_cache__config_set_process_shared(TRUE);
+        svn_cache__get_global_membuffer_cache();
+      }
   }
 
 #if APR_HAS_THREADS
@@ -36,6 +36,10 @@
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "svn_sorts.h"
+
+#include "private/svn_delta_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
@@ -605,6 +609,586 @@ random_txdelta_to_svndiff_stream_test(apr_pool_t *pool)
   return err;
 }
 
+/* Return LEN pseudo-random bytes generated from *SEED in POOL. */
+static svn_stringbuf_t *
+random_data(apr_size_t len, apr_uint32_t *seed, apr_pool_t *pool)
+{
+  svn_stringbuf_t *data = svn_stringbuf_create_ensure(len, pool);
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    data->data[i] = (char)(svn_test_rand(seed) >> 24);
+
+  data->data[len] = '\0';
+  data->len = len;
+
+  return data;
+}
+
+/* Return a copy of SOURCE with a few insertions and with a large block
+   moved far from its original position, allocated in POOL. */
+static svn_stringbuf_t *
+shuffle_data(const svn_stringbuf_t *source,
+             apr_uint32_t *seed,
+             apr_pool_t *pool)
+{
+  apr_size_t block = source->len / 5;
+  svn_stringbuf_t *target = svn_stringbuf_create_ensure(source->len + 1000,
+                                                         pool);
+  svn_stringbuf_t *insert = random_data(200, seed, pool);
+
+  /* Move the second fifth to the end and insert some data before the
+     third, fourth and last fifth. */
+  svn_stringbuf_appendbytes(target, source->data, block);
+  svn_stringbuf_appendstr(target, insert);
+  svn_stringbuf_appendbytes(target, source->data + 2 * block, block);
+  svn_stringbuf_appendstr(target, insert);
+  svn_stringbuf_appendbytes(target, source->data + 3 * block, block);
+  svn_stringbuf_appendstr(target, insert);
+  svn_stringbuf_appendbytes(target, source->data + 4 * block,
+                            source->len - 4 * block);
+  svn_stringbuf_appendbytes(target, source->data + block, block);
+
+  return target;
+}
+
+/* Set *DELTA to the uncompressed svndiff representation of the delta from
+   SOURCE to TARGET using ENGINE.  Allocate the result in POOL. */
+static svn_error_t *
+encode_delta(svn_stringbuf_t **delta,
+             const svn_stringbuf_t *source,
+             const svn_stringbuf_t *target,
+             svn_txdelta__engine_t engine,
+             apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *txstream;
+  svn_string_t source_str, target_str;
+
+  source_str.data = source->data;
+  source_str.len = source->len;
+  target_str.data = target->data;
+  target_str.len = target->len;
+
+  svn_txdelta__create(&txstream,
+                      svn_stream_from_string(&source_str, pool),
+                      svn_stream_from_string(&target_str, pool),
+                      FALSE, engine, pool);
+  SVN_ERR(svn_stringbuf_from_stream(delta,
+                                    svn_txdelta_to_svndiff_stream(txstream,
+                                                                  0, 0,
+                                                                  pool),
+                                    0, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DELTA to the svndiff representation of the delta from SOURCE to
+   TARGET using ENGINE.  Verify that applying it to SOURCE reconstructs
+   TARGET.  Allocate the result in POOL. */
+static svn_error_t *
+delta_with_engine(svn_stringbuf_t **delta,
+                  const svn_stringbuf_t *source,
+                  const svn_stringbuf_t *target,
+                  svn_txdelta__engine_t engine,
+                  apr_pool_t *pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *push_stream;
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  svn_string_t source_str;
+
+  source_str.data = source->data;
+  source_str.len = source->len;
+
+  SVN_ERR(encode_delta(delta, source, target, engine, pool));
+
+  svn_txdelta_apply(svn_stream_from_string(&source_str, pool),
+                    svn_stream_from_stringbuf(result, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+  push_stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE, pool);
+  SVN_ERR(svn_stream_write(push_stream, (*delta)->data, &(*delta)->len));
+  SVN_ERR(svn_stream_close(push_stream));
+
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+indexed_delta_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 1;
+  apr_size_t sizes[] = { 0, 1000, 300 * 1024, 1024 * 1024 };
+  apr_size_t i;
+
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+      svn_stringbuf_t *source = random_data(sizes[i], &seed, pool);
+      svn_stringbuf_t *target = shuffle_data(source, &seed, pool);
+      svn_stringbuf_t *xdelta, *indexed;
+
+      SVN_ERR(delta_with_engine(&xdelta, source, target,
+                                svn_txdelta__engine_xdelta, pool));
+      SVN_ERR(delta_with_engine(&indexed, source, target,
+                                svn_txdelta__engine_indexed, pool));
+
+      /* Random data is incompressible.  So, only the indexed engine
+         finds the shifted blocks beyond the first window. */
+      if (sizes[i] > 2 * SVN_DELTA_WINDOW_SIZE)
+        SVN_TEST_ASSERT(indexed->len < xdelta->len);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return LEN pseudo-random bytes generated from *SEED in POOL, with the
+   same block of RECORD_LEN bytes repeated every 4 * RECORD_LEN bytes. */
+static svn_stringbuf_t *
+repeated_data(apr_size_t len,
+              apr_size_t record_len,
+              apr_uint32_t *seed,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *data = random_data(len, seed, pool);
+  svn_stringbuf_t *record = random_data(record_len, seed, pool);
+  apr_size_t i;
+
+  for (i = 0; i + 4 * record_len <= len; i += 4 * record_len)
+    memcpy(data->data + i, record->data, record_len);
+
+  return data;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+indexed_delta_repeated_blocks_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 4;
+  apr_size_t record_sizes[] = { 64, 512, 4096 };
+  apr_size_t i, k;
+
+  for (i = 0; i < sizeof(record_sizes) / sizeof(record_sizes[0]); ++i)
+    {
+      svn_stringbuf_t *source = repeated_data(1024 * 1024, record_sizes[i],
+                                              &seed, pool);
+      svn_stringbuf_t *target = svn_stringbuf_dup(source, pool);
+      svn_stringbuf_t *xdelta, *indexed;
+
+      /* Modify the data in place such that xdelta finds everything
+         else at the same offset in the source. */
+      for (k = 5000; k < target->len; k += 30000)
+        target->data[k] ^= 1;
+
+      SVN_ERR(delta_with_engine(&xdelta, source, target,
+                                svn_txdelta__engine_xdelta, pool));
+      SVN_ERR(delta_with_engine(&indexed, source, target,
+                                svn_txdelta__engine_indexed, pool));
+
+      /* Repeated blocks must not lure the indexed engine away from the
+         source data at the same offset. */
+      SVN_TEST_ASSERT(indexed->len <= xdelta->len);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return LEN bytes of pseudo-random text generated from *SEED in POOL.
+   The text consists of lines of lower-case words. */
+static svn_stringbuf_t *
+random_text(apr_size_t len, apr_uint32_t *seed, apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(len, pool);
+
+  while (text->len < len)
+    {
+      apr_uint32_t word_len = svn_test_rand(seed) % 12 + 1;
+
+      while (word_len-- && text->len < len)
+        svn_stringbuf_appendbyte(text,
+                                 (char)('a' + (svn_test_rand(seed) >> 24)
+                                              % 26));
+
+      if (text->len < len)
+        svn_stringbuf_appendbyte(text, (svn_test_rand(seed) >> 24) % 10
+                                       ? ' ' : '\n');
+    }
+
+  return text;
+}
+
+/* Return a copy of TEXT with a random byte changed every AVG_DISTANCE
+   bytes on average.  If SHIFT is set, also insert and remove short
+   spans of text at the same rate.  Use *SEED as random number source and
+   allocate the result in POOL. */
+static svn_stringbuf_t *
+edit_text(const svn_stringbuf_t *text,
+          apr_size_t avg_distance,
+          svn_boolean_t shift,
+          apr_uint32_t *seed,
+          apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(text->len, pool);
+  apr_size_t pos = 0;
+
+  while (pos < text->len)
+    {
+      apr_size_t span = (svn_test_rand(seed) >> 8) % (2 * avg_distance);
+      if (span > text->len - pos)
+        span = text->len - pos;
+
+      svn_stringbuf_appendbytes(result, text->data + pos, span);
+      pos += span;
+      if (pos == text->len)
+        break;
+
+      if (!shift)
+        {
+          svn_stringbuf_appendbyte(result, '#');
+          pos++;
+        }
+      else if (svn_test_rand(seed) & 0x10000)
+        {
+          svn_stringbuf_appendstr(result, random_text(20, seed, pool));
+        }
+      else
+        {
+          pos += MIN(20, text->len - pos);
+        }
+    }
+
+  return result;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+txdelta_run_throughput(apr_pool_t *pool)
+{
+  enum { TEXT_SIZE = 0x800000 };
+  apr_uint32_t seed = 3;
+  svn_stringbuf_t *source = random_text(TEXT_SIZE, &seed, pool);
+  struct pair_t
+    {
+      const char *name;
+      svn_stringbuf_t *target;
+    }
+  pairs[] =
+    {
+      { "identical",           NULL },
+      { "text, sparse edits",  NULL },
+      { "text, dense edits",   NULL },
+      { "text, shifted",       NULL },
+      { "text, unrelated",     NULL },
+      { "binary, unrelated",   NULL }
+    };
+  apr_size_t i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  pairs[0].target = source;
+  pairs[1].target = edit_text(source, 64 * 1024, FALSE, &seed, pool);
+  pairs[2].target = edit_text(source, 500, FALSE, &seed, pool);
+  pairs[3].target = edit_text(source, 1000, TRUE, &seed, pool);
+  pairs[4].target = random_text(TEXT_SIZE, &seed, pool);
+  pairs[5].target = random_data(TEXT_SIZE, &seed, pool);
+
+  for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i)
+    {
+      svn_string_t source_str, target_str;
+      apr_time_t start, duration;
+
+      svn_pool_clear(iterpool);
+
+      source_str.data = source->data;
+      source_str.len = source->len;
+      target_str.data = pairs[i].target->data;
+      target_str.len = pairs[i].target->len;
+
+      start = apr_time_now();
+      SVN_ERR(svn_txdelta_run(svn_stream_from_string(&source_str, iterpool),
+                              svn_stream_from_string(&target_str, iterpool),
+                              svn_delta_noop_window_handler, NULL,
+                              svn_checksum_md5, NULL, NULL, NULL,
+                              iterpool, iterpool));
+      duration = apr_time_now() - start;
+
+      printf("%-20s %8.1f MB/s\n", pairs[i].name,
+             duration ? (double)target_str.len / duration : 0.0);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+indexed_delta_benchmark(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 0x400000 };
+  apr_uint32_t seed = 5;
+  svn_stringbuf_t *text = random_text(DATA_SIZE, &seed, pool);
+  svn_stringbuf_t *binary = random_data(DATA_SIZE, &seed, pool);
+  struct pair_t
+    {
+      const char *name;
+      svn_stringbuf_t *source;
+      svn_stringbuf_t *target;
+    }
+  pairs[] =
+    {
+      { "text, sparse edits",  NULL, NULL },
+      { "text, shifted",       NULL, NULL },
+      { "binary, moved",       NULL, NULL },
+      { "binary, repeated",    NULL, NULL }
+    };
+  apr_size_t i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  pairs[0].source = text;
+  pairs[0].target = edit_text(text, 64 * 1024, FALSE, &seed, pool);
+  pairs[1].source = text;
+  pairs[1].target = edit_text(text, 1000, TRUE, &seed, pool);
+  pairs[2].source = binary;
+  pairs[2].target = shuffle_data(binary, &seed, pool);
+  pairs[3].source = repeated_data(DATA_SIZE, 512, &seed, pool);
+  pairs[3].target = edit_text(pairs[3].source, 30000, FALSE, &seed, pool);
+
+  printf("%-20s %-8s %8s %10s\n", "data", "engine", "ratio", "MB/s");
+
+  for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i)
+    {
+      svn_txdelta__engine_t engines[] = { svn_txdelta__engine_xdelta,
+                                          svn_txdelta__engine_indexed };
+      const char *engine_names[] = { "xdelta", "indexed" };
+      apr_size_t k;
+
+      for (k = 0; k < sizeof(engines) / sizeof(engines[0]); ++k)
+        {
+          svn_stringbuf_t *delta;
+          apr_time_t start, duration;
+
+          svn_pool_clear(iterpool);
+
+          start = apr_time_now();
+          SVN_ERR(encode_delta(&delta, pairs[i].source, pairs[i].target,
+                               engines[k], iterpool));
+          duration = apr_time_now() - start;
+
+          printf("%-20s %-8s %7.2f%% %10.1f\n", pairs[i].name,
+                 engine_names[k],
+                 100.0 * delta->len / pairs[i].target->len,
+                 duration ? (double)pairs[i].target->len / duration : 0.0);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SVNDIFF to the svndiff VERSION representation of the delta from
+   SOURCE to TARGET, compressing up to THREADS windows concurrently.
+   Allocate the result in POOL. */
+static svn_error_t *
+encode_svndiff(svn_stringbuf_t **svndiff,
+               const svn_stringbuf_t *source,
+               const svn_stringbuf_t *target,
+               int version,
+               int threads,
+               apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *txstream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_string_t source_str, target_str;
+
+  source_str.data = source->data;
+  source_str.len = source->len;
+  target_str.data = target->data;
+  target_str.len = target->len;
+
+  *svndiff = svn_stringbuf_create_empty(pool);
+  svn_txdelta2(&txstream,
+               svn_stream_from_string(&source_str, pool),
+               svn_stream_from_string(&target_str, pool),
+               FALSE, pool);
+  svn_txdelta__to_svndiff_parallel(&handler, &handler_baton,
+                                   svn_stream_from_stringbuf(*svndiff, pool),
+                                   version,
+                                   SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                   NULL, threads, pool);
+
+  return svn_error_trace(svn_txdelta_send_txstream(txstream, handler,
+                                                   handler_baton, pool));
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+parallel_svndiff_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 5;
+  svn_stringbuf_t *source = random_text(2 * 1024 * 1024, &seed, pool);
+  svn_stringbuf_t *target = edit_text(source, 200, TRUE, &seed, pool);
+  int version;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  for (version = 0; version <= 3; ++version)
+    {
+      svn_stringbuf_t *serial, *parallel;
+      svn_stringbuf_t *result;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stream_t *push_stream;
+      svn_string_t source_str;
+      apr_size_t pos;
+
+      if (version == 3 && !svn__zstd_available())
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      /* Concurrent compression must not change the svndiff data. */
+      SVN_ERR(encode_svndiff(&serial, source, target, version, 1,
+                             iterpool));
+      SVN_ERR(encode_svndiff(&parallel, source, target, version, 4,
+                             iterpool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(serial, parallel));
+
+      /* Decode it again, feeding the data in odd-sized chunks. */
+      source_str.data = source->data;
+      source_str.len = source->len;
+      result = svn_stringbuf_create_empty(iterpool);
+      svn_txdelta_apply(svn_stream_from_string(&source_str, iterpool),
+                        svn_stream_from_stringbuf(result, iterpool),
+                        NULL, NULL, iterpool, &handler, &handler_baton);
+      push_stream = svn_txdelta_parse_svndiff(handler, handler_baton,
+                                              TRUE, iterpool);
+      for (pos = 0; pos < parallel->len; pos += 9999)
+        {
+          apr_size_t len = MIN(9999, parallel->len - pos);
+          SVN_ERR(svn_stream_write(push_stream, parallel->data + pos, &len));
+        }
+      SVN_ERR(svn_stream_close(push_stream));
+
+      SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+svndiff3_window_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 11;
+  svn_stringbuf_t *source = random_text(512 * 1024, &seed, pool);
+  svn_stringbuf_t *target = edit_text(source, 300, TRUE, &seed, pool);
+  svn_stringbuf_t *svndiff = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  svn_string_t source_str, target_str, svndiff_str;
+  svn_txdelta_stream_t *txstream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_txdelta_window_t *window;
+  svn_stream_t *stream;
+  svn_boolean_t data_available;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int windows = 0;
+
+  if (!svn__zstd_available())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Zstandard support not compiled in");
+
+  source_str.data = source->data;
+  source_str.len = source->len;
+  target_str.data = target->data;
+  target_str.len = target->len;
+
+  /* Encode through the public API. */
+  svn_txdelta2(&txstream,
+               svn_stream_from_string(&source_str, pool),
+               svn_stream_from_string(&target_str, pool),
+               FALSE, pool);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(svndiff, pool), 3,
+                          SVN__ZSTD_DEFAULT_LEVEL, pool);
+  SVN_ERR(svn_txdelta_send_txstream(txstream, handler, handler_baton, pool));
+  SVN_TEST_ASSERT(svndiff->len > 4);
+  SVN_TEST_ASSERT(memcmp(svndiff->data, "SVN\3", 4) == 0);
+
+  /* Read the windows back one by one, as FSFS does, and apply them. */
+  svndiff_str.data = svndiff->data + 4;
+  svndiff_str.len = svndiff->len - 4;
+  stream = svn_stream_from_string(&svndiff_str, pool);
+  svn_txdelta_apply(svn_stream_from_string(&source_str, pool),
+                    svn_stream_from_stringbuf(result, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+
+  SVN_ERR(svn_stream_data_available(stream, &data_available));
+  while (data_available)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_read_svndiff_window(&window, stream, 3, iterpool));
+      SVN_ERR(handler(window, handler_baton));
+      SVN_ERR(svn_stream_data_available(stream, &data_available));
+      ++windows;
+    }
+  SVN_ERR(handler(NULL, handler_baton));
+
+  SVN_TEST_ASSERT(windows > 1);
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, target));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+patterning_copy_test(apr_pool_t *pool)
+{
+  char buffer[256];
+  apr_size_t len;
+  svn_txdelta_window_t window = { 0 };
+  svn_txdelta_op_t ops[2];
+  svn_string_t new_data;
+  apr_size_t period, run;
+
+  /* Overlapping target copies of all sorts of pattern and run lengths
+     must create repeating patterns. */
+  new_data.data = "0123456789abcdefghijklmnopqrstuvwxyz";
+  new_data.len = strlen(new_data.data);
+  window.ops = ops;
+  window.num_ops = 2;
+  window.new_data = &new_data;
+  ops[0].action_code = svn_txdelta_new;
+  ops[0].offset = 0;
+  ops[1].action_code = svn_txdelta_target;
+  ops[1].offset = 0;
+
+  for (period = 1; period <= new_data.len; ++period)
+    for (run = 0; run < 200; ++run)
+      {
+        apr_size_t i;
+
+        ops[0].length = period;
+        ops[1].length = run;
+        window.tview_len = period + run;
+
+        len = window.tview_len;
+        svn_txdelta_apply_instructions(&window, NULL, buffer, &len);
+        SVN_TEST_ASSERT(len == period + run);
+
+        for (i = 0; i < len; ++i)
+          SVN_TEST_ASSERT(buffer[i] == new_data.data[i % period]);
+      }
+
+  return SVN_NO_ERROR;
+}
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -625,6 +1209,20 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "random combine delta test"),
     SVN_TEST_PASS2(random_txdelta_to_svndiff_stream_test,
                    "random txdelta to svndiff stream test"),
+    SVN_TEST_PASS2(indexed_delta_test,
+                   "indexed delta engine test"),
+    SVN_TEST_PASS2(indexed_delta_repeated_blocks_test,
+                   "indexed delta engine with repeated blocks"),
+    SVN_TEST_SKIP2(indexed_delta_benchmark, TRUE,
+                   "optional indexed delta engine performance test"),
+    SVN_TEST_SKIP2(txdelta_run_throughput, TRUE,
+                   "optional svn_txdelta_run performance test"),
+    SVN_TEST_PASS2(parallel_svndiff_test,
+                   "concurrent svndiff compression"),
+    SVN_TEST_PASS2(svndiff3_window_test,
+                   "svndiff3 round trip through svndiff windows"),
+    SVN_TEST_PASS2(patterning_copy_test,
+                   "repeating patterns in target copies"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
@@ -27,6 +27,7 @@
 #include "../svn_test.h"
 #include "../../libsvn_fs/fs-loader.h"
 #include "../../libsvn_fs_fs/fs.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
 #include "../../libsvn_fs_fs/low_level.h"
 #include "../../libsvn_fs_fs/pack.h"
@@ -1888,6 +1889,569 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 #undef REPO_NAME
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-indexed_delta_chain"
+#define REVISIONS 6
+
+/* Return a copy of CONTENTS with some text inserted and a block moved to
+   a different place, allocated in POOL.  Use SEED as random number
+   source. */
+static svn_stringbuf_t *
+shuffle_contents(const svn_stringbuf_t *contents,
+                 apr_uint32_t *seed,
+                 apr_pool_t *pool)
+{
+  apr_size_t block = contents->len / 4;
+  apr_size_t from = svn_test_rand(seed) % (contents->len - block);
+  apr_size_t insert_at = svn_test_rand(seed) % (contents->len - block);
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(contents->len + 100,
+                                                         pool);
+  svn_stringbuf_t *rest = svn_stringbuf_dup(contents, pool);
+
+  /* Cut out the block and move it to the front. */
+  svn_stringbuf_remove(rest, from, block);
+  svn_stringbuf_appendbytes(result, contents->data + from, block);
+  svn_stringbuf_appendstr(result, rest);
+
+  /* Insert some new text that is not found in any earlier revision. */
+  svn_stringbuf_insert(result, insert_at,
+                       apr_psprintf(pool, "<%08x>",
+                                    (unsigned)svn_test_rand(seed)), 10);
+
+  return result;
+}
+
+static svn_error_t *
+indexed_delta_chain(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents[REVISIONS + 1];
+  svn_stringbuf_t *actual;
+  apr_uint32_t seed = 2;
+  apr_hash_t *fs_config;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_INDEXED_DELTA_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  ffd->delta_engine = svn_txdelta__engine_indexed;
+
+  /* Text spanning several delta windows that never repeats itself
+   * within a few kBytes. */
+  contents[1] = svn_stringbuf_create_ensure(500000, pool);
+  while (contents[1]->len < 500000)
+    svn_stringbuf_appendcstr(contents[1],
+                             apr_psprintf(pool, "%08x\n",
+                                          (unsigned)svn_test_rand(&seed)));
+
+  /* Revision 1: create the file. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", contents[1]->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Further revisions: move parts of the contents around, so that the
+   * deltas between them use source views that are not aligned with the
+   * windows of their delta bases. */
+  for (rev = 2; rev <= REVISIONS; ++rev)
+    {
+      svn_revnum_t new_rev;
+
+      contents[rev] = shuffle_contents(contents[rev - 1], &seed, pool);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev - 1, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(root, "foo", contents[rev]->data,
+                                          pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, txn, pool));
+      SVN_TEST_ASSERT(new_rev == rev);
+    }
+
+  /* All revisions must be reconstructed correctly.  To make sure we
+   * actually read from disk, use a new FS instance with disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  for (rev = REVISIONS; rev >= 1; --rev)
+    {
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+      SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+      SVN_TEST_STRING_ASSERT(actual->data, contents[rev]->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REVISIONS
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-combined_window_reuse"
+#define REVISIONS 6
+
+static svn_error_t *
+combined_window_reuse(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents[REVISIONS + 1];
+  svn_stringbuf_t *actual;
+  apr_uint32_t seed = 3;
+  apr_hash_t *fs_config;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Text spanning several delta windows. */
+  contents[1] = svn_stringbuf_create_ensure(350000, pool);
+  while (contents[1]->len < 350000)
+    svn_stringbuf_appendcstr(contents[1],
+                             apr_psprintf(pool, "%08x\n",
+                                          (unsigned)svn_test_rand(&seed)));
+
+  /* Revision 1: create the file. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", contents[1]->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Further revisions: change a few bytes in every window.  That gives
+   * us a linear chain of deltas with aligned source views. */
+  for (rev = 2; rev <= REVISIONS; ++rev)
+    {
+      svn_revnum_t new_rev;
+      apr_size_t i;
+
+      contents[rev] = svn_stringbuf_dup(contents[rev - 1], pool);
+      for (i = rev; i < contents[rev]->len; i += 40000)
+        contents[rev]->data[i] = (char)('g' + rev);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev - 1, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(root, "foo", contents[rev]->data,
+                                          pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, txn, pool));
+      SVN_TEST_ASSERT(new_rev == rev);
+    }
+
+  /* Read the latest revision using a new FS instance with disjoint
+   * caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  ffd = fs->fsap_data;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, REVISIONS, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, contents[REVISIONS]->data);
+
+  /* Not only the first window of the deepest delta base that had to be
+   * reconstructed should have been cached.  Windows of delta bases use
+   * negative chunk indexes. */
+  if (ffd->combined_window_cache)
+    {
+      window_cache_key_t key = { 0 };
+      const svn_fs_id_t *id;
+      node_revision_t *noderev;
+      svn_boolean_t found;
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+      SVN_ERR(svn_fs_node_id(&id, root, "foo", pool));
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+
+      key.revision = noderev->data_rep->revision;
+      key.item_index = noderev->data_rep->item_index;
+      key.chunk_index = -1 - 2;
+      SVN_ERR(svn_cache__has_key(&found, ffd->combined_window_cache, &key,
+                                 pool));
+      SVN_TEST_ASSERT(found);
+
+      /* That is no substitute for the whole representation. */
+      key.chunk_index = 0;
+      SVN_ERR(svn_cache__has_key(&found, ffd->combined_window_cache, &key,
+                                 pool));
+      SVN_TEST_ASSERT(!found);
+    }
+
+  /* Older revisions get reconstructed from the cached windows of their
+   * delta bases. */
+  for (rev = REVISIONS - 1; rev >= 1; --rev)
+    {
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+      SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+      SVN_TEST_STRING_ASSERT(actual->data, contents[rev]->data);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REVISIONS
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-small_rep_on_cached_base"
+
+static svn_error_t *
+small_rep_on_cached_base(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *foo1, *foo2, *foo3, *bar3;
+  svn_stringbuf_t *actual;
+  apr_uint32_t seed = 4;
+  apr_hash_t *fs_config;
+  apr_size_t i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_INDEXED_DELTA_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* A file spanning several delta windows. */
+  foo1 = svn_stringbuf_create_ensure(350000, pool);
+  while (foo1->len < 350000)
+    svn_stringbuf_appendcstr(foo1, apr_psprintf(pool, "%08x\n",
+                                     (unsigned)svn_test_rand(&seed)));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", foo1->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: a multi-window delta against r1. */
+  foo2 = svn_stringbuf_dup(foo1, pool);
+  for (i = 7; i < foo2->len; i += 30000)
+    foo2->data[i] = 'x';
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", foo2->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r3: "bar" and "foo" both use foo@2 as their delta base.  "bar" is
+   * large, while "foo" shrinks to a small part of its base that is far
+   * beyond the first window.  The indexed engine will place its source
+   * view there. */
+  bar3 = svn_stringbuf_dup(foo2, pool);
+  for (i = 11; i < bar3->len; i += 30000)
+    bar3->data[i] = 'y';
+  foo3 = svn_stringbuf_ncreate(foo2->data + 250000, 20000, pool);
+
+  ffd->delta_engine = svn_txdelta__engine_indexed;
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_copy(root, "foo", root, "bar", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "bar", bar3->data, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", foo3->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Use a new FS instance with disjoint caches.  Reading "bar" puts
+   * windows of foo@2 into the cache.  Those must not be mistaken for
+   * the fulltext of foo@2 when reading "foo" afterwards. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "bar", &actual, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, bar3->data);
+  SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, foo3->data);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+/* Replace the fsfs.conf of the repository at REPO_PATH with CONTENTS.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+write_fsfs_conf(const char *repo_path,
+                const char *contents,
+                apr_pool_t *pool)
+{
+  const char *path = svn_dirent_join_many(pool, repo_path, "db", PATH_CONFIG,
+                                          SVN_VA_NULL);
+
+  return svn_error_trace(svn_io_write_atomic2(path, contents,
+                                              strlen(contents), NULL, FALSE,
+                                              pool));
+}
+
+/* Open the repository at REPO_PATH with disjoint caches, such that we
+ * actually read from disk, and return it in *FS.  Allocate it in POOL. */
+static svn_error_t *
+reopen_fs(svn_fs_t **fs,
+          const char *repo_path,
+          apr_pool_t *pool)
+{
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+
+  return svn_error_trace(svn_fs_open2(fs, repo_path, fs_config, pool, pool));
+}
+
+/* Return some compressible text with the sequence NUMBER, tagged with TAG.
+ * Texts with the same TAG are similar, so a Zstandard dictionary trained
+ * on some of them applies to all of them.  Allocate the result in POOL. */
+static svn_stringbuf_t *
+zstd_sample(const char *tag,
+            int number,
+            apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < 10; ++i)
+    svn_stringbuf_appendcstr(result,
+                             apr_psprintf(pool, "%s: line %d of sample %d, "
+                                          "mostly the same text every time\n",
+                                          tag, i, number));
+
+  return result;
+}
+
+/* Set *DICT to the contents of a Zstandard dictionary trained on texts
+ * tagged with TAG and *ID to its dictionary ID.  Allocate *DICT in POOL. */
+static svn_error_t *
+train_zstd_dict(svn_stringbuf_t **dict,
+                apr_uint32_t *id,
+                const char *tag,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *samples = apr_array_make(pool, 200,
+                                               sizeof(svn_string_t *));
+  svn__zstd_dict_t *digested;
+  int i;
+
+  for (i = 0; i < 200; ++i)
+    APR_ARRAY_PUSH(samples, svn_string_t *)
+      = svn_stringbuf__morph_into_string(zstd_sample(tag, i, pool));
+
+  SVN_ERR(svn__zstd_train_dict(dict, samples, 4096, pool, pool));
+  SVN_ERR(svn__zstd_dict_create(&digested, (*dict)->data, (*dict)->len,
+                                SVN__ZSTD_DEFAULT_LEVEL, pool));
+  *id = svn__zstd_dict_id(digested);
+
+  return SVN_NO_ERROR;
+}
+
+#define REPO_NAME "test-repo-zstd_compression"
+
+static svn_error_t *
+zstd_compression(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *rev_contents;
+  svn_stringbuf_t *actual;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+  if (!svn__zstd_available())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Zstandard support not compiled in");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(write_fsfs_conf(REPO_NAME,
+                          "[" CONFIG_SECTION_DELTIFICATION "]\n"
+                          CONFIG_OPTION_COMPRESSION " = zstd\n",
+                          pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->delta_compression_type == compression_type_zstd);
+
+  for (i = 0; i < 100; ++i)
+    svn_stringbuf_appendstr(contents, zstd_sample("zstd", i, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* The representation must have been written as svndiff3. */
+  SVN_ERR(svn_stringbuf_from_file2(&rev_contents,
+                                   svn_fs_fs__path_rev_absolute(fs, rev,
+                                                                pool),
+                                   pool));
+  SVN_TEST_ASSERT(stringbuf_find(rev_contents, "SVN\3") != APR_SIZE_MAX);
+
+  SVN_ERR(reopen_fs(&fs, REPO_NAME, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, contents->data);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-zstd_dictionary"
+#define COPY_NAME "test-repo-zstd_dictionary-copy"
+
+static svn_error_t *
+zstd_dictionary(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *dict;
+  svn_stringbuf_t *other_dict;
+  svn_stringbuf_t *copied_dict;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *actual;
+  apr_uint32_t id;
+  apr_uint32_t other_id;
+  const char *dict_path;
+  const char *copy_dict_path;
+  const char *config;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+  if (!svn__zstd_available())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Zstandard support not compiled in");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(train_zstd_dict(&dict, &id, "repos", pool));
+  SVN_ERR(train_zstd_dict(&other_dict, &other_id, "other", pool));
+  SVN_TEST_ASSERT(id != other_id);
+
+  /* A dictionary without a registered ID won't be used. */
+  dict_path = svn_dirent_join_many(pool, REPO_NAME, "db", PATH_ZSTD_DICT,
+                                   SVN_VA_NULL);
+  SVN_ERR(svn_io_file_create_bytes(dict_path, dict->data, dict->len, pool));
+  SVN_TEST_ASSERT_ERROR(reopen_fs(&fs, REPO_NAME, pool),
+                        SVN_ERR_BAD_CONFIG_VALUE);
+
+  /* Neither will one with a mismatching ID. */
+  config = apr_psprintf(pool,
+                        "[" CONFIG_SECTION_DELTIFICATION "]\n"
+                        CONFIG_OPTION_COMPRESSION " = zstd\n"
+                        CONFIG_OPTION_ZSTD_DICT_ID " = %u\n",
+                        other_id);
+  SVN_ERR(write_fsfs_conf(REPO_NAME, config, pool));
+  SVN_TEST_ASSERT_ERROR(reopen_fs(&fs, REPO_NAME, pool), SVN_ERR_FS_CORRUPT);
+
+  /* Register the right one and compress with it. */
+  config = apr_psprintf(pool,
+                        "[" CONFIG_SECTION_DELTIFICATION "]\n"
+                        CONFIG_OPTION_COMPRESSION " = zstd\n"
+                        CONFIG_OPTION_ZSTD_DICT_ID " = %u\n",
+                        id);
+  SVN_ERR(write_fsfs_conf(REPO_NAME, config, pool));
+  SVN_ERR(reopen_fs(&fs, REPO_NAME, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->zstd_dict);
+
+  for (i = 0; i < 100; ++i)
+    svn_stringbuf_appendstr(contents, zstd_sample("repos", i + 1000, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(reopen_fs(&fs, REPO_NAME, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, contents->data);
+
+  /* Hotcopy carries the dictionary along with its registration. */
+  SVN_ERR(svn_io_remove_dir2(COPY_NAME, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(COPY_NAME);
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, COPY_NAME, TRUE, FALSE, NULL, NULL,
+                          NULL, NULL, pool));
+
+  copy_dict_path = svn_dirent_join_many(pool, COPY_NAME, "db",
+                                        PATH_ZSTD_DICT, SVN_VA_NULL);
+  SVN_ERR(svn_stringbuf_from_file2(&copied_dict, copy_dict_path, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(copied_dict, dict));
+
+  SVN_ERR(reopen_fs(&fs, COPY_NAME, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, contents->data);
+
+  /* Incremental hotcopy must not replace a different dictionary. */
+  SVN_ERR(svn_io_remove_file2(copy_dict_path, FALSE, pool));
+  SVN_ERR(svn_io_file_create_bytes(copy_dict_path, other_dict->data,
+                                   other_dict->len, pool));
+  SVN_TEST_ASSERT_ANY_ERROR(svn_fs_hotcopy3(REPO_NAME, COPY_NAME, FALSE,
+                                            TRUE, NULL, NULL, NULL, NULL,
+                                            pool));
+  SVN_ERR(svn_stringbuf_from_file2(&copied_dict, copy_dict_path, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(copied_dict, other_dict));
+
+  /* A registered dictionary must not go missing. */
+  SVN_ERR(svn_io_remove_file2(dict_path, FALSE, pool));
+  SVN_TEST_ASSERT_ERROR(reopen_fs(&fs, REPO_NAME, pool), SVN_ERR_FS_CORRUPT);
+
+  return SVN_NO_ERROR;
+}
+
+#undef COPY_NAME
+#undef REPO_NAME
+
 
 
 /* The test table.  */
@@ -1943,6 +2507,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(indexed_delta_chain,
+                       "delta chains created by the indexed delta engine"),
+    SVN_TEST_OPTS_PASS(combined_window_reuse,
+                       "reuse combined windows of delta bases"),
+    SVN_TEST_OPTS_PASS(small_rep_on_cached_base,
+                       "small rep on a partially cached delta base"),
+    SVN_TEST_OPTS_PASS(zstd_compression,
+                       "commit and read zstd compressed representations"),
+    SVN_TEST_OPTS_PASS(zstd_dictionary,
+                       "registration and hotcopy of zstd dictionaries"),
     SVN_TEST_NULL
   };
 
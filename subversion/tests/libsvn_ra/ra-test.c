@@ -36,6 +36,10 @@
 #include "svn_cmdline.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_ra_svn.h"
+
+#include "private/svn_ra_svn_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -1877,6 +1881,67 @@ test_get_deleted_rev_errors(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Return a connection with COMPRESSION_LEVEL that has seen the peer
+ * announce the NUM_CAPS capabilities CAPS.  Allocate it in POOL. */
+static svn_error_t *
+make_conn_with_caps(svn_ra_svn_conn_t **conn,
+                    int compression_level,
+                    const char *caps[],
+                    int num_caps,
+                    apr_pool_t *pool)
+{
+  svn_ra_svn__list_t list;
+  int i;
+
+  list.nelts = num_caps;
+  list.items = apr_pcalloc(pool, num_caps * sizeof(*list.items));
+  for (i = 0; i < num_caps; ++i)
+    {
+      list.items[i].kind = SVN_RA_SVN_WORD;
+      list.items[i].u.word.data = caps[i];
+      list.items[i].u.word.len = strlen(caps[i]);
+    }
+
+  *conn = svn_ra_svn_create_conn5(NULL, svn_stream_empty(pool),
+                                  svn_stream_empty(pool), compression_level,
+                                  0, 0, 0, 0, pool);
+  return svn_error_trace(svn_ra_svn__set_capabilities(*conn, &list));
+}
+
+static svn_error_t *
+svndiff_version_negotiation(apr_pool_t *pool)
+{
+  const char *caps[] = { SVN_RA_SVN_CAP_SVNDIFF1,
+                         SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
+                         SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED };
+  svn_ra_svn_conn_t *conn;
+
+  SVN_ERR(make_conn_with_caps(&conn, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                              caps, 0, pool));
+  SVN_TEST_INT_ASSERT(svn_ra_svn__svndiff_version(conn), 0);
+
+  SVN_ERR(make_conn_with_caps(&conn, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                              caps, 1, pool));
+  SVN_TEST_INT_ASSERT(svn_ra_svn__svndiff_version(conn), 1);
+
+  SVN_ERR(make_conn_with_caps(&conn, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                              caps, 2, pool));
+  SVN_TEST_INT_ASSERT(svn_ra_svn__svndiff_version(conn), 2);
+
+  /* Only offer svndiff3 if we can produce it. */
+  SVN_ERR(make_conn_with_caps(&conn, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                              caps, 3, pool));
+  SVN_TEST_INT_ASSERT(svn_ra_svn__svndiff_version(conn),
+                      svn__zstd_available() ? 3 : 2);
+
+  /* Disabled compression overrides all capabilities. */
+  SVN_ERR(make_conn_with_caps(&conn, SVN_DELTA_COMPRESSION_LEVEL_NONE,
+                              caps, 3, pool));
+  SVN_TEST_INT_ASSERT(svn_ra_svn__svndiff_version(conn), 0);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -1917,6 +1982,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test get-deleted-rev no delete"),
     SVN_TEST_OPTS_PASS(test_get_deleted_rev_errors,
                        "test get-deleted-rev errors"),
+    SVN_TEST_PASS2(svndiff_version_negotiation,
+                   "svndiff version negotiation over ra_svn"),
     SVN_TEST_NULL
   };
 
@@ -26,10 +26,12 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
 
 #include "private/svn_cache.h"
+#include "private/svn_temp_serializer.h"
 #include "svn_private_config.h"
 
 #include "../svn_test.h"
@@ -210,7 +212,9 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   svn_membuffer_t *membuffer;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
@@ -268,7 +272,9 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
   void *val;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
@@ -300,7 +306,9 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
 
   /* Create a new cache. */
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
                                             serialize_revnum,
@@ -387,7 +395,9 @@ test_membuffer_cache_clearing(apr_pool_t *pool)
 
   /* Create a simple cache for strings, keyed by strings. */
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
                                             serialize_revnum,
@@ -505,7 +515,9 @@ test_membuffer_unaligned_string_keys(apr_pool_t *pool)
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(
@@ -555,7 +567,9 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(
@@ -590,6 +604,973 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Replay a simple access trace against a fresh membuffer cache using the
+ * admission POLICY:  Access a small working set a couple of times, then
+ * scan through a large number of items exactly once.  Return the number
+ * of working set items still in cache after the scan in *HITS and the
+ * cache statistics in *INFO.
+ */
+static svn_error_t *
+replay_scan_trace(int *hits,
+                  svn_cache__info_t *info,
+                  svn_cache__admission_policy_t policy,
+                  apr_pool_t *pool)
+{
+  enum { WORKING_SET = 200, ROUNDS = 5, SCAN = 5000, ITEM_SIZE = 1000 };
+
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_stringbuf_t *value;
+  apr_uint64_t key;
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024,
+                                            400 * 1024, 1, FALSE, FALSE,
+                                            policy, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer, NULL, NULL,
+                                            sizeof(key), "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  value = svn_stringbuf_create_ensure(ITEM_SIZE, pool);
+  svn_stringbuf_appendfill(value, 'x', ITEM_SIZE);
+
+  /* Read the working set a couple of times, fill the cache on misses. */
+  for (i = 0; i < ROUNDS; ++i)
+    for (key = 0; key < WORKING_SET; ++key)
+      {
+        void *result;
+        svn_boolean_t found;
+
+        SVN_ERR(svn_cache__get(&result, &found, cache, &key, pool));
+        if (!found)
+          SVN_ERR(svn_cache__set(cache, &key, value, pool));
+      }
+
+  /* One-time scan, e.g. a full export. */
+  for (key = WORKING_SET; key < WORKING_SET + SCAN; ++key)
+    {
+      void *result;
+      svn_boolean_t found;
+
+      SVN_ERR(svn_cache__get(&result, &found, cache, &key, pool));
+      if (!found)
+        SVN_ERR(svn_cache__set(cache, &key, value, pool));
+    }
+
+  /* How much of the working set survived? */
+  *hits = 0;
+  for (key = 0; key < WORKING_SET; ++key)
+    {
+      svn_boolean_t found;
+
+      SVN_ERR(svn_cache__has_key(&found, cache, &key, pool));
+      if (found)
+        ++*hits;
+    }
+
+  SVN_ERR(svn_cache__get_info(cache, info, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_tinylfu(const svn_test_opts_t *opts,
+                             apr_pool_t *pool)
+{
+  svn_cache__info_t default_info;
+  svn_cache__info_t tinylfu_info;
+  int default_hits;
+  int tinylfu_hits;
+
+  SVN_ERR(replay_scan_trace(&default_hits, &default_info,
+                            svn_cache__admission_default, pool));
+  SVN_ERR(replay_scan_trace(&tinylfu_hits, &tinylfu_info,
+                            svn_cache__admission_tinylfu, pool));
+
+  if (opts->verbose)
+    printf("default: %d of 200 working set items survived\n%s\n"
+           "tinylfu: %d of 200 working set items survived\n%s\n",
+           default_hits,
+           svn_cache__format_info(&default_info, FALSE, pool)->data,
+           tinylfu_hits,
+           svn_cache__format_info(&tinylfu_info, FALSE, pool)->data);
+
+  /* Only the admission policy knows about rejections. */
+  SVN_TEST_ASSERT(default_info.rejects == 0);
+  SVN_TEST_ASSERT(tinylfu_info.rejects > 0);
+
+  /* TinyLFU must protect the working set from the scan. */
+  SVN_TEST_ASSERT(tinylfu_hits >= 180);
+  SVN_TEST_ASSERT(tinylfu_hits > default_hits);
+
+  /* Both see the same trace. */
+  SVN_TEST_ASSERT(default_info.gets == tinylfu_info.gets);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Baton type for concurrent_reader_thread. */
+typedef struct concurrent_reader_baton_t
+{
+  /* The shared cache to read from. */
+  svn_membuffer_t *membuffer;
+
+  /* Keys 0 .. KEY_COUNT-1 have been stored with their key as value. */
+  apr_uint64_t key_count;
+
+  /* Number of lookups to perform. */
+  int iterations;
+
+  /* Number of lookups that returned data. */
+  int hits;
+
+  /* Result of the thread function. */
+  svn_error_t *err;
+} concurrent_reader_baton_t;
+
+/* Do BATON->ITERATIONS lookups in BATON->MEMBUFFER through a private
+ * cache front-end.  This is what a typical multi-threaded server does:
+ * one front-end per session, all sharing the same membuffer cache.
+ */
+static svn_error_t *
+concurrent_reads(concurrent_reader_baton_t *baton,
+                 apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, baton->membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(apr_uint64_t),
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  for (i = 0; i < baton->iterations; ++i)
+    {
+      apr_uint64_t key = ((apr_uint64_t)i * 7919) % baton->key_count;
+      svn_revnum_t *answer;
+      svn_boolean_t found;
+
+      if (i % 1000 == 0)
+        svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_cache__get((void **) &answer, &found, cache, &key,
+                             iterpool));
+      if (found)
+        {
+          if (*answer != (svn_revnum_t)key)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "expected %ld but found '%ld'",
+                                     (svn_revnum_t)key, *answer);
+          baton->hits++;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Thread function calling concurrent_reads() with DATA as baton. */
+static void *
+APR_THREAD_FUNC concurrent_reader_thread(apr_thread_t *tid, void *data)
+{
+  concurrent_reader_baton_t *baton = data;
+
+  /* Pools are not thread-safe, so use a separate one per thread. */
+  apr_allocator_t *allocator = svn_pool_create_allocator(FALSE);
+  apr_pool_t *pool = apr_allocator_owner_get(allocator);
+
+  baton->err = concurrent_reads(baton, pool);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Baton type for concurrent_writer_thread. */
+typedef struct concurrent_writer_baton_t
+{
+  /* The shared cache to write to. */
+  svn_membuffer_t *membuffer;
+
+  /* Write keys 0 .. KEY_COUNT-1 with their key as value. */
+  apr_uint64_t key_count;
+
+  /* Number of writes to perform. */
+  int iterations;
+
+  /* Result of the thread function. */
+  svn_error_t *err;
+} concurrent_writer_baton_t;
+
+/* Do BATON->ITERATIONS writes to BATON->MEMBUFFER through a private
+ * cache front-end.  Check for the key first, as the FSFS block reader
+ * does, such that the lock-free lookups race with our own writes, too.
+ */
+static svn_error_t *
+concurrent_writes(concurrent_writer_baton_t *baton,
+                  apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, baton->membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(apr_uint64_t),
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  for (i = 0; i < baton->iterations; ++i)
+    {
+      apr_uint64_t key = ((apr_uint64_t)i * 31) % baton->key_count;
+      svn_revnum_t value = (svn_revnum_t)key;
+      svn_boolean_t found;
+
+      if (i % 1000 == 0)
+        svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_cache__has_key(&found, cache, &key, iterpool));
+      if (!found)
+        SVN_ERR(svn_cache__set(cache, &key, &value, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Thread function calling concurrent_writes() with DATA as baton. */
+static void *
+APR_THREAD_FUNC concurrent_writer_thread(apr_thread_t *tid, void *data)
+{
+  concurrent_writer_baton_t *baton = data;
+
+  /* Pools are not thread-safe, so use a separate one per thread. */
+  apr_allocator_t *allocator = svn_pool_create_allocator(FALSE);
+  apr_pool_t *pool = apr_allocator_owner_get(allocator);
+
+  baton->err = concurrent_writes(baton, pool);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+#define APR_ERR(expr)                           \
+  do {                                          \
+    apr_status_t status = (expr);               \
+    if (status)                                 \
+      return svn_error_wrap_apr(status, NULL);  \
+  } while (0)
+
+#endif
+
+static svn_error_t *
+test_membuffer_cache_concurrent_reads(const svn_test_opts_t *opts,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  /* Populate a single-segment membuffer cache and read it concurrently
+   * with an increasing number of threads.  Verify that all hits return
+   * the correct data.  In verbose mode, report the hit rate in hits/s as
+   * a simple benchmark for the scalability of cache hits. */
+  enum { MAX_THREADS = 8, KEY_COUNT = 10000, ITERATIONS = 100000 };
+
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  concurrent_reader_baton_t batons[MAX_THREADS];
+  apr_thread_t *threads[MAX_THREADS];
+  apr_uint64_t key;
+  int thread_count;
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 8 * 1024 * 1024,
+                                            2 * 1024 * 1024, 1,
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(apr_uint64_t),
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  for (key = 0; key < KEY_COUNT; ++key)
+    {
+      svn_revnum_t value = (svn_revnum_t)key;
+      SVN_ERR(svn_cache__set(cache, &key, &value, pool));
+    }
+
+  for (thread_count = 1; thread_count <= MAX_THREADS; thread_count *= 2)
+    {
+      apr_time_t start = apr_time_now();
+      apr_time_t duration;
+      int hits = 0;
+
+      for (i = 0; i < thread_count; ++i)
+        {
+          batons[i].membuffer = membuffer;
+          batons[i].key_count = KEY_COUNT;
+          batons[i].iterations = ITERATIONS;
+          batons[i].hits = 0;
+          batons[i].err = SVN_NO_ERROR;
+
+          APR_ERR(apr_thread_create(&threads[i], NULL,
+                                    concurrent_reader_thread, &batons[i],
+                                    pool));
+        }
+
+      for (i = 0; i < thread_count; ++i)
+        {
+          apr_status_t retval;
+          APR_ERR(apr_thread_join(&retval, threads[i]));
+          APR_ERR(retval);
+        }
+
+      duration = apr_time_now() - start;
+      for (i = 0; i < thread_count; ++i)
+        {
+          SVN_ERR(batons[i].err);
+          hits += batons[i].hits;
+        }
+
+      /* Most of the data should still be in the cache. */
+      SVN_TEST_ASSERT(hits > thread_count * ITERATIONS / 2);
+
+      if (opts->verbose)
+        printf("%d thread(s): %d hits in %.3f s, %.0f hits/s\n",
+               thread_count, hits, (double)duration / APR_USEC_PER_SEC,
+               (double)hits * APR_USEC_PER_SEC
+                 / (double)(duration ? duration : 1));
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_concurrent_writes(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  /* Let one thread keep writing to and thus evicting from a cache that
+   * is much too small for all keys while other threads read from it
+   * using lock-free lookups.  Those may miss but must never return
+   * wrong data. */
+  enum { READER_COUNT = 4, KEY_COUNT = 1000, ITERATIONS = 100000 };
+
+  svn_membuffer_t *membuffer;
+  concurrent_reader_baton_t readers[READER_COUNT];
+  concurrent_writer_baton_t writer;
+  apr_thread_t *threads[READER_COUNT + 1];
+  apr_status_t retval;
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
+
+  writer.membuffer = membuffer;
+  writer.key_count = KEY_COUNT;
+  writer.iterations = ITERATIONS;
+  writer.err = SVN_NO_ERROR;
+  APR_ERR(apr_thread_create(&threads[READER_COUNT], NULL,
+                            concurrent_writer_thread, &writer, pool));
+
+  for (i = 0; i < READER_COUNT; ++i)
+    {
+      readers[i].membuffer = membuffer;
+      readers[i].key_count = KEY_COUNT;
+      readers[i].iterations = ITERATIONS;
+      readers[i].hits = 0;
+      readers[i].err = SVN_NO_ERROR;
+
+      APR_ERR(apr_thread_create(&threads[i], NULL,
+                                concurrent_reader_thread, &readers[i],
+                                pool));
+    }
+
+  for (i = 0; i <= READER_COUNT; ++i)
+    {
+      APR_ERR(apr_thread_join(&retval, threads[i]));
+      APR_ERR(retval);
+    }
+
+  SVN_ERR(writer.err);
+  for (i = 0; i < READER_COUNT; ++i)
+    SVN_ERR(readers[i].err);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Write KEY_COUNT items with keys FIRST_KEY + n and values n to CACHE.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_numbered_items(svn_cache__t *cache,
+                     apr_uint64_t first_key,
+                     int key_count,
+                     apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < key_count; ++i)
+    {
+      apr_uint64_t key = first_key + i;
+      svn_revnum_t value = i;
+      SVN_ERR(svn_cache__set(cache, &key, &value, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FOUND_COUNT to the number of items written to CACHE by
+ * write_numbered_items for FIRST_KEY and KEY_COUNT that can still be read
+ * from it with their correct values.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+count_numbered_items(int *found_count,
+                     svn_cache__t *cache,
+                     apr_uint64_t first_key,
+                     int key_count,
+                     apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  *found_count = 0;
+  for (i = 0; i < key_count; ++i)
+    {
+      apr_uint64_t key = first_key + i;
+      svn_revnum_t *value;
+      svn_boolean_t found;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__get((void **)&value, &found, cache, &key,
+                             iterpool));
+      if (found && *value == i)
+        ++*found_count;
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_shared(apr_pool_t *pool)
+{
+#if APR_HAS_FORK
+  /* Let a forked child process and its parent populate a shared cache
+   * concurrently.  Both must see each other's data.  The child reports
+   * errors through its exit code. */
+  enum { KEY_COUNT = 1000, PARENT_KEYS = 0, CHILD_KEYS = 10000 };
+
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  apr_proc_t proc;
+  apr_status_t status;
+  apr_exit_why_e exit_why;
+  int exit_code;
+  int found_count;
+  svn_error_t *err;
+
+  err = svn_cache__membuffer_cache_create_shared(&membuffer,
+                                                 4 * 1024 * 1024,
+                                                 1024 * 1024, 1, TRUE,
+                                                 svn_cache__admission_default,
+                                                 pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, err, NULL);
+  SVN_ERR(err);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(apr_uint64_t),
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(write_numbered_items(cache, PARENT_KEYS, 1, pool));
+
+  /* Don't let the child print our buffered output a second time. */
+  fflush(stdout);
+
+  status = apr_proc_fork(&proc, pool);
+  if (status == APR_INCHILD)
+    {
+      err = count_numbered_items(&found_count, cache, PARENT_KEYS, 1, pool);
+      if (!err)
+        err = write_numbered_items(cache, CHILD_KEYS, KEY_COUNT, pool);
+
+      exit_code = err ? 1 : (found_count == 1 ? 0 : 2);
+      svn_error_clear(err);
+      exit(exit_code);
+    }
+  else if (status != APR_INPARENT)
+    return svn_error_wrap_apr(status, "apr_proc_fork");
+
+  SVN_ERR(write_numbered_items(cache, PARENT_KEYS, KEY_COUNT, pool));
+
+  status = apr_proc_wait(&proc, &exit_code, &exit_why, APR_WAIT);
+  if (status != APR_CHILD_DONE)
+    return svn_error_wrap_apr(status, "apr_proc_wait");
+
+  SVN_TEST_ASSERT(APR_PROC_CHECK_EXIT(exit_why));
+  SVN_TEST_INT_ASSERT(exit_code, 0);
+
+  /* The cache is large enough to hold all items. */
+  SVN_ERR(count_numbered_items(&found_count, cache, CHILD_KEYS, KEY_COUNT,
+                               pool));
+  SVN_TEST_INT_ASSERT(found_count, KEY_COUNT);
+  SVN_ERR(count_numbered_items(&found_count, cache, PARENT_KEYS, KEY_COUNT,
+                               pool));
+  SVN_TEST_INT_ASSERT(found_count, KEY_COUNT);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+#endif
+}
+
+#if APR_HAS_FORK
+/* Implements svn_cache__partial_setter_func_t.
+ * Terminate the process while it holds the cache segment lock. */
+static svn_error_t *
+die_while_locked(void **data,
+                 apr_size_t *data_len,
+                 void *baton,
+                 apr_pool_t *result_pool)
+{
+  exit(0);
+}
+#endif
+
+static svn_error_t *
+test_membuffer_cache_shared_owner_death(apr_pool_t *pool)
+{
+#if APR_HAS_FORK
+  /* A worker process that dies while holding a segment lock must not
+   * block the other processes forever. */
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  apr_proc_t proc;
+  apr_status_t status;
+  apr_exit_why_e exit_why;
+  int exit_code;
+  int found_count;
+  svn_error_t *err;
+  apr_uint64_t key = 0;
+
+  err = svn_cache__membuffer_cache_create_shared(&membuffer,
+                                                 4 * 1024 * 1024,
+                                                 1024 * 1024, 1, TRUE,
+                                                 svn_cache__admission_default,
+                                                 pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, err, NULL);
+  SVN_ERR(err);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(apr_uint64_t),
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(write_numbered_items(cache, 0, 100, pool));
+
+  fflush(stdout);
+
+  status = apr_proc_fork(&proc, pool);
+  if (status == APR_INCHILD)
+    {
+      /* Partial setters get called with the segment being write-locked. */
+      err = svn_cache__set_partial(cache, &key, die_while_locked, NULL,
+                                   pool);
+      svn_error_clear(err);
+      exit(1);
+    }
+  else if (status != APR_INPARENT)
+    return svn_error_wrap_apr(status, "apr_proc_fork");
+
+  status = apr_proc_wait(&proc, &exit_code, &exit_why, APR_WAIT);
+  if (status != APR_CHILD_DONE)
+    return svn_error_wrap_apr(status, "apr_proc_wait");
+  SVN_TEST_INT_ASSERT(exit_code, 0);
+
+  /* The segment that the child held has been reset but the cache is
+   * fully functional again. */
+  SVN_ERR(count_numbered_items(&found_count, cache, 0, 100, pool));
+  SVN_TEST_ASSERT(found_count < 100);
+
+  SVN_ERR(write_numbered_items(cache, 0, 100, pool));
+  SVN_ERR(count_numbered_items(&found_count, cache, 0, 100, pool));
+  SVN_TEST_INT_ASSERT(found_count, 100);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+#endif
+}
+
+
+/* Create a front-end cache for MEMBUFFER with revnum values, PREFIX and
+ * keys of length KLEN in *CACHE.  Allocate it in POOL. */
+static svn_error_t *
+create_revnum_cache(svn_cache__t **cache,
+                    svn_membuffer_t *membuffer,
+                    apr_ssize_t klen,
+                    const char *prefix,
+                    apr_pool_t *pool)
+{
+  return svn_error_trace(svn_cache__create_membuffer_cache(
+                             cache, membuffer,
+                             serialize_revnum, deserialize_revnum,
+                             klen, prefix,
+                             SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                             FALSE, FALSE, pool, pool));
+}
+
+/* Set *FOUND_COUNT to the number of items written to CACHE by
+ * test_membuffer_cache_snapshot with string keys that can be read from
+ * it with their correct values. */
+static svn_error_t *
+count_string_key_items(int *found_count,
+                       svn_cache__t *cache,
+                       int key_count,
+                       apr_pool_t *pool)
+{
+  int i;
+
+  *found_count = 0;
+  for (i = 0; i < key_count; ++i)
+    {
+      svn_revnum_t *value;
+      svn_boolean_t found;
+
+      SVN_ERR(svn_cache__get((void **)&value, &found, cache,
+                             apr_psprintf(pool, "key %d", i), pool));
+      if (found && *value == i)
+        ++*found_count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_snapshot(apr_pool_t *pool)
+{
+  /* Save a cache with fixed-size and with string keys, then restore it
+   * into a cache of different size and configuration. */
+  enum { KEY_COUNT = 1000, STRING_KEY_COUNT = 20 };
+
+  svn_membuffer_t *membuffer;
+  svn_membuffer_t *restored;
+  svn_cache__t *fixed_keys;
+  svn_cache__t *string_keys;
+  svn_cache__t *unrelated;
+  svn_stringbuf_t *snapshot = svn_stringbuf_create_empty(pool);
+  svn_boolean_t loaded;
+  svn_error_t *err;
+  int found_count;
+  int string_found_count;
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024,
+                                            256 * 1024, 1, TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
+  SVN_ERR(create_revnum_cache(&fixed_keys, membuffer, sizeof(apr_uint64_t),
+                              "fixed:", pool));
+  SVN_ERR(create_revnum_cache(&string_keys, membuffer, APR_HASH_KEY_STRING,
+                              "string:", pool));
+
+  SVN_ERR(write_numbered_items(fixed_keys, 0, KEY_COUNT, pool));
+  for (i = 0; i < STRING_KEY_COUNT; ++i)
+    {
+      svn_revnum_t value = i;
+      SVN_ERR(svn_cache__set(string_keys, apr_psprintf(pool, "key %d", i),
+                             &value, pool));
+    }
+
+  SVN_ERR(count_string_key_items(&string_found_count, string_keys,
+                                 STRING_KEY_COUNT, pool));
+  SVN_TEST_ASSERT(string_found_count > 0);
+
+  SVN_ERR(svn_cache__membuffer_save(membuffer,
+                                    svn_stream_from_stringbuf(snapshot, pool),
+                                    "uuid:10", pool));
+
+  /* Use a different segmentation for the new cache and make sure that
+   * the key prefixes get different indexes. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&restored, 4 * 1024 * 1024,
+                                            1024 * 1024, 4, TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
+  SVN_ERR(create_revnum_cache(&unrelated, restored, sizeof(apr_uint64_t),
+                              "unrelated:", pool));
+  SVN_ERR(create_revnum_cache(&fixed_keys, restored, sizeof(apr_uint64_t),
+                              "fixed:", pool));
+  SVN_ERR(create_revnum_cache(&string_keys, restored, APR_HASH_KEY_STRING,
+                              "string:", pool));
+
+  /* Stale snapshots must be ignored. */
+  SVN_ERR(svn_cache__membuffer_load(&loaded, restored,
+                                    svn_stream_from_stringbuf(snapshot, pool),
+                                    "uuid:11", pool));
+  SVN_TEST_ASSERT(!loaded);
+  SVN_ERR(count_numbered_items(&found_count, fixed_keys, 0, KEY_COUNT,
+                               pool));
+  SVN_TEST_INT_ASSERT(found_count, 0);
+
+  /* Restore the snapshot. */
+  SVN_ERR(svn_cache__membuffer_load(&loaded, restored,
+                                    svn_stream_from_stringbuf(snapshot, pool),
+                                    "uuid:10", pool));
+  SVN_TEST_ASSERT(loaded);
+
+  SVN_ERR(count_numbered_items(&found_count, fixed_keys, 0, KEY_COUNT,
+                               pool));
+  SVN_TEST_INT_ASSERT(found_count, KEY_COUNT);
+  SVN_ERR(count_string_key_items(&found_count, string_keys,
+                                 STRING_KEY_COUNT, pool));
+  SVN_TEST_INT_ASSERT(found_count, string_found_count);
+  SVN_ERR(count_numbered_items(&found_count, unrelated, 0, KEY_COUNT,
+                               pool));
+  SVN_TEST_INT_ASSERT(found_count, 0);
+
+  /* Corrupt the last item's data, which is followed by a 48 byte end
+   * marker. */
+  snapshot->data[snapshot->len - 49] ^= 1;
+  err = svn_cache__membuffer_load(&loaded, restored,
+                                  svn_stream_from_stringbuf(snapshot, pool),
+                                  "uuid:10", pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_MALFORMED_FILE);
+
+  /* Truncated snapshots are corrupt as well. */
+  snapshot->len -= 1;
+  err = svn_cache__membuffer_load(&loaded, restored,
+                                  svn_stream_from_stringbuf(snapshot, pool),
+                                  "uuid:10", pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Simple structure with sub-structures for the view tests. */
+typedef struct view_test_item_t
+{
+  const char *name;
+  const char *value;
+} view_test_item_t;
+
+/* Implements svn_cache__serialize_func_t for view_test_item_t. */
+static svn_error_t *
+serialize_view_test_item(void **data,
+                         apr_size_t *data_len,
+                         void *in,
+                         apr_pool_t *pool)
+{
+  view_test_item_t *item = in;
+  svn_stringbuf_t *serialized;
+  svn_temp_serializer__context_t *context
+    = svn_temp_serializer__init(item, sizeof(*item), 64, pool);
+
+  svn_temp_serializer__add_string(context, &item->name);
+  svn_temp_serializer__add_string(context, &item->value);
+
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__partial_getter_func_t.  Return a copy of the
+ * value string without resolving the cached item itself. */
+static svn_error_t *
+get_view_test_value(void **out,
+                    const void *data,
+                    apr_size_t data_len,
+                    void *baton,
+                    apr_pool_t *result_pool)
+{
+  const view_test_item_t *item = data;
+  svn_temp_deserializer__view_t view;
+  const char *value;
+
+  svn_temp_deserializer__view_init(&view, data, data_len);
+  value = svn_temp_deserializer__view_string(&view, item, &item->value);
+  SVN_TEST_ASSERT(value);
+
+  /* The view must reject pointers that lead outside the item. */
+  SVN_TEST_ASSERT(svn_temp_deserializer__view_ptr(&view, item,
+                                          (const void *const *)&item->value,
+                                          data_len) == NULL);
+  SVN_TEST_ASSERT(svn_temp_deserializer__view_ptr(&view, item,
+                                          (const void *const *)&item->value,
+                                          strlen(value) + 1) == value);
+
+  /* The cached data must not have been modified. */
+  SVN_TEST_ASSERT(svn_temp_deserializer__ptr(item,
+                                     (const void *const *)&item->value)
+                  == value);
+
+  *out = apr_pstrdup(result_pool, value);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_partial_view(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  view_test_item_t item = { "name", "value" };
+  svn_boolean_t found;
+  const char *value;
+  svn_temp_deserializer__view_t view;
+  view_test_item_t bogus[2];
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE,
+                                            svn_cache__admission_default,
+                                            pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_view_test_item,
+                                            NULL,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  SVN_ERR(svn_cache__set(cache, "item", &item, pool));
+
+  /* Reading the value twice shows that the cached data stays intact. */
+  SVN_ERR(svn_cache__get_partial((void **)&value, &found, cache, "item",
+                                 get_view_test_value, NULL, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(value, "value");
+
+  SVN_ERR(svn_cache__get_partial((void **)&value, &found, cache, "item",
+                                 get_view_test_value, NULL, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(value, "value");
+
+  /* Strings that are not terminated within the view as well as NULL
+   * pointers get rejected. */
+  memset(bogus, 'x', sizeof(bogus));
+  bogus[0].name = (const char *)sizeof(bogus[0]);
+  bogus[0].value = NULL;
+  svn_temp_deserializer__view_init(&view, bogus, sizeof(bogus));
+  SVN_TEST_ASSERT(svn_temp_deserializer__view_ptr(&view, &bogus[0],
+                                          (const void *const *)&bogus[0].name,
+                                          sizeof(bogus[1])) == &bogus[1]);
+  SVN_TEST_ASSERT(svn_temp_deserializer__view_string(&view, &bogus[0],
+                                                     &bogus[0].name) == NULL);
+  SVN_TEST_ASSERT(svn_temp_deserializer__view_string(&view, &bogus[0],
+                                                     &bogus[0].value) == NULL);
+
+  /* Pointers that are cut off by the end of the view cannot be read. */
+  bogus[0].value = (const char *)1;
+  svn_temp_deserializer__view_init(&view, bogus,
+                                   APR_OFFSETOF(view_test_item_t, value) + 1);
+  SVN_TEST_ASSERT(svn_temp_deserializer__view_ptr(&view, &bogus[0],
+                                          (const void *const *)&bogus[0].value,
+                                          0) == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_cache_metrics(apr_pool_t *pool)
+{
+  svn_cache__t *cache1, *cache2;
+  svn_revnum_t answer = 42;
+  svn_revnum_t *value;
+  svn_boolean_t found;
+  apr_array_header_t *metrics;
+  const svn_cache__metrics_info_t *info = NULL;
+  svn_string_t *text;
+  apr_uint64_t timed = 0;
+  int i;
+
+  SVN_ERR(svn_cache__create_inprocess(&cache1, serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING, 1, 1, TRUE,
+                                      "cache1", pool));
+  SVN_ERR(svn_cache__create_inprocess(&cache2, serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING, 1, 1, TRUE,
+                                      "cache2", pool));
+
+  /* Registration is a no-op unless metrics have been enabled. */
+  SVN_ERR(svn_cache__enable_metrics(cache1, "test:disabled", pool));
+
+  /* Both caches contribute to the same record. */
+  svn_cache__config_set_metrics(TRUE);
+  SVN_ERR(svn_cache__enable_metrics(cache1, "test:metrics", pool));
+  SVN_ERR(svn_cache__enable_metrics(cache2, "test:metrics", pool));
+  svn_cache__config_set_metrics(FALSE);
+  svn_cache__config_set_latency_tracking(TRUE);
+
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache1, "answer", pool));
+  SVN_ERR(svn_cache__set(cache1, "answer", &answer, pool));
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache1, "answer", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_ERR(svn_cache__set(cache2, "answer", &answer, pool));
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache2, "answer", pool));
+  SVN_TEST_ASSERT(found);
+
+  svn_cache__config_set_latency_tracking(FALSE);
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache2, "answer", pool));
+
+  SVN_ERR(svn_cache__get_metrics(&metrics, pool));
+  for (i = 0; i < metrics->nelts; ++i)
+    {
+      const svn_cache__metrics_info_t *candidate
+        = APR_ARRAY_IDX(metrics, i, const svn_cache__metrics_info_t *);
+      if (strcmp(candidate->name, "test:metrics") == 0)
+        info = candidate;
+      SVN_TEST_ASSERT(strcmp(candidate->name, "test:disabled") != 0);
+    }
+
+  SVN_TEST_ASSERT(info);
+  SVN_TEST_ASSERT(info->gets == 4);
+  SVN_TEST_ASSERT(info->hits == 3);
+  SVN_TEST_ASSERT(info->sets == 2);
+  SVN_TEST_ASSERT(info->failures == 0);
+
+  /* Only the lookups while tracking was enabled have been timed. */
+  for (i = 0; i < SVN_CACHE__LATENCY_BUCKETS; ++i)
+    timed += info->latency[i];
+  SVN_TEST_ASSERT(timed == 3);
+
+  SVN_ERR(svn_cache__format_metrics(&text, pool, pool));
+  SVN_TEST_ASSERT(strstr(text->data,
+                         "svn_cache_gets_total{cache=\"test:metrics\"} 4\n"));
+  SVN_TEST_ASSERT(strstr(text->data,
+                         "svn_cache_lookup_duration_microseconds_count"
+                         "{cache=\"test:metrics\"} 3\n"));
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -616,6 +1597,24 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_OPTS_PASS(test_membuffer_cache_tinylfu,
+                       "scan resistance of TinyLFU admission"),
+    SVN_TEST_OPTS_SKIP(test_membuffer_cache_concurrent_reads,
+                       ! APR_HAS_THREADS,
+                       "concurrent membuffer cache reads"),
+    SVN_TEST_SKIP2(test_membuffer_cache_concurrent_writes,
+                   ! APR_HAS_THREADS,
+                   "lock-free reads during cache evictions"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared,
+                   "membuffer cache shared across processes"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared_owner_death,
+                   "shared membuffer cache survives dead lock owners"),
+    SVN_TEST_PASS2(test_membuffer_cache_snapshot,
+                   "save and restore membuffer cache contents"),
+    SVN_TEST_PASS2(test_membuffer_partial_view,
+                   "in-place access to membuffer cache items"),
+    SVN_TEST_PASS2(test_cache_metrics,
+                   "process-wide cache access metrics"),
     SVN_TEST_NULL
   };
 
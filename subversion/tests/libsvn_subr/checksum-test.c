@@ -21,12 +21,20 @@
  * ====================================================================
  */
 
+#include <stdio.h>
+
 #include <apr_pools.h>
+#include <apr_sha1.h>
+#include <apr_time.h>
 
 #include <zlib.h>
 
 #include "svn_error.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
+
+#include "private/svn_subr_private.h"
+#include "../../libsvn_subr/sha1.h"
 
 #include "../svn_test.h"
 
@@ -364,6 +372,170 @@ test_checksummed_stream_reset(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Fill the LEN bytes at BUFFER with pseudo-random data.
+ */
+static void
+fill_random(unsigned char *buffer, apr_size_t len)
+{
+  apr_uint32_t seed = 0x12345678;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      buffer[i] = (unsigned char)(seed >> 16);
+    }
+}
+
+/* Verify that the SHA1 checksum calculated with svn_checksum() and
+ * CHUNK_SIZE sized svn_checksum_update() calls over the first LEN bytes
+ * of DATA match the one calculated by APR.
+ */
+static svn_error_t *
+verify_sha1(const unsigned char *data,
+            apr_size_t len,
+            apr_size_t chunk_size,
+            apr_pool_t *pool)
+{
+  apr_sha1_ctx_t apr_ctx;
+  svn_checksum_ctx_t *ctx;
+  svn_checksum_t *expected, *actual;
+  apr_size_t offset;
+
+  expected = svn_checksum_create(svn_checksum_sha1, pool);
+  apr_sha1_init(&apr_ctx);
+  apr_sha1_update_binary(&apr_ctx, data, (unsigned int)len);
+  apr_sha1_final((unsigned char *)expected->digest, &apr_ctx);
+
+  SVN_ERR(svn_checksum(&actual, svn_checksum_sha1, data, len, pool));
+  if (!svn_checksum_match(expected, actual))
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "SHA1 mismatch for %lu bytes",
+                             (unsigned long)len);
+
+  ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+  for (offset = 0; offset < len; offset += chunk_size)
+    SVN_ERR(svn_checksum_update(ctx, data + offset,
+                                MIN(chunk_size, len - offset)));
+  SVN_ERR(svn_checksum_final(&actual, ctx, pool));
+  if (!svn_checksum_match(expected, actual))
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "SHA1 mismatch for %lu bytes in %lu byte chunks",
+                             (unsigned long)len, (unsigned long)chunk_size);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sha1_implementation(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 1000 };
+  static const apr_size_t chunk_sizes[] = { 1, 3, 63, 64, 65, 200 };
+  unsigned char data[DATA_SIZE];
+  svn_checksum_t *checksum;
+  apr_size_t len;
+  int i;
+
+  /* FIPS 180-2 test vector */
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, "abc", 3, pool));
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring(checksum, pool),
+                         "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+  /* Cover all padding variants and block boundaries. */
+  fill_random(data, sizeof(data));
+  for (len = 0; len <= DATA_SIZE; len += (len < 200 ? 1 : 97))
+    for (i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++i)
+      SVN_ERR(verify_sha1(data, len, chunk_sizes[i], pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_checksum_update_pair(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 100000 };
+  unsigned char *data = apr_palloc(pool, DATA_SIZE);
+  svn_checksum_ctx_t *md5_ctx, *sha1_ctx;
+  svn_checksum_t *expected, *actual;
+
+  fill_random(data, DATA_SIZE);
+
+  md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+  SVN_ERR(svn_checksum__update_pair(md5_ctx, sha1_ctx, data, 1));
+  SVN_ERR(svn_checksum__update_pair(md5_ctx, sha1_ctx, data + 1,
+                                    DATA_SIZE - 1));
+
+  SVN_ERR(svn_checksum(&expected, svn_checksum_md5, data, DATA_SIZE, pool));
+  SVN_ERR(svn_checksum_final(&actual, md5_ctx, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+  SVN_ERR(svn_checksum(&expected, svn_checksum_sha1, data, DATA_SIZE, pool));
+  SVN_ERR(svn_checksum_final(&actual, sha1_ctx, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+  /* A missing context is simply skipped. */
+  SVN_ERR(svn_checksum_ctx_reset(sha1_ctx));
+  SVN_ERR(svn_checksum__update_pair(NULL, sha1_ctx, data, DATA_SIZE));
+  SVN_ERR(svn_checksum_final(&actual, sha1_ctx, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the throughput in MB/s for processing LEN bytes in DURATION.
+ */
+static double
+throughput(apr_size_t len, apr_interval_time_t duration)
+{
+  return duration ? (double)len / (double)duration : 0.0;
+}
+
+static svn_error_t *
+test_checksum_throughput(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 0x1000000 };
+  unsigned char *data = apr_palloc(pool, DATA_SIZE);
+  apr_sha1_ctx_t apr_ctx;
+  svn_checksum_ctx_t *md5_ctx, *sha1_ctx;
+  svn_checksum_t *expected, *actual;
+  apr_time_t start, apr_sha1_time, sha1_time, md5_time, pair_time;
+
+  fill_random(data, DATA_SIZE);
+
+  start = apr_time_now();
+  expected = svn_checksum_create(svn_checksum_sha1, pool);
+  apr_sha1_init(&apr_ctx);
+  apr_sha1_update_binary(&apr_ctx, data, DATA_SIZE);
+  apr_sha1_final((unsigned char *)expected->digest, &apr_ctx);
+  apr_sha1_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  SVN_ERR(svn_checksum(&actual, svn_checksum_sha1, data, DATA_SIZE, pool));
+  sha1_time = apr_time_now() - start;
+  SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+  start = apr_time_now();
+  SVN_ERR(svn_checksum(&actual, svn_checksum_md5, data, DATA_SIZE, pool));
+  md5_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+  SVN_ERR(svn_checksum__update_pair(md5_ctx, sha1_ctx, data, DATA_SIZE));
+  SVN_ERR(svn_checksum_final(&actual, sha1_ctx, pool));
+  pair_time = apr_time_now() - start;
+  SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+  printf("SHA1 implementation: %s\n", svn_sha1__implementation());
+  printf("APR SHA1:  %8.1f MB/s\n", throughput(DATA_SIZE, apr_sha1_time));
+  printf("SHA1:      %8.1f MB/s\n", throughput(DATA_SIZE, sha1_time));
+  printf("MD5:       %8.1f MB/s\n", throughput(DATA_SIZE, md5_time));
+  printf("MD5+SHA1:  %8.1f MB/s\n", throughput(DATA_SIZE, pair_time));
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -389,6 +561,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "read from checksummed stream"),
     SVN_TEST_PASS2(test_checksummed_stream_reset,
                    "reset checksummed stream"),
+    SVN_TEST_PASS2(test_sha1_implementation,
+                   "SHA1 against APR's implementation"),
+    SVN_TEST_PASS2(test_checksum_update_pair,
+                   "update two checksums in one pass"),
+    SVN_TEST_SKIP2(test_checksum_throughput, TRUE,
+                   "optional checksum performance test"),
     SVN_TEST_NULL
   };
 
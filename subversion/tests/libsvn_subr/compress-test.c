@@ -76,6 +76,48 @@ test_compress_lz4_empty(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_compress_zstd(apr_pool_t *pool)
+{
+  const char input[] =
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb"
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb"
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb";
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+
+  if (!svn__zstd_available())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Zstandard support not compiled in");
+
+  SVN_ERR(svn__compress_zstd(input, sizeof(input), compressed,
+                             SVN__ZSTD_DEFAULT_LEVEL, NULL));
+  SVN_TEST_ASSERT(compressed->len < sizeof(input));
+  SVN_ERR(svn__decompress_zstd(compressed->data, compressed->len,
+                               decompressed, 100, NULL));
+  SVN_TEST_STRING_ASSERT(decompressed->data, input);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_compress_zstd_empty(apr_pool_t *pool)
+{
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+
+  if (!svn__zstd_available())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Zstandard support not compiled in");
+
+  SVN_ERR(svn__compress_zstd("", 0, compressed, 1, NULL));
+  SVN_ERR(svn__decompress_zstd(compressed->data, compressed->len,
+                               decompressed, 100, NULL));
+  SVN_TEST_STRING_ASSERT(decompressed->data, "");
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = -1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -87,6 +129,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                  "test svn__compress_lz4()"),
   SVN_TEST_PASS2(test_compress_lz4_empty,
                  "test svn__compress_lz4() with empty input"),
+  SVN_TEST_PASS2(test_compress_zstd,
+                 "test svn__compress_zstd()"),
+  SVN_TEST_PASS2(test_compress_zstd_empty,
+                 "test svn__compress_zstd() with empty input"),
   SVN_TEST_NULL
 };
 
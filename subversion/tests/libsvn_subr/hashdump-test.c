@@ -36,6 +36,8 @@
 #include "svn_error.h"
 #include "svn_hash.h"
 
+#include "private/svn_subr_private.h"
+
 
 /* Our own global variables */
 static apr_hash_t *proplist, *new_proplist;
@@ -230,6 +232,107 @@ read_hash_buffered_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_hash__entry_func_t.  Apply ENTRY to the apr_hash_t
+ * BATON, using copies of the key and value allocated in the hash's pool.
+ */
+static svn_error_t *
+apply_entry(void *baton,
+            svn_hash__entry_t *entry,
+            apr_pool_t *scratch_pool)
+{
+  apr_hash_t *ht = baton;
+  apr_pool_t *pool = apr_hash_pool_get(ht);
+
+  if (entry->val)
+    apr_hash_set(ht, apr_pstrmemdup(pool, entry->key, entry->keylen),
+                 entry->keylen,
+                 svn_string_ncreate(entry->val, entry->vallen, pool));
+  else
+    apr_hash_set(ht, entry->key, entry->keylen, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+parse_hash_in_place_test(apr_pool_t *pool)
+{
+  apr_hash_t *ht = apr_hash_make(pool);
+  apr_hash_t *changed;
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(buf, pool);
+  svn_hash__entry_t entry;
+  char *data;
+  const char *end;
+
+  /* A key with an embedded newline, an empty value and a value with
+   * an embedded NUL. */
+  svn_hash_sets(ht, "key1", svn_string_create("value1", pool));
+  svn_hash_sets(ht, "key\n2", svn_string_create("value2", pool));
+  svn_hash_sets(ht, "key3", svn_string_create("", pool));
+  svn_hash_sets(ht, "key4", svn_string_ncreate("val\0ue4", 7, pool));
+  SVN_ERR(svn_hash_write2(ht, stream, SVN_HASH_TERMINATOR, pool));
+
+  /* Follow it by some increments. */
+  changed = apr_hash_copy(pool, ht);
+  svn_hash_sets(changed, "key1", NULL);
+  svn_hash_sets(changed, "key3", svn_string_create("value3", pool));
+  svn_hash_sets(changed, "key5", svn_string_create("value5", pool));
+  SVN_ERR(svn_hash_write_incremental(changed, ht, stream, NULL, pool));
+
+  /* The first entry is parsed in place. */
+  data = buf->data;
+  end = buf->data + buf->len;
+  SVN_ERR(svn_hash__parse_entry(&entry, &data, end, SVN_HASH_TERMINATOR,
+                                FALSE));
+  SVN_TEST_ASSERT(entry.key > buf->data && entry.key < end);
+  SVN_TEST_ASSERT(entry.val > entry.key && entry.val < end);
+  SVN_TEST_ASSERT(entry.key[entry.keylen] == '\0');
+  SVN_TEST_ASSERT(entry.val[entry.vallen] == '\0');
+
+  /* Parse the rest, then the increments. */
+  ht = apr_hash_make(pool);
+  SVN_ERR(apply_entry(ht, &entry, pool));
+  SVN_ERR(svn_hash__parse(&data, end, SVN_HASH_TERMINATOR, FALSE,
+                          apply_entry, ht, pool));
+  SVN_TEST_ASSERT(apr_hash_count(ht) == 4);
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key\n2"), "value2");
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key3"), "");
+  SVN_TEST_ASSERT(svn_string_compare(svn_hash_gets(ht, "key4"),
+                             svn_string_ncreate("val\0ue4", 7, pool)));
+
+  SVN_ERR(svn_hash__parse(&data, end, NULL, TRUE, apply_entry, ht, pool));
+  SVN_TEST_ASSERT(data == end);
+  SVN_TEST_ASSERT(apr_hash_count(ht) == 4);
+  SVN_TEST_ASSERT(hash_gets_stringt(ht, "key1") == NULL);
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key3"), "value3");
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key5"), "value5");
+
+  /* Truncated or unterminated data must be detected. */
+  buf = svn_stringbuf_create("K 4\nkey1\nV 6\nval", pool);
+  data = buf->data;
+  SVN_TEST_ASSERT_ERROR(svn_hash__parse(&data, buf->data + buf->len,
+                                        SVN_HASH_TERMINATOR, FALSE,
+                                        apply_entry, ht, pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  buf = svn_stringbuf_create("K 4\nkey1\nV 6\nvalue1\n", pool);
+  data = buf->data;
+  SVN_TEST_ASSERT_ERROR(svn_hash__parse(&data, buf->data + buf->len,
+                                        SVN_HASH_TERMINATOR, FALSE,
+                                        apply_entry, ht, pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  /* Deletions are only allowed in incremental mode. */
+  buf = svn_stringbuf_create("D 4\nkey1\nEND\n", pool);
+  data = buf->data;
+  SVN_TEST_ASSERT_ERROR(svn_hash__parse(&data, buf->data + buf->len,
+                                        SVN_HASH_TERMINATOR, FALSE,
+                                        apply_entry, ht, pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
 
 /*
    ====================================================================
@@ -252,6 +355,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "write hash out, read back in, compare"),
     SVN_TEST_PASS2(read_hash_buffered_test,
                    "read hash from buffered file"),
+    SVN_TEST_PASS2(parse_hash_in_place_test,
+                   "parse hash in memory"),
     SVN_TEST_NULL
   };
 
@@ -25,6 +25,7 @@
 #include <string.h>
 #include <apr_hash.h>
 #include <apr_tables.h>
+#include <apr_time.h>
 
 #define SVN_DEPRECATED
 
@@ -2480,6 +2481,87 @@ test_mergeinfo_merge_random_non_validated_inputs(apr_pool_t *pool)
 
   return SVN_NO_ERROR;
 }
+
+/* Merge many small changes into a rangelist with a large number of ranges
+ * and intersect small rangelists with it.  With -v, use a ten times larger
+ * rangelist and report timings. */
+static svn_error_t *
+test_rangelist_large_merge_intersect(const svn_test_opts_t *opts,
+                                     apr_pool_t *pool)
+{
+  const int size = opts->verbose ? 50000 : 5000;
+  const int changes = size / 10;
+  const int stride = size / changes;
+  svn_rangelist_t *rangelist
+    = apr_array_make(pool, size, sizeof(svn_merge_range_t *));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start;
+  apr_time_t merge_duration, intersect_duration;
+  int i;
+
+  /* r1, r3, r5, ... i.e. SIZE ranges with gaps. */
+  for (i = 0; i < size; i++)
+    {
+      svn_merge_range_t *range = apr_pcalloc(pool, sizeof(*range));
+
+      range->start = 2 * i;
+      range->end = 2 * i + 1;
+      range->inheritable = TRUE;
+      APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = range;
+    }
+
+  /* Fill every STRIDE-th gap, in a scattered order. */
+  start = apr_time_now();
+  for (i = 0; i < changes; i++)
+    {
+      int k = ((i * 7919) % changes) * stride;
+      svn_rangelist_t *change;
+
+      svn_pool_clear(iterpool);
+      change = svn_rangelist__initialize(2 * k + 1, 2 * k + 2, TRUE,
+                                         iterpool);
+      SVN_ERR(svn_rangelist_merge2(rangelist, change, pool, iterpool));
+    }
+  merge_duration = apr_time_now() - start;
+
+  SVN_TEST_INT_ASSERT(rangelist->nelts, size - changes);
+  SVN_TEST_ASSERT(svn_rangelist__is_canonical(rangelist));
+
+  /* Filled gaps intersect, the ones in between don't. */
+  start = apr_time_now();
+  for (i = 0; i < changes; i++)
+    {
+      int k = i * stride;
+      svn_rangelist_t *filled, *empty, *intersection;
+
+      svn_pool_clear(iterpool);
+      filled = svn_rangelist__initialize(2 * k + 1, 2 * k + 2, TRUE,
+                                         iterpool);
+      empty = svn_rangelist__initialize(2 * (k + stride / 2) + 1,
+                                        2 * (k + stride / 2) + 2, TRUE,
+                                        iterpool);
+
+      SVN_ERR(svn_rangelist_intersect(&intersection, filled, rangelist,
+                                      TRUE, iterpool));
+      SVN_TEST_INT_ASSERT(intersection->nelts, 1);
+      SVN_ERR(svn_rangelist_intersect(&intersection, rangelist, empty,
+                                      TRUE, iterpool));
+      SVN_TEST_INT_ASSERT(intersection->nelts, 0);
+    }
+  intersect_duration = apr_time_now() - start;
+
+  svn_pool_destroy(iterpool);
+
+  if (opts->verbose)
+    {
+      printf("%d merges:     %.3f s\n", changes, merge_duration / 1e6);
+      printf("%d intersects: %.3f s\n", 2 * changes,
+             intersect_duration / 1e6);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -2540,6 +2622,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test rangelist merge random non-validated inputs"),
     SVN_TEST_PASS2(test_mergeinfo_merge_random_non_validated_inputs,
                    "test mergeinfo merge random non-validated inputs"),
+    SVN_TEST_OPTS_PASS(test_rangelist_large_merge_intersect,
+                       "merge and intersect with a large rangelist"),
     SVN_TEST_NULL
   };
 
@@ -31,11 +31,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <apr_pools.h>
+#include <apr_time.h>
 
 #include "../svn_test.h"
 
 #include "svn_error.h"
 #include "svn_string.h"   /* This includes <apr_*.h> */
+#include "svn_sorts.h"
 #include "private/svn_packed_data.h"
 
 /* Take the WRITE_ROOT, serialize its contents, parse it again into a new
@@ -553,6 +555,155 @@ test_full_structure(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return a pseudo-random 64 bit value based on *STATE and update it.
+ * Like real-world data, most values will be small.
+ */
+static apr_uint64_t
+next_value(apr_uint64_t *state)
+{
+  apr_uint64_t value;
+
+  *state = *state * APR_UINT64_C(6364136223846793005)
+         + APR_UINT64_C(1442695040888963407);
+  value = *state >> 11;
+
+  switch ((*state >> 60) & 0xf)
+    {
+      case 0:  return value;
+      case 1:
+      case 2:  return value & 0xffffff;
+      case 3:
+      case 4:  return value & 0x3fff;
+      default: return value & 0x7f;
+    }
+}
+
+/* Write COUNT pseudo-random values to a new stream configured with DIFF
+ * and SIGNED_INTS, serialize it and return the stream to read from in
+ * *STREAM.  Return the values that were written in *VALUES.  Allocate
+ * everything in POOL.
+ */
+static svn_error_t *
+create_random_stream(svn_packed__int_stream_t **stream,
+                     apr_uint64_t **values,
+                     apr_size_t count,
+                     svn_boolean_t diff,
+                     svn_boolean_t signed_ints,
+                     apr_pool_t *pool)
+{
+  svn_packed__data_root_t *root = svn_packed__data_create_root(pool);
+  svn_packed__int_stream_t *write_stream
+    = svn_packed__create_int_stream(root, diff, signed_ints);
+  apr_uint64_t state = count;
+  apr_size_t i;
+
+  *values = apr_palloc(pool, count * sizeof(**values));
+  for (i = 0; i < count; ++i)
+    {
+      (*values)[i] = next_value(&state);
+      svn_packed__add_uint(write_stream, (*values)[i]);
+    }
+
+  SVN_ERR(get_read_root(&root, root, pool));
+  *stream = svn_packed__first_int_stream(root);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_bulk_uint_stream(apr_pool_t *pool)
+{
+  enum { COUNT = 10000 };
+  int mode;
+
+  for (mode = 0; mode < 4; ++mode)
+    {
+      svn_packed__int_stream_t *stream;
+      apr_uint64_t *values;
+      apr_uint64_t buffer[100];
+      apr_size_t i = 0;
+      apr_size_t chunk = 1;
+
+      SVN_ERR(create_random_stream(&stream, &values, COUNT,
+                                   (mode & 1) != 0, (mode & 2) != 0,
+                                   pool));
+      SVN_TEST_ASSERT(svn_packed__int_count(stream) == COUNT);
+
+      /* Mix single and bulk reads of varying sizes. */
+      while (i < COUNT)
+        {
+          apr_size_t k, read;
+
+          SVN_TEST_ASSERT(svn_packed__get_uint(stream) == values[i++]);
+
+          read = svn_packed__get_uints(stream, buffer,
+                                       MIN(chunk, COUNT - i));
+          SVN_TEST_ASSERT(read == MIN(chunk, COUNT - i));
+          for (k = 0; k < read; ++k)
+            SVN_TEST_ASSERT(buffer[k] == values[i++]);
+
+          chunk = (chunk * 7 + 3) % 100;
+        }
+
+      /* reading beyond eos should not return any values */
+      SVN_TEST_ASSERT(svn_packed__get_uints(stream, buffer, 10) == 0);
+      SVN_TEST_ASSERT(svn_packed__get_uint(stream) == 0);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of values per second for processing COUNT values in
+ * DURATION.
+ */
+static double
+values_per_second(apr_size_t count, apr_interval_time_t duration)
+{
+  return duration ? (double)count * APR_USEC_PER_SEC / (double)duration
+                  : 0.0;
+}
+
+static svn_error_t *
+test_packed_uint_throughput(apr_pool_t *pool)
+{
+  enum { COUNT = 0x400000, CHUNK = 1024 };
+  svn_packed__int_stream_t *stream;
+  apr_uint64_t *values;
+  apr_uint64_t *buffer = apr_palloc(pool, CHUNK * sizeof(*buffer));
+  apr_uint64_t sum = 0;
+  apr_uint64_t expected = 0;
+  apr_time_t start, single_time, bulk_time;
+  apr_size_t i, read;
+
+  SVN_ERR(create_random_stream(&stream, &values, COUNT, FALSE, FALSE,
+                               pool));
+  for (i = 0; i < COUNT; ++i)
+    expected += values[i];
+
+  start = apr_time_now();
+  for (i = 0; i < COUNT; ++i)
+    sum += svn_packed__get_uint(stream);
+  single_time = apr_time_now() - start;
+  SVN_TEST_ASSERT(sum == expected);
+
+  SVN_ERR(create_random_stream(&stream, &values, COUNT, FALSE, FALSE,
+                               pool));
+
+  sum = 0;
+  start = apr_time_now();
+  while ((read = svn_packed__get_uints(stream, buffer, CHUNK)))
+    for (i = 0; i < read; ++i)
+      sum += buffer[i];
+  bulk_time = apr_time_now() - start;
+  SVN_TEST_ASSERT(sum == expected);
+
+  printf("get_uint: %8.1f Mvalues/s  get_uints: %8.1f Mvalues/s\n",
+         values_per_second(COUNT, single_time) / 1e6,
+         values_per_second(COUNT, bulk_time) / 1e6);
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -572,6 +723,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test empty, nested structure"),
     SVN_TEST_PASS2(test_full_structure,
                    "test nested structure"),
+    SVN_TEST_PASS2(test_bulk_uint_stream,
+                   "test bulk reading of uints"),
+    SVN_TEST_SKIP2(test_packed_uint_throughput, TRUE,
+                   "optional uint decoding performance test"),
     SVN_TEST_NULL
   };
 
@@ -32,7 +32,10 @@
 #include <string.h>
 #include <apr_general.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_sorts_private.h"
 
 #include "../svn_test.h"
 
@@ -1106,6 +1109,72 @@ test_compare_paths(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return a random canonical relpath with up to 4 segments, made of chars
+ * that sort before and after '/'. */
+static const char *
+random_path(apr_uint32_t *seed,
+            apr_pool_t *pool)
+{
+  static const char chars[] = "-+ab~";
+  char *path = apr_palloc(pool, 4 * 4);
+  int segments = 1 + svn_test_rand(seed) % 4;
+  int len = 0;
+  int i, k;
+
+  for (i = 0; i < segments; ++i)
+    {
+      int seg_len = 1 + svn_test_rand(seed) % 3;
+
+      if (i)
+        path[len++] = '/';
+      for (k = 0; k < seg_len; ++k)
+        path[len++] = chars[svn_test_rand(seed) % (sizeof(chars) - 1)];
+    }
+
+  path[len] = '\0';
+  return path;
+}
+
+static svn_error_t *
+test_sort_paths(apr_pool_t *pool)
+{
+  apr_hash_t *hash = apr_hash_make(pool);
+  apr_array_header_t *paths = apr_array_make(pool, 0, sizeof(const char *));
+  apr_array_header_t *sorted;
+  apr_uint32_t seed = 0;
+  int i;
+
+  /* Enough paths to trigger radix sorting, with lots of duplicates. */
+  for (i = 0; i < 10000; ++i)
+    {
+      const char *path = random_path(&seed, pool);
+
+      svn_hash_sets(hash, path, path);
+      APR_ARRAY_PUSH(paths, const char *) = path;
+    }
+
+  sorted = svn_sort__hash(hash, svn_sort_compare_items_as_paths, pool);
+  SVN_TEST_INT_ASSERT(sorted->nelts, apr_hash_count(hash));
+  for (i = 1; i < sorted->nelts; ++i)
+    SVN_TEST_ASSERT(svn_sort_compare_items_as_paths(
+                      &APR_ARRAY_IDX(sorted, i - 1, svn_sort__item_t),
+                      &APR_ARRAY_IDX(sorted, i, svn_sort__item_t)) < 0);
+
+  sorted = svn_sort__hash(hash, svn_sort_compare_items_lexically, pool);
+  for (i = 1; i < sorted->nelts; ++i)
+    SVN_TEST_ASSERT(svn_sort_compare_items_lexically(
+                      &APR_ARRAY_IDX(sorted, i - 1, svn_sort__item_t),
+                      &APR_ARRAY_IDX(sorted, i, svn_sort__item_t)) < 0);
+
+  svn_sort__array(paths, svn_sort_compare_paths);
+  for (i = 1; i < paths->nelts; ++i)
+    SVN_TEST_ASSERT(svn_path_compare_paths(
+                      APR_ARRAY_IDX(paths, i - 1, const char *),
+                      APR_ARRAY_IDX(paths, i, const char *)) <= 0);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_path_get_longest_ancestor(apr_pool_t *pool)
 {
@@ -1742,6 +1811,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_path_is_single_path_component"),
     SVN_TEST_PASS2(test_compare_paths,
                    "test svn_path_compare_paths"),
+    SVN_TEST_PASS2(test_sort_paths,
+                   "test sorting many paths"),
     SVN_TEST_PASS2(test_path_get_longest_ancestor,
                    "test svn_path_get_longest_ancestor"),
     SVN_TEST_PASS2(test_path_splitext,
@@ -25,6 +25,8 @@
 #include <apr_thread_proc.h>
 #include <apr_thread_cond.h>
 
+#include "svn_pools.h"
+
 #include "private/svn_atomic.h"
 #include "private/svn_subr_private.h"
 
@@ -118,6 +120,199 @@ test_root_pool_concurrency(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* acquire, use, release and re-acquire scratch pools for PARENT in
+   various orders */
+static svn_error_t *
+test_scratch_pool(apr_pool_t *pool)
+{
+  apr_pool_t *parent = svn_pool_create(pool);
+  apr_pool_t *scratch, *nested, *other;
+
+  /* released pools get recycled */
+  scratch = svn_pool__acquire_scratch(parent);
+  do_some_allocations(scratch);
+  svn_pool__release_scratch(scratch);
+  SVN_TEST_ASSERT(svn_pool__acquire_scratch(parent) == scratch);
+
+  /* pools in use are never handed out twice */
+  other = svn_pool__acquire_scratch(parent);
+  SVN_TEST_ASSERT(other != scratch);
+
+  /* scratch pools may be parents of other scratch pools */
+  nested = svn_pool__acquire_scratch(scratch);
+  SVN_TEST_ASSERT(nested != scratch && nested != other);
+  do_some_allocations(nested);
+
+  /* releasing out of order is fine and takes nested pools with it */
+  svn_pool__release_scratch(scratch);
+  svn_pool__release_scratch(other);
+
+  /* clearing the parent releases its scratch pools */
+  scratch = svn_pool__acquire_scratch(parent);
+  nested = svn_pool__acquire_scratch(scratch);
+  other = svn_pool__acquire_scratch(parent);
+  do_some_allocations(nested);
+  svn_pool_clear(parent);
+
+  /* so does destroying it */
+  scratch = svn_pool__acquire_scratch(parent);
+  do_some_allocations(scratch);
+  svn_pool_destroy(parent);
+
+  /* pools not acquired as scratch pools simply get destroyed */
+  svn_pool__release_scratch(svn_pool_create(pool));
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+/* acquire, use and release scratch pools in a separate thread */
+static void *
+APR_THREAD_FUNC scratch_thread_func(apr_thread_t *tid, void *data)
+{
+  apr_pool_t *parent = svn_pool_create(NULL);
+  int i;
+
+  apr_thread_yield();
+
+  for (i = 0; i < 1000; ++i)
+    {
+      apr_pool_t *scratch = svn_pool__acquire_scratch(parent);
+      apr_pool_t *nested = svn_pool__acquire_scratch(scratch);
+      do_some_allocations(nested);
+      if (i % 2)
+        svn_pool__release_scratch(scratch);
+      else
+        svn_pool_clear(parent);
+    }
+
+  svn_pool_destroy(parent);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+#endif
+
+#if APR_HAS_THREADS
+/* clear the parent pool given as DATA in a separate thread */
+static void *
+APR_THREAD_FUNC clear_parent_thread_func(apr_thread_t *tid, void *data)
+{
+  svn_pool_clear(data);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+#endif
+
+/* release scratch pools by clearing their parent in another thread */
+static svn_error_t *
+test_scratch_pool_foreign_release(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  apr_pool_t *parent = svn_pool_create(pool);
+  apr_pool_t *scratch, *nested;
+  apr_thread_t *thread;
+  apr_status_t retval;
+
+  scratch = svn_pool__acquire_scratch(parent);
+  nested = svn_pool__acquire_scratch(scratch);
+  do_some_allocations(nested);
+
+  /* the other thread must not put our pools into its own cache */
+  APR_ERR(apr_thread_create(&thread, NULL, clear_parent_thread_func,
+                            parent, pool));
+  APR_ERR(apr_thread_join(&retval, thread));
+  APR_ERR(retval);
+
+  /* our own cache is still intact and keeps recycling */
+  scratch = svn_pool__acquire_scratch(parent);
+  do_some_allocations(scratch);
+  svn_pool__release_scratch(scratch);
+  SVN_TEST_ASSERT(svn_pool__acquire_scratch(parent) == scratch);
+
+  svn_pool_destroy(parent);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_scratch_pool_concurrency(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  enum { THREAD_COUNT = 10 };
+  apr_thread_t *threads[THREAD_COUNT];
+  int i;
+
+  for (i = 0; i < THREAD_COUNT; ++i)
+    APR_ERR(apr_thread_create(&threads[i], NULL, scratch_thread_func, NULL,
+                              pool));
+
+  /* wait for the threads to finish */
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      apr_status_t retval;
+      APR_ERR(apr_thread_join(&retval, threads[i]));
+      APR_ERR(retval);
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* do the handful of small allocations typical for a loop iteration
+   from POOL and return their number */
+static int
+do_small_allocations(apr_pool_t *pool)
+{
+  int i;
+  for (i = 0; i < 16; ++i)
+    apr_palloc(pool, 16 + 24 * i);
+
+  return i;
+}
+
+/* compare short-lived sub-pools with recycled scratch pools */
+static svn_error_t *
+test_scratch_pool_performance(apr_pool_t *pool)
+{
+  enum { ITERATIONS = 200000 };
+  apr_pool_t *parent = svn_pool_create(pool);
+  apr_time_t start, subpool_time, scratch_time;
+  apr_int64_t allocations = 0;
+  int i;
+
+  start = apr_time_now();
+  for (i = 0; i < ITERATIONS; ++i)
+    {
+      apr_pool_t *subpool = svn_pool_create(parent);
+      allocations += do_small_allocations(subpool);
+      svn_pool_destroy(subpool);
+    }
+  subpool_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < ITERATIONS; ++i)
+    {
+      apr_pool_t *scratch = svn_pool__acquire_scratch(parent);
+      allocations += do_small_allocations(scratch);
+      svn_pool__release_scratch(scratch);
+    }
+  scratch_time = apr_time_now() - start;
+
+  printf("%" APR_INT64_T_FMT " allocations in %d pools per variant\n",
+         allocations / 2, ITERATIONS);
+  printf("sub-pools:     %6.1f ns per pool\n",
+         1000.0 * subpool_time / ITERATIONS);
+  printf("scratch pools: %6.1f ns per pool\n",
+         1000.0 * scratch_time / ITERATIONS);
+
+  svn_pool_destroy(parent);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -131,6 +326,16 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_SKIP2(test_root_pool_concurrency,
                    ! APR_HAS_THREADS,
                    "test concurrent root pool recycling"),
+    SVN_TEST_PASS2(test_scratch_pool,
+                   "test scratch pool recycling"),
+    SVN_TEST_SKIP2(test_scratch_pool_concurrency,
+                   ! APR_HAS_THREADS,
+                   "test concurrent scratch pool recycling"),
+    SVN_TEST_SKIP2(test_scratch_pool_foreign_release,
+                   ! APR_HAS_THREADS,
+                   "test scratch pool release by another thread"),
+    SVN_TEST_SKIP2(test_scratch_pool_performance, TRUE,
+                   "optional scratch pool performance test"),
     SVN_TEST_NULL
   };
 
@@ -21,6 +21,8 @@
  * ====================================================================
  */
 
+#include <apr_time.h>
+
 #include "private/svn_sqlite.h"
 #include "../svn_test.h"
 
@@ -29,6 +31,7 @@ open_db(svn_sqlite__db_t **sdb,
         const char **db_abspath_p,
         const char *db_name,
         const char *const *statements,
+        const svn_sqlite__open_options_t *options,
         apr_int32_t timeout,
         apr_pool_t *pool)
 {
@@ -41,8 +44,8 @@ open_db(svn_sqlite__db_t **sdb,
 
   db_abspath = svn_dirent_join(db_dir, db_name, pool);
 
-  SVN_ERR(svn_sqlite__open(sdb, db_abspath, svn_sqlite__mode_rwcreate,
-                           statements, 0, NULL, timeout, pool, pool));
+  SVN_ERR(svn_sqlite__open2(sdb, db_abspath, svn_sqlite__mode_rwcreate,
+                            statements, options, timeout, pool, pool));
 
   if (db_abspath_p)
     *db_abspath_p = db_abspath;
@@ -87,7 +90,7 @@ test_sqlite_reset(apr_pool_t *pool)
     NULL
   };
 
-  SVN_ERR(open_db(&sdb, NULL, "reset", statements, 0, pool));
+  SVN_ERR(open_db(&sdb, NULL, "reset", statements, NULL, 0, pool));
   SVN_ERR(svn_sqlite__create_scalar_function(sdb, "error_second",
                                              1, FALSE /* deterministic */,
                                              error_second, NULL));
@@ -141,7 +144,7 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
      SVN_ERR_SQLITE_BUSY error, and retrying for the default 10 seconds
      would be a waste of time. */
   SVN_ERR(open_db(&sdb1, &db_abspath, "txn_commit_busy",
-                  statements, 250, pool));
+                  statements, NULL, 250, pool));
   SVN_ERR(svn_sqlite__open(&sdb2, db_abspath, svn_sqlite__mode_readwrite,
                            statements, 0, NULL, 250, pool, pool));
   SVN_ERR(svn_sqlite__exec_statements(sdb1, 0));
@@ -170,6 +173,181 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_sqlite__bind_row_func_t.  Bind ROW and its name. */
+static svn_error_t *
+bind_numbered_row(svn_sqlite__stmt_t *stmt,
+                  int row,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_sqlite__bind_int(stmt, 1, row));
+  SVN_ERR(svn_sqlite__bind_text(stmt, 2,
+                                apr_psprintf(scratch_pool, "row %d", row)));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sqlite_insert_rows(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int i;
+
+  static const char *const statements[] = {
+    "CREATE TABLE rows ("
+    "    id INTEGER NOT NULL PRIMARY KEY,"
+    "    name TEXT NOT NULL,"
+    "    shared TEXT NOT NULL"
+    ")",
+
+    "INSERT INTO rows(id, name, shared) VALUES (?1, ?2, ?3)",
+
+    "SELECT id, name, shared FROM rows ORDER BY id",
+
+    NULL
+  };
+
+  SVN_ERR(open_db(&sdb, NULL, "insert_rows", statements, NULL, 0, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+
+  /* The shared value gets bound only once. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+  SVN_ERR(svn_sqlite__bind_text(stmt, 3, "shared"));
+  SVN_SQLITE__WITH_TXN(svn_sqlite__insert_rows(stmt, 100, bind_numbered_row,
+                                               NULL, pool),
+                       sdb);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 2));
+  for (i = 0; i < 100; ++i)
+    {
+      SVN_ERR(svn_sqlite__step_row(stmt));
+      SVN_TEST_INT_ASSERT(svn_sqlite__column_int(stmt, 0), i);
+      SVN_TEST_STRING_ASSERT(svn_sqlite__column_text(stmt, 1, NULL),
+                             apr_psprintf(pool, "row %d", i));
+      SVN_TEST_STRING_ASSERT(svn_sqlite__column_text(stmt, 2, NULL),
+                             "shared");
+    }
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_TEST_ASSERT(!have_row);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* Bindings must have been cleared, i.e. the NOT NULL constraint on
+     SHARED has to fail now. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+  SVN_TEST_ASSERT_ANY_ERROR(svn_sqlite__insert_rows(stmt, 1,
+                                                    bind_numbered_row,
+                                                    NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Insert COUNT rows in BATCHES transactions into the table created by
+   test_sqlite_wal_insert() in SDB.  Return the time taken in *DURATION. */
+static svn_error_t *
+insert_batches(apr_time_t *duration,
+               svn_sqlite__db_t *sdb,
+               int count,
+               int batches,
+               apr_pool_t *pool)
+{
+  apr_time_t start = apr_time_now();
+  int i;
+
+  for (i = 0; i < batches; ++i)
+    {
+      svn_sqlite__stmt_t *stmt;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+      SVN_ERR(svn_sqlite__bind_text(stmt, 3, apr_psprintf(pool, "%d", i)));
+      SVN_SQLITE__WITH_TXN(svn_sqlite__insert_rows(stmt, count / batches,
+                                                   bind_numbered_row,
+                                                   NULL, pool),
+                           sdb);
+
+      /* Make room for the next batch. */
+      SVN_ERR(svn_sqlite__exec_statements(sdb, 2));
+    }
+
+  *duration = apr_time_now() - start;
+  return SVN_NO_ERROR;
+}
+
+/* With -v, insert a hundred times more rows and report timings. */
+static svn_error_t *
+test_sqlite_wal_insert(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  const int count = opts->verbose ? 100000 : 1000;
+  const int batches = 50;
+
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  svn_sqlite__open_options_t options = { TRUE, svn_sqlite__sync_normal,
+                                         16 * 1024 * 1024 };
+  apr_time_t journal_duration;
+  apr_time_t wal_duration;
+  const char *wal_abspath;
+  svn_sqlite__mode_t mode;
+
+  static const char *const statements[] = {
+    "CREATE TABLE rows ("
+    "    id INTEGER NOT NULL PRIMARY KEY,"
+    "    name TEXT NOT NULL,"
+    "    shared TEXT NOT NULL"
+    ")",
+
+    "INSERT INTO rows(id, name, shared) VALUES (?1, ?2, ?3)",
+
+    "DELETE FROM rows",
+
+    "PRAGMA journal_mode",
+
+    NULL
+  };
+
+  /* Default rollback journal. */
+  SVN_ERR(open_db(&sdb, NULL, "journal", statements, NULL, 0, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+  SVN_ERR(insert_batches(&journal_duration, sdb, count, batches, pool));
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  /* Write-ahead log. */
+  SVN_ERR(open_db(&sdb, &wal_abspath, "wal", statements, &options, 0, pool));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 3));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  SVN_TEST_STRING_ASSERT(svn_sqlite__column_text(stmt, 0, NULL), "wal");
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+  SVN_ERR(insert_batches(&wal_duration, sdb, count, batches, pool));
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  /* Connections without the WAL option, read-only or not, must not switch
+     the database back to a rollback journal. */
+  for (mode = svn_sqlite__mode_readonly;
+       mode <= svn_sqlite__mode_readwrite;
+       ++mode)
+    {
+      SVN_ERR(svn_sqlite__open2(&sdb, wal_abspath, mode, statements, NULL, 0,
+                                pool, pool));
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 3));
+      SVN_ERR(svn_sqlite__step_row(stmt));
+      SVN_TEST_STRING_ASSERT(svn_sqlite__column_text(stmt, 0, NULL), "wal");
+      SVN_ERR(svn_sqlite__reset(stmt));
+      SVN_ERR(svn_sqlite__close(sdb));
+    }
+
+  if (opts->verbose)
+    {
+      printf("rollback journal: %.3f s\n", journal_duration / 1e6);
+      printf("write-ahead log:  %.3f s\n", wal_duration / 1e6);
+    }
+
+  return SVN_NO_ERROR;
+}
 
 static int max_threads = 1;
 
@@ -180,6 +358,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "sqlite reset"),
     SVN_TEST_PASS2(test_sqlite_txn_commit_busy,
                    "sqlite busy on transaction commit"),
+    SVN_TEST_PASS2(test_sqlite_insert_rows,
+                   "sqlite bulk insert"),
+    SVN_TEST_OPTS_PASS(test_sqlite_wal_insert,
+                       "sqlite bulk insert with write-ahead log"),
     SVN_TEST_NULL
   };
 
@@ -29,6 +29,7 @@
 #include <apr_general.h>
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -1065,6 +1066,252 @@ test_stream_readline_file_nul(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_stream_borrow(apr_pool_t *pool)
+{
+  const apr_size_t size = 5 * SVN__STREAM_CHUNK_SIZE + 123;
+  svn_stringbuf_t *data = svn_stringbuf_create_ensure(size, pool);
+  svn_string_t *str;
+  svn_stream_t *stream, *stream2;
+  svn_stringbuf_t *copy;
+  svn_checksum_t *expected, *actual;
+  svn_boolean_t same;
+  apr_file_t *file;
+  const char *path;
+  const char *borrowed;
+  apr_size_t len, total;
+
+  while (data->len < size)
+    svn_stringbuf_appendbyte(data, (char)('a' + (data->len * 7) % 26));
+  str = svn_string_create_from_buf(data, pool);
+  SVN_ERR(svn_checksum(&expected, svn_checksum_sha1, str->data, str->len,
+                       pool));
+
+  /* String streams hand out their own buffer. */
+  stream = svn_stream_from_string(str, pool);
+  SVN_TEST_ASSERT(svn_stream__supports_borrow(stream));
+  len = 10;
+  SVN_ERR(svn_stream__borrow(stream, &borrowed, &len));
+  SVN_TEST_ASSERT(len == 10 && borrowed == str->data);
+  len = size;
+  SVN_ERR(svn_stream__borrow(stream, &borrowed, &len));
+  SVN_TEST_ASSERT(len == size - 10 && borrowed == str->data + 10);
+  len = 10;
+  SVN_ERR(svn_stream__borrow(stream, &borrowed, &len));
+  SVN_TEST_ASSERT(len == 0);
+
+  /* Disowned streams forward the borrow support. */
+  stream = svn_stream_disown(svn_stream_from_string(str, pool), pool);
+  SVN_TEST_ASSERT(svn_stream__supports_borrow(stream));
+
+  /* Other streams don't support it. */
+  stream = svn_stream_from_stringbuf(data, pool);
+  SVN_TEST_ASSERT(!svn_stream__supports_borrow(stream));
+  len = 10;
+  SVN_TEST_ASSERT_ERROR(svn_stream__borrow(stream, &borrowed, &len),
+                        SVN_ERR_STREAM_NOT_SUPPORTED);
+
+  /* Write the data to a file and read it back through a mapped stream. */
+  SVN_ERR(svn_io_open_unique_file3(&file, &path, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+  SVN_ERR(svn_io_file_write_full(file, str->data, str->len, NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_stream__from_mapped_aprfile(&stream, file, pool, pool));
+  SVN_ERR(svn_stream_contents_checksum(&actual, stream, svn_checksum_sha1,
+                                       pool, pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_stream__from_mapped_aprfile(&stream, file, pool, pool));
+  if (svn_stream__supports_borrow(stream))
+    {
+      for (total = 0; ; total += len)
+        {
+          len = SVN__STREAM_CHUNK_SIZE;
+          SVN_ERR(svn_stream__borrow(stream, &borrowed, &len));
+          if (len == 0)
+            break;
+          SVN_TEST_ASSERT(memcmp(borrowed, str->data + total, len) == 0);
+        }
+      SVN_TEST_ASSERT(total == size);
+    }
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Copy and compare between mapped, string and plain file streams. */
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_stream__from_mapped_aprfile(&stream, file, pool, pool));
+  copy = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_stream_copy3(stream, svn_stream_from_stringbuf(copy, pool),
+                           NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(copy->data, str->data);
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_stream__from_mapped_aprfile(&stream, file, pool, pool));
+  SVN_ERR(svn_stream_open_readonly(&stream2, path, pool, pool));
+  SVN_ERR(svn_stream_contents_same2(&same, stream, stream2, pool));
+  SVN_TEST_ASSERT(same);
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_stream__from_mapped_aprfile(&stream, file, pool, pool));
+  copy->data[size / 2] ^= 1;
+  stream2 = svn_stream_from_string(svn_string_create_from_buf(copy, pool),
+                                   pool);
+  SVN_ERR(svn_stream_contents_same2(&same, stream, stream2, pool));
+  SVN_TEST_ASSERT(!same);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the base64 encoding of the LEN bytes at DATA, as produced by a
+ * straightforward implementation of RFC 4648 plus our line breaking rules.
+ */
+static svn_stringbuf_t *
+reference_base64(const unsigned char *data,
+                 apr_size_t len,
+                 svn_boolean_t break_lines,
+                 apr_pool_t *pool)
+{
+  static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                              "abcdefghijklmnopqrstuvwxyz0123456789+/";
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  apr_size_t i, linelen = 0;
+
+  for (i = 0; i < len; i += 3)
+    {
+      apr_size_t count = len - i < 3 ? len - i : 3;
+      apr_uint32_t group = (apr_uint32_t)data[i] << 16;
+      if (count > 1)
+        group |= (apr_uint32_t)data[i + 1] << 8;
+      if (count > 2)
+        group |= data[i + 2];
+
+      svn_stringbuf_appendbyte(result, chars[(group >> 18) & 0x3f]);
+      svn_stringbuf_appendbyte(result, chars[(group >> 12) & 0x3f]);
+      svn_stringbuf_appendbyte(result,
+                               count > 1 ? chars[(group >> 6) & 0x3f] : '=');
+      svn_stringbuf_appendbyte(result, count > 2 ? chars[group & 0x3f] : '=');
+
+      linelen += 4;
+      if (break_lines && linelen == 76)
+        {
+          svn_stringbuf_appendbyte(result, '\n');
+          linelen = 0;
+        }
+    }
+
+  if (break_lines && linelen > 0)
+    svn_stringbuf_appendbyte(result, '\n');
+
+  return result;
+}
+
+/* Fill the LEN bytes at BUFFER with pseudo-random data.
+ */
+static void
+fill_random(unsigned char *buffer, apr_size_t len)
+{
+  apr_uint32_t seed = 0x12345678;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    buffer[i] = (unsigned char)svn_test_rand(&seed);
+}
+
+static svn_error_t *
+test_base64_reference(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 1000 };
+  unsigned char data[DATA_SIZE];
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t len, i;
+
+  fill_random(data, sizeof(data));
+
+  for (len = 0; len <= DATA_SIZE; len += (len < 300 ? 1 : 61))
+    {
+      svn_string_t input;
+      const svn_string_t *encoded, *decoded;
+      svn_stringbuf_t *expected, *damaged;
+
+      svn_pool_clear(iterpool);
+      input.data = (const char *)data;
+      input.len = len;
+
+      /* Encoded output must not depend on the implementation. */
+      expected = reference_base64(data, len, TRUE, iterpool);
+      encoded = svn_base64_encode_string2(&input, TRUE, iterpool);
+      SVN_TEST_STRING_ASSERT(encoded->data, expected->data);
+
+      decoded = svn_base64_decode_string(encoded, iterpool);
+      SVN_TEST_ASSERT(svn_string_compare(decoded, &input));
+
+      expected = reference_base64(data, len, FALSE, iterpool);
+      encoded = svn_base64_encode_string2(&input, FALSE, iterpool);
+      SVN_TEST_STRING_ASSERT(encoded->data, expected->data);
+
+      decoded = svn_base64_decode_string(encoded, iterpool);
+      SVN_TEST_ASSERT(svn_string_compare(decoded, &input));
+
+      /* The decoder skips invalid chars, wherever they are. */
+      for (i = 0; i < encoded->len && encoded->data[i] != '='; i += 7)
+        {
+          damaged = svn_stringbuf_create_from_string(encoded, iterpool);
+          svn_stringbuf_insert(damaged, i, i % 2 ? "\n" : "*\x80",
+                               i % 2 ? 1 : 2);
+          decoded = svn_base64_decode_string(
+                      svn_string_create_from_buf(damaged, iterpool),
+                      iterpool);
+          SVN_TEST_ASSERT(svn_string_compare(decoded, &input));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_base64_throughput(apr_pool_t *pool)
+{
+  enum { DATA_SIZE = 0x1000000 };
+  unsigned char *data = apr_palloc(pool, DATA_SIZE);
+  svn_string_t input;
+  const svn_string_t *encoded, *unbroken, *decoded;
+  apr_time_t start, encode_time, unbroken_time, decode_time;
+
+  fill_random(data, DATA_SIZE);
+  input.data = (const char *)data;
+  input.len = DATA_SIZE;
+
+  start = apr_time_now();
+  encoded = svn_base64_encode_string2(&input, TRUE, pool);
+  encode_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  unbroken = svn_base64_encode_string2(&input, FALSE, pool);
+  unbroken_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  decoded = svn_base64_decode_string(encoded, pool);
+  decode_time = apr_time_now() - start;
+
+  SVN_TEST_ASSERT(svn_string_compare(decoded, &input));
+  SVN_TEST_ASSERT(unbroken->len == (DATA_SIZE + 2) / 3 * 4);
+
+  printf("base64 implementation: %s\n", svn_base64__implementation());
+  printf("encode:             %8.1f MB/s\n",
+         encode_time ? (double)DATA_SIZE / encode_time : 0.0);
+  printf("encode (no breaks): %8.1f MB/s\n",
+         unbroken_time ? (double)DATA_SIZE / unbroken_time : 0.0);
+  printf("decode:             %8.1f MB/s\n",
+         decode_time ? (double)DATA_SIZE / decode_time : 0.0);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -1104,6 +1351,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading CRLF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_nul,
                    "test reading line from file with nul bytes"),
+    SVN_TEST_PASS2(test_stream_borrow,
+                   "test borrowing data from streams"),
+    SVN_TEST_PASS2(test_base64_reference,
+                   "test base64 codecs against a reference"),
+    SVN_TEST_SKIP2(test_base64_throughput, TRUE,
+                   "optional base64 codec performance test"),
     SVN_TEST_NULL
   };
 
@@ -872,6 +872,35 @@ test_string_matching(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_string_matching_long(apr_pool_t *pool)
+{
+  /* Long enough to cover all vector and word sizes plus odd tails. */
+  enum { LEN = 100 };
+  char a[LEN];
+  char b[LEN];
+  apr_size_t len, mismatch;
+
+  memset(a, 'x', sizeof(a));
+
+  /* Place a single mismatch at every position of every buffer length,
+   * with MISMATCH == LEN meaning "no mismatch". */
+  for (len = 0; len <= LEN; ++len)
+    for (mismatch = 0; mismatch <= len; ++mismatch)
+      {
+        memset(b, 'x', sizeof(b));
+        if (mismatch < len)
+          b[mismatch] = 'y';
+
+        SVN_TEST_ASSERT(svn_cstring__match_length(a, b, len) == mismatch);
+        SVN_TEST_ASSERT(svn_cstring__reverse_match_length(a + len, b + len,
+                                                          len)
+                        == (mismatch < len ? len - mismatch - 1 : len));
+      }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_cstring_skip_prefix(apr_pool_t *pool)
 {
@@ -1141,6 +1170,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test string similarity scores"),
     SVN_TEST_PASS2(test_string_matching,
                    "test string matching"),
+    SVN_TEST_PASS2(test_string_matching_long,
+                   "test string matching beyond word size"),
     SVN_TEST_PASS2(test_cstring_skip_prefix,
                    "test svn_cstring_skip_prefix()"),
     SVN_TEST_PASS2(test_stringbuf_replace_all,
@@ -28,6 +28,7 @@
 #include "../svn_test.h"
 
 #include "svn_types.h"
+#include "svn_pools.h"
 #include "svn_string.h"
 #include "svn_subst.h"
 #include "svn_hash.h"
@@ -500,6 +501,137 @@ test_svn_subst_long_keywords(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Translate SOURCE, prefixed by runs of 0 to 40 'x' characters, with
+   the given options and compare the results to EXPECTED with the same
+   prefixes.  This moves the interesting characters across the chunk
+   boundaries of the vectorized scanners. */
+static svn_error_t *
+check_aligned_translation(const char *source,
+                          const char *eol_str,
+                          apr_hash_t *keywords,
+                          const char *expected,
+                          apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i <= 40; ++i)
+    {
+      const char *prefix;
+      const char *result;
+
+      svn_pool_clear(iterpool);
+      prefix = apr_psprintf(iterpool, "%.*s", i,
+                            "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+      SVN_ERR(svn_subst_translate_cstring2(apr_pstrcat(iterpool, prefix,
+                                                       source, SVN_VA_NULL),
+                                           &result, eol_str, TRUE, keywords,
+                                           TRUE, iterpool));
+      SVN_TEST_STRING_ASSERT(result, apr_pstrcat(iterpool, prefix, expected,
+                                                 SVN_VA_NULL));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_svn_subst_translate_alignment(apr_pool_t *pool)
+{
+  const char *source = "a$Rev$b\r\nc\rd\ne$Rev: 1 $f$Unknown$g$\n\n"
+                       "0123456789abcdef0123456789abcdef$Rev$";
+  apr_hash_t *keywords = apr_hash_make(pool);
+
+  svn_hash_sets(keywords, "Rev", svn_string_create("42", pool));
+
+  SVN_ERR(check_aligned_translation(source, "\r\n", keywords,
+                                    "a$Rev: 42 $b\r\nc\r\nd\r\n"
+                                    "e$Rev: 42 $f$Unknown$g$\r\n\r\n"
+                                    "0123456789abcdef0123456789abcdef"
+                                    "$Rev: 42 $",
+                                    pool));
+  SVN_ERR(check_aligned_translation(source, NULL, keywords,
+                                    "a$Rev: 42 $b\r\nc\rd\n"
+                                    "e$Rev: 42 $f$Unknown$g$\n\n"
+                                    "0123456789abcdef0123456789abcdef"
+                                    "$Rev: 42 $",
+                                    pool));
+  SVN_ERR(check_aligned_translation(source, "\n", NULL,
+                                    "a$Rev$b\nc\nd\n"
+                                    "e$Rev: 1 $f$Unknown$g$\n\n"
+                                    "0123456789abcdef0123456789abcdef$Rev$",
+                                    pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the throughput in MB/s for processing LEN bytes in DURATION.
+ */
+static double
+throughput(apr_size_t len, apr_interval_time_t duration)
+{
+  return duration ? (double)len / (double)duration : 0.0;
+}
+
+/* Translate SOURCE with the given options and print the throughput
+   under TITLE. */
+static svn_error_t *
+measure_translation(const char *title,
+                    const svn_stringbuf_t *source,
+                    const char *eol_str,
+                    apr_hash_t *keywords,
+                    apr_pool_t *pool)
+{
+  const char *result;
+  apr_time_t start = apr_time_now();
+
+  SVN_ERR(svn_subst_translate_cstring2(source->data, &result, eol_str,
+                                       FALSE, keywords, TRUE, pool));
+  printf("%-24s %8.1f MB/s\n", title,
+         throughput(source->len, apr_time_now() - start));
+
+  return SVN_NO_ERROR;
+}
+
+/* Benchmark EOL and keyword translation of typical source code. */
+static svn_error_t *
+test_svn_subst_translate_throughput(apr_pool_t *pool)
+{
+  static const char * const lines[] = {
+    "/* $Id$ */\n",
+    "static svn_error_t *\n",
+    "translate_chunk(svn_stream_t *dst, const char *buf, apr_size_t len)\n",
+    "{\n",
+    "  SVN_ERR(svn_stream_write(dst, buf, &len));\n",
+    "\n",
+    "  /* Costs about 4 bytes per character: US$ 0.01 */\n",
+    "  return SVN_NO_ERROR;\n",
+    "}\n"
+  };
+  enum { SOURCE_SIZE = 0x800000 };
+  svn_stringbuf_t *source = svn_stringbuf_create_ensure(SOURCE_SIZE, pool);
+  apr_hash_t *keywords = apr_hash_make(pool);
+  int i;
+
+  svn_hash_sets(keywords, "Id",
+                svn_string_create("subst.c 1234 2024-01-01 jrandom", pool));
+
+  /* Only the first line of the source contains a keyword. */
+  svn_stringbuf_appendcstr(source, lines[0]);
+  for (i = 1; source->len < SOURCE_SIZE; i = i % (ARRAY_LEN(lines) - 1) + 1)
+    svn_stringbuf_appendcstr(source, lines[i]);
+
+  SVN_ERR(measure_translation("LF -> CRLF", source, "\r\n", NULL, pool));
+  SVN_ERR(measure_translation("LF -> LF", source, "\n", NULL, pool));
+  SVN_ERR(measure_translation("keywords", source, NULL, keywords, pool));
+  SVN_ERR(measure_translation("LF -> CRLF, keywords", source, "\r\n",
+                              keywords, pool));
+  SVN_ERR(measure_translation("LF -> LF, keywords", source, "\n",
+                              keywords, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -519,6 +651,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test truncated keywords (issue 4349)"),
     SVN_TEST_PASS2(test_svn_subst_long_keywords,
                    "test long keywords (issue 4350)"),
+    SVN_TEST_PASS2(test_svn_subst_translate_alignment,
+                   "test translation across scanner chunks"),
+    SVN_TEST_SKIP2(test_svn_subst_translate_throughput, TRUE,
+                   "optional translation performance test"),
     SVN_TEST_NULL
   };
 
@@ -215,6 +215,231 @@ utf_validate2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Write a random, valid UTF-8 character to BUF and return its length. */
+static apr_size_t
+random_utf8_char(char *buf)
+{
+  apr_uint32_t ucs;
+
+  switch (range_rand(0, 3))
+    {
+      case 0:
+        buf[0] = (char)range_rand(0, 0x7f);
+        return 1;
+
+      case 1:
+        ucs = range_rand(0x80, 0x7ff);
+        buf[0] = (char)(0xc0 | (ucs >> 6));
+        buf[1] = (char)(0x80 | (ucs & 0x3f));
+        return 2;
+
+      case 2:
+        do
+          ucs = range_rand(0x800, 0xffff);
+        while (ucs >= 0xd800 && ucs <= 0xdfff);
+        buf[0] = (char)(0xe0 | (ucs >> 12));
+        buf[1] = (char)(0x80 | ((ucs >> 6) & 0x3f));
+        buf[2] = (char)(0x80 | (ucs & 0x3f));
+        return 3;
+
+      default:
+        ucs = range_rand(0x10000, 0x10ffff);
+        buf[0] = (char)(0xf0 | (ucs >> 18));
+        buf[1] = (char)(0x80 | ((ucs >> 12) & 0x3f));
+        buf[2] = (char)(0x80 | ((ucs >> 6) & 0x3f));
+        buf[3] = (char)(0x80 | (ucs & 0x3f));
+        return 4;
+    }
+}
+
+/* Compare the two different implementations using long, mostly valid
+   strings that exercise the vectorized code paths. */
+static svn_error_t *
+utf_validate3(apr_pool_t *pool)
+{
+  int i;
+
+  seed_val();
+
+  for (i = 0; i < 20000; ++i)
+    {
+      char str[400];
+      apr_size_t len = 0;
+      apr_size_t ascii_len = range_rand(0, 100);
+      apr_size_t target_len = ascii_len + range_rand(0, 280);
+      const char *last;
+
+      /* An ASCII prefix followed by a random mix of characters. */
+      while (len < ascii_len)
+        str[len++] = (char)range_rand(0x20, 0x7e);
+      while (len < target_len)
+        len += random_utf8_char(str + len);
+
+      /* Usually corrupt or truncate the string. */
+      switch (range_rand(0, 3))
+        {
+          case 0:
+            break;
+          case 1:
+            len -= range_rand(0, 3);
+            break;
+          default:
+            if (len)
+              str[range_rand(0, (apr_uint32_t)len - 1)]
+                = (char)range_rand(0x80, 0xff);
+            break;
+        }
+
+      last = svn_utf__last_valid(str, len);
+      if (last != svn_utf__last_valid2(str, len)
+          || svn_utf__is_valid(str, len) != (last == str + len))
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "is_valid3 test %d failed", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the throughput in MB/s for processing LEN bytes in DURATION.
+ */
+static double
+throughput(apr_size_t len, apr_interval_time_t duration)
+{
+  return duration ? (double)len / (double)duration : 0.0;
+}
+
+/* Measure the validation speed for the strings in CORPUS and print the
+   results with the given TITLE. */
+static svn_error_t *
+validate_corpus(const char *title,
+                const apr_array_header_t *corpus)
+{
+  apr_size_t total = 0;
+  apr_time_t start, fsm_time, is_valid_time, last_valid_time;
+  int i;
+
+  start = apr_time_now();
+  for (i = 0; i < corpus->nelts; ++i)
+    {
+      const svn_string_t *str = APR_ARRAY_IDX(corpus, i, svn_string_t *);
+      SVN_TEST_ASSERT(svn_utf__last_valid2(str->data, str->len)
+                      == str->data + str->len);
+      total += str->len;
+    }
+  fsm_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < corpus->nelts; ++i)
+    {
+      const svn_string_t *str = APR_ARRAY_IDX(corpus, i, svn_string_t *);
+      SVN_TEST_ASSERT(svn_utf__is_valid(str->data, str->len));
+    }
+  is_valid_time = apr_time_now() - start;
+
+  start = apr_time_now();
+  for (i = 0; i < corpus->nelts; ++i)
+    {
+      const svn_string_t *str = APR_ARRAY_IDX(corpus, i, svn_string_t *);
+      SVN_TEST_ASSERT(svn_utf__last_valid(str->data, str->len)
+                      == str->data + str->len);
+    }
+  last_valid_time = apr_time_now() - start;
+
+  printf("%-14s FSM: %8.1f MB/s  is_valid: %8.1f MB/s  "
+         "last_valid: %8.1f MB/s\n",
+         title, throughput(total, fsm_time),
+         throughput(total, is_valid_time),
+         throughput(total, last_valid_time));
+
+  return SVN_NO_ERROR;
+}
+
+/* Benchmark UTF-8 validation on typical repository paths and log
+   messages. */
+static svn_error_t *
+test_utf_validate_throughput(apr_pool_t *pool)
+{
+  static const char * const path_parts[] = {
+    "trunk", "branches", "tags", "1.14.x", "subversion", "libsvn_subr",
+    "include", "private", "utf_validate.c", "README", "docs", "Makefile",
+    "\xc3\x9c" "bersicht", "r\xc3\xa9sum\xc3\xa9.txt",
+    "\xd0\xb4\xd0\xbe\xd0\xba\xd1\x83\xd0\xbc\xd0\xb5\xd0\xbd"
+    "\xd1\x82\xd1\x8b",
+    "\xe6\x96\x87\xe6\xa1\xa3", "images", "logo.png"
+  };
+  static const char * const log_lines[] = {
+    "Fix a crash when committing a file with an empty property value.\n",
+    "* subversion/libsvn_subr/utf_validate.c\n"
+    "  (svn_utf__is_valid): Use the vectorized validator.\n",
+    "Follow-up to r1876543: Update the comment as suggested by Bert.\n",
+    "Patch by: Jos\xc3\xa9 Garc\xc3\xad" "a <jose@example.com>\n",
+    "Translate the messages into Japanese: "
+    "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae"
+    "\xe3\x83\xa1\xe3\x83\x83\xe3\x82\xbb\xe3\x83\xbc"
+    "\xe3\x82\xb8\n",
+    "Add a regression test for issue #4711 \xe2\x80\x94 "
+    "merge of a renamed file.\n",
+    "\n"
+  };
+  enum { CORPUS_SIZE = 0x400000 };
+  apr_array_header_t *paths = apr_array_make(pool, 0, sizeof(svn_string_t *));
+  apr_array_header_t *logs = apr_array_make(pool, 0, sizeof(svn_string_t *));
+  apr_array_header_t *ascii = apr_array_make(pool, 0, sizeof(svn_string_t *));
+  apr_size_t total;
+
+  seed_val();
+
+  for (total = 0; total < CORPUS_SIZE; )
+    {
+      svn_stringbuf_t *path = svn_stringbuf_create_empty(pool);
+      int depth = range_rand(1, 8);
+
+      while (depth--)
+        {
+          if (path->len)
+            svn_stringbuf_appendbyte(path, '/');
+          svn_stringbuf_appendcstr(path,
+                                   path_parts[range_rand(0,
+                                     sizeof(path_parts) / sizeof(path_parts[0])
+                                     - 1)]);
+        }
+
+      total += path->len;
+      APR_ARRAY_PUSH(paths, svn_string_t *)
+        = svn_stringbuf__morph_into_string(path);
+    }
+
+  for (total = 0; total < CORPUS_SIZE; )
+    {
+      svn_stringbuf_t *log = svn_stringbuf_create_empty(pool);
+      svn_stringbuf_t *plain = svn_stringbuf_create_empty(pool);
+      int lines = range_rand(1, 20);
+
+      while (lines--)
+        {
+          const char *line = log_lines[range_rand(0,
+                                 sizeof(log_lines) / sizeof(log_lines[0])
+                                 - 1)];
+          svn_stringbuf_appendcstr(log, line);
+          svn_stringbuf_appendcstr(plain, log_lines[0]);
+        }
+
+      total += log->len;
+      APR_ARRAY_PUSH(logs, svn_string_t *)
+        = svn_stringbuf__morph_into_string(log);
+      APR_ARRAY_PUSH(ascii, svn_string_t *)
+        = svn_stringbuf__morph_into_string(plain);
+    }
+
+  printf("UTF-8 validator: %s\n", svn_utf__validator_implementation());
+
+  SVN_ERR(validate_corpus("paths", paths));
+  SVN_ERR(validate_corpus("log messages", logs));
+  SVN_ERR(validate_corpus("ASCII logs", ascii));
+
+  return SVN_NO_ERROR;
+}
+
 /* Test conversion from different codepages to utf8. */
 static svn_error_t *
 test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
@@ -1010,6 +1235,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test is_valid/last_valid"),
     SVN_TEST_PASS2(utf_validate2,
                    "test last_valid/last_valid2"),
+    SVN_TEST_PASS2(utf_validate3,
+                   "test utf-8 validators with long strings"),
     SVN_TEST_PASS2(test_utf_cstring_to_utf8_ex2,
                    "test svn_utf_cstring_to_utf8_ex2"),
     SVN_TEST_PASS2(test_utf_cstring_from_utf8_ex2,
@@ -1028,6 +1255,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_utf__normalize"),
     SVN_TEST_PASS2(test_utf_xfrm,
                    "test svn_utf__xfrm"),
+    SVN_TEST_SKIP2(test_utf_validate_throughput, TRUE,
+                   "optional utf-8 validation performance test"),
     SVN_TEST_NULL
   };
 